@@ -0,0 +1,276 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <winrt/Windows.Foundation.h>
+
+#include "BoxGeometry.h"
+#include "WindowsVersionHelper.h"
+
+using namespace winrt;
+
+// Kinds of objects in the synthetic detections, boxes of different kinds never suppress each other
+static const int32_t KindCount = 4;
+
+// Boxes a tracker would hold, compared to the detections of each frame in the IoU matrix benchmark
+static const uint32_t TrackCount = 256;
+
+//
+// Synthetic detections of a frame: boxes normalized in the frame, in clusters of about 20 boxes around each object
+// like the raw candidates of a detector before overlap suppression, with random scores and kinds
+//
+struct FrameDetections
+{
+    std::vector<BoxGeometry::Box> boxes;
+    std::vector<float> scores;
+    std::vector<int32_t> kinds;
+};
+
+FrameDetections GenerateDetections(uint32_t boxCount, uint32_t seed)
+{
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::normal_distribution<float> jitter(0.0f, 0.01f);
+
+    FrameDetections detections;
+    uint32_t objectCount = std::max<uint32_t>(boxCount / 20, 1);
+    std::vector<BoxGeometry::Box> objects;
+    std::vector<int32_t> objectKinds;
+    for (uint32_t i = 0; i < objectCount; i++)
+    {
+        float width = 0.02f + unit(random) * 0.1f;
+        float height = 0.02f + unit(random) * 0.2f;
+        objects.push_back({ unit(random) * (1.0f - width), unit(random) * (1.0f - height), width, height });
+        objectKinds.push_back((int32_t)(random() % KindCount));
+    }
+    for (uint32_t i = 0; i < boxCount; i++)
+    {
+        uint32_t object = (uint32_t)(random() % objectCount);
+        auto& box = objects[object];
+        detections.boxes.push_back({ box.x + jitter(random), box.y + jitter(random), box.width * (1.0f + jitter(random) * 5), box.height * (1.0f + jitter(random) * 5) });
+        detections.scores.push_back(unit(random));
+        detections.kinds.push_back(objectKinds[object]);
+    }
+    return detections;
+}
+
+//
+// Zones of interest the foot points of the detections are counted in, convex and concave polygons in normalized coordinates
+//
+std::vector<std::vector<BoxGeometry::Point>> GenerateZones()
+{
+    std::vector<std::vector<BoxGeometry::Point>> zones;
+    for (uint32_t i = 0; i < 8; i++)
+    {
+        // Star shaped polygons of 5 to 12 vertices alternating between two radii
+        float centerX = 0.15f + 0.7f * (i % 4) / 3.0f;
+        float centerY = (i < 4) ? 0.3f : 0.7f;
+        uint32_t vertexCount = 5 + i;
+        std::vector<BoxGeometry::Point> zone;
+        for (uint32_t vertex = 0; vertex < vertexCount; vertex++)
+        {
+            float angle = 6.2831853f * vertex / vertexCount;
+            float radius = (vertex % 2 == 0) ? 0.15f : 0.08f;
+            zone.push_back({ centerX + radius * std::cos(angle), centerY + radius * std::sin(angle) });
+        }
+        zones.push_back(zone);
+    }
+    return zones;
+}
+
+//
+// Helper method to retrieve the value following a named argument, i.e. "-boxes 4000"
+//
+const char* FindOptionValue(const char* optionName)
+{
+    for (int i = 1; i < __argc - 1; i++)
+    {
+        if (strcmp(__argv[i], optionName) == 0)
+        {
+            return __argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+//
+// Average time in microseconds a kernel takes over iterationCount runs
+//
+template <typename Kernel>
+double MeasureUs(uint32_t iterationCount, Kernel kernel)
+{
+    kernel(); // warm up
+    auto begin = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < iterationCount; i++)
+    {
+        kernel();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::micro>(end - begin).count() / iterationCount;
+}
+
+void PrintResult(const std::string& name, double scalarUs, double simdUs)
+{
+    std::cout << std::left << std::setw(36) << name << std::right << std::fixed << std::setprecision(1)
+        << std::setw(10) << scalarUs << "us" << std::setw(10) << simdUs << "us" << std::setw(8) << std::setprecision(2) << scalarUs / simdUs << "x" << std::endl;
+}
+
+//
+// Run each kernel on the detections of a frame with the scalar and the SIMD code, checking that both agree
+//
+void RunBenchmark(uint32_t boxCount, uint32_t iterationCount)
+{
+    auto detections = GenerateDetections(boxCount, 1);
+    auto tracks = GenerateDetections(TrackCount, 2);
+    auto zones = GenerateZones();
+
+#ifdef BOX_GEOMETRY_USE_SSE2
+    std::cout << "Kernels on " << boxCount << " boxes per frame, " << iterationCount << " iterations, scalar code vs SSE2" << std::endl;
+#else
+    std::cout << "Kernels on " << boxCount << " boxes per frame, " << iterationCount << " iterations, SSE2 is not available so both use the scalar code" << std::endl;
+#endif
+    std::cout << std::left << std::setw(36) << "Kernel" << std::right << std::setw(12) << "scalar" << std::setw(12) << "SIMD" << std::setw(9) << "speedup" << std::endl;
+
+    // IoU of the detections with the boxes of a tracker
+    {
+        BoxGeometry::BoxSet rows(detections.boxes);
+        BoxGeometry::BoxSet columns(tracks.boxes);
+        std::vector<float> scalarMatrix;
+        std::vector<float> simdMatrix;
+        double scalarUs = MeasureUs(iterationCount, [&]() { BoxGeometry::IoUMatrix(rows, columns, scalarMatrix, false); });
+        double simdUs = MeasureUs(iterationCount, [&]() { BoxGeometry::IoUMatrix(rows, columns, simdMatrix, true); });
+        if (scalarMatrix != simdMatrix)
+        {
+            throw std::runtime_error("Error: scalar and SIMD IoU matrices differ");
+        }
+        PrintResult("IoU matrix " + std::to_string(boxCount) + " x " + std::to_string(TrackCount), scalarUs, simdUs);
+    }
+
+    // Overlap suppression of the detections, both methods
+    std::vector<uint32_t> reference;
+    for (auto method : { BoxGeometry::NmsMethod::Sorted, BoxGeometry::NmsMethod::Bitmask })
+    {
+        BoxGeometry::NmsOptions options;
+        options.iouThreshold = 0.5f;
+        options.method = method;
+        std::vector<uint32_t> scalarKept;
+        std::vector<uint32_t> simdKept;
+        options.useSimd = false;
+        double scalarUs = MeasureUs(iterationCount, [&]() { scalarKept = BoxGeometry::SuppressNonMaximum(detections.boxes, detections.scores, detections.kinds, options); });
+        options.useSimd = true;
+        double simdUs = MeasureUs(iterationCount, [&]() { simdKept = BoxGeometry::SuppressNonMaximum(detections.boxes, detections.scores, detections.kinds, options); });
+        if (reference.empty())
+        {
+            reference = scalarKept;
+        }
+        if (scalarKept != reference || simdKept != reference)
+        {
+            throw std::runtime_error("Error: overlap suppression methods kept different boxes");
+        }
+        PrintResult(std::string("NMS ") + (method == BoxGeometry::NmsMethod::Sorted ? "sorted" : "bitmask") + ", kept " + std::to_string(reference.size()), scalarUs, simdUs);
+    }
+
+    // Mapping of boxes and of the joints of their limbs from a region of a 1920 x 1080 frame back to the frame
+    {
+        auto transform = BoxGeometry::Affine::RegionToFrame(640.0f, 180.0f, 960.0f, 720.0f, 1920.0f, 1080.0f);
+        auto scalarBoxes = detections.boxes;
+        auto simdBoxes = detections.boxes;
+        double scalarUs = MeasureUs(iterationCount, [&]() { scalarBoxes = detections.boxes; BoxGeometry::TransformBoxes(transform, scalarBoxes.data(), scalarBoxes.size(), false); });
+        double simdUs = MeasureUs(iterationCount, [&]() { simdBoxes = detections.boxes; BoxGeometry::TransformBoxes(transform, simdBoxes.data(), simdBoxes.size(), true); });
+        if (memcmp(scalarBoxes.data(), simdBoxes.data(), scalarBoxes.size() * sizeof(BoxGeometry::Box)) != 0)
+        {
+            throw std::runtime_error("Error: scalar and SIMD box mappings differ");
+        }
+        PrintResult("Map boxes to frame", scalarUs, simdUs);
+
+        std::vector<BoxGeometry::Point> joints;
+        for (auto&& box : detections.boxes)
+        {
+            joints.push_back({ box.x, box.y });
+            joints.push_back({ box.x + box.width, box.y + box.height });
+        }
+        auto scalarJoints = joints;
+        auto simdJoints = joints;
+        scalarUs = MeasureUs(iterationCount, [&]() { scalarJoints = joints; BoxGeometry::TransformPoints(transform, scalarJoints.data(), scalarJoints.size(), false); });
+        simdUs = MeasureUs(iterationCount, [&]() { simdJoints = joints; BoxGeometry::TransformPoints(transform, simdJoints.data(), simdJoints.size(), true); });
+        if (memcmp(scalarJoints.data(), simdJoints.data(), scalarJoints.size() * sizeof(BoxGeometry::Point)) != 0)
+        {
+            throw std::runtime_error("Error: scalar and SIMD joint mappings differ");
+        }
+        PrintResult("Map " + std::to_string(joints.size()) + " joints to frame", scalarUs, simdUs);
+    }
+
+    // Detections counted in each zone by the middle of their bottom edge, where objects touch the ground
+    {
+        std::vector<BoxGeometry::Point> footPoints;
+        for (auto&& box : detections.boxes)
+        {
+            footPoints.push_back({ box.x + box.width / 2, box.y + box.height });
+        }
+        std::vector<uint32_t> scalarCounts;
+        std::vector<uint32_t> simdCounts;
+        double scalarUs = MeasureUs(iterationCount, [&]() { BoxGeometry::CountInZones(zones, footPoints, scalarCounts, false); });
+        double simdUs = MeasureUs(iterationCount, [&]() { BoxGeometry::CountInZones(zones, footPoints, simdCounts, true); });
+        if (scalarCounts != simdCounts)
+        {
+            throw std::runtime_error("Error: scalar and SIMD zone counts differ");
+        }
+        PrintResult("Count in " + std::to_string(zones.size()) + " zones", scalarUs, simdUs);
+    }
+}
+
+//
+// App main loop
+//
+int main()
+{
+    try
+    {
+        // Check if we are running Windows 10.0.18362.x or above as required
+        HRESULT hr = WindowsVersionHelper::EqualOrAboveWindows10Version(18362);
+        if (FAILED(hr))
+        {
+            throw_hresult(hr);
+        }
+        std::cout << "Box Geometry C++/WinRT Non-packaged(win32) console App" << std::endl;
+
+        try
+        {
+            uint32_t boxCount = 4000;
+            uint32_t iterationCount = 100;
+            if (auto boxes = FindOptionValue("-boxes"))
+            {
+                boxCount = (uint32_t)std::max<int>(1, atoi(boxes));
+            }
+            if (auto iterations = FindOptionValue("-iterations"))
+            {
+                iterationCount = (uint32_t)std::max<int>(1, atoi(iterations));
+            }
+            RunBenchmark(boxCount, iterationCount);
+        }
+        catch (hresult_error const& ex)
+        {
+            std::wcerr << "Error:" << ex.message().c_str() << ":" << std::hex << ex.code().value << std::endl;
+            return ex.code().value;
+        }
+        catch (std::exception const& ex)
+        {
+            std::cerr << "Error:" << ex.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    catch (hresult_error const& ex)
+    {
+        std::cerr << "Error:" << std::hex << ex.code() << ":" << ex.message().c_str();
+    }
+}
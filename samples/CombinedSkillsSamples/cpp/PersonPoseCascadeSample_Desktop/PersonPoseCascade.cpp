@@ -0,0 +1,304 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "PersonPoseCascade.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+#include "BoxGeometry.h"
+#include "Tracing.h"
+#include "WorkStealingThreadPool.h"
+#include "winrt/Microsoft.AI.Skills.SkillInterface.h"
+
+using namespace winrt;
+using namespace winrt::Windows::Foundation;
+using namespace winrt::Windows::Foundation::Collections;
+using namespace winrt::Windows::Graphics::Imaging;
+using namespace winrt::Windows::Media;
+using namespace winrt::Microsoft::AI::Skills::SkillInterface;
+using namespace winrt::Microsoft::AI::Skills::Vision::ObjectDetector;
+using namespace winrt::Microsoft::AI::Skills::Vision::SkeletalDetector;
+
+//
+// Round a pixel dimension up to a multiple of alignment, skills do not accept odd image dimensions
+//
+static uint32_t AlignDimension(uint32_t value, uint32_t alignment)
+{
+    return std::max(alignment, (value + alignment - 1) / alignment * alignment);
+}
+
+//
+// Create the ObjectDetector binding and the set of SkeletalDetector bindings used to evaluate persons concurrently
+//
+PersonPoseCascade::PersonPoseCascade(
+    ObjectDetectorSkill const& objectDetectorSkill,
+    SkeletalDetectorSkill const& skeletalDetectorSkill,
+    Options const& options)
+    : m_options(options),
+    m_objectDetectorSkill(objectDetectorSkill),
+    m_skeletalDetectorSkill(skeletalDetectorSkill)
+{
+    if (m_options.cropPadding < 0.0f || m_options.maxCropDimension < 2)
+    {
+        throw hresult_invalid_argument(L"Error: crop padding must be positive and crop dimension at least 2 pixels");
+    }
+
+    m_objectDetectorBinding = m_objectDetectorSkill.CreateSkillBindingAsync().get().as<ObjectDetectorBinding>();
+
+    uint32_t workerCount = std::max<uint32_t>(m_options.workerCount, 1);
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        m_skeletalDetectorBindings.push_back(m_skeletalDetectorSkill.CreateSkillBindingAsync().get().as<SkeletalDetectorBinding>());
+    }
+
+    // Crops are scaled to the input size SkeletalDetector expects, if any, so that it does not resize them again
+    for (auto&& featureDescriptor : m_skeletalDetectorSkill.SkillDescriptor().InputFeatureDescriptors())
+    {
+        if (featureDescriptor.FeatureKind() == SkillFeatureKind::Image)
+        {
+            auto imageDescriptor = featureDescriptor.as<ISkillFeatureImageDescriptor>();
+            if (imageDescriptor.Width() > 0 && imageDescriptor.Height() > 0)
+            {
+                m_requiredWidth = (uint32_t)imageDescriptor.Width();
+                m_requiredHeight = (uint32_t)imageDescriptor.Height();
+            }
+            break;
+        }
+    }
+}
+
+//
+// Pad the person box, clamp it to the frame and fit it in the image bound to SkeletalDetector without distorting it
+//
+PersonPoseCascade::Crop PersonPoseCascade::ComputeCrop(Rect const& personRect, uint32_t frameWidth, uint32_t frameHeight) const
+{
+    float paddingX = personRect.Width * m_options.cropPadding;
+    float paddingY = personRect.Height * m_options.cropPadding;
+    uint32_t left = (uint32_t)std::clamp((personRect.X - paddingX) * frameWidth, 0.0f, (float)frameWidth);
+    uint32_t top = (uint32_t)std::clamp((personRect.Y - paddingY) * frameHeight, 0.0f, (float)frameHeight);
+    uint32_t right = (uint32_t)std::clamp((personRect.X + personRect.Width + paddingX) * frameWidth, 0.0f, (float)frameWidth);
+    uint32_t bottom = (uint32_t)std::clamp((personRect.Y + personRect.Height + paddingY) * frameHeight, 0.0f, (float)frameHeight);
+
+    // Grow the crop to an even size, shifting it back inside the frame when at its edge
+    uint32_t width = std::min(AlignDimension(right - left, 2), frameWidth & ~1u);
+    uint32_t height = std::min(AlignDimension(bottom - top, 2), frameHeight & ~1u);
+    left = std::min(left, frameWidth - width);
+    top = std::min(top, frameHeight - height);
+
+    Crop crop;
+    crop.sourceBounds = { left, top, width, height };
+    if (m_requiredWidth > 0)
+    {
+        // Letterbox the crop in the required input size
+        float scale = std::min((float)m_requiredWidth / width, (float)m_requiredHeight / height);
+        uint32_t targetWidth = std::min(AlignDimension((uint32_t)(width * scale), 2), m_requiredWidth);
+        uint32_t targetHeight = std::min(AlignDimension((uint32_t)(height * scale), 2), m_requiredHeight);
+        crop.targetWidth = m_requiredWidth;
+        crop.targetHeight = m_requiredHeight;
+        crop.targetBounds = { (m_requiredWidth - targetWidth) / 2, (m_requiredHeight - targetHeight) / 2, targetWidth, targetHeight };
+    }
+    else
+    {
+        // Only ever scale crops down
+        float scale = std::min(1.0f, (float)m_options.maxCropDimension / std::max(width, height));
+        crop.targetWidth = AlignDimension((uint32_t)(width * scale), 2);
+        crop.targetHeight = AlignDimension((uint32_t)(height * scale), 2);
+        crop.targetBounds = { 0, 0, crop.targetWidth, crop.targetHeight };
+    }
+    return crop;
+}
+
+//
+// Evaluate SkeletalDetector on the crop of a person and map the joints of its skeleton back to the frame
+//
+void PersonPoseCascade::EvaluatePerson(
+    SkeletalDetectorBinding const& binding,
+    VideoFrame const& frame,
+    uint32_t frameWidth,
+    uint32_t frameHeight,
+    const Crop& crop,
+    PersonPose& person)
+{
+    {
+        SAMPLES_TRACE_SCOPE("Person.Bind");
+        VideoFrame cropFrame(BitmapPixelFormat::Bgra8, crop.targetWidth, crop.targetHeight, BitmapAlphaMode::Premultiplied);
+        frame.CopyToAsync(cropFrame, crop.sourceBounds, crop.targetBounds).get();
+        binding.SetInputImageAsync(cropFrame).get();
+    }
+
+    {
+        SAMPLES_TRACE_SCOPE("Person.Evaluate");
+        m_skeletalDetectorSkill.EvaluateAsync(binding).get();
+    }
+
+    SAMPLES_TRACE_SCOPE("Person.Extract");
+    auto bodies = binding.Bodies();
+
+    // Joints are normalized in the image bound to SkeletalDetector: map them to the crop it holds, then to the frame
+    auto toCrop = BoxGeometry::Affine::RegionToFrame(
+        (float)crop.targetBounds.X, (float)crop.targetBounds.Y, (float)crop.targetBounds.Width, (float)crop.targetBounds.Height,
+        (float)crop.targetWidth, (float)crop.targetHeight).Inverse();
+    auto toFrame = toCrop.Then(BoxGeometry::Affine::RegionToFrame(
+        (float)crop.sourceBounds.X, (float)crop.sourceBounds.Y, (float)crop.sourceBounds.Width, (float)crop.sourceBounds.Height,
+        (float)frameWidth, (float)frameHeight));
+
+    // The padding may catch parts of nearby persons: keep the most complete body centered in the person box
+    BoxGeometry::Box personBox = { person.personRect.X, person.personRect.Y, person.personRect.Width, person.personRect.Height };
+    IVectorView<Limb> bestLimbs = nullptr;
+    for (auto&& body : bodies)
+    {
+        auto limbs = body.Limbs();
+        if (limbs.Size() == 0 || (bestLimbs != nullptr && limbs.Size() <= bestLimbs.Size()))
+        {
+            continue;
+        }
+        BoxGeometry::Point center = { 0.0f, 0.0f };
+        for (auto&& limb : limbs)
+        {
+            center.x += (float)limb.Joint1.X + (float)limb.Joint2.X;
+            center.y += (float)limb.Joint1.Y + (float)limb.Joint2.Y;
+        }
+        center.x /= 2 * limbs.Size();
+        center.y /= 2 * limbs.Size();
+        if (BoxGeometry::Contains(personBox, toFrame.Apply(center)))
+        {
+            bestLimbs = limbs;
+        }
+    }
+
+    if (bestLimbs != nullptr)
+    {
+        std::vector<BoxGeometry::Point> joints;
+        for (auto&& limb : bestLimbs)
+        {
+            joints.push_back({ (float)limb.Joint1.X, (float)limb.Joint1.Y });
+            joints.push_back({ (float)limb.Joint2.X, (float)limb.Joint2.Y });
+        }
+        BoxGeometry::TransformPoints(toFrame, joints.data(), joints.size());
+
+        uint32_t jointIndex = 0;
+        for (auto limb : bestLimbs)
+        {
+            limb.Joint1.X = joints[jointIndex].x;
+            limb.Joint1.Y = joints[jointIndex].y;
+            limb.Joint2.X = joints[jointIndex + 1].x;
+            limb.Joint2.Y = joints[jointIndex + 1].y;
+            jointIndex += 2;
+            person.limbs.push_back(limb);
+        }
+    }
+}
+
+//
+// Detect persons in the frame and evaluate their skeletons across all workers
+//
+std::vector<PersonPoseCascade::PersonPose> PersonPoseCascade::Evaluate(VideoFrame const& frame)
+{
+    m_lastTimings = Timings();
+    auto begin = std::chrono::high_resolution_clock::now();
+
+    {
+        SAMPLES_TRACE_SCOPE("Detect.Bind");
+        m_objectDetectorBinding.SetInputImageAsync(frame).get();
+    }
+    {
+        SAMPLES_TRACE_SCOPE("Detect.Evaluate");
+        m_objectDetectorSkill.EvaluateAsync(m_objectDetectorBinding).get();
+    }
+
+    std::vector<PersonPose> persons;
+    {
+        SAMPLES_TRACE_SCOPE("Detect.Extract");
+        for (auto&& detectedObject : m_objectDetectorBinding.DetectedObjects())
+        {
+            auto rect = detectedObject.Rect();
+            if (detectedObject.Kind() == ObjectKind::Person && rect.Width * rect.Height >= m_options.minPersonArea)
+            {
+                persons.push_back({ rect, {}, {} });
+            }
+        }
+    }
+    m_lastTimings.detectedPersonCount = (uint32_t)persons.size();
+
+    // Favor the largest persons when there are too many to evaluate them all
+    std::sort(persons.begin(), persons.end(), [](const PersonPose& a, const PersonPose& b)
+    {
+        return a.personRect.Width * a.personRect.Height > b.personRect.Width * b.personRect.Height;
+    });
+    if (persons.size() > m_options.maxPersons)
+    {
+        persons.resize(m_options.maxPersons);
+    }
+    m_lastTimings.evaluatedPersonCount = (uint32_t)persons.size();
+
+    auto end = std::chrono::high_resolution_clock::now();
+    m_lastTimings.detectMs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+    begin = end;
+
+    if (!persons.empty())
+    {
+        uint32_t frameWidth = 0;
+        uint32_t frameHeight = 0;
+        if (frame.SoftwareBitmap() != nullptr)
+        {
+            frameWidth = (uint32_t)frame.SoftwareBitmap().PixelWidth();
+            frameHeight = (uint32_t)frame.SoftwareBitmap().PixelHeight();
+        }
+        else
+        {
+            auto surfaceDescription = frame.Direct3DSurface().Description();
+            frameWidth = (uint32_t)surfaceDescription.Width;
+            frameHeight = (uint32_t)surfaceDescription.Height;
+        }
+
+        std::vector<Crop> crops;
+        for (auto&& person : persons)
+        {
+            crops.push_back(ComputeCrop(person.personRect, frameWidth, frameHeight));
+            person.cropBounds = crops.back().sourceBounds;
+        }
+
+        if (persons.size() == 1)
+        {
+            // Spare the task hand-off for the common single person case
+            EvaluatePerson(m_skeletalDetectorBindings[0], frame, frameWidth, frameHeight, crops[0], persons[0]);
+        }
+        else
+        {
+            std::atomic<uint32_t> nextPerson = 0;
+
+            // Persons are traced as part of the frame they were detected in
+            uint64_t frameId = SAMPLES_TRACE_FRAME_ID();
+
+            // Declared last so that the tasks completing in its destructor never outlive what they reference
+            WorkStealingThreadPool::TaskGroup workers(WorkStealingThreadPool::Default());
+
+            uint32_t workerCount = std::min((uint32_t)m_skeletalDetectorBindings.size(), (uint32_t)persons.size());
+            for (uint32_t workerIndex = 0; workerIndex < workerCount; workerIndex++)
+            {
+                // Each task owns a binding and picks persons until none is left
+                workers.Run([&, workerIndex]()
+                {
+                    SAMPLES_TRACE_SET_FRAME_ID(frameId);
+                    try
+                    {
+                        for (uint32_t personIndex = nextPerson++; personIndex < persons.size(); personIndex = nextPerson++)
+                        {
+                            EvaluatePerson(m_skeletalDetectorBindings[workerIndex], frame, frameWidth, frameHeight, crops[personIndex], persons[personIndex]);
+                        }
+                    }
+                    catch (...)
+                    {
+                        // Stop handing out persons, the first failure is rethrown to the caller by Wait()
+                        nextPerson = (uint32_t)persons.size();
+                        throw;
+                    }
+                });
+            }
+            workers.Wait();
+        }
+    }
+
+    end = std::chrono::high_resolution_clock::now();
+    m_lastTimings.poseMs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+    return persons;
+}
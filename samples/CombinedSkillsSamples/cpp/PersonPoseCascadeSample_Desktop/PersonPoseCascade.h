@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <vector>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Graphics.Imaging.h>
+#include <winrt/Windows.Media.h>
+
+#include "winrt/Microsoft.AI.Skills.Vision.ObjectDetector.h"
+#include "winrt/Microsoft.AI.Skills.Vision.SkeletalDetector.h"
+
+//
+// Helper class that cascades ObjectDetector into SkeletalDetector: the object detector runs on the whole frame,
+// then only the regions of the detected persons, padded with some context, are cropped, scaled and evaluated
+// by SkeletalDetector in parallel across a set of bindings. Joints are mapped back to normalized frame coordinates.
+// Skeletal evaluation work therefore grows with the amount of persons in view rather than with the frame area,
+// and each person is seen by SkeletalDetector at a resolution close to the one it expects.
+//
+class PersonPoseCascade
+{
+public:
+    struct Options
+    {
+        float cropPadding = 0.15f; // fraction of the person box width and height added on each side as context
+        float minPersonArea = 0.0f; // normalized area under which a person box is not evaluated
+        uint32_t maxPersons = 8; // largest persons evaluated per frame
+        uint32_t maxCropDimension = 256; // pixels, used when SkeletalDetector does not require a specific input size
+        uint32_t workerCount = 2; // SkeletalDetector bindings evaluated concurrently
+    };
+
+    //
+    // Skeleton of a detected person, joints are normalized in the frame
+    //
+    struct PersonPose
+    {
+        winrt::Windows::Foundation::Rect personRect; // normalized bounding box found by ObjectDetector
+        winrt::Windows::Graphics::Imaging::BitmapBounds cropBounds; // region of the frame bound to SkeletalDetector, in pixels
+        std::vector<winrt::Microsoft::AI::Skills::Vision::SkeletalDetector::Limb> limbs;
+    };
+
+    struct Timings
+    {
+        float detectMs = 0.0f; // ObjectDetector bind and evaluation
+        float poseMs = 0.0f; // crops and SkeletalDetector bind and evaluation of all persons
+        uint32_t detectedPersonCount = 0;
+        uint32_t evaluatedPersonCount = 0;
+    };
+
+    PersonPoseCascade(
+        winrt::Microsoft::AI::Skills::Vision::ObjectDetector::ObjectDetectorSkill const& objectDetectorSkill,
+        winrt::Microsoft::AI::Skills::Vision::SkeletalDetector::SkeletalDetectorSkill const& skeletalDetectorSkill,
+        Options const& options);
+
+    std::vector<PersonPose> Evaluate(winrt::Windows::Media::VideoFrame const& frame);
+
+    uint32_t WorkerCount() const { return (uint32_t)m_skeletalDetectorBindings.size(); }
+    const Timings& LastTimings() const { return m_lastTimings; }
+
+private:
+    //
+    // Where a person crop lands in the image bound to SkeletalDetector
+    //
+    struct Crop
+    {
+        winrt::Windows::Graphics::Imaging::BitmapBounds sourceBounds; // in the frame
+        winrt::Windows::Graphics::Imaging::BitmapBounds targetBounds; // in the image bound to SkeletalDetector
+        uint32_t targetWidth;
+        uint32_t targetHeight;
+    };
+
+    Crop ComputeCrop(winrt::Windows::Foundation::Rect const& personRect, uint32_t frameWidth, uint32_t frameHeight) const;
+    void EvaluatePerson(
+        winrt::Microsoft::AI::Skills::Vision::SkeletalDetector::SkeletalDetectorBinding const& binding,
+        winrt::Windows::Media::VideoFrame const& frame,
+        uint32_t frameWidth,
+        uint32_t frameHeight,
+        const Crop& crop,
+        PersonPose& person);
+
+    Options m_options;
+    winrt::Microsoft::AI::Skills::Vision::ObjectDetector::ObjectDetectorSkill m_objectDetectorSkill = nullptr;
+    winrt::Microsoft::AI::Skills::Vision::ObjectDetector::ObjectDetectorBinding m_objectDetectorBinding = nullptr;
+    winrt::Microsoft::AI::Skills::Vision::SkeletalDetector::SkeletalDetectorSkill m_skeletalDetectorSkill = nullptr;
+    std::vector<winrt::Microsoft::AI::Skills::Vision::SkeletalDetector::SkeletalDetectorBinding> m_skeletalDetectorBindings;
+
+    // Input size required by SkeletalDetector, 0 if any size is accepted
+    uint32_t m_requiredWidth = 0;
+    uint32_t m_requiredHeight = 0;
+
+    Timings m_lastTimings;
+};
@@ -0,0 +1,189 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/windows.foundation.collections.h>
+#include <winrt/windows.media.h>
+#include <winrt/windows.system.threading.h>
+
+#include "CameraHelper_cppwinrt.h"
+#include "PersonPoseCascade.h"
+#include "Tracing.h"
+#include "WindowsVersionHelper.h"
+#include "winrt/Microsoft.AI.Skills.SkillInterface.h"
+#include "winrt/Microsoft.AI.Skills.Vision.ObjectDetector.h"
+#include "winrt/Microsoft.AI.Skills.Vision.SkeletalDetector.h"
+
+using namespace winrt;
+using namespace winrt::Windows::Foundation;
+using namespace winrt::Windows::Foundation::Collections;
+using namespace winrt::Windows::System::Threading;
+using namespace winrt::Windows::Media;
+
+using namespace Microsoft::AI::Skills::SkillInterface;
+using namespace Microsoft::AI::Skills::Vision::ObjectDetector;
+using namespace Microsoft::AI::Skills::Vision::SkeletalDetector;
+
+// enum to string lookup table for SkillExecutionDeviceKind
+static const std::map<SkillExecutionDeviceKind, std::string> SkillExecutionDeviceKindLookup = {
+    { SkillExecutionDeviceKind::Undefined, "Undefined" },
+    { SkillExecutionDeviceKind::Cpu, "Cpu" },
+    { SkillExecutionDeviceKind::Gpu, "Gpu" },
+    { SkillExecutionDeviceKind::Vpu, "Vpu" },
+    { SkillExecutionDeviceKind::Fpga, "Fpga" },
+    { SkillExecutionDeviceKind::Cloud, "Cloud" }
+};
+
+//
+// Helper method to retrieve the value following a named argument, i.e. "-workers 4"
+//
+const char* FindOptionValue(const char* optionName)
+{
+    for (int i = 1; i < __argc - 1; i++)
+    {
+        if (strcmp(__argv[i], optionName) == 0)
+        {
+            return __argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+//
+// Helper method to create an instance of a skill and display the device it runs on
+//
+template <typename TSkill>
+TSkill CreateSkill(ISkillDescriptor const& skillDescriptor)
+{
+    auto skill = skillDescriptor.CreateSkillAsync().get().as<TSkill>();
+    std::wcout << skillDescriptor.Information().Name().c_str() << L" running on : ";
+    std::cout << SkillExecutionDeviceKindLookup.at(skill.Device().ExecutionDeviceKind());
+    std::wcout << L" : " << skill.Device().Name().c_str() << std::endl;
+    return skill;
+}
+
+//
+// App main loop
+//
+int main()
+{
+    try
+    {
+        // Check if we are running Windows 10.0.18362.x or above as required
+        HRESULT hr = WindowsVersionHelper::EqualOrAboveWindows10Version(18362);
+        if (FAILED(hr))
+        {
+            throw_hresult(hr);
+        }
+        std::cout << "Person Pose Cascade C++/WinRT Non-packaged(win32) console App: Step in front of the camera" << std::endl;
+        std::cout << "Optional arguments: -workers <amount of persons evaluated concurrently>, -padding <fraction of the person box added on each side>" << std::endl;
+
+        // Set and run skills
+        try
+        {
+            // Create instances of the skills
+            auto objectDetectorSkill = CreateSkill<ObjectDetectorSkill>(ObjectDetectorDescriptor().as<ISkillDescriptor>());
+            auto skeletalDetectorSkill = CreateSkill<SkeletalDetectorSkill>(SkeletalDetectorDescriptor().as<ISkillDescriptor>());
+            std::cout << std::fixed;
+            std::cout.precision(3);
+
+            // Create the cascade running SkeletalDetector on the persons found by ObjectDetector
+            PersonPoseCascade::Options options;
+            options.workerCount = std::max(2u, std::thread::hardware_concurrency() / 2);
+            if (auto workerCount = FindOptionValue("-workers"))
+            {
+                options.workerCount = (uint32_t)std::max(1, atoi(workerCount));
+            }
+            if (auto padding = FindOptionValue("-padding"))
+            {
+                options.cropPadding = (float)atof(padding);
+            }
+            PersonPoseCascade cascade(objectDetectorSkill, skeletalDetectorSkill, options);
+            std::cout << "Evaluating up to " << cascade.WorkerCount() << " persons concurrently" << std::endl;
+
+            // Create a mutex to orchestrate skill evaluation one at a time
+            winrt::slim_mutex lock;
+
+            // Initialize Camera and register a frame callback handler
+            auto cameraHelper = std::shared_ptr<CameraHelper>(
+                CameraHelper::CreateCameraHelper(
+                    [&](std::string failureMessage) // lambda function that acts as callback for failure event
+                    {
+                        std::cerr << failureMessage;
+                        return 1;
+                    },
+                    [&](VideoFrame const& videoFrame) // lambda function that acts as callback for new frame event
+                    {
+                        // Lock context so multiple overlapping events from FrameReader do not race for the resources.
+                        if (!lock.try_lock())
+                        {
+                            return;
+                        }
+
+                        auto persons = cascade.Evaluate(videoFrame);
+                        auto& timings = cascade.LastTimings();
+
+                        // Display the time spent detecting persons then evaluating their skeletons, along with the joints found for each person
+                        std::ostringstream line;
+                        line << std::fixed << std::setprecision(3);
+                        line << "persons: " << timings.evaluatedPersonCount << "/" << timings.detectedPersonCount
+                            << " | detect: " << timings.detectMs << "ms | pose: " << timings.poseMs << "ms | ";
+                        if (persons.empty())
+                        {
+                            line << "---------------- No person detected ----------------";
+                        }
+                        for (size_t i = 0; i < persons.size(); i++)
+                        {
+                            line << "<-P" << i + 1 << "->" << persons[i].limbs.size() << " limbs";
+                            if (!persons[i].limbs.empty())
+                            {
+                                auto& joint = persons[i].limbs[0].Joint1;
+                                line << " (" << (float)joint.X << "," << (float)joint.Y << ")";
+                            }
+                            line << "|";
+                        }
+                        std::cout << line.str() << "\r";
+
+                        videoFrame.Close();
+
+                        lock.unlock();
+                    }));
+
+            std::cout << "\t\t\t\t\t\t\t\t...press enter to Stop" << std::endl;
+
+            // Wait for enter keypress
+            while (std::cin.get() != '\n');
+
+            std::cout << std::endl << "Key pressed.. exiting";
+
+            // De-initialize the MediaCapture and FrameReader
+            cameraHelper->Cleanup();
+
+            // Write the events traced while processing frames, when built with SKILLS_SAMPLES_ENABLE_TRACING
+            SAMPLES_TRACE_DUMP("PersonPoseCascadeSample_Desktop.trace.json");
+        }
+        catch (hresult_error const& ex)
+        {
+            std::wcerr << "Error:" << ex.message().c_str() << ":" << std::hex << ex.code().value << std::endl;
+            return ex.code().value;
+        }
+        catch (std::exception const& ex)
+        {
+            std::cerr << "Error:" << ex.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    catch (hresult_error const& ex)
+    {
+        std::cerr << "Error:" << std::hex << ex.code() << ":" << ex.message().c_str();
+    }
+}
@@ -0,0 +1,452 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "PipelineConfig.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <initializer_list>
+#include <sstream>
+#include <utility>
+#include <winrt/Windows.Data.Json.h>
+#include <winrt/Windows.Foundation.Collections.h>
+
+using namespace winrt;
+using namespace winrt::Windows::Data::Json;
+
+//
+// Helper class reading the values of a JSON configuration and collecting the errors found along with their
+// location, i.e. "skills[1].device", so that all of them are reported at once instead of one per run
+//
+class ConfigReader
+{
+public:
+    const std::vector<std::string>& Errors() const { return m_errors; }
+
+    void AddError(std::string const& path, std::string const& message)
+    {
+        m_errors.push_back(path + " " + message);
+    }
+
+    static std::string Member(std::string const& path, const char* name)
+    {
+        return path.empty() ? name : path + "." + name;
+    }
+
+    static std::string Item(std::string const& path, uint32_t index)
+    {
+        return path + "[" + std::to_string(index) + "]";
+    }
+
+    //
+    // Report members other than the expected ones, since a misspelled setting would otherwise silently keep its default value
+    //
+    void CheckMembers(JsonObject const& object, std::string const& path, std::initializer_list<const char*> names)
+    {
+        for (auto&& member : object)
+        {
+            std::string name = to_string(member.Key());
+            if (std::none_of(names.begin(), names.end(), [&](const char* knownName) { return name == knownName; }))
+            {
+                AddError(Member(path, name.c_str()), "is not a known setting");
+            }
+        }
+    }
+
+    //
+    // Look up a member expected to have the specified type, reports an error if it is missing while required or has another type
+    //
+    bool Find(JsonObject const& object, std::string const& path, const char* name, JsonValueType type, bool isRequired)
+    {
+        hstring key = to_hstring(name);
+        if (!object.HasKey(key))
+        {
+            if (isRequired)
+            {
+                AddError(Member(path, name), "is required");
+            }
+            return false;
+        }
+        if (object.GetNamedValue(key).ValueType() != type)
+        {
+            AddError(Member(path, name), std::string("must be ") + TypeName(type));
+            return false;
+        }
+        return true;
+    }
+
+    JsonObject ReadObject(JsonObject const& object, std::string const& path, const char* name, bool isRequired = false)
+    {
+        return Find(object, path, name, JsonValueType::Object, isRequired) ? object.GetNamedObject(to_hstring(name)) : nullptr;
+    }
+
+    JsonArray ReadArray(JsonObject const& object, std::string const& path, const char* name, bool isRequired = false)
+    {
+        return Find(object, path, name, JsonValueType::Array, isRequired) ? object.GetNamedArray(to_hstring(name)) : nullptr;
+    }
+
+    std::string ReadString(JsonObject const& object, std::string const& path, const char* name, bool isRequired = false)
+    {
+        return Find(object, path, name, JsonValueType::String, isRequired) ? to_string(object.GetNamedString(to_hstring(name))) : std::string();
+    }
+
+    bool ReadBool(JsonObject const& object, std::string const& path, const char* name, bool defaultValue)
+    {
+        return Find(object, path, name, JsonValueType::Boolean, false) ? object.GetNamedBoolean(to_hstring(name)) : defaultValue;
+    }
+
+    double ReadNumber(JsonObject const& object, std::string const& path, const char* name, double defaultValue, double minValue, double maxValue)
+    {
+        if (!Find(object, path, name, JsonValueType::Number, false))
+        {
+            return defaultValue;
+        }
+        double value = object.GetNamedNumber(to_hstring(name));
+        if (value < minValue || value > maxValue)
+        {
+            std::ostringstream message;
+            message << "must range between " << minValue << " and " << maxValue;
+            AddError(Member(path, name), message.str());
+            return defaultValue;
+        }
+        return value;
+    }
+
+    uint32_t ReadInteger(JsonObject const& object, std::string const& path, const char* name, uint32_t defaultValue, uint32_t minValue, uint32_t maxValue)
+    {
+        double value = ReadNumber(object, path, name, defaultValue, minValue, maxValue);
+        if (value != (double)(uint32_t)value)
+        {
+            AddError(Member(path, name), "must be an integer");
+            return defaultValue;
+        }
+        return (uint32_t)value;
+    }
+
+    //
+    // Read a string member naming one of the values of an enum
+    //
+    template <typename T>
+    T ReadEnum(
+        JsonObject const& object,
+        std::string const& path,
+        const char* name,
+        T defaultValue,
+        std::initializer_list<std::pair<const char*, T>> values,
+        bool isRequired = false)
+    {
+        if (!Find(object, path, name, JsonValueType::String, isRequired))
+        {
+            return defaultValue;
+        }
+        std::string value = to_string(object.GetNamedString(to_hstring(name)));
+        for (auto&& namedValue : values)
+        {
+            if (value == namedValue.first)
+            {
+                return namedValue.second;
+            }
+        }
+        std::string message = "must be one of";
+        for (auto&& namedValue : values)
+        {
+            message += std::string(" ") + namedValue.first;
+        }
+        AddError(Member(path, name), message);
+        return defaultValue;
+    }
+
+private:
+    static const char* TypeName(JsonValueType type)
+    {
+        switch (type)
+        {
+        case JsonValueType::Object:
+            return "an object";
+        case JsonValueType::Array:
+            return "an array";
+        case JsonValueType::String:
+            return "a string";
+        case JsonValueType::Number:
+            return "a number";
+        case JsonValueType::Boolean:
+            return "true or false";
+        default:
+            return "null";
+        }
+    }
+
+    std::vector<std::string> m_errors;
+};
+
+const char* PipelineConfig::SkillTypeName(SkillType type)
+{
+    switch (type)
+    {
+    case SkillType::ConceptTagger:
+        return "ConceptTagger";
+    case SkillType::SkeletalDetector:
+        return "SkeletalDetector";
+    default:
+        return "ObjectDetector";
+    }
+}
+
+//
+// Read the frame source and check that the settings it uses are consistent with its type
+//
+static void ParseSource(ConfigReader& reader, JsonObject const& object, PipelineConfig::Source& source)
+{
+    const std::string path = "source";
+    reader.CheckMembers(object, path, { "type", "path", "fast", "record", "deadlineMs" });
+    source.type = reader.ReadEnum(object, path, "type", PipelineConfig::SourceType::Camera, {
+        { "camera", PipelineConfig::SourceType::Camera },
+        { "replay", PipelineConfig::SourceType::Replay },
+        { "folder", PipelineConfig::SourceType::Folder } }, true);
+    source.path = reader.ReadString(object, path, "path");
+    source.fast = reader.ReadBool(object, path, "fast", false);
+    source.recordPath = reader.ReadString(object, path, "record");
+    source.deadlineMs = reader.ReadNumber(object, path, "deadlineMs", 0.0, 0.0, 60000.0);
+
+    std::error_code error;
+    switch (source.type)
+    {
+    case PipelineConfig::SourceType::Camera:
+        if (!source.path.empty())
+        {
+            reader.AddError("source.path", "is only used by replay and folder sources");
+        }
+        break;
+    case PipelineConfig::SourceType::Replay:
+        if (source.path.empty())
+        {
+            reader.AddError("source.path", "is required by replay sources");
+        }
+        else if (!std::filesystem::is_regular_file(source.path, error))
+        {
+            reader.AddError("source.path", "must be an existing recording, \"" + source.path + "\" was not found");
+        }
+        break;
+    case PipelineConfig::SourceType::Folder:
+        if (source.path.empty())
+        {
+            reader.AddError("source.path", "is required by folder sources");
+        }
+        else if (!std::filesystem::is_directory(source.path, error))
+        {
+            reader.AddError("source.path", "must be an existing folder, \"" + source.path + "\" was not found");
+        }
+        break;
+    }
+    if (source.fast && source.type != PipelineConfig::SourceType::Replay)
+    {
+        reader.AddError("source.fast", "is only used by replay sources");
+    }
+    if (!source.recordPath.empty() && source.type != PipelineConfig::SourceType::Camera)
+    {
+        reader.AddError("source.record", "is only used by camera sources");
+    }
+}
+
+//
+// Read the skills, each identified by a unique name
+//
+static void ParseSkills(ConfigReader& reader, JsonArray const& array, std::vector<PipelineConfig::Skill>& skills)
+{
+    if (array.Size() == 0)
+    {
+        reader.AddError("skills", "must declare at least one skill");
+    }
+    for (uint32_t i = 0; i < array.Size(); i++)
+    {
+        std::string path = ConfigReader::Item("skills", i);
+        if (array.GetAt(i).ValueType() != JsonValueType::Object)
+        {
+            reader.AddError(path, "must be an object");
+            continue;
+        }
+        JsonObject object = array.GetObjectAt(i);
+        reader.CheckMembers(object, path, { "name", "skill", "device", "parameters" });
+
+        PipelineConfig::Skill skill;
+        skill.name = reader.ReadString(object, path, "name", true);
+        skill.type = reader.ReadEnum(object, path, "skill", PipelineConfig::SkillType::ObjectDetector, {
+            { "ObjectDetector", PipelineConfig::SkillType::ObjectDetector },
+            { "ConceptTagger", PipelineConfig::SkillType::ConceptTagger },
+            { "SkeletalDetector", PipelineConfig::SkillType::SkeletalDetector } }, true);
+        skill.device = reader.ReadEnum(object, path, "device", PipelineConfig::Device::Any, {
+            { "any", PipelineConfig::Device::Any },
+            { "cpu", PipelineConfig::Device::Cpu },
+            { "gpu", PipelineConfig::Device::Gpu } });
+
+        if (auto parameters = reader.ReadObject(object, path, "parameters"))
+        {
+            std::string parametersPath = ConfigReader::Member(path, "parameters");
+            if (skill.type == PipelineConfig::SkillType::ConceptTagger)
+            {
+                reader.CheckMembers(parameters, parametersPath, { "topX", "threshold" });
+                skill.topX = reader.ReadInteger(parameters, parametersPath, "topX", skill.topX, 1, 100);
+                skill.threshold = (float)reader.ReadNumber(parameters, parametersPath, "threshold", skill.threshold, 0.0, 1.0);
+            }
+            else
+            {
+                reader.AddError(parametersPath, std::string("are not supported by ") + PipelineConfig::SkillTypeName(skill.type));
+            }
+        }
+
+        if (!skill.name.empty())
+        {
+            auto sameName = std::find_if(skills.begin(), skills.end(), [&](PipelineConfig::Skill const& other) { return other.name == skill.name; });
+            if (sameName != skills.end())
+            {
+                reader.AddError(ConfigReader::Member(path, "name"), "\"" + skill.name + "\" is already used by skills[" + std::to_string(sameName - skills.begin()) + "]");
+            }
+        }
+        skills.push_back(skill);
+    }
+}
+
+//
+// Read the outputs and check that they reference declared skills that DetectionLogger can log
+//
+static void ParseOutputs(
+    ConfigReader& reader,
+    JsonArray const& array,
+    std::vector<PipelineConfig::Skill> const& skills,
+    std::vector<PipelineConfig::Output>& outputs)
+{
+    int32_t consoleOutputIndex = -1;
+    for (uint32_t i = 0; i < array.Size(); i++)
+    {
+        std::string path = ConfigReader::Item("outputs", i);
+        if (array.GetAt(i).ValueType() != JsonValueType::Object)
+        {
+            reader.AddError(path, "must be an object");
+            continue;
+        }
+        JsonObject object = array.GetObjectAt(i);
+
+        PipelineConfig::Output output;
+        output.type = reader.ReadEnum(object, path, "type", PipelineConfig::OutputType::Console, {
+            { "console", PipelineConfig::OutputType::Console },
+            { "log", PipelineConfig::OutputType::Log } }, true);
+        if (output.type == PipelineConfig::OutputType::Log)
+        {
+            reader.CheckMembers(object, path, { "type", "skill", "format", "path", "queueCapacity" });
+            output.skill = reader.ReadString(object, path, "skill", true);
+            output.format = reader.ReadEnum(object, path, "format", DetectionLogger::Format::Text, {
+                { "text", DetectionLogger::Format::Text },
+                { "json", DetectionLogger::Format::Json } });
+            output.path = reader.ReadString(object, path, "path");
+            output.queueCapacity = reader.ReadInteger(object, path, "queueCapacity", output.queueCapacity, 16, 1 << 20);
+
+            auto skill = std::find_if(skills.begin(), skills.end(), [&](PipelineConfig::Skill const& other) { return other.name == output.skill; });
+            if (!output.skill.empty() && skill == skills.end())
+            {
+                reader.AddError(ConfigReader::Member(path, "skill"), "\"" + output.skill + "\" is not a declared skill");
+            }
+            else if (skill != skills.end() && skill->type == PipelineConfig::SkillType::ConceptTagger)
+            {
+                reader.AddError(ConfigReader::Member(path, "skill"), "must be an ObjectDetector or SkeletalDetector skill, ConceptTagger results cannot be logged");
+            }
+
+            for (uint32_t j = 0; j < outputs.size(); j++)
+            {
+                if (!output.path.empty() && outputs[j].path == output.path)
+                {
+                    reader.AddError(ConfigReader::Member(path, "path"), "\"" + output.path + "\" is already written by outputs[" + std::to_string(j) + "]");
+                }
+            }
+        }
+        else
+        {
+            reader.CheckMembers(object, path, { "type" });
+        }
+
+        // Outputs writing to the console refresh the same line, a second one would overwrite the first
+        if (output.type == PipelineConfig::OutputType::Console || output.path.empty())
+        {
+            if (consoleOutputIndex >= 0)
+            {
+                reader.AddError(path, "writes to the console like outputs[" + std::to_string(consoleOutputIndex) + "], only one output can");
+            }
+            consoleOutputIndex = (int32_t)i;
+        }
+        outputs.push_back(output);
+    }
+}
+
+PipelineConfig PipelineConfig::Parse(std::string const& json)
+{
+    JsonObject root = nullptr;
+    if (!JsonObject::TryParse(to_hstring(json), root))
+    {
+        throw hresult_invalid_argument(L"Error: the pipeline configuration is not a valid JSON object");
+    }
+
+    ConfigReader reader;
+    PipelineConfig config;
+    reader.CheckMembers(root, "", { "source", "threads", "bindings", "queue", "skills", "outputs" });
+    if (auto source = reader.ReadObject(root, "", "source", true))
+    {
+        ParseSource(reader, source, config.source);
+    }
+    config.threadCount = reader.ReadInteger(root, "", "threads", config.threadCount, 0, 256);
+    config.bindingCount = reader.ReadInteger(root, "", "bindings", config.bindingCount, 1, 64);
+
+    if (auto queue = reader.ReadObject(root, "", "queue"))
+    {
+        reader.CheckMembers(queue, "queue", { "capacity", "dropPolicy" });
+        config.queue.capacity = reader.ReadInteger(queue, "queue", "capacity", config.queue.capacity, 1, 1024);
+        config.queue.dropPolicy = reader.ReadEnum(queue, "queue", "dropPolicy", config.queue.dropPolicy, {
+            { "dropNewest", DropPolicy::DropNewest },
+            { "dropOldest", DropPolicy::DropOldest },
+            { "block", DropPolicy::Block } });
+    }
+
+    // Blocking the camera frame handler would stall FrameReader, which then drops frames on its own
+    if (config.queue.dropPolicy == DropPolicy::Block && config.source.type == SourceType::Camera)
+    {
+        reader.AddError("queue.dropPolicy", "cannot be block with a camera source, use dropNewest or dropOldest");
+    }
+
+    if (auto skills = reader.ReadArray(root, "", "skills", true))
+    {
+        ParseSkills(reader, skills, config.skills);
+    }
+
+    if (auto outputs = reader.ReadArray(root, "", "outputs"))
+    {
+        ParseOutputs(reader, outputs, config.skills, config.outputs);
+    }
+    else
+    {
+        config.outputs.push_back(Output()); // a summary line per frame on the console
+    }
+
+    if (!reader.Errors().empty())
+    {
+        std::string message = "Error: invalid pipeline configuration";
+        for (auto&& error : reader.Errors())
+        {
+            message += "\n  " + error;
+        }
+        throw hresult_invalid_argument(to_hstring(message));
+    }
+    return config;
+}
+
+PipelineConfig PipelineConfig::Load(std::string const& filePath)
+{
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file)
+    {
+        throw hresult_invalid_argument(to_hstring("Error: could not open the pipeline configuration " + filePath));
+    }
+    std::string json((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // Skip the UTF-8 byte order mark editors may add
+    if (json.compare(0, 3, "\xEF\xBB\xBF") == 0)
+    {
+        json.erase(0, 3);
+    }
+    return Parse(json);
+}
@@ -0,0 +1,117 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <winrt/Windows.Foundation.h>
+
+#include "DetectionLogger.h"
+
+//
+// Declarative description of a pipeline run by PipelineRunner: where frames come from, which skills evaluate them,
+// how many frames are evaluated concurrently, how frames queue up when evaluation falls behind and where results go.
+// It is loaded from a JSON file such as:
+//
+// {
+//     "source": { "type": "camera", "deadlineMs": 200 },
+//     "threads": 4,
+//     "bindings": 2,
+//     "queue": { "capacity": 2, "dropPolicy": "dropOldest" },
+//     "skills": [
+//         { "name": "objects", "skill": "ObjectDetector", "device": "gpu" },
+//         { "name": "tags", "skill": "ConceptTagger", "parameters": { "topX": 3, "threshold": 0.7 } }
+//     ],
+//     "outputs": [
+//         { "type": "console" },
+//         { "type": "log", "skill": "objects", "format": "json", "path": "objects.jsonl" }
+//     ]
+// }
+//
+// The whole file is validated before anything is created: unknown keys, missing or ill-typed values, out of range
+// numbers and references to undeclared skills are all reported at once with their location in the file.
+//
+struct PipelineConfig
+{
+    enum class SourceType
+    {
+        Camera,
+        Replay, // a session recorded with FrameRecorder
+        Folder // .jpg and .png images of a folder, in name order
+    };
+
+    enum class DropPolicy
+    {
+        DropNewest, // frames arriving while the queue is full are discarded
+        DropOldest, // the oldest queued frame makes room for the one arriving
+        Block // the source waits for room, only meaningful with replay and folder sources
+    };
+
+    enum class SkillType
+    {
+        ObjectDetector,
+        ConceptTagger,
+        SkeletalDetector
+    };
+
+    enum class Device
+    {
+        Any, // the default device of the skill
+        Cpu,
+        Gpu
+    };
+
+    enum class OutputType
+    {
+        Console, // a summary line per frame
+        Log // the results of a skill logged with DetectionLogger
+    };
+
+    struct Source
+    {
+        SourceType type = SourceType::Camera;
+        std::string path; // recording or folder
+        bool fast = false; // replay frames as fast as they are handled instead of with their recorded timing
+        std::string recordPath; // camera session recorded there if not empty
+        double deadlineMs = 0.0; // frames older than that are discarded, 0 to evaluate all frames
+    };
+
+    struct Queue
+    {
+        uint32_t capacity = 2; // in frames
+        DropPolicy dropPolicy = DropPolicy::DropNewest;
+    };
+
+    struct Skill
+    {
+        std::string name; // identifies the skill in outputs and statistics
+        SkillType type = SkillType::ObjectDetector;
+        Device device = Device::Any;
+        uint32_t topX = 3; // ConceptTagger: amount of tags reported
+        float threshold = 0.7f; // ConceptTagger: score above which tags are reported
+    };
+
+    struct Output
+    {
+        OutputType type = OutputType::Console;
+        std::string skill; // Log: name of the logged skill
+        DetectionLogger::Format format = DetectionLogger::Format::Text;
+        std::string path; // Log: file written, the console is used if empty
+        uint32_t queueCapacity = 4096; // Log: in records
+    };
+
+    Source source;
+    uint32_t threadCount = 0; // workers of the thread pool evaluating skills, 0 for one per logical processor
+    uint32_t bindingCount = 1; // sets of skill bindings, that is frames evaluated concurrently
+    Queue queue;
+    std::vector<Skill> skills;
+    std::vector<Output> outputs;
+
+    // Parse and validate a configuration, throws hresult_invalid_argument listing every error found
+    static PipelineConfig Parse(std::string const& json);
+
+    // Read, parse and validate a configuration file, throws hresult_invalid_argument if it is missing or invalid
+    static PipelineConfig Load(std::string const& filePath);
+
+    static const char* SkillTypeName(SkillType type);
+};
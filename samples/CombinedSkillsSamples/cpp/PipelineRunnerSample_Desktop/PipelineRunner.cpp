@@ -0,0 +1,681 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "PipelineRunner.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <winrt/Windows.Foundation.Collections.h>
+#include <winrt/Windows.Graphics.Imaging.h>
+#include <winrt/Windows.Storage.h>
+#include <winrt/Windows.Storage.Streams.h>
+
+#include "SoftwareBitmapHelper_cppwinrt.h"
+#include "Tracing.h"
+#include "winrt/Microsoft.AI.Skills.Vision.ConceptTagger.h"
+#include "winrt/Microsoft.AI.Skills.Vision.ObjectDetector.h"
+#include "winrt/Microsoft.AI.Skills.Vision.SkeletalDetector.h"
+
+using namespace winrt;
+using namespace winrt::Windows::Foundation;
+using namespace winrt::Windows::Foundation::Collections;
+using namespace winrt::Windows::Graphics::Imaging;
+using namespace winrt::Windows::Media;
+using namespace winrt::Windows::Storage;
+using namespace winrt::Windows::Storage::Streams;
+
+using namespace Microsoft::AI::Skills::SkillInterface;
+using namespace Microsoft::AI::Skills::Vision::ConceptTagger;
+using namespace Microsoft::AI::Skills::Vision::ObjectDetector;
+using namespace Microsoft::AI::Skills::Vision::SkeletalDetector;
+
+// enum to string lookup table for ObjectKind, indexed by ObjectKind + 1 since ObjectKind::Undefined is -1
+static constexpr const char* ObjectKindLookup[] = {
+    "Undefined",
+    "Person",
+    "Bicycle",
+    "Car",
+    "Motorbike",
+    "Aeroplane",
+    "Bus",
+    "Train",
+    "Truck",
+    "Boat",
+    "TrafficLight",
+    "FireHydrant",
+    "StopSign",
+    "ParkingMeter",
+    "Bench",
+    "Bird",
+    "Cat",
+    "Dog",
+    "Horse",
+    "Sheep",
+    "Cow",
+    "Elephant",
+    "Bear",
+    "Zebra",
+    "Giraffe",
+    "Backpack",
+    "Umbrella",
+    "Handbag",
+    "Tie",
+    "Suitcase",
+    "Frisbee",
+    "Skis",
+    "Snowboard",
+    "SportsBall",
+    "Kite",
+    "BaseballBat",
+    "BaseballGlove",
+    "Skateboard",
+    "Surfboard",
+    "TennisRacket",
+    "Bottle",
+    "WineGlass",
+    "Cup",
+    "Fork",
+    "Knife",
+    "Spoon",
+    "Bowl",
+    "Banana",
+    "Apple",
+    "Sandwich",
+    "Orange",
+    "Broccoli",
+    "Carrot",
+    "HotDog",
+    "Pizza",
+    "Donut",
+    "Cake",
+    "Chair",
+    "Sofa",
+    "PottedPlant",
+    "Bed",
+    "DiningTable",
+    "Toilet",
+    "Tvmonitor",
+    "Laptop",
+    "Mouse",
+    "Remote",
+    "Keyboard",
+    "CellPhone",
+    "Microwave",
+    "Oven",
+    "Toaster",
+    "Sink",
+    "Refrigerator",
+    "Book",
+    "Clock",
+    "Vase",
+    "Scissors",
+    "TeddyBear",
+    "HairDryer",
+    "Toothbrush",
+};
+static_assert(sizeof(ObjectKindLookup) / sizeof(ObjectKindLookup[0]) == (size_t)ObjectKind::Toothbrush + 2, "ObjectKindLookup must name every ObjectKind");
+
+static const char* ObjectKindName(int32_t kind)
+{
+    return (kind >= (int32_t)ObjectKind::Undefined && kind <= (int32_t)ObjectKind::Toothbrush) ? ObjectKindLookup[kind + 1] : nullptr;
+}
+
+// enum to string lookup table for JointLabel
+static constexpr const char* JointLabelLookup[] = {
+    "Nose",
+    "Neck",
+    "RightShoulder",
+    "RightElbow",
+    "RightWrist",
+    "LeftShoulder",
+    "LeftElbow",
+    "LeftWrist",
+    "RightHip",
+    "RightKnee",
+    "RightAnkle",
+    "LeftHip",
+    "LeftKnee",
+    "LeftAnkle",
+    "RightEye",
+    "LeftEye",
+    "RightEar",
+    "LeftEar",
+    "NumJoints",
+};
+static_assert(sizeof(JointLabelLookup) / sizeof(JointLabelLookup[0]) == (size_t)JointLabel::NumJoints + 1, "JointLabelLookup must name every JointLabel");
+
+static const char* JointLabelName(int32_t label)
+{
+    return (label >= 0 && label <= (int32_t)JointLabel::NumJoints) ? JointLabelLookup[label] : nullptr;
+}
+
+// enum to string lookup table for SkillExecutionDeviceKind
+static const std::map<SkillExecutionDeviceKind, std::string> SkillExecutionDeviceKindLookup = {
+    { SkillExecutionDeviceKind::Undefined, "Undefined" },
+    { SkillExecutionDeviceKind::Cpu, "Cpu" },
+    { SkillExecutionDeviceKind::Gpu, "Gpu" },
+    { SkillExecutionDeviceKind::Vpu, "Vpu" },
+    { SkillExecutionDeviceKind::Fpga, "Fpga" },
+    { SkillExecutionDeviceKind::Cloud, "Cloud" }
+};
+
+static float ElapsedMs(std::chrono::high_resolution_clock::time_point begin)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - begin).count() / 1000000.0f;
+}
+
+//
+// Decode a .jpg or .png file into a BGRA8 VideoFrame
+//
+static VideoFrame LoadVideoFrameFromImageFile(std::filesystem::path const& filePath)
+{
+    StorageFile file = StorageFile::GetFileFromPathAsync(std::filesystem::absolute(filePath).wstring()).get();
+    IRandomAccessStream stream = file.OpenAsync(FileAccessMode::Read).get();
+    BitmapDecoder decoder = BitmapDecoder::CreateAsync(stream).get();
+    SoftwareBitmap softwareBitmap = SoftwareBitmap::Convert(decoder.GetSoftwareBitmapAsync().get(), BitmapPixelFormat::Bgra8, BitmapAlphaMode::Premultiplied);
+    stream.Close();
+    return VideoFrame::CreateWithSoftwareBitmap(softwareBitmap);
+}
+
+static WorkStealingThreadPool::Options ThreadPoolOptions(PipelineConfig const& config)
+{
+    WorkStealingThreadPool::Options options;
+    options.workerCount = config.threadCount;
+    return options;
+}
+
+PipelineRunner::PipelineRunner(PipelineConfig const& config)
+    : m_config(config),
+    m_pool(ThreadPoolOptions(config)),
+    m_queue(config.queue.capacity),
+    m_deadlinePolicy(std::make_shared<FrameDeadlinePolicy>(config.source.deadlineMs))
+{
+    for (auto&& skillConfig : m_config.skills)
+    {
+        m_skills.push_back(CreateSkill(skillConfig));
+    }
+
+    // Each graph creates its own bindings of the shared skills, all of them reading the frame set as the "frame" input
+    for (uint32_t i = 0; i < m_config.bindingCount; i++)
+    {
+        auto pipeline = std::make_unique<Pipeline>();
+        pipeline->graph = std::make_unique<SkillGraph>(SkillGraph::WorkStealingScheduler(m_pool));
+        for (size_t skillIndex = 0; skillIndex < m_skills.size(); skillIndex++)
+        {
+            auto& skill = m_skills[skillIndex];
+            auto node = pipeline->graph->AddNode(m_config.skills[skillIndex].name, skill);
+            pipeline->graph->AddInput("frame", node, SkillGraph::FindFeatureName(skill.SkillDescriptor().InputFeatureDescriptors(), SkillFeatureKind::Image));
+        }
+        pipeline->graph->Build();
+        pipeline->evaluateMsSums.assign(m_skills.size(), 0.0);
+        m_pipelines.push_back(std::move(pipeline));
+    }
+
+    for (auto&& output : m_config.outputs)
+    {
+        if (output.type != PipelineConfig::OutputType::Log)
+        {
+            m_loggers.push_back(nullptr);
+            continue;
+        }
+        auto skillConfig = std::find_if(m_config.skills.begin(), m_config.skills.end(), [&](PipelineConfig::Skill const& skill) { return skill.name == output.skill; });
+        DetectionLogger::Options options;
+        options.format = output.format;
+        options.filePath = output.path;
+        options.writeToConsole = output.path.empty();
+        options.queueCapacity = output.queueCapacity;
+        if (skillConfig->type == PipelineConfig::SkillType::SkeletalDetector)
+        {
+            options.noResultText = "---------------- No body detected ----------------";
+            options.resultName = "bodies";
+            m_loggers.push_back(std::make_unique<DetectionLogger>(options, JointLabelName));
+        }
+        else
+        {
+            options.noResultText = "---------------- No object detected ----------------";
+            m_loggers.push_back(std::make_unique<DetectionLogger>(options, ObjectKindName));
+        }
+    }
+}
+
+PipelineRunner::~PipelineRunner()
+{
+    Stop();
+}
+
+//
+// Create an instance of a skill on the configured device and display the device it runs on
+//
+ISkill PipelineRunner::CreateSkill(PipelineConfig::Skill const& skillConfig)
+{
+    ISkillDescriptor descriptor = nullptr;
+    switch (skillConfig.type)
+    {
+    case PipelineConfig::SkillType::ConceptTagger:
+        descriptor = ConceptTaggerDescriptor().as<ISkillDescriptor>();
+        break;
+    case PipelineConfig::SkillType::SkeletalDetector:
+        descriptor = SkeletalDetectorDescriptor().as<ISkillDescriptor>();
+        break;
+    default:
+        descriptor = ObjectDetectorDescriptor().as<ISkillDescriptor>();
+        break;
+    }
+
+    ISkill skill = nullptr;
+    if (skillConfig.device == PipelineConfig::Device::Any)
+    {
+        skill = descriptor.CreateSkillAsync().get().as<ISkill>();
+    }
+    else
+    {
+        auto deviceKind = (skillConfig.device == PipelineConfig::Device::Gpu) ? SkillExecutionDeviceKind::Gpu : SkillExecutionDeviceKind::Cpu;
+        for (auto&& device : descriptor.GetSupportedExecutionDevicesAsync().get())
+        {
+            if (device.ExecutionDeviceKind() == deviceKind)
+            {
+                skill = descriptor.CreateSkillAsync(device).get().as<ISkill>();
+                break;
+            }
+        }
+        if (skill == nullptr)
+        {
+            throw hresult_invalid_argument(to_hstring(
+                "Error: skill \"" + skillConfig.name + "\" cannot run on " + SkillExecutionDeviceKindLookup.at(deviceKind) + " on this machine"));
+        }
+    }
+
+    std::cout << skillConfig.name << " (" << PipelineConfig::SkillTypeName(skillConfig.type) << ") running on : "
+        << SkillExecutionDeviceKindLookup.at(skill.Device().ExecutionDeviceKind()) << " : " << to_string(skill.Device().Name()) << std::endl;
+    return skill;
+}
+
+void PipelineRunner::Start()
+{
+    if (m_isStarted)
+    {
+        return;
+    }
+    m_isStarted = true;
+
+    for (auto&& pipeline : m_pipelines)
+    {
+        Pipeline* pipelinePointer = pipeline.get();
+        pipeline->worker = std::thread([this, pipelinePointer]() { WorkerLoop(*pipelinePointer); });
+    }
+
+    auto failureHandler = [](std::string failureMessage)
+    {
+        std::cerr << failureMessage << std::endl;
+        return 1;
+    };
+    switch (m_config.source.type)
+    {
+    case PipelineConfig::SourceType::Camera:
+        if (!m_config.source.recordPath.empty())
+        {
+            m_recorder = std::make_shared<FrameRecorder>(m_config.source.recordPath);
+            std::cout << "Recording the camera session to " << m_config.source.recordPath << std::endl;
+        }
+        m_cameraHelper = std::shared_ptr<CameraHelper>(CameraHelper::CreateCameraHelper(
+            failureHandler,
+            [this](VideoFrame const& videoFrame) { Enqueue(videoFrame, false); },
+            m_deadlinePolicy,
+            m_recorder,
+            [](CameraReconnector::Gap const& gap)
+            {
+                std::cout << "Camera recovered after " << (gap.endTime - gap.startTime) / FrameDeadlinePolicy::TicksPerMs
+                    << "ms | ~" << gap.lostFrameCount << " frames lost" << std::endl;
+            }));
+        break;
+    case PipelineConfig::SourceType::Replay:
+        m_replaySource = std::make_unique<FrameReplaySource>(
+            m_config.source.path,
+            m_config.source.fast ? FrameReplaySource::Timing::AsFastAsPossible : FrameReplaySource::Timing::Recorded,
+            failureHandler,
+            [this](VideoFrame const& videoFrame) { Enqueue(videoFrame, true); },
+            m_deadlinePolicy);
+        break;
+    case PipelineConfig::SourceType::Folder:
+        m_folderThread = std::thread([this]() { RunFolderSource(); });
+        break;
+    }
+}
+
+void PipelineRunner::WaitForSource()
+{
+    if (m_replaySource != nullptr)
+    {
+        m_replaySource->Wait();
+    }
+    if (m_folderThread.joinable())
+    {
+        m_folderThread.join();
+    }
+}
+
+void PipelineRunner::Stop()
+{
+    if (!m_isStarted)
+    {
+        return;
+    }
+    m_isStarted = false;
+
+    // Stop the source first so that no frame arrives once the queue is closed
+    m_isStopping = true;
+    if (m_cameraHelper != nullptr)
+    {
+        m_cameraHelper->Cleanup();
+    }
+    if (m_recorder != nullptr)
+    {
+        m_recorder->Close();
+    }
+    if (m_replaySource != nullptr)
+    {
+        m_replaySource->Stop();
+    }
+    if (m_folderThread.joinable())
+    {
+        m_folderThread.join();
+    }
+
+    m_queue.Close();
+    for (auto&& pipeline : m_pipelines)
+    {
+        if (pipeline->worker.joinable())
+        {
+            pipeline->worker.join();
+        }
+    }
+    for (auto&& logger : m_loggers)
+    {
+        if (logger != nullptr)
+        {
+            logger->Close();
+        }
+    }
+}
+
+//
+// Emit the .jpg and .png images of the source folder in name order, each tagged with the time it was loaded
+//
+void PipelineRunner::RunFolderSource()
+{
+    std::vector<std::filesystem::path> filePaths;
+    for (auto&& entry : std::filesystem::directory_iterator(m_config.source.path))
+    {
+        auto extension = entry.path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return (char)tolower(c); });
+        if (entry.is_regular_file() && (extension == ".jpg" || extension == ".png"))
+        {
+            filePaths.push_back(entry.path());
+        }
+    }
+    std::sort(filePaths.begin(), filePaths.end());
+
+    for (auto&& filePath : filePaths)
+    {
+        if (m_isStopping)
+        {
+            break;
+        }
+        try
+        {
+            VideoFrame videoFrame = LoadVideoFrameFromImageFile(filePath);
+            int64_t captureTime = FrameDeadlinePolicy::SystemRelativeNow();
+            videoFrame.SystemRelativeTime(IReference<TimeSpan>(TimeSpan(captureTime)));
+            if (m_deadlinePolicy->Admit(captureTime))
+            {
+                Enqueue(videoFrame, true);
+            }
+        }
+        catch (hresult_error const& ex)
+        {
+            std::cerr << "Could not load VideoFrame from file: " << filePath.string() << ": " << to_string(ex.message()) << std::endl;
+        }
+    }
+}
+
+//
+// Queue a frame from the source, applying the drop policy if the queue is full.
+// Frames the source does not hand over (isOwned false) are closed once the handler returns and are copied.
+//
+void PipelineRunner::Enqueue(VideoFrame const& frame, bool isOwned)
+{
+    SAMPLES_TRACE_SCOPE("PipelineRunner::Enqueue");
+    m_receivedFrameCount++;
+    auto dropPolicy = m_config.queue.dropPolicy;
+
+    // Do not pay for a copy that would be dropped right away
+    if (dropPolicy == PipelineConfig::DropPolicy::DropNewest && m_queue.Size() >= m_queue.Capacity())
+    {
+        m_droppedFrameCount++;
+        return;
+    }
+
+    QueuedFrame queuedFrame;
+    queuedFrame.captureTime = CameraHelper::GetCaptureTime(frame);
+    queuedFrame.frameId = ++m_nextFrameId;
+    queuedFrame.frame = frame;
+    if (!isOwned)
+    {
+        auto bitmap = SoftwareBitmapHelper::GetSoftwareBitmap(frame);
+        if (bitmap == frame.SoftwareBitmap())
+        {
+            bitmap = SoftwareBitmap::Copy(bitmap);
+        }
+        queuedFrame.frame = VideoFrame::CreateWithSoftwareBitmap(bitmap);
+        queuedFrame.frame.SystemRelativeTime(frame.SystemRelativeTime());
+    }
+
+    switch (dropPolicy)
+    {
+    case PipelineConfig::DropPolicy::Block:
+        m_queue.Push(std::move(queuedFrame));
+        break;
+    case PipelineConfig::DropPolicy::DropOldest:
+        while (!m_queue.TryPush(queuedFrame))
+        {
+            if (m_isStopping)
+            {
+                return;
+            }
+            if (auto oldestFrame = m_queue.TryPop())
+            {
+                oldestFrame->frame.Close();
+                m_droppedFrameCount++;
+            }
+        }
+        break;
+    default:
+        if (!m_queue.TryPush(std::move(queuedFrame)))
+        {
+            m_droppedFrameCount++;
+        }
+        break;
+    }
+}
+
+//
+// Evaluate queued frames with the graph of the pipeline until the queue is closed and drained
+//
+void PipelineRunner::WorkerLoop(Pipeline& pipeline)
+{
+    while (auto queuedFrame = m_queue.Pop())
+    {
+        SAMPLES_TRACE_SET_FRAME_ID(queuedFrame->frameId);
+
+        // The frame may have waited in the queue past the deadline, a newer one is waiting behind it
+        if (queuedFrame->captureTime >= 0 && m_deadlinePolicy->DeadlineMs() > 0
+            && m_deadlinePolicy->AgeMs(queuedFrame->captureTime) > m_deadlinePolicy->DeadlineMs())
+        {
+            m_staleFrameCount++;
+            queuedFrame->frame.Close();
+            continue;
+        }
+
+        try
+        {
+            auto begin = std::chrono::high_resolution_clock::now();
+            {
+                SAMPLES_TRACE_SCOPE("PipelineRunner::Evaluate");
+                pipeline.graph->SetInput("frame", queuedFrame->frame);
+                pipeline.graph->Evaluate();
+            }
+            float graphMs = ElapsedMs(begin);
+            double ageMs = queuedFrame->captureTime >= 0 ? m_deadlinePolicy->RecordResult(queuedFrame->captureTime) : 0.0;
+
+            for (SkillGraph::NodeId node = 0; node < pipeline.graph->NodeCount(); node++)
+            {
+                pipeline.evaluateMsSums[node] += pipeline.graph->LastEvaluateMs(node);
+            }
+            pipeline.evaluatedFrameCount++;
+
+            SAMPLES_TRACE_SCOPE("PipelineRunner::Outputs");
+            WriteOutputs(pipeline, *queuedFrame, graphMs, ageMs);
+        }
+        catch (hresult_error const& ex)
+        {
+            m_failedFrameCount++;
+            std::cerr << "Error evaluating frame " << queuedFrame->frameId << ":" << to_string(ex.message()) << std::endl;
+        }
+        catch (std::exception const& ex)
+        {
+            m_failedFrameCount++;
+            std::cerr << "Error evaluating frame " << queuedFrame->frameId << ":" << ex.what() << std::endl;
+        }
+        queuedFrame->frame.Close();
+    }
+}
+
+//
+// Write the results of a frame to the console summary line and to the logs of the skills they belong to
+//
+void PipelineRunner::WriteOutputs(Pipeline& pipeline, QueuedFrame const& queuedFrame, float graphMs, double ageMs)
+{
+    std::lock_guard<std::mutex> guard(m_outputLock);
+    for (size_t outputIndex = 0; outputIndex < m_config.outputs.size(); outputIndex++)
+    {
+        auto& output = m_config.outputs[outputIndex];
+        if (output.type == PipelineConfig::OutputType::Console)
+        {
+            std::ostringstream line;
+            line << std::fixed << std::setprecision(3);
+            line << "frame " << queuedFrame.frameId << " | age: " << ageMs << "ms | graph: " << graphMs << "ms | ";
+            for (SkillGraph::NodeId node = 0; node < pipeline.graph->NodeCount(); node++)
+            {
+                auto binding = pipeline.graph->Binding(node);
+                auto& skillConfig = m_config.skills[node];
+                line << skillConfig.name << ": " << pipeline.graph->LastEvaluateMs(node) << "ms ";
+                switch (skillConfig.type)
+                {
+                case PipelineConfig::SkillType::ConceptTagger:
+                    line << "[";
+                    for (auto&& tag : binding.as<ConceptTaggerBinding>().GetTopXTagsAboveThreshold(skillConfig.topX, skillConfig.threshold))
+                    {
+                        line << " " << to_string(tag.Name());
+                    }
+                    line << " ] | ";
+                    break;
+                case PipelineConfig::SkillType::SkeletalDetector:
+                    line << "[" << binding.as<SkeletalDetectorBinding>().Bodies().Size() << " bodies] | ";
+                    break;
+                default:
+                    line << "[" << binding.as<ObjectDetectorBinding>().DetectedObjects().Size() << " objects] | ";
+                    break;
+                }
+            }
+            std::cout << line.str() << "\r";
+            continue;
+        }
+
+        auto& logger = m_loggers[outputIndex];
+        auto node = (SkillGraph::NodeId)(std::find_if(m_config.skills.begin(), m_config.skills.end(),
+            [&](PipelineConfig::Skill const& skill) { return skill.name == output.skill; }) - m_config.skills.begin());
+        float evaluateMs = pipeline.graph->LastEvaluateMs(node);
+        auto binding = pipeline.graph->Binding(node);
+        if (m_config.skills[node].type == PipelineConfig::SkillType::SkeletalDetector)
+        {
+            auto bodies = binding.as<SkeletalDetectorBinding>().Bodies();
+            uint32_t limbCount = 0;
+            for (auto&& body : bodies)
+            {
+                limbCount += body.Limbs().Size();
+            }
+            logger->LogFrame(queuedFrame.frameId, 0.0f, evaluateMs, bodies.Size(), limbCount);
+            for (uint32_t i = 0; i < bodies.Size(); i++)
+            {
+                for (auto&& limb : bodies.GetAt(i).Limbs())
+                {
+                    logger->LogLimb(
+                        queuedFrame.frameId, i,
+                        (int32_t)limb.Joint1.Label, limb.Joint1.X, limb.Joint1.Y,
+                        (int32_t)limb.Joint2.Label, limb.Joint2.X, limb.Joint2.Y);
+                }
+            }
+        }
+        else
+        {
+            auto detectedObjects = binding.as<ObjectDetectorBinding>().DetectedObjects();
+            logger->LogFrame(queuedFrame.frameId, 0.0f, evaluateMs, detectedObjects.Size());
+            for (auto&& detectedObject : detectedObjects)
+            {
+                auto rect = detectedObject.Rect();
+                logger->LogObject(queuedFrame.frameId, (int32_t)detectedObject.Kind(), rect.X, rect.Y, rect.Width, rect.Height);
+            }
+        }
+    }
+}
+
+void PipelineRunner::PrintStatistics(std::ostream& stream) const
+{
+    uint64_t evaluatedFrameCount = 0;
+    for (auto&& pipeline : m_pipelines)
+    {
+        evaluatedFrameCount += pipeline->evaluatedFrameCount;
+    }
+
+    stream << std::fixed << std::setprecision(3);
+    stream << "Frames received: " << m_receivedFrameCount << " | evaluated: " << evaluatedFrameCount
+        << " | dropped by the queue: " << m_droppedFrameCount << " | past the deadline: " << m_deadlinePolicy->DiscardedFrameCount() + m_staleFrameCount
+        << " | failed: " << m_failedFrameCount << std::endl;
+    stream << "Queue: capacity " << m_queue.Capacity() << " | max depth " << m_queue.MaxDepth() << " | average depth " << m_queue.AverageDepth()
+        << " | threads: " << m_pool.WorkerCount() << " | bindings: " << m_pipelines.size() << std::endl;
+
+    for (size_t node = 0; node < m_config.skills.size(); node++)
+    {
+        double evaluateMsSum = 0.0;
+        for (auto&& pipeline : m_pipelines)
+        {
+            evaluateMsSum += pipeline->evaluateMsSums[node];
+        }
+        stream << m_config.skills[node].name << ": average " << (evaluatedFrameCount > 0 ? evaluateMsSum / evaluatedFrameCount : 0.0) << "ms" << std::endl;
+    }
+
+    auto& resultAges = m_deadlinePolicy->ResultAges();
+    stream << "Result age: p50 " << resultAges.Percentile(0.5) << "ms | p99 " << resultAges.Percentile(0.99) << "ms | max " << resultAges.MaxMs() << "ms";
+    if (m_deadlinePolicy->DeadlineMs() > 0)
+    {
+        stream << " | late results: " << m_deadlinePolicy->LateResultCount();
+    }
+    stream << std::endl;
+
+    auto reconnectStatistics = (m_cameraHelper != nullptr) ? m_cameraHelper->ReconnectStatistics() : CameraReconnector::Statistics();
+    if (reconnectStatistics.failureCount > 0)
+    {
+        stream << "Camera failures: " << reconnectStatistics.failureCount << " | recovered: " << reconnectStatistics.recoveryCount
+            << " | longest recovery: " << reconnectStatistics.maxRecoveryMs << "ms | frames lost: " << reconnectStatistics.lostFrameCount << std::endl;
+    }
+
+    for (size_t outputIndex = 0; outputIndex < m_loggers.size(); outputIndex++)
+    {
+        if (m_loggers[outputIndex] != nullptr && m_loggers[outputIndex]->DroppedRecordCount() > 0)
+        {
+            stream << "outputs[" << outputIndex << "] dropped " << m_loggers[outputIndex]->DroppedRecordCount() << " records" << std::endl;
+        }
+    }
+}
@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Media.h>
+
+#include "BoundedQueue.h"
+#include "CameraHelper_cppwinrt.h"
+#include "DetectionLogger.h"
+#include "FrameDeadlinePolicy.h"
+#include "FrameRecorder_cppwinrt.h"
+#include "PipelineConfig.h"
+#include "SkillGraph_cppwinrt.h"
+#include "WorkStealingThreadPool.h"
+#include "winrt/Microsoft.AI.Skills.SkillInterface.h"
+
+//
+// Helper class running the pipeline described by a PipelineConfig.
+// Frames from the source are queued, applying the drop policy of the queue when evaluation falls behind, and
+// bindingCount workers each dequeue frames and evaluate them with their own SkillGraph. All graphs share the
+// skill instances and the thread pool the skills are evaluated on, and each graph has its own set of bindings,
+// so that up to bindingCount frames are evaluated concurrently. Results are then written to the configured outputs.
+//
+class PipelineRunner
+{
+public:
+    // Create the skills, their bindings and the outputs, throws if a skill is not supported on the configured device
+    explicit PipelineRunner(PipelineConfig const& config);
+    ~PipelineRunner();
+
+    PipelineRunner(const PipelineRunner&) = delete;
+    PipelineRunner& operator=(const PipelineRunner&) = delete;
+
+    // Start the workers and the source
+    void Start();
+
+    // Wait until a replay or folder source emitted all its frames, returns right away for a camera source
+    void WaitForSource();
+
+    // Stop the source, evaluate the frames still queued and close the outputs
+    void Stop();
+
+    void PrintStatistics(std::ostream& stream) const;
+
+private:
+    struct QueuedFrame
+    {
+        winrt::Windows::Media::VideoFrame frame = nullptr;
+        int64_t captureTime = -1;
+        uint64_t frameId = 0;
+    };
+
+    // Set of bindings and the worker evaluating frames with them
+    struct Pipeline
+    {
+        std::unique_ptr<SkillGraph> graph;
+        std::vector<double> evaluateMsSums; // per node
+        uint64_t evaluatedFrameCount = 0;
+        std::thread worker;
+    };
+
+    winrt::Microsoft::AI::Skills::SkillInterface::ISkill CreateSkill(PipelineConfig::Skill const& skillConfig);
+    void Enqueue(winrt::Windows::Media::VideoFrame const& frame, bool isOwned);
+    void WorkerLoop(Pipeline& pipeline);
+    void WriteOutputs(Pipeline& pipeline, QueuedFrame const& queuedFrame, float graphMs, double ageMs);
+    void RunFolderSource();
+
+    PipelineConfig m_config;
+    WorkStealingThreadPool m_pool;
+    std::vector<winrt::Microsoft::AI::Skills::SkillInterface::ISkill> m_skills; // in the order of m_config.skills
+    std::vector<std::unique_ptr<Pipeline>> m_pipelines;
+    BoundedQueue<QueuedFrame> m_queue;
+    std::shared_ptr<FrameDeadlinePolicy> m_deadlinePolicy;
+    std::vector<std::unique_ptr<DetectionLogger>> m_loggers; // in the order of m_config.outputs, nullptr for the console output
+    std::mutex m_outputLock; // keeps the results of a frame together in the outputs
+
+    // Sources
+    std::shared_ptr<FrameRecorder> m_recorder;
+    std::shared_ptr<CameraHelper> m_cameraHelper;
+    std::unique_ptr<FrameReplaySource> m_replaySource;
+    std::thread m_folderThread;
+    std::atomic<bool> m_isStopping = false;
+    bool m_isStarted = false;
+
+    std::atomic<uint64_t> m_receivedFrameCount = 0;
+    std::atomic<uint64_t> m_droppedFrameCount = 0; // by the drop policy
+    std::atomic<uint64_t> m_staleFrameCount = 0; // past the deadline once dequeued
+    std::atomic<uint64_t> m_failedFrameCount = 0;
+    std::atomic<uint64_t> m_nextFrameId = 0;
+};
@@ -0,0 +1,141 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <winrt/Windows.Foundation.h>
+
+#include "PipelineConfig.h"
+#include "PipelineRunner.h"
+#include "Tracing.h"
+#include "WindowsVersionHelper.h"
+
+using namespace winrt;
+
+static const char* OutputTypeName(PipelineConfig::OutputType type)
+{
+    return (type == PipelineConfig::OutputType::Log) ? "log" : "console";
+}
+
+//
+// Helper method to check if a named flag argument was specified, i.e. "-validate"
+//
+bool HasOption(const char* optionName)
+{
+    for (int i = 1; i < __argc; i++)
+    {
+        if (strcmp(__argv[i], optionName) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//
+// Display what a validated configuration is going to run
+//
+void PrintConfig(PipelineConfig const& config)
+{
+    static const char* SourceTypeNames[] = { "camera", "replay", "folder" };
+    static const char* DropPolicyNames[] = { "dropNewest", "dropOldest", "block" };
+
+    std::cout << "Source: " << SourceTypeNames[(int)config.source.type];
+    if (!config.source.path.empty())
+    {
+        std::cout << " " << config.source.path;
+    }
+    if (config.source.deadlineMs > 0)
+    {
+        std::cout << " | deadline " << config.source.deadlineMs << "ms";
+    }
+    std::cout << std::endl;
+    std::cout << "Threads: " << (config.threadCount > 0 ? std::to_string(config.threadCount) : "one per logical processor")
+        << " | bindings: " << config.bindingCount
+        << " | queue: " << config.queue.capacity << " frames, " << DropPolicyNames[(int)config.queue.dropPolicy] << std::endl;
+    for (auto&& skill : config.skills)
+    {
+        std::cout << "Skill: " << skill.name << " (" << PipelineConfig::SkillTypeName(skill.type) << ")" << std::endl;
+    }
+    for (auto&& output : config.outputs)
+    {
+        std::cout << "Output: " << OutputTypeName(output.type);
+        if (output.type == PipelineConfig::OutputType::Log)
+        {
+            std::cout << " " << output.skill << " to " << (output.path.empty() ? "the console" : output.path);
+        }
+        std::cout << std::endl;
+    }
+}
+
+//
+// App main loop
+//
+int main()
+{
+    try
+    {
+        // Check if we are running Windows 10.0.18362.x or above as required
+        HRESULT hr = WindowsVersionHelper::EqualOrAboveWindows10Version(18362);
+        if (FAILED(hr))
+        {
+            throw_hresult(hr);
+        }
+        std::cout << "Pipeline Runner C++/WinRT Non-packaged(win32) console App" << std::endl;
+        if (__argc < 2 || __argv[1][0] == '-')
+        {
+            std::cout << "Usage: PipelineRunnerSample_Desktop.exe <pipeline configuration file> [-validate]" << std::endl;
+            std::cout << "-validate only checks the configuration and displays what it would run" << std::endl;
+            return 1;
+        }
+
+        try
+        {
+            // Load and validate the whole configuration before creating anything
+            PipelineConfig config = PipelineConfig::Load(__argv[1]);
+            PrintConfig(config);
+            if (HasOption("-validate"))
+            {
+                std::cout << "The pipeline configuration is valid" << std::endl;
+                return 0;
+            }
+
+            PipelineRunner runner(config);
+            runner.Start();
+            if (config.source.type == PipelineConfig::SourceType::Camera)
+            {
+                std::cout << "\t\t\t\t\t\t\t\t...press enter to Stop" << std::endl;
+
+                // Wait for enter keypress
+                while (std::cin.get() != '\n');
+
+                std::cout << std::endl << "Key pressed.. exiting" << std::endl;
+            }
+            else
+            {
+                runner.WaitForSource();
+            }
+            runner.Stop();
+            std::cout << std::endl;
+            runner.PrintStatistics(std::cout);
+
+            // Write the events traced while processing frames, when built with SKILLS_SAMPLES_ENABLE_TRACING
+            SAMPLES_TRACE_DUMP("PipelineRunnerSample_Desktop.trace.json");
+        }
+        catch (hresult_error const& ex)
+        {
+            std::wcerr << "Error:" << ex.message().c_str() << ":" << std::hex << ex.code().value << std::endl;
+            return ex.code().value;
+        }
+        catch (std::exception const& ex)
+        {
+            std::cerr << "Error:" << ex.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    catch (hresult_error const& ex)
+    {
+        std::cerr << "Error:" << std::hex << ex.code() << ":" << ex.message().c_str();
+    }
+}
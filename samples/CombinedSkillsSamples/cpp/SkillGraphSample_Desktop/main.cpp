@@ -0,0 +1,165 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/windows.foundation.collections.h>
+#include <winrt/windows.media.h>
+#include <winrt/windows.system.threading.h>
+
+#include "CameraHelper_cppwinrt.h"
+#include "SkillGraph_cppwinrt.h"
+#include "Tracing.h"
+#include "WindowsVersionHelper.h"
+#include "winrt/Microsoft.AI.Skills.SkillInterface.h"
+#include "winrt/Microsoft.AI.Skills.Vision.ConceptTagger.h"
+#include "winrt/Microsoft.AI.Skills.Vision.ObjectDetector.h"
+
+using namespace winrt;
+using namespace winrt::Windows::Foundation;
+using namespace winrt::Windows::Foundation::Collections;
+using namespace winrt::Windows::System::Threading;
+using namespace winrt::Windows::Media;
+
+using namespace Microsoft::AI::Skills::SkillInterface;
+using namespace Microsoft::AI::Skills::Vision::ConceptTagger;
+using namespace Microsoft::AI::Skills::Vision::ObjectDetector;
+
+// enum to string lookup table for SkillExecutionDeviceKind
+static const std::map<SkillExecutionDeviceKind, std::string> SkillExecutionDeviceKindLookup = {
+    { SkillExecutionDeviceKind::Undefined, "Undefined" },
+    { SkillExecutionDeviceKind::Cpu, "Cpu" },
+    { SkillExecutionDeviceKind::Gpu, "Gpu" },
+    { SkillExecutionDeviceKind::Vpu, "Vpu" },
+    { SkillExecutionDeviceKind::Fpga, "Fpga" },
+    { SkillExecutionDeviceKind::Cloud, "Cloud" }
+};
+
+//
+// Helper method to create an instance of a skill and display the device it runs on
+//
+ISkill CreateSkill(ISkillDescriptor const& skillDescriptor)
+{
+    auto skill = skillDescriptor.CreateSkillAsync().get().as<ISkill>();
+    std::wcout << skillDescriptor.Information().Name().c_str() << L" running on : ";
+    std::cout << SkillExecutionDeviceKindLookup.at(skill.Device().ExecutionDeviceKind());
+    std::wcout << L" : " << skill.Device().Name().c_str() << std::endl;
+    return skill;
+}
+
+//
+// App main loop
+//
+int main()
+{
+    try
+    {
+        // Check if we are running Windows 10.0.18362.x or above as required
+        HRESULT hr = WindowsVersionHelper::EqualOrAboveWindows10Version(18362);
+        if (FAILED(hr))
+        {
+            throw_hresult(hr);
+        }
+        std::cout << "Skill Graph C++/WinRT Non-packaged(win32) console App: Place something in front of the camera" << std::endl;
+
+        // Set and run skills
+        try
+        {
+            // Create instances of the skills
+            auto objectDetectorSkill = CreateSkill(ObjectDetectorDescriptor().as<ISkillDescriptor>());
+            auto conceptTaggerSkill = CreateSkill(ConceptTaggerDescriptor().as<ISkillDescriptor>());
+            std::cout << std::fixed;
+            std::cout.precision(3);
+
+            // Create a graph where both skills are independent branches evaluating the same camera frame concurrently
+            SkillGraph graph;
+            auto objectDetectorNode = graph.AddNode("ObjectDetector", objectDetectorSkill);
+            auto conceptTaggerNode = graph.AddNode("ConceptTagger", conceptTaggerSkill);
+            graph.AddInput("frame", objectDetectorNode, SkillGraph::FindFeatureName(objectDetectorSkill.SkillDescriptor().InputFeatureDescriptors(), SkillFeatureKind::Image));
+            graph.AddInput("frame", conceptTaggerNode, SkillGraph::FindFeatureName(conceptTaggerSkill.SkillDescriptor().InputFeatureDescriptors(), SkillFeatureKind::Image));
+            graph.Build();
+
+            auto objectDetectorBinding = graph.Binding(objectDetectorNode).as<ObjectDetectorBinding>();
+            auto conceptTaggerBinding = graph.Binding(conceptTaggerNode).as<ConceptTaggerBinding>();
+
+            // Create a mutex to orchestrate skill evaluation one at a time
+            winrt::slim_mutex lock;
+
+            // Initialize Camera and register a frame callback handler
+            auto cameraHelper = std::shared_ptr<CameraHelper>(
+                CameraHelper::CreateCameraHelper(
+                    [&](std::string failureMessage) // lambda function that acts as callback for failure event
+                    {
+                        std::cerr << failureMessage;
+                        return 1;
+                    },
+                    [&](VideoFrame const& videoFrame) // lambda function that acts as callback for new frame event
+                    {
+                        // Lock context so multiple overlapping events from FrameReader do not race for the resources.
+                        if (!lock.try_lock())
+                        {
+                            return;
+                        }
+
+                        // Bind the frame once for both skills then evaluate them
+                        auto begin = std::chrono::high_resolution_clock::now();
+                        graph.SetInput("frame", videoFrame);
+                        graph.Evaluate();
+                        auto end = std::chrono::high_resolution_clock::now();
+                        float graphMs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+
+                        // Display the time spent by each skill and by the whole graph, along with the results of both skills
+                        std::ostringstream line;
+                        line << std::fixed << std::setprecision(3);
+                        line << "graph: " << graphMs << "ms | ";
+                        for (SkillGraph::NodeId node = 0; node < graph.NodeCount(); node++)
+                        {
+                            line << graph.NodeName(node) << ": " << graph.LastEvaluateMs(node) << "ms | ";
+                        }
+                        line << "objects: " << objectDetectorBinding.DetectedObjects().Size() << " | tags: ";
+                        for (auto&& tag : conceptTaggerBinding.GetTopXTagsAboveThreshold(3, 0.7f))
+                        {
+                            line << to_string(tag.Name()) << " ";
+                        }
+                        std::cout << line.str() << "\r";
+
+                        videoFrame.Close();
+
+                        lock.unlock();
+                    }));
+
+            std::cout << "\t\t\t\t\t\t\t\t...press enter to Stop" << std::endl;
+
+            // Wait for enter keypress
+            while (std::cin.get() != '\n');
+
+            std::cout << std::endl << "Key pressed.. exiting";
+
+            // De-initialize the MediaCapture and FrameReader
+            cameraHelper->Cleanup();
+
+            // Write the events traced while processing frames, when built with SKILLS_SAMPLES_ENABLE_TRACING
+            SAMPLES_TRACE_DUMP("SkillGraphSample_Desktop.trace.json");
+        }
+        catch (hresult_error const& ex)
+        {
+            std::wcerr << "Error:" << ex.message().c_str() << ":" << std::hex << ex.code().value << std::endl;
+            return ex.code().value;
+        }
+        catch (std::exception const& ex)
+        {
+            std::cerr << "Error:" << ex.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    catch (hresult_error const& ex)
+    {
+        std::cerr << "Error:" << std::hex << ex.code() << ":" << ex.message().c_str();
+    }
+}
@@ -0,0 +1,467 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Foundation.Collections.h>
+#include <winrt/Windows.Graphics.Imaging.h>
+#include <winrt/Windows.Media.h>
+#include <winrt/Windows.Storage.h>
+#include <winrt/Windows.Storage.Streams.h>
+
+#include "SkillHost.h"
+#include "SoftwareBitmapHelper_cppwinrt.h"
+#include "WindowsVersionHelper.h"
+#include "WorkStealingThreadPool.h"
+#include "winrt/Microsoft.AI.Skills.SkillInterface.h"
+#include "winrt/Microsoft.AI.Skills.Vision.ObjectDetector.h"
+
+using namespace winrt;
+using namespace winrt::Windows::Foundation;
+using namespace winrt::Windows::Foundation::Collections;
+using namespace winrt::Windows::Graphics::Imaging;
+using namespace winrt::Windows::Media;
+using namespace winrt::Windows::Storage;
+using namespace winrt::Windows::Storage::Streams;
+
+using namespace Microsoft::AI::Skills::SkillInterface;
+using namespace Microsoft::AI::Skills::Vision::ObjectDetector;
+
+// enum to string lookup table for ObjectKind, indexed by enum value + 1 since ObjectKind::Undefined is -1
+static constexpr const char* ObjectKindLookup[] = {
+    "Undefined",
+    "Person",
+    "Bicycle",
+    "Car",
+    "Motorbike",
+    "Aeroplane",
+    "Bus",
+    "Train",
+    "Truck",
+    "Boat",
+    "TrafficLight",
+    "FireHydrant",
+    "StopSign",
+    "ParkingMeter",
+    "Bench",
+    "Bird",
+    "Cat",
+    "Dog",
+    "Horse",
+    "Sheep",
+    "Cow",
+    "Elephant",
+    "Bear",
+    "Zebra",
+    "Giraffe",
+    "Backpack",
+    "Umbrella",
+    "Handbag",
+    "Tie",
+    "Suitcase",
+    "Frisbee",
+    "Skis",
+    "Snowboard",
+    "SportsBall",
+    "Kite",
+    "BaseballBat",
+    "BaseballGlove",
+    "Skateboard",
+    "Surfboard",
+    "TennisRacket",
+    "Bottle",
+    "WineGlass",
+    "Cup",
+    "Fork",
+    "Knife",
+    "Spoon",
+    "Bowl",
+    "Banana",
+    "Apple",
+    "Sandwich",
+    "Orange",
+    "Broccoli",
+    "Carrot",
+    "HotDog",
+    "Pizza",
+    "Donut",
+    "Cake",
+    "Chair",
+    "Sofa",
+    "PottedPlant",
+    "Bed",
+    "DiningTable",
+    "Toilet",
+    "Tvmonitor",
+    "Laptop",
+    "Mouse",
+    "Remote",
+    "Keyboard",
+    "CellPhone",
+    "Microwave",
+    "Oven",
+    "Toaster",
+    "Sink",
+    "Refrigerator",
+    "Book",
+    "Clock",
+    "Vase",
+    "Scissors",
+    "TeddyBear",
+    "HairDryer",
+    "Toothbrush",
+};
+
+static_assert(sizeof(ObjectKindLookup) / sizeof(ObjectKindLookup[0]) == (size_t)ObjectKind::Toothbrush + 2, "ObjectKindLookup must name every ObjectKind");
+
+//
+// Helper method to retrieve the name of an ObjectKind value, nullptr if unknown
+//
+constexpr const char* ObjectKindName(int32_t kind)
+{
+    return (kind >= (int32_t)ObjectKind::Undefined && kind <= (int32_t)ObjectKind::Toothbrush) ? ObjectKindLookup[kind + 1] : nullptr;
+}
+
+// enum to string lookup table for SkillExecutionDeviceKind
+static const std::map<SkillExecutionDeviceKind, std::string> SkillExecutionDeviceKindLookup = {
+    { SkillExecutionDeviceKind::Undefined, "Undefined" },
+    { SkillExecutionDeviceKind::Cpu, "Cpu" },
+    { SkillExecutionDeviceKind::Gpu, "Gpu" },
+    { SkillExecutionDeviceKind::Vpu, "Vpu" },
+    { SkillExecutionDeviceKind::Fpga, "Fpga" },
+    { SkillExecutionDeviceKind::Cloud, "Cloud" }
+};
+
+//
+// Helper method to retrieve the value following a named argument, i.e. "-bindings 4"
+//
+const char* FindOptionValue(const char* optionName)
+{
+    for (int i = 1; i < __argc - 1; i++)
+    {
+        if (strcmp(__argv[i], optionName) == 0)
+        {
+            return __argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+//
+// Helper method to retrieve a positive count following a named argument, or its default value
+//
+uint32_t FindCountOption(const char* optionName, uint32_t defaultValue)
+{
+    const char* value = FindOptionValue(optionName);
+    return (value != nullptr) ? (uint32_t)std::max<int>(1, atoi(value)) : defaultValue;
+}
+
+//
+// Helper method to load an image file as a Bgra8 SoftwareBitmap
+//
+SoftwareBitmap LoadSoftwareBitmapFromImageFile(std::string const& filePath)
+{
+    StorageFile file = StorageFile::GetFileFromPathAsync(std::filesystem::absolute(filePath).wstring()).get();
+    IRandomAccessStream stream = file.OpenAsync(FileAccessMode::Read).get();
+    BitmapDecoder decoder = BitmapDecoder::CreateAsync(stream).get();
+    SoftwareBitmap softwareBitmap = SoftwareBitmap::Convert(decoder.GetSoftwareBitmapAsync().get(), BitmapPixelFormat::Bgra8, BitmapAlphaMode::Premultiplied);
+    stream.Close();
+    return softwareBitmap;
+}
+
+//
+// Display the latency percentiles of a histogram
+//
+void PrintLatencies(const char* name, LatencyHistogram const& latencies)
+{
+    std::cout << name << ": " << latencies.Count() << " | p50 " << latencies.Percentile(0.5)
+        << "ms | p99 " << latencies.Percentile(0.99) << "ms | max " << latencies.MaxMs() << "ms" << std::endl;
+}
+
+//
+// Display what a skill host served
+//
+void PrintHostStatistics(SkillHost const& host)
+{
+    std::cout << "Frames served: " << host.FrameCount() << " in " << host.BatchCount() << " batches"
+        << " | average batch: " << host.AverageBatchSize()
+        << " | occupancy: " << std::setprecision(3) << host.Occupancy() * 100 << "%" << std::endl;
+    PrintLatencies("Batch evaluation", host.BatchLatencies());
+}
+
+//
+// Backend evaluating a batch with ObjectDetector, one binding per frame of the batch.
+// The skill only binds VideoFrames, so each frame is copied once from its shared slot into the bitmap of its binding.
+//
+class ObjectDetectorBackend
+{
+public:
+    explicit ObjectDetectorBackend(uint32_t bindingCount)
+        : m_pool(ThreadPoolOptions(bindingCount))
+    {
+        auto descriptor = ObjectDetectorDescriptor();
+        m_skill = descriptor.CreateSkillAsync().get().as<ObjectDetectorSkill>();
+        std::cout << "Running Skill on : " << SkillExecutionDeviceKindLookup.at(m_skill.Device().ExecutionDeviceKind());
+        std::wcout << L" : " << m_skill.Device().Name().c_str() << std::endl;
+        for (uint32_t i = 0; i < bindingCount; i++)
+        {
+            m_bindings.push_back(m_skill.CreateSkillBindingAsync().get().as<ObjectDetectorBinding>());
+        }
+    }
+
+    void Evaluate(std::vector<SkillHost::Request>& batch)
+    {
+        WorkStealingThreadPool::TaskGroup evaluations(m_pool);
+
+        // Each task owns a binding and evaluates every bindingCount-th frame of the batch
+        size_t bindingCount = m_bindings.size();
+        for (size_t bindingIndex = 0; bindingIndex < std::min<size_t>(bindingCount, batch.size()); bindingIndex++)
+        {
+            evaluations.Run([this, &batch, bindingIndex, bindingCount]()
+            {
+                for (size_t i = bindingIndex; i < batch.size(); i += bindingCount)
+                {
+                    auto& request = batch[i];
+                    try
+                    {
+                        EvaluateFrame(m_bindings[bindingIndex], request);
+                    }
+                    catch (...)
+                    {
+                        request.status = SharedFrameChannel::Status::Failed;
+                        request.results.clear();
+                    }
+                }
+            });
+        }
+        evaluations.Wait();
+    }
+
+private:
+    static WorkStealingThreadPool::Options ThreadPoolOptions(uint32_t bindingCount)
+    {
+        WorkStealingThreadPool::Options options;
+        options.workerCount = bindingCount;
+        return options;
+    }
+
+    void EvaluateFrame(ObjectDetectorBinding const& binding, SkillHost::Request& request)
+    {
+        if (request.frame.pixelFormat != (int32_t)BitmapPixelFormat::Bgra8 || request.frame.stride < (int32_t)request.frame.width * 4)
+        {
+            request.status = SharedFrameChannel::Status::InvalidFrame;
+            return;
+        }
+
+        SoftwareBitmap bitmap(BitmapPixelFormat::Bgra8, request.frame.width, request.frame.height, BitmapAlphaMode::Premultiplied);
+        {
+            SoftwareBitmapHelper::PixelView slotView;
+            slotView.data = const_cast<uint8_t*>(request.pixels);
+            slotView.stride = request.frame.stride;
+            slotView.width = request.frame.width;
+            slotView.height = request.frame.height;
+            SoftwareBitmapHelper::LockedPixels bitmapPixels(bitmap, BitmapBufferAccessMode::Write);
+            SoftwareBitmapHelper::CopyBgra8Region(slotView, 0, 0, bitmapPixels.View(), 0, 0, request.frame.width, request.frame.height);
+        }
+        binding.SetInputImageAsync(VideoFrame::CreateWithSoftwareBitmap(bitmap)).get();
+        m_skill.EvaluateAsync(binding).get();
+
+        for (auto&& detectedObject : binding.DetectedObjects())
+        {
+            auto rect = detectedObject.Rect();
+            request.results.push_back({ (int32_t)detectedObject.Kind(), rect.X, rect.Y, rect.Width, rect.Height });
+        }
+    }
+
+    ObjectDetectorSkill m_skill = nullptr;
+    std::vector<ObjectDetectorBinding> m_bindings;
+    WorkStealingThreadPool m_pool;
+};
+
+//
+// Serve ObjectDetector to local clients until enter is pressed
+//
+void Serve(std::string const& name)
+{
+    uint32_t bindingCount = FindCountOption("-bindings", 2);
+    ObjectDetectorBackend backend(bindingCount);
+
+    SkillHost::Options options;
+    options.maxBatchSize = FindCountOption("-batch", bindingCount);
+    options.channel.slotCount = std::max<uint32_t>(8, options.maxBatchSize * 2);
+    SkillHost host(name, [&backend](std::vector<SkillHost::Request>& batch) { backend.Evaluate(batch); }, options);
+    host.Start();
+    std::cout << "Serving ObjectDetector as \"" << name << "\" with " << bindingCount << " bindings, batches of up to " << options.maxBatchSize << " frames" << std::endl;
+    std::cout << "\t\t\t\t\t\t\t\t...press enter to Stop" << std::endl;
+
+    // Wait for enter keypress
+    while (std::cin.get() != '\n');
+
+    std::cout << std::endl << "Key pressed.. exiting" << std::endl;
+    host.Stop();
+    PrintHostStatistics(host);
+}
+
+//
+// Submit an image to a running host frameCount times and display the objects found in it
+//
+void RunClient(std::string const& name, std::string const& imagePath)
+{
+    uint32_t frameCount = FindCountOption("-frames", 1);
+    SoftwareBitmap bitmap = LoadSoftwareBitmapFromImageFile(imagePath);
+    SoftwareBitmapHelper::LockedPixels pixels(bitmap, BitmapBufferAccessMode::Read);
+    auto& view = pixels.View();
+
+    SkillHostClient client(name);
+    SharedFrameChannel::FrameDescription frame = { view.width, view.height, (int32_t)view.width * 4, (int32_t)BitmapPixelFormat::Bgra8, -1 };
+    std::vector<SharedFrameChannel::Result> results;
+    for (uint32_t i = 0; i < frameCount; i++)
+    {
+        auto status = client.Evaluate(frame, [&view](uint8_t* slotPixels)
+        {
+            // Written straight into the shared slot, the host reads it from there
+            for (uint32_t y = 0; y < view.height; y++)
+            {
+                memcpy(slotPixels + (size_t)y * view.width * 4, view.Row(y), (size_t)view.width * 4);
+            }
+        }, results);
+        if (status != SharedFrameChannel::Status::Success)
+        {
+            static const char* StatusNames[] = { "success", "failed", "invalid frame", "host stopped" };
+            throw std::runtime_error(std::string("Error: the skill host did not evaluate the frame: ") + StatusNames[(int)status]);
+        }
+    }
+
+    std::cout << "Objects detected: " << results.size() << std::endl;
+    for (auto&& result : results)
+    {
+        const char* kindName = ObjectKindName(result.label);
+        std::cout << "\t" << (kindName != nullptr ? kindName : "Unknown") << " at (" << result.x << ", " << result.y
+            << ") size " << result.width << " x " << result.height << std::endl;
+    }
+    PrintLatencies("Client latency", client.Latencies());
+}
+
+//
+// Measure client latency and host occupancy for increasing batch sizes, with clientCount clients each submitting
+// frameCount frames to a stand-in backend costing a fixed time per batch plus a time per frame
+//
+void RunBenchmark()
+{
+    const double FixedMs = 8.0;
+    const double PerFrameMs = 2.0;
+    uint32_t clientCount = FindCountOption("-clients", 4);
+    uint32_t frameCount = FindCountOption("-frames", 200);
+    std::string name = "benchmark." + std::to_string(GetCurrentProcessId());
+
+    std::cout << "Stand-in backend: " << FixedMs << "ms per batch + " << PerFrameMs << "ms per frame | "
+        << clientCount << " clients x " << frameCount << " frames of 640x480" << std::endl;
+    std::cout << "batch | frames/s | client p50 | client p99 | occupancy | average batch" << std::endl;
+    for (uint32_t maxBatchSize : { 1u, 2u, 4u, 8u })
+    {
+        SkillHost::Options options;
+        options.maxBatchSize = maxBatchSize;
+        options.channel.slotCount = std::max<uint32_t>(clientCount, maxBatchSize);
+        options.channel.maxWidth = 640;
+        options.channel.maxHeight = 480;
+        SkillHost host(name, SkillHost::SimulatedBackend(FixedMs, PerFrameMs), options);
+        host.Start();
+
+        // Clients run as threads here, they go through the same shared region as clients in other processes
+        LatencyHistogram latencies;
+        std::vector<std::thread> clients;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t clientIndex = 0; clientIndex < clientCount; clientIndex++)
+        {
+            clients.emplace_back([&]()
+            {
+                SkillHostClient client(name);
+                SharedFrameChannel::FrameDescription frame = { 640, 480, 640 * 4, (int32_t)BitmapPixelFormat::Bgra8, -1 };
+                std::vector<SharedFrameChannel::Result> results;
+                for (uint32_t i = 0; i < frameCount; i++)
+                {
+                    auto frameStart = std::chrono::steady_clock::now();
+                    client.Evaluate(frame, [](uint8_t* slotPixels) { memset(slotPixels, 0x80, 640 * 480 * 4); }, results);
+                    latencies.Record(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameStart).count());
+                }
+            });
+        }
+        for (auto&& client : clients)
+        {
+            client.join();
+        }
+        double elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double occupancy = host.Occupancy();
+        host.Stop();
+
+        std::cout << std::setw(5) << maxBatchSize << " | " << std::setw(8) << std::fixed << std::setprecision(1) << host.FrameCount() / elapsedSeconds
+            << " | " << std::setw(8) << latencies.Percentile(0.5) << "ms | " << std::setw(8) << latencies.Percentile(0.99)
+            << "ms | " << std::setw(8) << occupancy * 100 << "% | " << std::setw(13) << std::setprecision(2) << host.AverageBatchSize() << std::endl;
+    }
+}
+
+//
+// App main loop
+//
+int main()
+{
+    try
+    {
+        // Check if we are running Windows 10.0.18362.x or above as required
+        HRESULT hr = WindowsVersionHelper::EqualOrAboveWindows10Version(18362);
+        if (FAILED(hr))
+        {
+            throw_hresult(hr);
+        }
+        std::cout << "Skill Host C++/WinRT Non-packaged(win32) console App" << std::endl;
+
+        try
+        {
+            if (__argc >= 3 && strcmp(__argv[1], "-serve") == 0)
+            {
+                Serve(__argv[2]);
+            }
+            else if (__argc >= 4 && strcmp(__argv[1], "-client") == 0)
+            {
+                RunClient(__argv[2], __argv[3]);
+            }
+            else if (__argc >= 2 && strcmp(__argv[1], "-benchmark") == 0)
+            {
+                RunBenchmark();
+            }
+            else
+            {
+                std::cout << "Usage:" << std::endl;
+                std::cout << "SkillHostSample_Desktop.exe -serve <host name> [-bindings <count>] [-batch <frames>]" << std::endl;
+                std::cout << "SkillHostSample_Desktop.exe -client <host name> <image file> [-frames <count>]" << std::endl;
+                std::cout << "SkillHostSample_Desktop.exe -benchmark [-clients <count>] [-frames <count per client>]" << std::endl;
+                return 1;
+            }
+        }
+        catch (hresult_error const& ex)
+        {
+            std::wcerr << "Error:" << ex.message().c_str() << ":" << std::hex << ex.code().value << std::endl;
+            return ex.code().value;
+        }
+        catch (std::exception const& ex)
+        {
+            std::cerr << "Error:" << ex.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    catch (hresult_error const& ex)
+    {
+        std::cerr << "Error:" << std::hex << ex.code() << ":" << ex.message().c_str();
+    }
+}
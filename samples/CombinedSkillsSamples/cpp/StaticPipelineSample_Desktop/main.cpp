@@ -0,0 +1,374 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+
+#include <any>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <winrt/Windows.Foundation.h>
+
+#include "BoundedQueue.h"
+#include "StaticPipeline.h"
+#include "WindowsVersionHelper.h"
+
+using namespace winrt;
+
+//
+// Data flowing through the stand-in pipeline: a small frame, its normalized tensor, the scores the stand-in skill
+// computes from it and the detection picked from the scores
+//
+static constexpr size_t FramePixelCount = 64;
+static constexpr size_t LabelCount = 4;
+
+struct Frame
+{
+    uint64_t id = 0;
+    std::array<float, FramePixelCount> pixels = {};
+};
+
+struct Tensor
+{
+    uint64_t id;
+    std::array<float, FramePixelCount> values;
+};
+
+struct Scores
+{
+    uint64_t id;
+    std::array<float, LabelCount> values;
+};
+
+struct Detection
+{
+    uint64_t id;
+    uint32_t label;
+    float score;
+};
+
+//
+// Compile-time configuration of the stand-in pipeline, validated before anything runs
+//
+struct BenchmarkConfig
+{
+    static constexpr size_t QueueCapacity = 64;
+    static constexpr uint32_t SkillIterations = 1; // passes of the stand-in skill over its tensor
+};
+static_assert(BenchmarkConfig::SkillIterations >= 1, "the stand-in skill needs at least one pass");
+
+//
+// Stand-in stages, the same objects are used by the static and the dynamic pipelines
+//
+class FrameSource
+{
+public:
+    using Frame = ::Frame;
+
+    explicit FrameSource(uint64_t frameCount) : m_frameCount(frameCount) {}
+
+    bool operator()(Frame& frame)
+    {
+        if (m_nextId >= m_frameCount)
+        {
+            return false;
+        }
+        frame.id = m_nextId++;
+        for (size_t i = 0; i < FramePixelCount; i++)
+        {
+            frame.pixels[i] = (float)((frame.id * 31 + i * 17) % 255);
+        }
+        return true;
+    }
+
+private:
+    uint64_t m_frameCount;
+    uint64_t m_nextId = 0;
+};
+
+struct Preprocess
+{
+    Tensor operator()(Frame&& frame) const
+    {
+        Tensor tensor;
+        tensor.id = frame.id;
+        for (size_t i = 0; i < FramePixelCount; i++)
+        {
+            tensor.values[i] = frame.pixels[i] / 127.5f - 1.0f;
+        }
+        return tensor;
+    }
+};
+
+struct StandInSkill
+{
+    Scores operator()(Tensor&& tensor) const
+    {
+        Scores scores;
+        scores.id = tensor.id;
+        scores.values = {};
+        for (uint32_t iteration = 0; iteration < BenchmarkConfig::SkillIterations; iteration++)
+        {
+            for (size_t label = 0; label < LabelCount; label++)
+            {
+                for (size_t i = 0; i < FramePixelCount; i++)
+                {
+                    scores.values[label] += tensor.values[i] * (float)((i + label + iteration) % 7) * 0.01f;
+                }
+            }
+        }
+        return scores;
+    }
+};
+
+struct Postprocess
+{
+    Detection operator()(Scores&& scores) const
+    {
+        Detection detection = { scores.id, 0, scores.values[0] };
+        for (uint32_t label = 1; label < LabelCount; label++)
+        {
+            if (scores.values[label] > detection.score)
+            {
+                detection.label = label;
+                detection.score = scores.values[label];
+            }
+        }
+        return detection;
+    }
+};
+
+struct ChecksumSink
+{
+    uint64_t checksum = 0;
+    uint64_t frameCount = 0;
+
+    void operator()(Detection&& detection)
+    {
+        checksum = checksum * 31 + detection.id * LabelCount + detection.label;
+        frameCount++;
+    }
+};
+
+using BenchmarkPipeline = StaticPipeline<FrameSource, BenchmarkConfig::QueueCapacity, Preprocess, StandInSkill, Postprocess, ChecksumSink>;
+
+//
+// Dynamic equivalent, the way a runner configured at run time chains its stages: each stage sits behind a virtual
+// call and data travels between stages as std::any, and frames go through a BoundedQueue
+//
+class IDynamicStage
+{
+public:
+    virtual ~IDynamicStage() = default;
+    virtual std::any Process(std::any&& input) = 0;
+};
+
+template <typename Stage, typename Input>
+class DynamicStage : public IDynamicStage
+{
+public:
+    explicit DynamicStage(Stage& stage) : m_stage(stage) {}
+
+    std::any Process(std::any&& input) override
+    {
+        if constexpr (std::is_void_v<std::invoke_result_t<Stage&, Input&&>>)
+        {
+            m_stage(std::any_cast<Input&&>(std::move(input)));
+            return std::any();
+        }
+        else
+        {
+            return m_stage(std::any_cast<Input&&>(std::move(input)));
+        }
+    }
+
+private:
+    Stage& m_stage;
+};
+
+class DynamicPipeline
+{
+public:
+    DynamicPipeline(FrameSource& source, std::vector<std::unique_ptr<IDynamicStage>> stages, size_t queueCapacity)
+        : m_source(source),
+        m_stages(std::move(stages)),
+        m_queue(queueCapacity)
+    {
+    }
+
+    uint64_t RunInline()
+    {
+        uint64_t frameCount = 0;
+        Frame frame;
+        while (m_source(frame))
+        {
+            Process(std::any(std::move(frame)));
+            frameCount++;
+        }
+        return frameCount;
+    }
+
+    uint64_t Run()
+    {
+        std::thread sourceThread([this]()
+        {
+            Frame frame;
+            while (m_source(frame) && m_queue.Push(std::any(frame)));
+            m_queue.Close();
+        });
+
+        uint64_t frameCount = 0;
+        while (auto item = m_queue.Pop())
+        {
+            Process(std::move(*item));
+            frameCount++;
+        }
+        sourceThread.join();
+        return frameCount;
+    }
+
+private:
+    void Process(std::any&& input)
+    {
+        std::any value = std::move(input);
+        for (auto&& stage : m_stages)
+        {
+            value = stage->Process(std::move(value));
+        }
+    }
+
+    FrameSource& m_source;
+    std::vector<std::unique_ptr<IDynamicStage>> m_stages;
+    BoundedQueue<std::any> m_queue;
+};
+
+//
+// Helper method to retrieve the value following a named argument, i.e. "-frames 100000"
+//
+const char* FindOptionValue(const char* optionName)
+{
+    for (int i = 1; i < __argc - 1; i++)
+    {
+        if (strcmp(__argv[i], optionName) == 0)
+        {
+            return __argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+//
+// Run a pipeline, display its time per frame and return its checksum
+//
+template <typename RunFunction>
+uint64_t Measure(const char* name, uint64_t frameCount, RunFunction run, ChecksumSink const& sink, double& nsPerFrame)
+{
+    auto begin = std::chrono::high_resolution_clock::now();
+    uint64_t processedCount = run();
+    auto end = std::chrono::high_resolution_clock::now();
+    nsPerFrame = std::chrono::duration<double, std::nano>(end - begin).count() / std::max<uint64_t>(frameCount, 1);
+    std::cout << std::left << std::setw(28) << name << std::right << std::setw(10) << std::fixed << std::setprecision(1) << nsPerFrame
+        << "ns/frame | frames: " << processedCount << " | checksum: " << std::hex << sink.checksum << std::dec << std::endl;
+    return sink.checksum;
+}
+
+//
+// Run the stand-in pipeline statically and dynamically, inline and with the source on its own thread
+//
+void RunBenchmark(uint64_t frameCount)
+{
+    std::cout << "Stand-in pipeline: source -> preprocess -> skill -> postprocess -> sink | " << frameCount << " frames | queue of "
+        << BenchmarkConfig::QueueCapacity << " frames" << std::endl;
+
+    double staticInlineNs = 0.0, dynamicInlineNs = 0.0, staticThreadedNs = 0.0, dynamicThreadedNs = 0.0;
+    uint64_t checksums[4] = {};
+    {
+        auto pipeline = std::make_unique<BenchmarkPipeline>(FrameSource(frameCount), Preprocess(), StandInSkill(), Postprocess(), ChecksumSink());
+        checksums[0] = Measure("static, inline", frameCount, [&]() { return pipeline->RunInline(); }, pipeline->GetStage<3>(), staticInlineNs);
+    }
+    {
+        FrameSource source(frameCount);
+        Preprocess preprocess;
+        StandInSkill skill;
+        Postprocess postprocess;
+        ChecksumSink sink;
+        std::vector<std::unique_ptr<IDynamicStage>> stages;
+        stages.push_back(std::make_unique<DynamicStage<Preprocess, Frame>>(preprocess));
+        stages.push_back(std::make_unique<DynamicStage<StandInSkill, Tensor>>(skill));
+        stages.push_back(std::make_unique<DynamicStage<Postprocess, Scores>>(postprocess));
+        stages.push_back(std::make_unique<DynamicStage<ChecksumSink, Detection>>(sink));
+        DynamicPipeline pipeline(source, std::move(stages), BenchmarkConfig::QueueCapacity);
+        checksums[1] = Measure("dynamic, inline", frameCount, [&]() { return pipeline.RunInline(); }, sink, dynamicInlineNs);
+    }
+    {
+        auto pipeline = std::make_unique<BenchmarkPipeline>(FrameSource(frameCount), Preprocess(), StandInSkill(), Postprocess(), ChecksumSink());
+        checksums[2] = Measure("static, source thread", frameCount, [&]() { return pipeline->Run(); }, pipeline->GetStage<3>(), staticThreadedNs);
+    }
+    {
+        FrameSource source(frameCount);
+        Preprocess preprocess;
+        StandInSkill skill;
+        Postprocess postprocess;
+        ChecksumSink sink;
+        std::vector<std::unique_ptr<IDynamicStage>> stages;
+        stages.push_back(std::make_unique<DynamicStage<Preprocess, Frame>>(preprocess));
+        stages.push_back(std::make_unique<DynamicStage<StandInSkill, Tensor>>(skill));
+        stages.push_back(std::make_unique<DynamicStage<Postprocess, Scores>>(postprocess));
+        stages.push_back(std::make_unique<DynamicStage<ChecksumSink, Detection>>(sink));
+        DynamicPipeline pipeline(source, std::move(stages), BenchmarkConfig::QueueCapacity);
+        checksums[3] = Measure("dynamic, source thread", frameCount, [&]() { return pipeline.Run(); }, sink, dynamicThreadedNs);
+    }
+
+    if (checksums[0] != checksums[1] || checksums[0] != checksums[2] || checksums[0] != checksums[3])
+    {
+        throw std::runtime_error("Error: the static and dynamic pipelines produced different results");
+    }
+    std::cout << "Per-frame overhead removed: " << std::setprecision(1) << dynamicInlineNs - staticInlineNs << "ns inline | "
+        << dynamicThreadedNs - staticThreadedNs << "ns with a source thread" << std::endl;
+}
+
+//
+// App main loop
+//
+int main()
+{
+    try
+    {
+        // Check if we are running Windows 10.0.18362.x or above as required
+        HRESULT hr = WindowsVersionHelper::EqualOrAboveWindows10Version(18362);
+        if (FAILED(hr))
+        {
+            throw_hresult(hr);
+        }
+        std::cout << "Static Pipeline C++/WinRT Non-packaged(win32) console App" << std::endl;
+
+        try
+        {
+            uint64_t frameCount = 1000000;
+            if (auto frames = FindOptionValue("-frames"))
+            {
+                frameCount = (uint64_t)std::max<long long>(1, atoll(frames));
+            }
+            RunBenchmark(frameCount);
+        }
+        catch (hresult_error const& ex)
+        {
+            std::wcerr << "Error:" << ex.message().c_str() << ":" << std::hex << ex.code().value << std::endl;
+            return ex.code().value;
+        }
+        catch (std::exception const& ex)
+        {
+            std::cerr << "Error:" << ex.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+    catch (hresult_error const& ex)
+    {
+        std::cerr << "Error:" << std::hex << ex.code() << ":" << ex.message().c_str();
+    }
+}
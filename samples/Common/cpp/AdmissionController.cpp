@@ -0,0 +1,181 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "AdmissionController.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+#ifndef _WIN32
+#include <fstream>
+#include <string>
+#endif
+
+AdmissionController::AdmissionController()
+    : AdmissionController(Options())
+{
+}
+
+AdmissionController::AdmissionController(Options const& options, Clock clock, CpuSampler cpuSampler)
+    : m_options(options),
+    m_clock(std::move(clock)),
+    m_cpuSampler(std::move(cpuSampler)),
+    m_liveSamples(std::max<uint32_t>(options.liveWindowCapacity, 1), LiveSample{ INT64_MIN, 0.0 })
+{
+}
+
+//
+// Each call reports the utilization since the previous one, the first call the utilization since boot
+//
+AdmissionController::CpuSampler AdmissionController::SystemCpuSampler()
+{
+    struct Times
+    {
+        uint64_t idle = 0;
+        uint64_t total = 0;
+    };
+    auto previous = std::make_shared<Times>();
+    return [previous]()
+    {
+        Times current;
+#ifdef _WIN32
+        FILETIME idle, kernel, user;
+        if (!GetSystemTimes(&idle, &kernel, &user))
+        {
+            return -1.0;
+        }
+        auto toTicks = [](FILETIME const& time) { return ((uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime; };
+
+        // Kernel time includes idle time
+        current.idle = toTicks(idle);
+        current.total = toTicks(kernel) + toTicks(user);
+#else
+        // First line sums all processors: "cpu user nice system idle iowait irq softirq steal ..."
+        std::ifstream stat("/proc/stat");
+        std::string name;
+        if (!(stat >> name) || name != "cpu")
+        {
+            return -1.0;
+        }
+        uint64_t value = 0;
+        for (uint32_t field = 0; field < 8 && stat >> value; field++)
+        {
+            current.total += value;
+            if (field == 3 || field == 4)
+            {
+                current.idle += value;
+            }
+        }
+#endif
+        uint64_t total = current.total - previous->total;
+        uint64_t idleTotal = current.idle - previous->idle;
+        *previous = current;
+        if (total == 0)
+        {
+            return -1.0;
+        }
+        return 1.0 - (double)idleTotal / total;
+    };
+}
+
+void AdmissionController::RecordLiveLatency(double latencyMs)
+{
+    int64_t now = m_clock();
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_liveSamples[m_nextLiveSample] = { now, latencyMs };
+    m_nextLiveSample = (m_nextLiveSample + 1) % m_liveSamples.size();
+    m_lastLiveTime = now;
+}
+
+double AdmissionController::LiveP99Ms()
+{
+    int64_t now = m_clock();
+    std::lock_guard<std::mutex> guard(m_lock);
+    return LiveP99MsLocked(now);
+}
+
+double AdmissionController::LiveP99MsLocked(int64_t now)
+{
+    int64_t windowStart = now - (int64_t)(m_options.liveWindowMs * FrameDeadlinePolicy::TicksPerMs);
+    std::vector<double> latencies;
+    latencies.reserve(m_liveSamples.size());
+    for (auto&& sample : m_liveSamples)
+    {
+        if (sample.time != INT64_MIN && sample.time >= windowStart)
+        {
+            latencies.push_back(sample.latencyMs);
+        }
+    }
+    if (latencies.empty())
+    {
+        return 0.0;
+    }
+    auto rank = latencies.begin() + (size_t)std::ceil(latencies.size() * 0.99) - 1;
+    std::nth_element(latencies.begin(), rank, latencies.end());
+    return *rank;
+}
+
+void AdmissionController::SampleCpuLocked(int64_t now)
+{
+    if (m_cpuSampler == nullptr || now < m_nextCpuSampleTime)
+    {
+        return;
+    }
+    m_nextCpuSampleTime = now + (int64_t)(m_options.cpuSampleIntervalMs * FrameDeadlinePolicy::TicksPerMs);
+    double utilization = m_cpuSampler();
+    if (utilization >= 0.0)
+    {
+        m_cpuUtilization.store(utilization, std::memory_order_relaxed);
+    }
+}
+
+AdmissionController::Decision AdmissionController::AdmitBatch(int64_t readyTime)
+{
+    int64_t now = m_clock();
+    int64_t sojourn = now - readyTime;
+    int64_t targetTicks = (int64_t)(m_options.sojournTargetMs * FrameDeadlinePolicy::TicksPerMs);
+    int64_t intervalTicks = (int64_t)(m_options.sojournIntervalMs * FrameDeadlinePolicy::TicksPerMs);
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    SampleCpuLocked(now);
+
+    // Live work is at risk when its tail latency or the host load is over target, only while live frames come in
+    bool isLiveActive = m_lastLiveTime != INT64_MIN && now - m_lastLiveTime <= (int64_t)(m_options.liveIdleMs * FrameDeadlinePolicy::TicksPerMs);
+    bool isLiveAtRisk = isLiveActive
+        && (LiveP99MsLocked(now) > m_options.liveLatencyTargetMs || CpuUtilization() > m_options.cpuUtilizationTarget);
+
+    // Track how long sojourn stayed above target
+    if (sojourn < targetTicks)
+    {
+        m_firstAboveTime = 0;
+        m_isShedding = false;
+    }
+    else if (m_firstAboveTime == 0)
+    {
+        m_firstAboveTime = now + intervalTicks;
+    }
+    else if (!m_isShedding && now >= m_firstAboveTime)
+    {
+        // Resume close to the previous shedding rate if it stopped recently, the overload is likely the same
+        bool isRecent = m_shedStreak > 2 && now - m_nextShedTime < 16 * intervalTicks;
+        m_shedStreak = isRecent ? m_shedStreak - 2 : 0;
+        m_isShedding = true;
+        m_nextShedTime = now;
+    }
+
+    if (!isLiveAtRisk)
+    {
+        m_isShedding = false;
+        m_firstAboveTime = 0;
+        m_admittedCount.fetch_add(1, std::memory_order_relaxed);
+        m_batchSojourns.Record((double)sojourn / FrameDeadlinePolicy::TicksPerMs);
+        return Decision::Admit;
+    }
+    if (m_isShedding && now >= m_nextShedTime)
+    {
+        m_shedStreak++;
+        m_nextShedTime = now + (int64_t)(intervalTicks / std::sqrt((double)m_shedStreak));
+        m_shedCount.fetch_add(1, std::memory_order_relaxed);
+        return Decision::Shed;
+    }
+    m_deferredCount.fetch_add(1, std::memory_order_relaxed);
+    return Decision::Defer;
+}
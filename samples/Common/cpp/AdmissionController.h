@@ -0,0 +1,113 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "FrameDeadlinePolicy.h"
+
+//
+// Admission controller shared by a latency-sensitive live lane and a throughput batch lane running on the same host.
+//
+// The live lane reports the latency of each frame it evaluates. Its p99 over the recent window, together with the
+// CPU utilization of the host, tells whether live work is at risk. While it is, batch items are deferred: the caller
+// waits DeferDelayMs() and asks again for the same item. The time the batch lane has been waiting for its next
+// admission is its sojourn time, tracked CoDel-style: once sojourn stayed above SojournTargetMs for a whole
+// SojournIntervalMs while live work is still at risk, the controller sheds batch items instead of piling them up,
+// the first one right away and the next ones at intervals shrinking with the square root of the amount shed so far.
+// Shedding stops as soon as an item gets admitted or waits less than the target.
+//
+// Batch work is never held back while no live latency was reported for LiveIdleMs, so a batch running alone keeps
+// the whole host. Clock and CPU sampler are injectable so that the control loop can be driven by a simulated host.
+//
+class AdmissionController
+{
+public:
+    enum class Decision
+    {
+        Admit, // run the batch item now
+        Defer, // ask again for the same item after DeferDelayMs()
+        Shed // drop the batch item
+    };
+
+    struct Options
+    {
+        double liveLatencyTargetMs = 66.0; // p99 of live latencies above which batch work is held back
+        double cpuUtilizationTarget = 0.9; // host utilization above which batch work is held back while live work runs
+        double sojournTargetMs = 100.0; // acceptable standing wait of batch items
+        double sojournIntervalMs = 1000.0; // time sojourn needs to stay above target before items get shed
+        double liveWindowMs = 2000.0; // live latencies older than this no longer count
+        double liveIdleMs = 1000.0; // live lane considered idle when it did not report for this long
+        double cpuSampleIntervalMs = 250.0;
+        uint32_t liveWindowCapacity = 256; // most recent live latencies kept
+    };
+
+    using Clock = FrameDeadlinePolicy::Clock; // 100ns ticks
+    using CpuSampler = std::function<double()>; // host utilization in [0, 1] since the previous call, negative if unknown
+
+    AdmissionController();
+    explicit AdmissionController(Options const& options, Clock clock = FrameDeadlinePolicy::SystemRelativeNow, CpuSampler cpuSampler = SystemCpuSampler());
+
+    AdmissionController(const AdmissionController&) = delete;
+    AdmissionController& operator=(const AdmissionController&) = delete;
+
+    // Utilization of all processors of the host from GetSystemTimes(), or /proc/stat off Windows
+    static CpuSampler SystemCpuSampler();
+
+    // Report the latency of a live frame, from any thread
+    void RecordLiveLatency(double latencyMs);
+
+    // Decide what to do with the next batch item. readyTime, in ticks of the clock, is when the batch lane became ready
+    // for it: when its previous admitted item completed. Deferred and shed items do not move it.
+    Decision AdmitBatch(int64_t readyTime);
+
+    int64_t Now() const { return m_clock(); }
+    double DeferDelayMs() const { return m_options.sojournTargetMs / 4; }
+
+    // p99 of the live latencies of the window, 0 when the live lane is idle
+    double LiveP99Ms();
+    double CpuUtilization() const { return m_cpuUtilization.load(std::memory_order_relaxed); }
+
+    uint64_t AdmittedCount() const { return m_admittedCount.load(std::memory_order_relaxed); }
+    uint64_t DeferredCount() const { return m_deferredCount.load(std::memory_order_relaxed); }
+    uint64_t ShedCount() const { return m_shedCount.load(std::memory_order_relaxed); }
+    const LatencyHistogram& BatchSojourns() const { return m_batchSojourns; } // wait of admitted batch items
+
+private:
+    struct LiveSample
+    {
+        int64_t time;
+        double latencyMs;
+    };
+
+    double LiveP99MsLocked(int64_t now);
+    void SampleCpuLocked(int64_t now);
+
+    Options m_options;
+    Clock m_clock;
+    CpuSampler m_cpuSampler;
+    std::mutex m_lock;
+
+    // Live lane, ring of the most recent latencies
+    std::vector<LiveSample> m_liveSamples;
+    size_t m_nextLiveSample = 0;
+    int64_t m_lastLiveTime = INT64_MIN;
+
+    // Host
+    std::atomic<double> m_cpuUtilization = 0.0;
+    int64_t m_nextCpuSampleTime = INT64_MIN;
+
+    // CoDel state of the batch lane
+    int64_t m_firstAboveTime = 0; // when sojourn may have stayed above target for a whole interval, 0 if below target
+    bool m_isShedding = false;
+    int64_t m_nextShedTime = 0;
+    uint32_t m_shedStreak = 0; // items shed since shedding started
+
+    std::atomic<uint64_t> m_admittedCount = 0;
+    std::atomic<uint64_t> m_deferredCount = 0;
+    std::atomic<uint64_t> m_shedCount = 0;
+    LatencyHistogram m_batchSojourns;
+};
@@ -0,0 +1,220 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "AsyncFrameWriter_cppwinrt.h"
+#include <algorithm>
+#include <cstring>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Foundation.Collections.h>
+#include <winrt/Windows.Storage.Streams.h>
+
+#include "SoftwareBitmapHelper_cppwinrt.h"
+#include "Tracing.h"
+
+using namespace winrt;
+using namespace winrt::Windows::Foundation;
+using namespace winrt::Windows::Media;
+using namespace winrt::Windows::Graphics::Imaging;
+using namespace winrt::Windows::Storage;
+using namespace winrt::Windows::Storage::Streams;
+
+//
+// Start the pool of workers writing frames
+//
+AsyncFrameWriter::AsyncFrameWriter(Options const& options)
+    : m_options(options),
+    m_queue(options.queueCapacity)
+{
+    if (m_options.jpegQuality < 0.0f || m_options.jpegQuality > 1.0f)
+    {
+        throw hresult_invalid_argument(L"Error: JPEG quality must range between 0 and 1");
+    }
+
+    // Hold fewer frames while over budget, Write() then blocks on the workers sooner
+    if (m_options.memoryTracker != nullptr)
+    {
+        m_queueMemory = &m_options.memoryTracker->GetComponent("AsyncFrameWriter queue");
+        m_bufferMemory = &m_options.memoryTracker->GetComponent("AsyncFrameWriter buffers");
+        auto onPressureChanged = [this](MemoryTracker::Pressure pressure)
+        {
+            m_queue.SetCapacity((pressure == MemoryTracker::Pressure::High) ? 1 : m_options.queueCapacity);
+        };
+        m_pressureHandlerId = m_options.memoryTracker->AddPressureHandler(onPressureChanged);
+        onPressureChanged(m_options.memoryTracker->CurrentPressure());
+    }
+
+    uint32_t workerCount = std::max<uint32_t>(m_options.workerCount, 1);
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        m_workers.emplace_back([this]() { WorkerLoop(); });
+    }
+}
+
+AsyncFrameWriter::~AsyncFrameWriter()
+{
+    Close();
+}
+
+//
+// File extension matching an output format
+//
+const wchar_t* AsyncFrameWriter::FileExtension(OutputFormat format)
+{
+    switch (format)
+    {
+    case OutputFormat::Png:
+        return L".png";
+    case OutputFormat::Raw:
+        return L".raw";
+    default:
+        return L".jpg";
+    }
+}
+
+//
+// Copy the frame pixels and enqueue them to be written by a worker
+//
+std::future<hstring> AsyncFrameWriter::Write(std::wstring const& folderPath, std::wstring const& baseFileName, VideoFrame const& frame)
+{
+    // Throughput is measured from the first frame rather than from the creation of the writer
+    std::call_once(m_startOnce, [this]() { m_startTime = std::chrono::high_resolution_clock::now(); });
+
+    WriteRequest request;
+    request.folderPath = folderPath;
+    request.fileName = baseFileName + FileExtension(m_options.format);
+    request.frameId = SAMPLES_TRACE_FRAME_ID();
+
+    // Detach the pixels from the frame since it may be overwritten or closed by the caller once this returns
+    SAMPLES_TRACE_SCOPE("AsyncFrameWriter::Enqueue");
+    request.bitmap = SoftwareBitmapHelper::GetSoftwareBitmap(frame);
+    if (request.bitmap == frame.SoftwareBitmap())
+    {
+        request.bitmap = SoftwareBitmap::Copy(request.bitmap);
+    }
+    request.memory = MemoryTracker::Allocation(m_queueMemory, (uint64_t)request.bitmap.PixelWidth() * request.bitmap.PixelHeight() * 4);
+
+    auto result = request.completion.get_future();
+    if (!m_queue.Push(std::move(request)))
+    {
+        throw hresult_illegal_method_call(L"Error: attempting to write a frame after the AsyncFrameWriter was closed");
+    }
+    return result;
+}
+
+//
+// Wait for all enqueued frames to be written and stop the workers
+//
+void AsyncFrameWriter::Close()
+{
+    if (m_pressureHandlerId != 0)
+    {
+        m_options.memoryTracker->RemovePressureHandler(m_pressureHandlerId);
+        m_pressureHandlerId = 0;
+    }
+    m_queue.Close();
+    for (auto&& worker : m_workers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+}
+
+//
+// Dequeue and write frames until the writer is closed
+//
+void AsyncFrameWriter::WorkerLoop()
+{
+    while (auto request = m_queue.Pop())
+    {
+        SAMPLES_TRACE_SET_FRAME_ID(request->frameId);
+        SAMPLES_TRACE_SCOPE("AsyncFrameWriter::Write");
+        try
+        {
+            StorageFolder folder = StorageFolder::GetFolderFromPathAsync(request->folderPath).get();
+            StorageFile file = folder.CreateFileAsync(request->fileName, CreationCollisionOption::GenerateUniqueName).get();
+            uint64_t byteCount = (m_options.format == OutputFormat::Raw) ? WriteRaw(*request, file) : WriteEncoded(*request, file);
+
+            m_bytesWritten += byteCount;
+            m_framesWritten++;
+            int64_t writeTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - m_startTime).count();
+            int64_t lastWriteTime = m_lastWriteTime;
+            while (writeTime > lastWriteTime && !m_lastWriteTime.compare_exchange_weak(lastWriteTime, writeTime));
+            request->completion.set_value(file.Path());
+        }
+        catch (...)
+        {
+            m_failures++;
+            request->completion.set_exception(std::current_exception());
+        }
+    }
+}
+
+//
+// Encode the frame as .jpg or .png
+//
+uint64_t AsyncFrameWriter::WriteEncoded(WriteRequest& request, StorageFile const& file)
+{
+    IRandomAccessStream stream = file.OpenAsync(FileAccessMode::ReadWrite).get();
+
+    // Create the encoder from the stream
+    BitmapEncoder encoder = nullptr;
+    if (m_options.format == OutputFormat::Jpeg)
+    {
+        BitmapPropertySet encodingOptions;
+        encodingOptions.Insert(L"ImageQuality", BitmapTypedValue(box_value(m_options.jpegQuality), PropertyType::Single));
+        encoder = BitmapEncoder::CreateAsync(BitmapEncoder::JpegEncoderId(), stream, encodingOptions).get();
+    }
+    else
+    {
+        encoder = BitmapEncoder::CreateAsync(BitmapEncoder::PngEncoderId(), stream).get();
+    }
+    encoder.SetSoftwareBitmap(request.bitmap);
+    encoder.FlushAsync().get();
+
+    uint64_t byteCount = stream.Size();
+    stream.Close();
+    return byteCount;
+}
+
+//
+// Dump the frame pixels uncompressed, prefixed with a RawFrameHeader
+//
+uint64_t AsyncFrameWriter::WriteRaw(WriteRequest& request, StorageFile const& file)
+{
+    SoftwareBitmapHelper::LockedPixels pixels(request.bitmap, BitmapBufferAccessMode::Read);
+    auto& view = pixels.View();
+    uint32_t rowSize = view.width * 4;
+
+    RawFrameHeader header = { { 'R', 'A', 'W', 'F' }, 1, (int32_t)request.bitmap.BitmapPixelFormat(), view.width, view.height, (int32_t)rowSize };
+    std::vector<uint8_t, MemoryTracker::Allocator<uint8_t>> content(
+        sizeof(header) + (size_t)rowSize * view.height,
+        MemoryTracker::Allocator<uint8_t>(m_bufferMemory));
+    memcpy(content.data(), &header, sizeof(header));
+    for (uint32_t y = 0; y < view.height; y++)
+    {
+        memcpy(content.data() + sizeof(header) + (size_t)y * rowSize, view.Row(y), rowSize);
+    }
+
+    FileIO::WriteBytesAsync(file, array_view<const uint8_t>(content.data(), content.data() + content.size())).get();
+    return content.size();
+}
+
+//
+// Write throughput and queue depth since the writer was created
+//
+AsyncFrameWriter::Metrics AsyncFrameWriter::GetMetrics() const
+{
+    Metrics metrics;
+    metrics.framesWritten = m_framesWritten;
+    metrics.bytesWritten = m_bytesWritten;
+    metrics.failures = m_failures;
+    metrics.elapsedSeconds = m_lastWriteTime / 1e9;
+    if (metrics.elapsedSeconds > 0.0)
+    {
+        metrics.framesPerSecond = metrics.framesWritten / metrics.elapsedSeconds;
+        metrics.megabytesPerSecond = metrics.bytesWritten / (1024.0 * 1024.0) / metrics.elapsedSeconds;
+    }
+    metrics.maxQueueDepth = m_queue.MaxDepth();
+    metrics.averageQueueDepth = m_queue.AverageDepth();
+    return metrics;
+}
@@ -0,0 +1,114 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <winrt/Windows.Graphics.Imaging.h>
+#include <winrt/Windows.Media.h>
+#include <winrt/Windows.Storage.h>
+
+#include "BoundedQueue.h"
+#include "MemoryTracker.h"
+
+//
+// Helper class that encodes and writes VideoFrames to files on a pool of worker threads so that
+// folder lookup, encoding and disk I/O do not block the thread evaluating skills.
+// Frames are copied when enqueued, so the caller can reuse the VideoFrame (i.e. a binding output) right away.
+// The queue is bounded: Write() blocks when all workers are busy and the queue is full.
+// When a MemoryTracker is specified, queued frames and raw output buffers are accounted to it and the queue
+// shrinks to a single frame while its pressure is High.
+//
+class AsyncFrameWriter
+{
+public:
+    enum class OutputFormat
+    {
+        Jpeg,
+        Png,
+        Raw // uncompressed pixels prefixed with a RawFrameHeader
+    };
+
+    //
+    // Header written at the beginning of files in OutputFormat::Raw, followed by height * stride bytes of pixels
+    //
+    struct RawFrameHeader
+    {
+        char magic[4]; // "RAWF"
+        uint32_t version;
+        int32_t pixelFormat; // BitmapPixelFormat
+        uint32_t width;
+        uint32_t height;
+        int32_t stride;
+    };
+
+    struct Options
+    {
+        OutputFormat format = OutputFormat::Jpeg;
+        float jpegQuality = 0.9f; // between 0 and 1
+        size_t queueCapacity = 8;
+        uint32_t workerCount = 2;
+        MemoryTracker* memoryTracker = nullptr; // must outlive the writer
+    };
+
+    struct Metrics
+    {
+        uint64_t framesWritten = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t failures = 0;
+        double elapsedSeconds = 0.0; // from the first Write() to the last completed write
+        double framesPerSecond = 0.0;
+        double megabytesPerSecond = 0.0;
+        size_t maxQueueDepth = 0;
+        double averageQueueDepth = 0.0;
+    };
+
+    AsyncFrameWriter(Options const& options);
+    ~AsyncFrameWriter();
+
+    //
+    // Enqueue a frame to be written in the specified folder as <baseFileName>.<extension of the output format>,
+    // generating a unique name if the file already exists.
+    // The returned future holds the path of the written file once done, or the error that occured.
+    //
+    std::future<winrt::hstring> Write(std::wstring const& folderPath, std::wstring const& baseFileName, winrt::Windows::Media::VideoFrame const& frame);
+
+    // Wait for all enqueued frames to be written and stop the workers
+    void Close();
+
+    Metrics GetMetrics() const;
+
+    static const wchar_t* FileExtension(OutputFormat format);
+
+private:
+    struct WriteRequest
+    {
+        std::wstring folderPath;
+        std::wstring fileName;
+        winrt::Windows::Graphics::Imaging::SoftwareBitmap bitmap = nullptr;
+        std::promise<winrt::hstring> completion;
+        uint64_t frameId = 0; // frame the request is traced as part of
+        MemoryTracker::Allocation memory; // pixels of the bitmap
+    };
+
+    void WorkerLoop();
+    uint64_t WriteEncoded(WriteRequest& request, winrt::Windows::Storage::StorageFile const& file);
+    uint64_t WriteRaw(WriteRequest& request, winrt::Windows::Storage::StorageFile const& file);
+
+    Options m_options;
+    BoundedQueue<WriteRequest> m_queue;
+    std::vector<std::thread> m_workers;
+    MemoryTracker::Component* m_queueMemory = nullptr;
+    MemoryTracker::Component* m_bufferMemory = nullptr;
+    uint32_t m_pressureHandlerId = 0;
+    std::once_flag m_startOnce;
+    std::chrono::high_resolution_clock::time_point m_startTime; // of the first Write(), read by workers after dequeuing its frame
+    std::atomic<int64_t> m_lastWriteTime = 0; // nanoseconds since the first Write()
+    std::atomic<uint64_t> m_framesWritten = 0;
+    std::atomic<uint64_t> m_bytesWritten = 0;
+    std::atomic<uint64_t> m_failures = 0;
+};
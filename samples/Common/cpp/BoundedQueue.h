@@ -0,0 +1,175 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+//
+// Thread-safe FIFO queue holding at most a fixed amount of items.
+// Producers block (Push) or fail (TryPush) when the queue is full and consumers block until an item
+// is available or the queue is closed, which lets pipeline stages apply backpressure on each other.
+//
+template <typename T>
+class BoundedQueue
+{
+public:
+    explicit BoundedQueue(size_t capacity)
+        : m_capacity(std::max<size_t>(capacity, 1))
+    {
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    //
+    // Enqueue an item, waiting for room if the queue is full. Returns false if the queue was closed.
+    //
+    bool Push(T item)
+    {
+        std::unique_lock<std::mutex> guard(m_lock);
+        m_notFull.wait(guard, [this]() { return m_isClosed || m_items.size() < m_capacity; });
+        if (m_isClosed)
+        {
+            return false;
+        }
+        PushLocked(std::move(item));
+        guard.unlock();
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    //
+    // Enqueue an item only if there is room for it. Returns false if the queue is full or closed.
+    //
+    bool TryPush(T item)
+    {
+        std::unique_lock<std::mutex> guard(m_lock);
+        if (m_isClosed || m_items.size() >= m_capacity)
+        {
+            return false;
+        }
+        PushLocked(std::move(item));
+        guard.unlock();
+        m_notEmpty.notify_one();
+        return true;
+    }
+
+    //
+    // Dequeue the oldest item, waiting for one if the queue is empty.
+    // Returns an empty optional once the queue is closed and drained.
+    //
+    std::optional<T> Pop()
+    {
+        std::unique_lock<std::mutex> guard(m_lock);
+        m_notEmpty.wait(guard, [this]() { return m_isClosed || !m_items.empty(); });
+        if (m_items.empty())
+        {
+            return std::nullopt;
+        }
+        std::optional<T> item(std::move(m_items.front()));
+        m_items.pop_front();
+        guard.unlock();
+        m_notFull.notify_one();
+        return item;
+    }
+
+    //
+    // Dequeue the oldest item if there is one, without waiting
+    //
+    std::optional<T> TryPop()
+    {
+        std::unique_lock<std::mutex> guard(m_lock);
+        if (m_items.empty())
+        {
+            return std::nullopt;
+        }
+        std::optional<T> item(std::move(m_items.front()));
+        m_items.pop_front();
+        guard.unlock();
+        m_notFull.notify_one();
+        return item;
+    }
+
+    //
+    // Stop accepting new items and wake up all waiting producers and consumers.
+    // Items already enqueued can still be dequeued.
+    //
+    void Close()
+    {
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_isClosed = true;
+        }
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+
+    size_t Size() const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_items.size();
+    }
+
+    // Whether TryPush would fail for lack of room, which may change as soon as it returns
+    bool IsFull() const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_items.size() >= m_capacity;
+    }
+
+    size_t Capacity() const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_capacity;
+    }
+
+    //
+    // Change the amount of items the queue holds at most, i.e. to shrink it under memory pressure.
+    // Items enqueued beyond a lowered capacity are kept, producers wait until the queue drains below it.
+    //
+    void SetCapacity(size_t capacity)
+    {
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_capacity = std::max<size_t>(capacity, 1);
+        }
+        m_notFull.notify_all();
+    }
+
+    // Maximum amount of items held at once since the queue was created
+    size_t MaxDepth() const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_maxDepth;
+    }
+
+    // Average amount of items already in the queue when an item got enqueued
+    double AverageDepth() const
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_pushCount > 0 ? (double)m_depthSum / m_pushCount : 0.0;
+    }
+
+private:
+    void PushLocked(T&& item)
+    {
+        m_depthSum += m_items.size();
+        m_pushCount++;
+        m_items.push_back(std::move(item));
+        m_maxDepth = std::max(m_maxDepth, m_items.size());
+    }
+
+    size_t m_capacity;
+    std::deque<T> m_items;
+    bool m_isClosed = false;
+    size_t m_maxDepth = 0;
+    uint64_t m_depthSum = 0;
+    uint64_t m_pushCount = 0;
+    mutable std::mutex m_lock;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+};
@@ -0,0 +1,619 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "BoxGeometry.h"
+#include <algorithm>
+#include <stdexcept>
+
+#ifdef BOX_GEOMETRY_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+static_assert(sizeof(BoxGeometry::Box) == 4 * sizeof(float), "boxes are loaded 4 floats at a time");
+static_assert(sizeof(BoxGeometry::Point) == 2 * sizeof(float), "points are loaded 2 at a time");
+
+//
+// IoU of a box given by its edges and area with the box at index of a set. The batched version below
+// computes the same operations in the same order, so that both give the same results.
+//
+static inline float IoUAt(float left, float top, float right, float bottom, float area, BoxGeometry::BoxSet const& boxes, size_t index)
+{
+    float intersectionWidth = std::max<float>(std::min<float>(right, boxes.Right()[index]) - std::max<float>(left, boxes.Left()[index]), 0.0f);
+    float intersectionHeight = std::max<float>(std::min<float>(bottom, boxes.Bottom()[index]) - std::max<float>(top, boxes.Top()[index]), 0.0f);
+    float intersection = intersectionWidth * intersectionHeight;
+    float unionArea = area + boxes.Area()[index] - intersection;
+    return unionArea > 0.0f ? intersection / unionArea : 0.0f;
+}
+
+#ifdef BOX_GEOMETRY_USE_SSE2
+// IoU of a box given by its edges and area, each broadcast to 4 lanes, with the 4 boxes of a set starting at index
+static inline __m128 IoUAt4(__m128 left, __m128 top, __m128 right, __m128 bottom, __m128 area, BoxGeometry::BoxSet const& boxes, size_t index)
+{
+    __m128 zero = _mm_setzero_ps();
+    __m128 intersectionWidth = _mm_max_ps(_mm_sub_ps(_mm_min_ps(right, _mm_loadu_ps(boxes.Right() + index)), _mm_max_ps(left, _mm_loadu_ps(boxes.Left() + index))), zero);
+    __m128 intersectionHeight = _mm_max_ps(_mm_sub_ps(_mm_min_ps(bottom, _mm_loadu_ps(boxes.Bottom() + index)), _mm_max_ps(top, _mm_loadu_ps(boxes.Top() + index))), zero);
+    __m128 intersection = _mm_mul_ps(intersectionWidth, intersectionHeight);
+    __m128 unionArea = _mm_sub_ps(_mm_add_ps(area, _mm_loadu_ps(boxes.Area() + index)), intersection);
+
+    // Lanes of empty unions divide by 0, masked to 0 like the scalar version
+    return _mm_and_ps(_mm_div_ps(intersection, unionArea), _mm_cmpgt_ps(unionArea, zero));
+}
+#endif
+
+//
+// IoU of a box given by its edges and area with each box of a set, ious has room for boxes.PaddedSize() values
+//
+static void IoURowOfEdges(float left, float top, float right, float bottom, float area, BoxGeometry::BoxSet const& boxes, float* ious, bool useSimd)
+{
+#ifdef BOX_GEOMETRY_USE_SSE2
+    if (useSimd)
+    {
+        __m128 left4 = _mm_set1_ps(left);
+        __m128 top4 = _mm_set1_ps(top);
+        __m128 right4 = _mm_set1_ps(right);
+        __m128 bottom4 = _mm_set1_ps(bottom);
+        __m128 area4 = _mm_set1_ps(area);
+        for (size_t i = 0; i < boxes.PaddedSize(); i += 4)
+        {
+            _mm_storeu_ps(ious + i, IoUAt4(left4, top4, right4, bottom4, area4, boxes, i));
+        }
+        return;
+    }
+#else
+    (void)useSimd;
+#endif
+    for (size_t i = 0; i < boxes.PaddedSize(); i++)
+    {
+        ious[i] = IoUAt(left, top, right, bottom, area, boxes, i);
+    }
+}
+
+//
+// Edge of a polygon from (x, y) to a previous vertex, prepared for the even-odd rule: a horizontal ray going right
+// from a point crosses it when the point is between the heights of its ends and left of x + (pointY - y) * slope
+//
+struct PolygonEdge
+{
+    float x;
+    float y;
+    float previousY;
+    float slope;
+};
+
+static std::vector<PolygonEdge> PrepareEdges(std::vector<BoxGeometry::Point> const& polygon)
+{
+    std::vector<PolygonEdge> edges;
+    edges.reserve(polygon.size());
+    for (size_t i = 0, previous = polygon.size() - 1; i < polygon.size(); previous = i++)
+    {
+        auto& point = polygon[i];
+        auto& previousPoint = polygon[previous];
+
+        // Horizontal edges are never crossed, whatever their slope
+        float slope = (previousPoint.y != point.y) ? (previousPoint.x - point.x) / (previousPoint.y - point.y) : 0.0f;
+        edges.push_back({ point.x, point.y, previousPoint.y, slope });
+    }
+    return edges;
+}
+
+static inline bool IsInEdges(std::vector<PolygonEdge> const& edges, float x, float y)
+{
+    bool isInside = false;
+    for (auto&& edge : edges)
+    {
+        if ((edge.y > y) != (edge.previousY > y) && x < edge.x + (y - edge.y) * edge.slope)
+        {
+            isInside = !isInside;
+        }
+    }
+    return isInside;
+}
+
+BoxGeometry::Affine BoxGeometry::Affine::ScaleTranslate(float scaleX, float scaleY, float offsetX, float offsetY)
+{
+    Affine transform;
+    transform.m11 = scaleX;
+    transform.m22 = scaleY;
+    transform.dx = offsetX;
+    transform.dy = offsetY;
+    return transform;
+}
+
+BoxGeometry::Affine BoxGeometry::Affine::RegionToFrame(float regionX, float regionY, float regionWidth, float regionHeight, float frameWidth, float frameHeight)
+{
+    if (frameWidth <= 0.0f || frameHeight <= 0.0f)
+    {
+        throw std::invalid_argument("Error: the frame must not be empty");
+    }
+    return ScaleTranslate(regionWidth / frameWidth, regionHeight / frameHeight, regionX / frameWidth, regionY / frameHeight);
+}
+
+BoxGeometry::Affine BoxGeometry::Affine::Then(Affine const& next) const
+{
+    Affine transform;
+    transform.m11 = next.m11 * m11 + next.m12 * m21;
+    transform.m12 = next.m11 * m12 + next.m12 * m22;
+    transform.m21 = next.m21 * m11 + next.m22 * m21;
+    transform.m22 = next.m21 * m12 + next.m22 * m22;
+    transform.dx = next.m11 * dx + next.m12 * dy + next.dx;
+    transform.dy = next.m21 * dx + next.m22 * dy + next.dy;
+    return transform;
+}
+
+BoxGeometry::Affine BoxGeometry::Affine::Inverse() const
+{
+    float determinant = m11 * m22 - m12 * m21;
+    if (determinant == 0.0f)
+    {
+        throw std::invalid_argument("Error: the transform is not invertible");
+    }
+    Affine transform;
+    transform.m11 = m22 / determinant;
+    transform.m12 = -m12 / determinant;
+    transform.m21 = -m21 / determinant;
+    transform.m22 = m11 / determinant;
+    transform.dx = -(transform.m11 * dx + transform.m12 * dy);
+    transform.dy = -(transform.m21 * dx + transform.m22 * dy);
+    return transform;
+}
+
+BoxGeometry::BoxSet::BoxSet(std::vector<Box> const& boxes)
+{
+    Reserve(boxes.size());
+    for (auto&& box : boxes)
+    {
+        Add(box);
+    }
+}
+
+void BoxGeometry::BoxSet::Add(Box const& box)
+{
+    if (m_size == m_left.size())
+    {
+        size_t paddedSize = m_size + 4;
+        m_left.resize(paddedSize, 0.0f);
+        m_top.resize(paddedSize, 0.0f);
+        m_right.resize(paddedSize, 0.0f);
+        m_bottom.resize(paddedSize, 0.0f);
+        m_area.resize(paddedSize, 0.0f);
+    }
+    m_left[m_size] = box.x;
+    m_top[m_size] = box.y;
+    m_right[m_size] = box.x + box.width;
+    m_bottom[m_size] = box.y + box.height;
+    m_area[m_size] = box.width * box.height;
+    m_size++;
+}
+
+void BoxGeometry::BoxSet::Clear()
+{
+    m_size = 0;
+    m_left.clear();
+    m_top.clear();
+    m_right.clear();
+    m_bottom.clear();
+    m_area.clear();
+}
+
+void BoxGeometry::BoxSet::Reserve(size_t count)
+{
+    size_t paddedCount = (count + 3) & ~(size_t)3;
+    m_left.reserve(paddedCount);
+    m_top.reserve(paddedCount);
+    m_right.reserve(paddedCount);
+    m_bottom.reserve(paddedCount);
+    m_area.reserve(paddedCount);
+}
+
+BoxGeometry::Box BoxGeometry::BoxSet::Get(size_t index) const
+{
+    return { m_left[index], m_top[index], m_right[index] - m_left[index], m_bottom[index] - m_top[index] };
+}
+
+bool BoxGeometry::Contains(Box const& box, Point const& point)
+{
+    return point.x >= box.x && point.x <= box.x + box.width && point.y >= box.y && point.y <= box.y + box.height;
+}
+
+float BoxGeometry::IoU(Box const& a, Box const& b)
+{
+    float intersectionWidth = std::max<float>(std::min<float>(a.x + a.width, b.x + b.width) - std::max<float>(a.x, b.x), 0.0f);
+    float intersectionHeight = std::max<float>(std::min<float>(a.y + a.height, b.y + b.height) - std::max<float>(a.y, b.y), 0.0f);
+    float intersection = intersectionWidth * intersectionHeight;
+    float unionArea = Area(a) + Area(b) - intersection;
+    return unionArea > 0.0f ? intersection / unionArea : 0.0f;
+}
+
+void BoxGeometry::IoURow(Box const& box, BoxSet const& boxes, float* ious, bool useSimd)
+{
+    IoURowOfEdges(box.x, box.y, box.x + box.width, box.y + box.height, box.width * box.height, boxes, ious, useSimd);
+}
+
+void BoxGeometry::IoUMatrix(BoxSet const& rows, BoxSet const& columns, std::vector<float>& matrix, bool useSimd)
+{
+    matrix.resize(rows.Size() * columns.Size());
+    if (columns.Size() == 0)
+    {
+        return;
+    }
+
+    // Rows are computed over the padded columns, the padding of the last row lands in a scratch row
+    std::vector<float> lastRow(columns.PaddedSize());
+    for (size_t row = 0; row < rows.Size(); row++)
+    {
+        bool isRoomForPadding = (rows.Size() - row - 1) * columns.Size() >= columns.PaddedSize() - columns.Size();
+        float* ious = isRoomForPadding ? &matrix[row * columns.Size()] : lastRow.data();
+        IoURowOfEdges(rows.Left()[row], rows.Top()[row], rows.Right()[row], rows.Bottom()[row], rows.Area()[row], columns, ious, useSimd);
+        if (!isRoomForPadding)
+        {
+            std::copy(lastRow.begin(), lastRow.begin() + columns.Size(), matrix.begin() + row * columns.Size());
+        }
+    }
+}
+
+//
+// Whether a box overlaps any box of a set by more than iouThreshold, stopping at the first one that does
+//
+bool BoxGeometry::OverlapsAny(Box const& box, BoxSet const& boxes, float iouThreshold, bool useSimd)
+{
+    float left = box.x;
+    float top = box.y;
+    float right = box.x + box.width;
+    float bottom = box.y + box.height;
+    float area = box.width * box.height;
+#ifdef BOX_GEOMETRY_USE_SSE2
+    if (useSimd)
+    {
+        __m128 left4 = _mm_set1_ps(left);
+        __m128 top4 = _mm_set1_ps(top);
+        __m128 right4 = _mm_set1_ps(right);
+        __m128 bottom4 = _mm_set1_ps(bottom);
+        __m128 area4 = _mm_set1_ps(area);
+        __m128 threshold4 = _mm_set1_ps(iouThreshold);
+        for (size_t i = 0; i < boxes.PaddedSize(); i += 4)
+        {
+            if (_mm_movemask_ps(_mm_cmpgt_ps(IoUAt4(left4, top4, right4, bottom4, area4, boxes, i), threshold4)) != 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+#else
+    (void)useSimd;
+#endif
+    for (size_t i = 0; i < boxes.Size(); i++)
+    {
+        if (IoUAt(left, top, right, bottom, area, boxes, i) > iouThreshold)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//
+// Keep each box of order, sorted by decreasing score, that overlaps none of the boxes kept before it
+//
+void BoxGeometry::SuppressSorted(std::vector<uint32_t> const& order, std::vector<Box> const& boxes, NmsOptions const& options, std::vector<uint32_t>& kept)
+{
+    BoxSet keptBoxes;
+    for (uint32_t index : order)
+    {
+        if (options.maxCount > 0 && keptBoxes.Size() >= options.maxCount)
+        {
+            break;
+        }
+        if (!OverlapsAny(boxes[index], keptBoxes, options.iouThreshold, options.useSimd))
+        {
+            keptBoxes.Add(boxes[index]);
+            kept.push_back(index);
+        }
+    }
+}
+
+//
+// Flag, for each box of order, the boxes after it that it overlaps in a row of 64 bit masks, then sweep the rows:
+// a box not suppressed yet is kept and suppresses all the boxes flagged in its row at once
+//
+void BoxGeometry::SuppressBitmask(std::vector<uint32_t> const& order, std::vector<Box> const& boxes, NmsOptions const& options, std::vector<uint32_t>& kept)
+{
+    BoxSet sortedBoxes;
+    sortedBoxes.Reserve(order.size());
+    for (uint32_t index : order)
+    {
+        sortedBoxes.Add(boxes[index]);
+    }
+
+    size_t count = order.size();
+    size_t wordCount = (count + 63) / 64;
+    std::vector<uint64_t> masks(count * wordCount, 0);
+    for (size_t i = 0; i < count; i++)
+    {
+        uint64_t* mask = &masks[i * wordCount];
+        float left = sortedBoxes.Left()[i];
+        float top = sortedBoxes.Top()[i];
+        float right = sortedBoxes.Right()[i];
+        float bottom = sortedBoxes.Bottom()[i];
+        float area = sortedBoxes.Area()[i];
+
+        // Start at the group of 4 holding the next box, the bits up to box i are cleared below
+        size_t first = (i + 1) & ~(size_t)3;
+#ifdef BOX_GEOMETRY_USE_SSE2
+        if (options.useSimd)
+        {
+            __m128 left4 = _mm_set1_ps(left);
+            __m128 top4 = _mm_set1_ps(top);
+            __m128 right4 = _mm_set1_ps(right);
+            __m128 bottom4 = _mm_set1_ps(bottom);
+            __m128 area4 = _mm_set1_ps(area);
+            __m128 threshold4 = _mm_set1_ps(options.iouThreshold);
+            for (size_t j = first; j < sortedBoxes.PaddedSize(); j += 4)
+            {
+                // Groups of 4 never straddle 2 words
+                uint64_t bits = (uint64_t)_mm_movemask_ps(_mm_cmpgt_ps(IoUAt4(left4, top4, right4, bottom4, area4, sortedBoxes, j), threshold4));
+                mask[j / 64] |= bits << (j % 64);
+            }
+        }
+        else
+#endif
+        {
+            for (size_t j = first; j < count; j++)
+            {
+                if (IoUAt(left, top, right, bottom, area, sortedBoxes, j) > options.iouThreshold)
+                {
+                    mask[j / 64] |= (uint64_t)1 << (j % 64);
+                }
+            }
+        }
+        for (size_t j = first; j <= i; j++)
+        {
+            mask[j / 64] &= ~((uint64_t)1 << (j % 64));
+        }
+    }
+
+    std::vector<uint64_t> suppressed(wordCount, 0);
+    size_t keptCount = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        if ((suppressed[i / 64] >> (i % 64)) & 1)
+        {
+            continue;
+        }
+        kept.push_back(order[i]);
+        if (options.maxCount > 0 && ++keptCount >= options.maxCount)
+        {
+            break;
+        }
+        const uint64_t* mask = &masks[i * wordCount];
+        for (size_t word = i / 64; word < wordCount; word++)
+        {
+            suppressed[word] |= mask[word];
+        }
+    }
+}
+
+std::vector<uint32_t> BoxGeometry::SuppressNonMaximum(
+    std::vector<Box> const& boxes,
+    std::vector<float> const& scores,
+    std::vector<int32_t> const& kinds,
+    NmsOptions const& options)
+{
+    if ((!scores.empty() && scores.size() != boxes.size()) || (!kinds.empty() && kinds.size() != boxes.size()))
+    {
+        throw std::invalid_argument("Error: there must be as many scores and kinds as boxes");
+    }
+    if (!(options.iouThreshold >= 0.0f && options.iouThreshold <= 1.0f))
+    {
+        throw std::invalid_argument("Error: the IoU threshold must be between 0 and 1");
+    }
+
+    // Group boxes by kind, then by decreasing score, the first box winning ties
+    auto kindOf = [&](uint32_t index) { return kinds.empty() ? 0 : kinds[index]; };
+    std::vector<uint32_t> order(boxes.size());
+    for (uint32_t i = 0; i < (uint32_t)order.size(); i++)
+    {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+    {
+        if (kindOf(a) != kindOf(b))
+        {
+            return kindOf(a) < kindOf(b);
+        }
+        if (!scores.empty() && scores[a] != scores[b])
+        {
+            return scores[a] > scores[b];
+        }
+        return a < b;
+    });
+
+    std::vector<uint32_t> kept;
+    std::vector<uint32_t> kindOrder;
+    for (size_t begin = 0; begin < order.size();)
+    {
+        size_t end = begin + 1;
+        while (end < order.size() && kindOf(order[end]) == kindOf(order[begin]))
+        {
+            end++;
+        }
+        kindOrder.assign(order.begin() + begin, order.begin() + end);
+        if (options.method == NmsMethod::Bitmask)
+        {
+            SuppressBitmask(kindOrder, boxes, options, kept);
+        }
+        else
+        {
+            SuppressSorted(kindOrder, boxes, options, kept);
+        }
+        begin = end;
+    }
+
+    if (!kinds.empty())
+    {
+        // Merge the kinds back by decreasing score
+        std::sort(kept.begin(), kept.end(), [&](uint32_t a, uint32_t b)
+        {
+            if (!scores.empty() && scores[a] != scores[b])
+            {
+                return scores[a] > scores[b];
+            }
+            return a < b;
+        });
+        if (options.maxCount > 0 && kept.size() > options.maxCount)
+        {
+            kept.resize(options.maxCount);
+        }
+    }
+    return kept;
+}
+
+BoxGeometry::Box BoxGeometry::TransformBox(Affine const& transform, Box const& box)
+{
+    if (transform.IsAxisAligned())
+    {
+        Box result = { transform.m11 * box.x + transform.dx, transform.m22 * box.y + transform.dy, transform.m11 * box.width, transform.m22 * box.height };
+        if (result.width < 0.0f)
+        {
+            result.x += result.width;
+            result.width = -result.width;
+        }
+        if (result.height < 0.0f)
+        {
+            result.y += result.height;
+            result.height = -result.height;
+        }
+        return result;
+    }
+
+    Point corners[4] =
+    {
+        transform.Apply({ box.x, box.y }),
+        transform.Apply({ box.x + box.width, box.y }),
+        transform.Apply({ box.x, box.y + box.height }),
+        transform.Apply({ box.x + box.width, box.y + box.height })
+    };
+    float left = corners[0].x;
+    float top = corners[0].y;
+    float right = corners[0].x;
+    float bottom = corners[0].y;
+    for (auto&& corner : corners)
+    {
+        left = std::min<float>(left, corner.x);
+        top = std::min<float>(top, corner.y);
+        right = std::max<float>(right, corner.x);
+        bottom = std::max<float>(bottom, corner.y);
+    }
+    return { left, top, right - left, bottom - top };
+}
+
+void BoxGeometry::TransformBoxes(Affine const& transform, Box* boxes, size_t count, bool useSimd)
+{
+#ifdef BOX_GEOMETRY_USE_SSE2
+    // Each box is one register, only when the transform keeps boxes axis aligned and does not flip them
+    if (useSimd && transform.IsAxisAligned() && transform.m11 >= 0.0f && transform.m22 >= 0.0f)
+    {
+        __m128 scale = _mm_setr_ps(transform.m11, transform.m22, transform.m11, transform.m22);
+        __m128 offset = _mm_setr_ps(transform.dx, transform.dy, 0.0f, 0.0f);
+        for (size_t i = 0; i < count; i++)
+        {
+            float* box = &boxes[i].x;
+            _mm_storeu_ps(box, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(box), scale), offset));
+        }
+        return;
+    }
+#else
+    (void)useSimd;
+#endif
+    for (size_t i = 0; i < count; i++)
+    {
+        boxes[i] = TransformBox(transform, boxes[i]);
+    }
+}
+
+void BoxGeometry::TransformPoints(Affine const& transform, Point* points, size_t count, bool useSimd)
+{
+    size_t i = 0;
+#ifdef BOX_GEOMETRY_USE_SSE2
+    if (useSimd)
+    {
+        // Two points per register: (x0, y0, x1, y1) * (m11, m22, ...) + (y0, x0, y1, x1) * (m12, m21, ...) + (dx, dy, ...)
+        __m128 diagonal = _mm_setr_ps(transform.m11, transform.m22, transform.m11, transform.m22);
+        __m128 antiDiagonal = _mm_setr_ps(transform.m12, transform.m21, transform.m12, transform.m21);
+        __m128 offset = _mm_setr_ps(transform.dx, transform.dy, transform.dx, transform.dy);
+        for (; i + 2 <= count; i += 2)
+        {
+            float* pair = &points[i].x;
+            __m128 coordinates = _mm_loadu_ps(pair);
+            __m128 swapped = _mm_shuffle_ps(coordinates, coordinates, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_ps(pair, _mm_add_ps(_mm_add_ps(_mm_mul_ps(coordinates, diagonal), _mm_mul_ps(swapped, antiDiagonal)), offset));
+        }
+    }
+#else
+    (void)useSimd;
+#endif
+    for (; i < count; i++)
+    {
+        points[i] = transform.Apply(points[i]);
+    }
+}
+
+bool BoxGeometry::IsInPolygon(std::vector<Point> const& polygon, Point const& point)
+{
+    if (polygon.size() < 3)
+    {
+        return false;
+    }
+    return IsInEdges(PrepareEdges(polygon), point.x, point.y);
+}
+
+uint32_t BoxGeometry::CountInPolygon(std::vector<Point> const& polygon, Point const* points, size_t count, bool useSimd)
+{
+    if (polygon.size() < 3)
+    {
+        return 0;
+    }
+    auto edges = PrepareEdges(polygon);
+    uint32_t insideCount = 0;
+    size_t i = 0;
+#ifdef BOX_GEOMETRY_USE_SSE2
+    if (useSimd)
+    {
+        // Four points per iteration, each lane flipping its inside flag at each edge its ray crosses
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 first = _mm_loadu_ps(&points[i].x);
+            __m128 second = _mm_loadu_ps(&points[i + 2].x);
+            __m128 x = _mm_shuffle_ps(first, second, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 y = _mm_shuffle_ps(first, second, _MM_SHUFFLE(3, 1, 3, 1));
+            __m128 isInside = _mm_setzero_ps();
+            for (auto&& edge : edges)
+            {
+                __m128 isBetween = _mm_xor_ps(_mm_cmpgt_ps(_mm_set1_ps(edge.y), y), _mm_cmpgt_ps(_mm_set1_ps(edge.previousY), y));
+                __m128 crossX = _mm_add_ps(_mm_set1_ps(edge.x), _mm_mul_ps(_mm_sub_ps(y, _mm_set1_ps(edge.y)), _mm_set1_ps(edge.slope)));
+                isInside = _mm_xor_ps(isInside, _mm_and_ps(isBetween, _mm_cmplt_ps(x, crossX)));
+            }
+            int mask = _mm_movemask_ps(isInside);
+            insideCount += (mask & 1) + ((mask >> 1) & 1) + ((mask >> 2) & 1) + ((mask >> 3) & 1);
+        }
+    }
+#else
+    (void)useSimd;
+#endif
+    for (; i < count; i++)
+    {
+        insideCount += IsInEdges(edges, points[i].x, points[i].y) ? 1 : 0;
+    }
+    return insideCount;
+}
+
+void BoxGeometry::CountInZones(
+    std::vector<std::vector<Point>> const& zones,
+    std::vector<Point> const& points,
+    std::vector<uint32_t>& counts,
+    bool useSimd)
+{
+    counts.assign(zones.size(), 0);
+    for (size_t i = 0; i < zones.size(); i++)
+    {
+        counts[i] = CountInPolygon(zones[i], points.data(), points.size(), useSimd);
+    }
+}
@@ -0,0 +1,158 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// SSE2 is used when targeting x86 or x64, other architectures use the equivalent scalar code
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BOX_GEOMETRY_USE_SSE2
+#endif
+
+//
+// Helper class with the geometry kernels needed to post-process the boxes and joints skills detect:
+// - intersection over union (IoU) of one box against many, and IoU matrices between two sets of boxes
+// - non-maximum suppression (NMS) of overlapping boxes of the same kind, either by comparing each box to the ones
+//   kept so far (Sorted) or by computing the overlaps of all pairs up front and sweeping them as bitmasks (Bitmask)
+// - affine mapping of boxes and points, i.e. from the crop or region a skill evaluated back to the frame
+// - point in polygon tests and counting of points per zone
+// Batched kernels process 4 boxes or points at a time with SSE2 on x86/x64 and give the same results as the scalar code.
+//
+class BoxGeometry
+{
+public:
+    // Axis aligned box, with the same layout as Windows::Foundation::Rect
+    struct Box
+    {
+        float x;
+        float y;
+        float width;
+        float height;
+    };
+
+    struct Point
+    {
+        float x;
+        float y;
+    };
+
+    //
+    // Affine transform mapping (x, y) to (m11 * x + m12 * y + dx, m21 * x + m22 * y + dy)
+    //
+    struct Affine
+    {
+        float m11 = 1.0f;
+        float m12 = 0.0f;
+        float m21 = 0.0f;
+        float m22 = 1.0f;
+        float dx = 0.0f;
+        float dy = 0.0f;
+
+        static Affine ScaleTranslate(float scaleX, float scaleY, float offsetX, float offsetY);
+
+        // Map coordinates normalized in a region of a frame, given in frame pixels, to coordinates normalized in the frame
+        static Affine RegionToFrame(float regionX, float regionY, float regionWidth, float regionHeight, float frameWidth, float frameHeight);
+
+        // Transform applying this one, then next
+        Affine Then(Affine const& next) const;
+
+        // Throws if the transform is not invertible
+        Affine Inverse() const;
+
+        bool IsAxisAligned() const { return m12 == 0.0f && m21 == 0.0f; }
+        Point Apply(Point const& point) const { return { m11 * point.x + m12 * point.y + dx, m21 * point.x + m22 * point.y + dy }; }
+    };
+
+    //
+    // Boxes stored as separate arrays of edges and areas so that batched kernels load 4 boxes at a time.
+    // The arrays are padded with empty boxes to a multiple of 4, which never overlap anything.
+    //
+    class BoxSet
+    {
+    public:
+        BoxSet() = default;
+        explicit BoxSet(std::vector<Box> const& boxes);
+
+        void Add(Box const& box);
+        void Clear();
+        void Reserve(size_t count);
+
+        size_t Size() const { return m_size; }
+        size_t PaddedSize() const { return m_left.size(); }
+        Box Get(size_t index) const;
+
+        const float* Left() const { return m_left.data(); }
+        const float* Top() const { return m_top.data(); }
+        const float* Right() const { return m_right.data(); }
+        const float* Bottom() const { return m_bottom.data(); }
+        const float* Area() const { return m_area.data(); }
+
+    private:
+        size_t m_size = 0;
+        std::vector<float> m_left;
+        std::vector<float> m_top;
+        std::vector<float> m_right;
+        std::vector<float> m_bottom;
+        std::vector<float> m_area;
+    };
+
+    enum class NmsMethod
+    {
+        Sorted, // compare each box to the boxes kept so far, cheap when few boxes are kept
+        Bitmask // compute the overlaps of all pairs, then sweep them 64 boxes at a time, cost independent of how many are kept
+    };
+
+    struct NmsOptions
+    {
+        float iouThreshold = 0.5f; // overlap above which the box with the lower score is suppressed
+        NmsMethod method = NmsMethod::Sorted;
+        uint32_t maxCount = 0; // boxes kept at most, those with the highest scores, 0 to keep all
+        bool useSimd = true; // only effective when BOX_GEOMETRY_USE_SSE2 is defined
+    };
+
+    static float Area(Box const& box) { return box.width * box.height; }
+    static bool Contains(Box const& box, Point const& point);
+
+    // Intersection over union of two boxes, 0 when they do not overlap
+    static float IoU(Box const& a, Box const& b);
+
+    // IoU of a box with each box of a set, ious has room for boxes.PaddedSize() values
+    static void IoURow(Box const& box, BoxSet const& boxes, float* ious, bool useSimd = true);
+
+    // IoU of each box of rows with each box of columns, row by row
+    static void IoUMatrix(BoxSet const& rows, BoxSet const& columns, std::vector<float>& matrix, bool useSimd = true);
+
+    //
+    // Indexes of the boxes left once each box overlapping a box of the same kind with a higher score is suppressed,
+    // by decreasing score. Boxes rank in their order when scores is empty and are all of the same kind when kinds is empty.
+    //
+    static std::vector<uint32_t> SuppressNonMaximum(
+        std::vector<Box> const& boxes,
+        std::vector<float> const& scores,
+        std::vector<int32_t> const& kinds,
+        NmsOptions const& options);
+
+    // Bounding box of the transformed box, the box itself when the transform is axis aligned
+    static Box TransformBox(Affine const& transform, Box const& box);
+    static void TransformBoxes(Affine const& transform, Box* boxes, size_t count, bool useSimd = true);
+    static void TransformPoints(Affine const& transform, Point* points, size_t count, bool useSimd = true);
+
+    // Even-odd rule, a point right on an edge may be found on either side of it
+    static bool IsInPolygon(std::vector<Point> const& polygon, Point const& point);
+
+    // Amount of points in the polygon, polygons of less than 3 vertices contain none
+    static uint32_t CountInPolygon(std::vector<Point> const& polygon, Point const* points, size_t count, bool useSimd = true);
+
+    // Amount of points in each zone, a point in overlapping zones counts in each of them
+    static void CountInZones(
+        std::vector<std::vector<Point>> const& zones,
+        std::vector<Point> const& points,
+        std::vector<uint32_t>& counts,
+        bool useSimd = true);
+
+private:
+    static bool OverlapsAny(Box const& box, BoxSet const& boxes, float iouThreshold, bool useSimd);
+    static void SuppressSorted(std::vector<uint32_t> const& order, std::vector<Box> const& boxes, NmsOptions const& options, std::vector<uint32_t>& kept);
+    static void SuppressBitmask(std::vector<uint32_t> const& order, std::vector<Box> const& boxes, NmsOptions const& options, std::vector<uint32_t>& kept);
+};
@@ -2,13 +2,19 @@
 #include "CameraHelper_cppwinrt.h"
 #include <Mferror.h>
 #include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <stdexcept>
 #include <winerror.h>
 #include <winrt\Windows.Foundation.Collections.h>
 #include <winrt\Windows.Foundation.h>
 #include <winrt\Windows.Media.MediaProperties.h>
 
+#include "Tracing.h"
+
 using namespace winrt;
 using namespace winrt::Windows::Media;
 using namespace winrt::Windows::Media::Capture;
@@ -28,7 +34,12 @@ std::string ToUpperString(winrt::hstring value)
 //
 // CameraHelper factory method that regsiters a callback for when new VideoFrames become available
 //
-CameraHelper* CameraHelper::CreateCameraHelper(winrt::delegate<std::string> failureHandler, winrt::delegate<VideoFrame> newFrameArrivedHandler)
+CameraHelper* CameraHelper::CreateCameraHelper(
+    winrt::delegate<std::string> failureHandler,
+    winrt::delegate<VideoFrame> newFrameArrivedHandler,
+    std::shared_ptr<FrameDeadlinePolicy> deadlinePolicy,
+    std::shared_ptr<FrameRecorder> recorder,
+    winrt::delegate<CameraReconnector::Gap> gapHandler)
 {
     if (failureHandler == nullptr)
     {
@@ -44,7 +55,31 @@ CameraHelper* CameraHelper::CreateCameraHelper(winrt::delegate<std::string> fail
     {
         instance->m_signalFailure.add(failureHandler);
         instance->m_signalFrameAvailable.add(newFrameArrivedHandler);
-        instance->Initialize();
+        if (gapHandler != nullptr)
+        {
+            instance->m_signalGap.add(gapHandler);
+        }
+        instance->m_deadlinePolicy = deadlinePolicy;
+        instance->m_recorder = recorder;
+
+        // The camera is opened on this thread first, then reopened by the reconnect thread after each failure
+        instance->m_reconnector = std::make_unique<CameraReconnector>(
+            [instance]()
+            {
+                try
+                {
+                    instance->Initialize();
+                }
+                catch (hresult_error const& ex)
+                {
+                    // Reported as the reason reopening gave up
+                    throw std::runtime_error(winrt::to_string(ex.message()) + " (" + std::to_string(ex.code().value) + ")");
+                }
+            },
+            [instance]() { instance->CloseCapture(); },
+            [instance](CameraReconnector::Gap const& gap) { instance->m_signalGap(gap); },
+            [instance](std::string const& message) { instance->m_signalFailure(message); });
+        instance->m_reconnector->Start();
     }
     catch (...)
     {
@@ -58,11 +93,128 @@ CameraHelper* CameraHelper::CreateCameraHelper(winrt::delegate<std::string> fail
     return instance;
 }
 
+//
+// Format negotiated for a frame source, identified by the id of the source
+//
+struct CachedFormat
+{
+    std::wstring subtype;
+    uint32_t width;
+    uint32_t height;
+    uint32_t frameRateNumerator;
+    uint32_t frameRateDenominator;
+};
+static std::mutex s_formatCacheLock;
+static std::map<std::wstring, CachedFormat> s_formatCache;
+
+static bool IsSameFormat(MediaFrameFormat const& format, CachedFormat const& cachedFormat)
+{
+    return format.Subtype() == cachedFormat.subtype.c_str()
+        && format.VideoFormat().Width() == cachedFormat.width
+        && format.VideoFormat().Height() == cachedFormat.height
+        && format.FrameRate().Numerator() == cachedFormat.frameRateNumerator
+        && format.FrameRate().Denominator() == cachedFormat.frameRateDenominator;
+}
+
+static CachedFormat ToCachedFormat(MediaFrameFormat const& format)
+{
+    return { format.Subtype().c_str(), format.VideoFormat().Width(), format.VideoFormat().Height(), format.FrameRate().Numerator(), format.FrameRate().Denominator() };
+}
+
+//
+// Find the supported format of a frame source that was negotiated when it was last opened, nullptr if none
+//
+static MediaFrameFormat FindCachedFormat(MediaFrameSource const& frameSource, std::wstring const& sourceId)
+{
+    CachedFormat cachedFormat;
+    {
+        std::lock_guard<std::mutex> guard(s_formatCacheLock);
+        auto cacheEntry = s_formatCache.find(sourceId);
+        if (cacheEntry == s_formatCache.end())
+        {
+            return nullptr;
+        }
+        cachedFormat = cacheEntry->second;
+    }
+    for (auto&& format : frameSource.SupportedFormats())
+    {
+        if (IsSameFormat(format, cachedFormat))
+        {
+            return format;
+        }
+    }
+    return nullptr;
+}
+
+//
+// Select the format of highest resolution at 15fps+, in BGRA8 if possible
+//
+static MediaFrameFormat SelectFormat(MediaFrameSource const& frameSource)
+{
+    auto mediaFrameFormats = frameSource.SupportedFormats();
+    std::vector<MediaFrameFormat> sortedMediaFrameFormats;
+    for (auto&& format : mediaFrameFormats)
+    {
+        sortedMediaFrameFormats.push_back(format);
+    }
+
+    // Sort supported format by descending order of resolution
+    std::sort(
+        sortedMediaFrameFormats.begin(),
+        sortedMediaFrameFormats.end(),
+        [&](const MediaFrameFormat& format1, const MediaFrameFormat& format2) -> bool {
+            return format1.VideoFormat().Width()* format1.VideoFormat().Height() > format2.VideoFormat().Width()* format2.VideoFormat().Height();
+        });
+
+    // Find a format in Bgra at 15+fps
+    auto compatibleFormat = std::find_if(
+        sortedMediaFrameFormats.begin(),
+        sortedMediaFrameFormats.end(),
+        [&](const MediaFrameFormat & format) -> bool {
+            std::string formatUTF8 = ToUpperString(format.Subtype());
+            return format.FrameRate().Numerator() / format.FrameRate().Denominator() >= 15 //fps
+                && 0 == formatUTF8.compare(ToUpperString(MediaEncodingSubtypes::Bgra8()));
+        });
+
+    // If not possible, then try to use other supported format at 15fps+
+    if (compatibleFormat == sortedMediaFrameFormats.end())
+    {
+        compatibleFormat = std::find_if(
+            sortedMediaFrameFormats.begin(),
+            sortedMediaFrameFormats.end(),
+            [&](const MediaFrameFormat & format) -> bool {
+                std::string formatUTF8 = ToUpperString(format.Subtype());
+                return format.FrameRate().Numerator() / format.FrameRate().Denominator() >= 15 //fps
+                    && (0 == formatUTF8.compare(ToUpperString(MediaEncodingSubtypes::Nv12())) || 0 == formatUTF8.compare(ToUpperString(MediaEncodingSubtypes::Yuy2())) || 0 == formatUTF8.compare(ToUpperString(MediaEncodingSubtypes::Rgb32())));
+            });
+    }
+    if (compatibleFormat == sortedMediaFrameFormats.end())
+    {
+        std::cerr << "No suitable media format found on the selected source";
+        winrt::throw_hresult(MF_E_INVALIDMEDIATYPE);
+    }
+    return *compatibleFormat;
+}
+
+//
+// Milliseconds elapsed since begin, which is moved to now for the next phase
+//
+static float LapMs(std::chrono::high_resolution_clock::time_point& begin)
+{
+    auto end = std::chrono::high_resolution_clock::now();
+    float elapsedMs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+    begin = end;
+    return elapsedMs;
+}
+
 //
 // Initialize camera pipeline resources and register a callback for when new VideoFrames become available.
 //
 void CameraHelper::Initialize()
 {
+    StartupProfile profile;
+    auto begin = std::chrono::high_resolution_clock::now();
+
     // Initialize MediaCapture with default settings in video-only streaming mode.
     // We first try to aquire exclusive sharing mode and if we fail, we then attempt again in shared mode
     // so that multiple instances can access the camera concurrently
@@ -72,10 +224,14 @@ void CameraHelper::Initialize()
     mediaCaptureInitializationSettings.StreamingCaptureMode(StreamingCaptureMode::Video);
 
     // Register a callback in case MediaCapture fails. This can happen for example if another app is using the camera and we can't get ExclusiveControl
-    m_mediaCapture.Failed({ this, &CameraHelper::MediaCapture_Failed });
+    m_failureEventToken = m_mediaCapture.Failed({ this, &CameraHelper::MediaCapture_Failed });
 
     // This call will throw if there are no cameras attached
-    m_mediaCapture.InitializeAsync(mediaCaptureInitializationSettings).get();
+    {
+        SAMPLES_TRACE_SCOPE("CameraHelper::InitializeAsync");
+        m_mediaCapture.InitializeAsync(mediaCaptureInitializationSettings).get();
+    }
+    profile.initializeMs = LapMs(begin);
 
     // Get a list of available frame sources and iterate through them to find a video preview or 
     // a video record source with color images (and not IR, depth or other types)
@@ -110,58 +266,37 @@ void CameraHelper::Initialize()
         std::cerr << "No valid video frame sources were found with source type color.";
         winrt::throw_hresult(MF_E_INVALIDMEDIATYPE);
     }
+    profile.enumerateSourcesMs = LapMs(begin);
 
-    // If initializing in ExclusiveControl mode, attempt to use a 15fps+ BGRA8 format natively from the camera.
-    // If not, just use whatever format is already set.
+    // If initializing in ExclusiveControl mode, attempt to use a 15fps+ BGRA8 format natively from the camera,
+    // the one negotiated when the source was last opened if any. If not, just use whatever format is already set.
     auto selectedFrameSource = frameSourceIterator.Current().Value();
     MediaFrameFormat selectedFormat = selectedFrameSource.CurrentFormat();
     if (m_sharingMode == MediaCaptureSharingMode::ExclusiveControl)
     {
-        auto mediaFrameFormats = selectedFrameSource.SupportedFormats();
-        std::vector<MediaFrameFormat> sortedMediaFrameFormats;
-        for (auto&& format : mediaFrameFormats)
+        std::wstring sourceId = selectedFrameSource.Info().Id().c_str();
+        MediaFrameFormat compatibleFormat = FindCachedFormat(selectedFrameSource, sourceId);
+        profile.isFormatCached = (compatibleFormat != nullptr);
+        if (compatibleFormat == nullptr)
         {
-            sortedMediaFrameFormats.push_back(format);
+            SAMPLES_TRACE_SCOPE("CameraHelper::SelectFormat");
+            compatibleFormat = SelectFormat(selectedFrameSource);
         }
+        profile.selectFormatMs = LapMs(begin);
 
-        // Sort supported format by descending order of resolution
-        std::sort(
-            sortedMediaFrameFormats.begin(),
-            sortedMediaFrameFormats.end(),
-            [&](const MediaFrameFormat& format1, const MediaFrameFormat& format2) -> bool {
-                return format1.VideoFormat().Width()* format1.VideoFormat().Height() > format2.VideoFormat().Width()* format2.VideoFormat().Height();
-            });
-
-        // Find a format in Bgra at 15+fps
-        auto compatibleFormat = std::find_if(
-            sortedMediaFrameFormats.begin(),
-            sortedMediaFrameFormats.end(),
-            [&](const MediaFrameFormat & format) -> bool {
-                std::string formatUTF8 = ToUpperString(format.Subtype());
-                return format.FrameRate().Numerator() / format.FrameRate().Denominator() >= 15 //fps
-                    && 0 == formatUTF8.compare(ToUpperString(MediaEncodingSubtypes::Bgra8()));
-            });
-
-        // If not possible, then try to use other supported format at 15fps+
-        if (compatibleFormat == sortedMediaFrameFormats.end())
+        // Setting the format restarts the stream of the source, skip it if the source already uses the format
+        if (selectedFormat == nullptr || !IsSameFormat(selectedFormat, ToCachedFormat(compatibleFormat)))
         {
-            compatibleFormat = std::find_if(
-                sortedMediaFrameFormats.begin(),
-                sortedMediaFrameFormats.end(),
-                [&](const MediaFrameFormat & format) -> bool {
-                    std::string formatUTF8 = ToUpperString(format.Subtype());
-                    return format.FrameRate().Numerator() / format.FrameRate().Denominator() >= 15 //fps
-                        && (0 == formatUTF8.compare(ToUpperString(MediaEncodingSubtypes::Nv12())) || 0 == formatUTF8.compare(ToUpperString(MediaEncodingSubtypes::Yuy2())) || 0 == formatUTF8.compare(ToUpperString(MediaEncodingSubtypes::Rgb32())));
-                });
+            SAMPLES_TRACE_SCOPE("CameraHelper::SetFormatAsync");
+            selectedFrameSource.SetFormatAsync(compatibleFormat).get();
+            selectedFormat = selectedFrameSource.CurrentFormat();
+            profile.isFormatSet = true;
         }
-        if (compatibleFormat == sortedMediaFrameFormats.end())
+        profile.setFormatMs = LapMs(begin);
         {
-            std::cerr << "No suitable media format found on the selected source";
-            winrt::throw_hresult(MF_E_INVALIDMEDIATYPE);
+            std::lock_guard<std::mutex> guard(s_formatCacheLock);
+            s_formatCache[sourceId] = ToCachedFormat(selectedFormat);
         }
-        selectedFormat = *compatibleFormat;
-        selectedFrameSource.SetFormatAsync(selectedFormat).get();
-        selectedFormat = selectedFrameSource.CurrentFormat();
 
         std::wcout << "Attempting to set camera source to " << selectedFormat.Subtype().c_str()
             << " : " << std::to_wstring(selectedFormat.VideoFormat().Width()) << "x" << std::to_wstring(selectedFormat.VideoFormat().Height())
@@ -172,20 +307,70 @@ void CameraHelper::Initialize()
         << " : " << std::to_wstring(selectedFormat.VideoFormat().Width()) << "x" << std::to_wstring(selectedFormat.VideoFormat().Height())
         << "@" << std::to_wstring(selectedFormat.FrameRate().Numerator() / selectedFormat.FrameRate().Denominator()) << L"fps" << std::endl;
 
+    if (m_recorder != nullptr)
+    {
+        m_recorder->RecordFormat(selectedFormat);
+    }
+    begin = std::chrono::high_resolution_clock::now();
+
     // Create FrameReader with the FrameSource that we selected in the loop above.
-    m_frameReader = m_mediaCapture.CreateFrameReaderAsync(frameSourceIterator.Current().Value()).get();
+    {
+        SAMPLES_TRACE_SCOPE("CameraHelper::CreateFrameReaderAsync");
+        m_frameReader = m_mediaCapture.CreateFrameReaderAsync(frameSourceIterator.Current().Value()).get();
+    }
+    profile.createReaderMs = LapMs(begin);
 
     // Set up a delegate to handle the frames when they are ready
     m_frameArrivedEventToken = m_frameReader.FrameArrived({ this, &CameraHelper::FrameArrivedHandler});
 
     // Finally start the FrameReader
-    m_frameReader.StartAsync().get();
+    {
+        SAMPLES_TRACE_SCOPE("CameraHelper::StartAsync");
+        m_frameReader.StartAsync().get();
+    }
+    profile.startMs = LapMs(begin);
+
+    std::lock_guard<std::mutex> guard(m_profileLock);
+    m_lastStartupProfile = profile;
+}
+
+CameraHelper::StartupProfile CameraHelper::LastStartupProfile() const
+{
+    std::lock_guard<std::mutex> guard(m_profileLock);
+    return m_lastStartupProfile;
 }
 
 //
-// Dispose of camera pipeline resources
+// Startup profile as a single line, i.e. "initialize: 412.3ms | sources: 8.1ms | ..."
+//
+std::string CameraHelper::StartupProfile::ToString() const
+{
+    char text[256];
+    snprintf(text, sizeof(text), "initialize: %.1fms | sources: %.1fms | format: %.1fms%s | set format: %.1fms%s | reader: %.1fms | start: %.1fms | camera total: %.1fms",
+        initializeMs, enumerateSourcesMs, selectFormatMs, isFormatCached ? " (cached)" : "", setFormatMs, isFormatSet ? "" : " (skipped)",
+        createReaderMs, startMs, TotalMs());
+    return text;
+}
+
+//
+// Stop reopening the camera and dispose of camera pipeline resources
 //
 void CameraHelper::Cleanup()
+{
+    if (m_reconnector != nullptr)
+    {
+        m_reconnector->Stop();
+    }
+    else
+    {
+        CloseCapture();
+    }
+}
+
+//
+// Dispose of camera pipeline resources, the camera can be initialized again afterwards
+//
+void CameraHelper::CloseCapture()
 {
     // Revoke callback, stop FrameReader and close instances
     if (m_frameReader != nullptr)
@@ -210,15 +395,47 @@ void CameraHelper::Cleanup()
 void CameraHelper::FrameArrivedHandler(MediaFrameReader FrameReader, MediaFrameArrivedEventArgs)
 {
     MediaFrameReference mediaFrame(nullptr);
+    int64_t arrivalTime = FrameDeadlinePolicy::SystemRelativeNow();
+
+    // Tag the events traced on this thread while handling the frame, including those of the registered frame handler
+    SAMPLES_TRACE_SET_FRAME_ID(++m_frameCount);
+    SAMPLES_TRACE_SCOPE("CameraHelper::FrameArrived");
 
     // Try to get the actual Video Frame from the FrameReader
-    mediaFrame = FrameReader.TryAcquireLatestFrame();
+    {
+        SAMPLES_TRACE_SCOPE("TryAcquireLatestFrame");
+        mediaFrame = FrameReader.TryAcquireLatestFrame();
+    }
     if (mediaFrame != nullptr)
     {
+        // Frames arriving again after a camera failure are preceded by a gap for the frame handlers
+        m_reconnector->NotifyFrame(arrivalTime);
+
+        // Record the frame before it may get discarded so that a replay reproduces the load the camera generated
+        auto captureTime = mediaFrame.SystemRelativeTime();
+        if (m_recorder != nullptr && mediaFrame.VideoMediaFrame() != nullptr)
+        {
+            m_recorder->Record(mediaFrame.VideoMediaFrame().GetVideoFrame(), captureTime != nullptr ? captureTime.Value().count() : -1, arrivalTime);
+        }
+
+        // Discard the frame if it already waited past the deadline, a newer one is on its way
+        if (m_deadlinePolicy != nullptr && captureTime != nullptr && !m_deadlinePolicy->Admit(captureTime.Value().count()))
+        {
+            mediaFrame.Close();
+            return;
+        }
+
         auto vmFrame = mediaFrame.VideoMediaFrame();
         if (vmFrame != nullptr)
         {
-            auto videoFrame = vmFrame.GetVideoFrame();
+            VideoFrame videoFrame = nullptr;
+            {
+                SAMPLES_TRACE_SCOPE("GetVideoFrame");
+                videoFrame = vmFrame.GetVideoFrame();
+            }
+
+            // Tag the frame with its capture time so that the age of the results derived from it can be tracked
+            videoFrame.SystemRelativeTime(captureTime);
             m_signalFrameAvailable(videoFrame);
         }
         mediaFrame.Close();
@@ -226,12 +443,21 @@ void CameraHelper::FrameArrivedHandler(MediaFrameReader FrameReader, MediaFrameA
 }
 
 //
-// Handle MediaCapture failure
+// Retrieve the capture time CameraHelper tagged a frame with
+//
+int64_t CameraHelper::GetCaptureTime(VideoFrame const& videoFrame)
+{
+    auto captureTime = videoFrame.SystemRelativeTime();
+    return captureTime != nullptr ? captureTime.Value().count() : -1;
+}
+
+//
+// Handle MediaCapture failure by handing the camera over to the reconnect thread, so that this thread does not block
+// on reinitializing it
 //
-void CameraHelper::MediaCapture_Failed(MediaCapture sender, MediaCaptureFailedEventArgs errorEventArgs)
+void CameraHelper::MediaCapture_Failed(MediaCapture, MediaCaptureFailedEventArgs errorEventArgs)
 {
     std::wcerr << L"MediaCapture failed: " << errorEventArgs.Message().c_str() << std::endl;
-    Cleanup();
 
     // if we failed to initialize MediaCapture ExclusiveControl with MF_E_HW_MFT_FAILED_START_STREAMING,
     // let's retry in SharedReadOnly mode since this points to a camera already in use
@@ -239,11 +465,7 @@ void CameraHelper::MediaCapture_Failed(MediaCapture sender, MediaCaptureFailedEv
         && errorEventArgs.Code() == 0xc00d3704)
     {
         m_sharingMode = MediaCaptureSharingMode::SharedReadOnly;
-        std::cout << "Retrying MediaCapture initialization" << std::endl;
-        Initialize();
+        std::cout << "Retrying MediaCapture initialization in shared mode" << std::endl;
     }
-    else
-    {
-        m_signalFailure(std::string("Camera error:") + std::to_string(errorEventArgs.Code()) + winrt::to_string(errorEventArgs.Message()));
-    }
-}
\ No newline at end of file
+    m_reconnector->ReportFailure(std::string("Camera error:") + std::to_string(errorEventArgs.Code()) + winrt::to_string(errorEventArgs.Message()));
+}
@@ -1,34 +1,89 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <winrt/Windows.Media.h>
 #include <winrt/windows.media.capture.h>
 #include <winrt/windows.media.capture.frames.h>
 #include <winrt/Windows.Devices.Enumeration.h>
 #include <winrt/windows.system.threading.h>
 
+#include "CameraReconnector.h"
+#include "FrameDeadlinePolicy.h"
+#include "FrameRecorder_cppwinrt.h"
+
 //
-// Helper class to initialize a basic camera pipeline
+// Helper class to initialize a basic camera pipeline.
+// When the camera fails, it is reopened in the background by a CameraReconnector while frame handlers and the skill
+// bindings they use stay alive. failureHandler is only called once reopening gave up.
+// The format negotiated for a frame source is cached for the lifetime of the process, so that reopening the source,
+// i.e. after a failure or from another CameraHelper, skips sorting its formats and setting the one it already uses.
 //
 class CameraHelper
 {
 public:
-    static CameraHelper* CreateCameraHelper(winrt::delegate<std::string> failureHandler, winrt::delegate<winrt::Windows::Media::VideoFrame> newFrameArrivedHandler);
+    //
+    // Duration of each phase of a camera initialization, in milliseconds
+    //
+    struct StartupProfile
+    {
+        float initializeMs = 0.0f; // MediaCapture::InitializeAsync
+        float enumerateSourcesMs = 0.0f; // frame source selection
+        float selectFormatMs = 0.0f; // format sort and selection, or lookup of the cached format
+        float setFormatMs = 0.0f; // SetFormatAsync, skipped when the source already uses the selected format
+        float createReaderMs = 0.0f; // CreateFrameReaderAsync
+        float startMs = 0.0f; // MediaFrameReader::StartAsync
+        bool isFormatCached = false; // the format negotiated by a previous initialization of the source was reused
+        bool isFormatSet = false;
+
+        float TotalMs() const { return initializeMs + enumerateSourcesMs + selectFormatMs + setFormatMs + createReaderMs + startMs; }
+        std::string ToString() const;
+    };
+
+    // Frames older than the deadline of deadlinePolicy, when specified, are discarded before reaching newFrameArrivedHandler.
+    // All frames that arrive, discarded ones included, and the negotiated format are recorded with recorder when specified.
+    // gapHandler, when specified, is called before the first frame following a camera recovery, on the same thread.
+    static CameraHelper* CreateCameraHelper(
+        winrt::delegate<std::string> failureHandler,
+        winrt::delegate<winrt::Windows::Media::VideoFrame> newFrameArrivedHandler,
+        std::shared_ptr<FrameDeadlinePolicy> deadlinePolicy = nullptr,
+        std::shared_ptr<FrameRecorder> recorder = nullptr,
+        winrt::delegate<CameraReconnector::Gap> gapHandler = nullptr);
     void Cleanup();
+
+    // Camera failures, recoveries and frames lost across them
+    CameraReconnector::Statistics ReconnectStatistics() const { return m_reconnector->GetStatistics(); }
+
+    // Phases of the last camera initialization, the first one or the last reopening after a failure
+    StartupProfile LastStartupProfile() const;
+
+    // Capture time of a frame provided by CameraHelper in 100ns ticks of the system-relative clock, -1 if unknown
+    static int64_t GetCaptureTime(winrt::Windows::Media::VideoFrame const& videoFrame);
     
 private:
     CameraHelper(){};
     void Initialize();
+    void CloseCapture();
     void FrameArrivedHandler(winrt::Windows::Media::Capture::Frames::MediaFrameReader FrameReader, winrt::Windows::Media::Capture::Frames::MediaFrameArrivedEventArgs);
     void MediaCapture_Failed(winrt::Windows::Media::Capture::MediaCapture sender, winrt::Windows::Media::Capture::MediaCaptureFailedEventArgs errorEventArgs);
 
     winrt::Windows::Media::Capture::MediaCapture m_mediaCapture = nullptr;
-    winrt::Windows::Media::Capture::MediaCaptureSharingMode m_sharingMode = winrt::Windows::Media::Capture::MediaCaptureSharingMode::ExclusiveControl;
+    std::atomic<winrt::Windows::Media::Capture::MediaCaptureSharingMode> m_sharingMode = winrt::Windows::Media::Capture::MediaCaptureSharingMode::ExclusiveControl; // changed by failures, read when reopening
     winrt::Windows::Media::Capture::Frames::MediaFrameReader m_frameReader = nullptr;
     int m_firstFrameReceived = 0;
+    std::atomic<uint64_t> m_frameCount = 0; // frames acquired so far, identifies frames in traces
+    std::shared_ptr<FrameDeadlinePolicy> m_deadlinePolicy;
+    std::shared_ptr<FrameRecorder> m_recorder;
     winrt::event<winrt::delegate<winrt::Windows::Media::VideoFrame>> m_signalFrameAvailable;
     winrt::event<winrt::delegate<std::string>> m_signalFailure;
+    winrt::event<winrt::delegate<CameraReconnector::Gap>> m_signalGap;
     winrt::event_token m_frameArrivedEventToken;
     winrt::event_token m_failureEventToken;
     winrt::slim_mutex lock;
+    mutable std::mutex m_profileLock;
+    StartupProfile m_lastStartupProfile;
+    std::unique_ptr<CameraReconnector> m_reconnector; // declared last so that it stops before the members it drives are destroyed
 };
\ No newline at end of file
@@ -0,0 +1,274 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "CameraReconnector.h"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <stdexcept>
+
+CameraReconnector::CameraReconnector(
+    DeviceHandler open,
+    DeviceHandler close,
+    GapHandler gapHandler,
+    GiveUpHandler giveUpHandler,
+    Options const& options,
+    Clock clock)
+    : m_open(std::move(open)),
+    m_close(std::move(close)),
+    m_gapHandler(std::move(gapHandler)),
+    m_giveUpHandler(std::move(giveUpHandler)),
+    m_options(options),
+    m_clock(std::move(clock))
+{
+    if (!m_open || !m_close)
+    {
+        throw std::invalid_argument("Error: a camera reconnector needs open and close handlers");
+    }
+}
+
+CameraReconnector::~CameraReconnector()
+{
+    Stop();
+}
+
+void CameraReconnector::Start()
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+    if (m_state != State::Stopped)
+    {
+        return;
+    }
+
+    // Failures reported while opening are handled by the reconnect thread once it starts
+    m_state = State::Running;
+    m_isStopping = false;
+    guard.unlock();
+    try
+    {
+        m_open();
+    }
+    catch (...)
+    {
+        m_close();
+        guard.lock();
+        m_state = State::Stopped;
+        m_isFailurePending = false;
+        m_isGapPending = false;
+        throw;
+    }
+
+    guard.lock();
+    m_isOpen = true;
+    m_thread = std::thread([this]() { ReconnectLoop(); });
+}
+
+void CameraReconnector::Stop()
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+    m_isStopping = true;
+    m_state = State::Stopped;
+    m_wakeUp.notify_all();
+    guard.unlock();
+
+    // A handler stopping the reconnector from the reconnect thread lets it exit on its own
+    if (m_thread.joinable())
+    {
+        if (m_thread.get_id() == std::this_thread::get_id())
+        {
+            m_thread.detach();
+        }
+        else
+        {
+            m_thread.join();
+        }
+    }
+
+    guard.lock();
+    bool isOpen = m_isOpen;
+    m_isOpen = false;
+    guard.unlock();
+    if (isOpen)
+    {
+        m_close();
+    }
+}
+
+void CameraReconnector::ReportFailure(std::string const& message)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    if (m_state != State::Running || m_isFailurePending)
+    {
+        return;
+    }
+    m_statistics.failureCount++;
+    m_isFailurePending = true;
+    m_failureMessage = message;
+    m_state = State::Reconnecting;
+
+    // A device failing again before delivering a frame extends the gap it already opened
+    if (!m_isGapPending)
+    {
+        int64_t now = m_clock();
+        m_isGapPending = true;
+        m_gapStartTime = (m_lastFrameTime >= 0) ? m_lastFrameTime : now;
+        m_failureTime = now;
+        m_gapAttemptCount = 0;
+    }
+    m_wakeUp.notify_all();
+}
+
+void CameraReconnector::NotifyFrame(int64_t arrivalTime)
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+    if (m_isGapPending && m_gapAttemptCount == 0)
+    {
+        // Frame the failed device delivered before it was closed, the gap starts after it
+        m_gapStartTime = std::max<int64_t>(m_gapStartTime, arrivalTime);
+        m_lastFrameTime = arrivalTime;
+        return;
+    }
+    if (m_isGapPending)
+    {
+        // First frame of the reopened device, which may deliver frames before opening it returned
+        // and the state is back to Running. The frame interval is not updated across the gap.
+        Gap gap;
+        gap.startTime = m_gapStartTime;
+        gap.endTime = arrivalTime;
+        gap.attemptCount = m_gapAttemptCount;
+        gap.lostFrameCount = 0;
+        if (m_frameIntervalTicks > 0.0)
+        {
+            // The frame closing the gap is not lost
+            gap.lostFrameCount = (uint64_t)std::max<double>(std::llround((arrivalTime - m_gapStartTime) / m_frameIntervalTicks) - 1.0, 0.0);
+        }
+
+        double recoveryMs = (double)(arrivalTime - m_failureTime) / FrameDeadlinePolicy::TicksPerMs;
+        m_statistics.recoveryCount++;
+        m_statistics.lostFrameCount += gap.lostFrameCount;
+        m_statistics.lastRecoveryMs = recoveryMs;
+        m_statistics.maxRecoveryMs = std::max<double>(m_statistics.maxRecoveryMs, recoveryMs);
+        m_statistics.totalRecoveryMs += recoveryMs;
+        m_isGapPending = false;
+        m_lastFrameTime = arrivalTime;
+        guard.unlock();
+
+        if (m_gapHandler)
+        {
+            m_gapHandler(gap);
+        }
+        return;
+    }
+
+    if (m_lastFrameTime >= 0 && arrivalTime > m_lastFrameTime)
+    {
+        double interval = (double)(arrivalTime - m_lastFrameTime);
+        m_frameIntervalTicks = (m_frameIntervalTicks > 0.0) ? m_frameIntervalTicks * 0.9 + interval * 0.1 : interval;
+    }
+    m_lastFrameTime = arrivalTime;
+}
+
+CameraReconnector::State CameraReconnector::CurrentState() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_state;
+}
+
+CameraReconnector::Statistics CameraReconnector::GetStatistics() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_statistics;
+}
+
+void CameraReconnector::ReconnectLoop()
+{
+    std::unique_lock<std::mutex> guard(m_lock);
+    while (true)
+    {
+        m_wakeUp.wait(guard, [this]() { return m_isStopping || m_isFailurePending; });
+        if (m_isStopping)
+        {
+            return;
+        }
+        m_isFailurePending = false;
+        std::string failureMessage = m_failureMessage;
+
+        // Release the failed device first, frames stop until it reopens
+        m_isOpen = false;
+        guard.unlock();
+        try
+        {
+            m_close();
+        }
+        catch (...)
+        {
+        }
+        guard.lock();
+
+        auto backoff = m_options.initialBackoff;
+        uint32_t attemptCount = 0;
+        while (!m_wakeUp.wait_for(guard, backoff, [this]() { return m_isStopping; }))
+        {
+            attemptCount++;
+            m_gapAttemptCount++;
+            m_statistics.attemptCount++;
+            guard.unlock();
+
+            bool isOpen = false;
+            std::string error;
+            try
+            {
+                m_open();
+                isOpen = true;
+            }
+            catch (std::exception const& ex)
+            {
+                error = ex.what();
+            }
+            catch (...)
+            {
+                error = "unknown error";
+            }
+            if (!isOpen)
+            {
+                try
+                {
+                    m_close();
+                }
+                catch (...)
+                {
+                }
+            }
+            guard.lock();
+
+            // Frames delivered by an attempt that failed afterwards closed the gap too early, the next frames are after it
+            if (!isOpen && !m_isGapPending)
+            {
+                m_isGapPending = true;
+                m_gapStartTime = (m_lastFrameTime >= 0) ? m_lastFrameTime : m_clock();
+            }
+
+            if (isOpen)
+            {
+                // The gap closes with the first frame of the reopened device, Stop() closes it if stopping meanwhile
+                m_isOpen = true;
+                if (!m_isStopping)
+                {
+                    m_state = State::Running;
+                }
+                break;
+            }
+            if (m_options.maxAttempts > 0 && attemptCount >= m_options.maxAttempts)
+            {
+                m_state = State::Failed;
+                guard.unlock();
+                if (m_giveUpHandler)
+                {
+                    m_giveUpHandler(failureMessage + ", could not reopen the camera after " + std::to_string(attemptCount) + " attempts: " + error);
+                }
+                return;
+            }
+            backoff = std::min<std::chrono::milliseconds>(
+                std::chrono::milliseconds((int64_t)(backoff.count() * m_options.backoffMultiplier)),
+                m_options.maxBackoff);
+        }
+    }
+}
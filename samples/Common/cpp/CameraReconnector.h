@@ -0,0 +1,130 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "FrameDeadlinePolicy.h"
+
+//
+// Helper class recovering a capture device that failed, without blocking the thread reporting the failure.
+// A failure hands the device over to a reconnect thread that closes it and reopens it after an exponentially growing
+// backoff, while the frame consumers and their skill bindings stay alive. Once frames flow again, the first of them
+// is preceded by a Gap telling consumers that frames were missed, so that they can reset state carried across frames.
+//
+// The device is driven through open and close callbacks so that a fake device can stand in for a camera.
+//
+class CameraReconnector
+{
+public:
+    using Clock = FrameDeadlinePolicy::Clock;
+
+    struct Options
+    {
+        std::chrono::milliseconds initialBackoff = std::chrono::milliseconds(250); // before the first reopen attempt
+        std::chrono::milliseconds maxBackoff = std::chrono::milliseconds(8000);
+        double backoffMultiplier = 2.0;
+        uint32_t maxAttempts = 10; // consecutive failed reopen attempts before giving up, 0 to retry forever
+    };
+
+    enum class State
+    {
+        Stopped,
+        Running,
+        Reconnecting, // closed or reopening, no frame arrives
+        Failed // gave up reopening
+    };
+
+    // Frames stopped arriving between startTime and endTime, in ticks of the clock
+    struct Gap
+    {
+        int64_t startTime; // arrival of the last frame before the failure, or the failure if no frame arrived before
+        int64_t endTime; // arrival of the first frame after the recovery
+        uint64_t lostFrameCount; // estimated from the frame interval before the failure
+        uint32_t attemptCount; // reopen attempts it took
+    };
+
+    struct Statistics
+    {
+        uint64_t failureCount = 0;
+        uint64_t recoveryCount = 0;
+        uint64_t attemptCount = 0; // reopen attempts, failed ones included
+        uint64_t lostFrameCount = 0;
+        double lastRecoveryMs = 0.0; // from the failure to the first frame after it
+        double maxRecoveryMs = 0.0;
+        double totalRecoveryMs = 0.0;
+    };
+
+    using DeviceHandler = std::function<void()>; // opening throws on failure
+    using GapHandler = std::function<void(Gap const&)>;
+    using GiveUpHandler = std::function<void(std::string const&)>;
+
+    CameraReconnector(DeviceHandler open, DeviceHandler close, GapHandler gapHandler, GiveUpHandler giveUpHandler)
+        : CameraReconnector(std::move(open), std::move(close), std::move(gapHandler), std::move(giveUpHandler), Options()) {}
+    CameraReconnector(
+        DeviceHandler open,
+        DeviceHandler close,
+        GapHandler gapHandler,
+        GiveUpHandler giveUpHandler,
+        Options const& options,
+        Clock clock = FrameDeadlinePolicy::SystemRelativeNow);
+
+    // Stops reconnecting and closes the device
+    ~CameraReconnector();
+
+    CameraReconnector(const CameraReconnector&) = delete;
+    CameraReconnector& operator=(const CameraReconnector&) = delete;
+
+    // Open the device on the calling thread, throws what opening threw. Frames and failures may be reported while it opens.
+    void Start();
+
+    // Stop reconnecting and close the device, waits for a reopen attempt in progress
+    void Stop();
+
+    // Hand a failed device over to the reconnect thread, returns right away. Failures reported while reconnecting are ignored.
+    void ReportFailure(std::string const& message);
+
+    //
+    // Account a frame that arrived at arrivalTime, called before handing the frame to consumers.
+    // The first frame the device delivers once a reopen attempt started, possibly while the attempt is still opening it,
+    // calls the gap handler first, on the calling thread.
+    //
+    void NotifyFrame(int64_t arrivalTime);
+
+    State CurrentState() const;
+    Statistics GetStatistics() const;
+
+private:
+    void ReconnectLoop();
+
+    DeviceHandler m_open;
+    DeviceHandler m_close;
+    GapHandler m_gapHandler;
+    GiveUpHandler m_giveUpHandler;
+    Options m_options;
+    Clock m_clock;
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_wakeUp;
+    std::thread m_thread;
+    State m_state = State::Stopped;
+    bool m_isOpen = false;
+    bool m_isStopping = false;
+    bool m_isFailurePending = false;
+    std::string m_failureMessage;
+
+    // Frame timing, to date the gap and estimate the frames it lost
+    int64_t m_lastFrameTime = -1;
+    double m_frameIntervalTicks = 0.0; // moving average
+    bool m_isGapPending = false;
+    int64_t m_gapStartTime = 0;
+    int64_t m_failureTime = 0;
+    uint32_t m_gapAttemptCount = 0;
+
+    Statistics m_statistics;
+};
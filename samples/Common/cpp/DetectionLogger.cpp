@@ -0,0 +1,358 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "DetectionLogger.h"
+#include <cstdio>
+#include <iostream>
+#include <stdexcept>
+
+// Maximum amount of records rendered before writing them out
+static const size_t MaxBatchSize = 256;
+
+//
+// Open the sinks and start the background thread
+//
+DetectionLogger::DetectionLogger(Options const& options, LabelNameFunction labelName)
+    : m_options(options),
+    m_labelName(labelName),
+    m_queue(options.queueCapacity)
+{
+    if (!m_options.filePath.empty())
+    {
+        m_file.open(m_options.filePath, std::ios::out | std::ios::trunc);
+        if (!m_file)
+        {
+            throw std::runtime_error("Could not create log file " + m_options.filePath);
+        }
+    }
+    m_worker = std::thread([this]() { WorkerLoop(); });
+}
+
+DetectionLogger::~DetectionLogger()
+{
+    Close();
+}
+
+bool DetectionLogger::Push(const Record& record)
+{
+    if (!m_queue.TryPush(record))
+    {
+        m_droppedRecordCount++;
+        return false;
+    }
+    return true;
+}
+
+bool DetectionLogger::LogFrame(uint64_t frameId, float bindMs, float evalMs, uint32_t resultCount)
+{
+    return LogFrame(frameId, bindMs, evalMs, resultCount, resultCount);
+}
+
+bool DetectionLogger::LogFrame(uint64_t frameId, float bindMs, float evalMs, uint32_t resultCount, uint32_t recordCount)
+{
+    return Push({ RecordType::Frame, {}, {}, resultCount, frameId, { (int32_t)recordCount, 0 }, { bindMs, evalMs, 0.0f, 0.0f } });
+}
+
+bool DetectionLogger::LogObject(uint64_t frameId, int32_t label, float x, float y, float width, float height)
+{
+    return Push({ RecordType::Object, {}, {}, 0, frameId, { label, 0 }, { x, y, width, height } });
+}
+
+bool DetectionLogger::LogLimb(uint64_t frameId, uint32_t bodyIndex, int32_t label1, float x1, float y1, int32_t label2, float x2, float y2)
+{
+    return Push({ RecordType::Limb, {}, {}, bodyIndex, frameId, { label1, label2 }, { x1, y1, x2, y2 } });
+}
+
+bool DetectionLogger::LogEvent(SceneEventGenerator::Event const& event)
+{
+    Record record = { RecordType::Event, event.type, event.subject, event.objectId, event.frameId, { event.label, 0 },
+        { event.box.x, event.box.y, event.box.width, event.box.height } };
+    if (event.subject == SceneEventGenerator::Subject::BodyCount)
+    {
+        record.count = event.count;
+        record.labels[0] = (int32_t)event.previousCount;
+    }
+    return Push(record);
+}
+
+//
+// Write all queued records and stop the background thread
+//
+void DetectionLogger::Close()
+{
+    if (!m_worker.joinable())
+    {
+        return;
+    }
+    m_isClosing = true;
+    m_worker.join();
+
+    if (m_droppedRecordCount > 0)
+    {
+        std::cerr << std::endl << "DetectionLogger dropped " << m_droppedRecordCount << " records" << std::endl;
+    }
+}
+
+//
+// Drain the queue in batches until closed
+//
+void DetectionLogger::WorkerLoop()
+{
+    while (true)
+    {
+        // Read the flag before draining so that records pushed before Close() are always written
+        bool isClosing = m_isClosing;
+
+        Record record;
+        size_t recordCount = 0;
+        while (recordCount < MaxBatchSize && m_queue.TryPop(record))
+        {
+            Render(record);
+            recordCount++;
+        }
+        WriteBatch();
+
+        if (recordCount == 0)
+        {
+            if (isClosing)
+            {
+                break;
+            }
+            std::this_thread::sleep_for(m_options.flushPeriod);
+        }
+    }
+
+    // Write out the last frame even if some of its results were dropped
+    FlushFrame();
+    WriteBatch();
+}
+
+const char* DetectionLogger::LabelName(int32_t label) const
+{
+    const char* name = m_labelName(label);
+    return (name != nullptr) ? name : "Unknown";
+}
+
+//
+// Append a record to the line of the frame it belongs to, the line is complete once all results of the frame are rendered
+//
+void DetectionLogger::Render(const Record& record)
+{
+    char text[256];
+    bool isJson = (m_options.format == Format::Json);
+
+    if (record.type == RecordType::Event)
+    {
+        RenderEvent(record);
+        return;
+    }
+
+    if (record.type == RecordType::Frame)
+    {
+        FlushFrame();
+        m_pendingFrame = record;
+        m_hasPendingFrame = true;
+        m_pendingRecordCount = 0;
+        if (isJson)
+        {
+            snprintf(text, sizeof(text), "{\"frame\":%llu,\"bindMs\":%.3f,\"evalMs\":%.3f,",
+                (unsigned long long)record.frameId, record.values[0], record.values[1]);
+            m_line = text;
+            if (!m_options.resultName.empty())
+            {
+                snprintf(text, sizeof(text), "\"%s\":%u,", m_options.resultName.c_str(), record.count);
+                m_line += text;
+            }
+            m_line += "\"results\":[";
+        }
+        else
+        {
+            snprintf(text, sizeof(text), "frame %llu | bind: %.3fms | eval: %.3fms | ",
+                (unsigned long long)record.frameId, record.values[0], record.values[1]);
+            m_line = text;
+            if (!m_options.resultName.empty() && record.count > 0)
+            {
+                snprintf(text, sizeof(text), "Found %u %s:", record.count, m_options.resultName.c_str());
+                m_line += text;
+            }
+        }
+
+        // Results may have no record of their own, i.e. bodies without limbs
+        if (record.labels[0] == 0)
+        {
+            FlushFrame();
+        }
+        return;
+    }
+
+    // Results of a frame whose own record was dropped cannot be rendered
+    if (!m_hasPendingFrame || record.frameId != m_pendingFrame.frameId)
+    {
+        m_droppedRecordCount++;
+        return;
+    }
+
+    const char* label1 = LabelName(record.labels[0]);
+    if (record.type == RecordType::Object)
+    {
+        if (isJson)
+        {
+            snprintf(text, sizeof(text), "%s{\"label\":\"%s\",\"box\":[%.4f,%.4f,%.4f,%.4f]}",
+                m_pendingRecordCount > 0 ? "," : "", label1, record.values[0], record.values[1], record.values[2], record.values[3]);
+        }
+        else
+        {
+            snprintf(text, sizeof(text), "%s ", label1);
+        }
+    }
+    else
+    {
+        const char* label2 = LabelName(record.labels[1]);
+        if (isJson)
+        {
+            snprintf(text, sizeof(text), "%s{\"body\":%u,\"joints\":[{\"label\":\"%s\",\"x\":%.4f,\"y\":%.4f},{\"label\":\"%s\",\"x\":%.4f,\"y\":%.4f}]}",
+                m_pendingRecordCount > 0 ? "," : "", record.count, label1, record.values[0], record.values[1], label2, record.values[2], record.values[3]);
+        }
+        else
+        {
+            // Mark the beginning of each body
+            bool isNewBody = (m_pendingRecordCount == 0 || record.count != m_lastBodyIndex);
+            m_lastBodyIndex = record.count;
+            if (isNewBody)
+            {
+                snprintf(text, sizeof(text), "<-B%u->%s-%s|", record.count + 1, label1, label2);
+            }
+            else
+            {
+                snprintf(text, sizeof(text), "%s-%s|", label1, label2);
+            }
+        }
+    }
+    m_line += text;
+
+    if (++m_pendingRecordCount == (uint32_t)m_pendingFrame.labels[0])
+    {
+        FlushFrame();
+    }
+}
+
+//
+// Render an event as a whole line of its own, events are not refreshed on the console since each of them matters
+//
+void DetectionLogger::RenderEvent(const Record& record)
+{
+    char text[256];
+    bool isJson = (m_options.format == Format::Json);
+    const char* type = SceneEventGenerator::ToString(record.eventType);
+    const char* subject = SceneEventGenerator::ToString(record.eventSubject);
+
+    switch (record.eventSubject)
+    {
+    case SceneEventGenerator::Subject::Object:
+        if (isJson)
+        {
+            snprintf(text, sizeof(text), "{\"frame\":%llu,\"event\":\"%s\",\"subject\":\"%s\",\"id\":%u,\"label\":\"%s\",\"box\":[%.4f,%.4f,%.4f,%.4f]}\n",
+                (unsigned long long)record.frameId, type, subject, record.count, LabelName(record.labels[0]),
+                record.values[0], record.values[1], record.values[2], record.values[3]);
+        }
+        else
+        {
+            snprintf(text, sizeof(text), "frame %llu | %s %s #%u | box: %.3f %.3f %.3f %.3f\n",
+                (unsigned long long)record.frameId, type, LabelName(record.labels[0]), record.count,
+                record.values[0], record.values[1], record.values[2], record.values[3]);
+        }
+        break;
+    case SceneEventGenerator::Subject::BodyCount:
+        if (isJson)
+        {
+            snprintf(text, sizeof(text), "{\"frame\":%llu,\"event\":\"%s\",\"subject\":\"%s\",\"count\":%u,\"previousCount\":%d}\n",
+                (unsigned long long)record.frameId, type, subject, record.count, record.labels[0]);
+        }
+        else
+        {
+            snprintf(text, sizeof(text), "frame %llu | %s %s | count: %u (was %d)\n",
+                (unsigned long long)record.frameId, type, subject, record.count, record.labels[0]);
+        }
+        break;
+    default:
+        if (isJson)
+        {
+            snprintf(text, sizeof(text), "{\"frame\":%llu,\"event\":\"%s\",\"subject\":\"%s\",\"box\":[%.4f,%.4f,%.4f,%.4f]}\n",
+                (unsigned long long)record.frameId, type, subject, record.values[0], record.values[1], record.values[2], record.values[3]);
+        }
+        else
+        {
+            snprintf(text, sizeof(text), "frame %llu | %s %s | box: %.3f %.3f %.3f %.3f\n",
+                (unsigned long long)record.frameId, type, subject, record.values[0], record.values[1], record.values[2], record.values[3]);
+        }
+        break;
+    }
+
+    if (m_options.writeToConsole)
+    {
+        m_consoleBatch += text;
+    }
+    if (m_file.is_open())
+    {
+        m_fileBatch += text;
+    }
+}
+
+//
+// Terminate the line of the pending frame and append it to the batches to write
+//
+void DetectionLogger::FlushFrame()
+{
+    if (!m_hasPendingFrame)
+    {
+        return;
+    }
+    m_hasPendingFrame = false;
+
+    if (m_options.format == Format::Json)
+    {
+        m_line += "]}\n";
+        if (m_options.writeToConsole)
+        {
+            m_consoleBatch += m_line;
+        }
+        if (m_file.is_open())
+        {
+            m_fileBatch += m_line;
+        }
+        return;
+    }
+
+    if (m_pendingFrame.count == 0)
+    {
+        m_line += m_options.noResultText;
+    }
+    if (m_options.writeToConsole)
+    {
+        // Refresh the current console line
+        m_consoleBatch += m_line;
+        m_consoleBatch += "\r";
+    }
+    if (m_file.is_open())
+    {
+        m_fileBatch += m_line;
+        m_fileBatch += "\n";
+    }
+}
+
+//
+// Write the rendered lines to the sinks at once
+//
+void DetectionLogger::WriteBatch()
+{
+    if (!m_consoleBatch.empty())
+    {
+        std::cout.write(m_consoleBatch.data(), m_consoleBatch.size());
+        std::cout.flush();
+        m_consoleBatch.clear();
+    }
+    if (!m_fileBatch.empty())
+    {
+        m_file.write(m_fileBatch.data(), m_fileBatch.size());
+        m_file.flush();
+        m_fileBatch.clear();
+    }
+}
@@ -0,0 +1,119 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "MpmcQueue.h"
+#include "SceneEventGenerator.h"
+
+//
+// Helper class that logs skill results off the thread evaluating skills.
+// Log calls only copy a small fixed-size record into a lock-free queue; a background thread drains the queue in batches,
+// renders records as text or JSON lines and writes them to the console and/or a file.
+// When the queue is full, records are dropped rather than stalling the caller and the amount of dropped records is reported.
+//
+// A frame is logged with LogFrame() followed by the records of its results (LogObject() or LogLimb()) carrying the same frame id:
+// one per object, or one per limb of each body, in which case LogFrame() also takes the amount of limb records that follow.
+// An event of a SceneEventGenerator is logged on its own with LogEvent() and rendered as a whole line.
+// Labels are logged as their integer enum value and turned into names by the background thread using the LabelNameFunction.
+//
+class DetectionLogger
+{
+public:
+    enum class Format
+    {
+        Text,
+        Json // one JSON object per frame or event and per line
+    };
+
+    struct Options
+    {
+        Format format = Format::Text;
+        bool writeToConsole = true; // text lines refresh the current console line
+        std::string filePath; // no file is written if empty
+        size_t queueCapacity = 4096; // in records
+        std::chrono::milliseconds flushPeriod = std::chrono::milliseconds(10);
+        std::string noResultText = "---------------- No detection ----------------"; // text displayed for frames without results
+        std::string resultName; // i.e. "bodies", displays the amount of results of each frame as "Found 2 bodies:" if not empty
+    };
+
+    using LabelNameFunction = const char* (*)(int32_t label);
+
+    // Throws std::runtime_error if the log file cannot be created
+    DetectionLogger(Options const& options, LabelNameFunction labelName);
+    ~DetectionLogger();
+
+    DetectionLogger(const DetectionLogger&) = delete;
+    DetectionLogger& operator=(const DetectionLogger&) = delete;
+
+    // Log the timings of a frame and the amount of results that follow, one record each. Returns false if the record was dropped.
+    bool LogFrame(uint64_t frameId, float bindMs, float evalMs, uint32_t resultCount);
+
+    // Log the timings of a frame and the amount of results whose recordCount records follow, i.e. bodies and their limbs
+    bool LogFrame(uint64_t frameId, float bindMs, float evalMs, uint32_t resultCount, uint32_t recordCount);
+
+    // Log a detected object and its bounding box
+    bool LogObject(uint64_t frameId, int32_t label, float x, float y, float width, float height);
+
+    // Log a limb of a detected body as its 2 joints
+    bool LogLimb(uint64_t frameId, uint32_t bodyIndex, int32_t label1, float x1, float y1, int32_t label2, float x2, float y2);
+
+    // Log an event generated from the results of frames
+    bool LogEvent(SceneEventGenerator::Event const& event);
+
+    // Write all queued records and stop the background thread
+    void Close();
+
+    // Records dropped because the queue was full or because the frame they belong to was dropped
+    uint64_t DroppedRecordCount() const { return m_droppedRecordCount; }
+
+private:
+    enum class RecordType : uint8_t
+    {
+        Frame,
+        Object,
+        Limb,
+        Event
+    };
+
+    struct Record
+    {
+        RecordType type;
+        SceneEventGenerator::EventType eventType; // Event only
+        SceneEventGenerator::Subject eventSubject; // Event only
+        uint32_t count; // Frame: amount of results, Limb: body index, Event: object id or amount of bodies
+        uint64_t frameId;
+        int32_t labels[2]; // Frame: amount of records that follow, Event: label of the object or amount of bodies last reported
+        float values[4]; // Frame: bind and eval ms, Object and Event: x, y, width, height, Limb: x1, y1, x2, y2
+    };
+
+    bool Push(const Record& record);
+    void WorkerLoop();
+    const char* LabelName(int32_t label) const;
+    void Render(const Record& record);
+    void RenderEvent(const Record& record);
+    void FlushFrame();
+    void WriteBatch();
+
+    Options m_options;
+    LabelNameFunction m_labelName;
+    MpmcQueue<Record> m_queue;
+    std::ofstream m_file;
+    std::thread m_worker;
+    std::atomic<bool> m_isClosing = false;
+    std::atomic<uint64_t> m_droppedRecordCount = 0;
+
+    // State of the background thread
+    Record m_pendingFrame = {};
+    bool m_hasPendingFrame = false;
+    uint32_t m_pendingRecordCount = 0; // result records rendered so far
+    uint32_t m_lastBodyIndex = 0;
+    std::string m_line;
+    std::string m_consoleBatch;
+    std::string m_fileBatch;
+};
@@ -0,0 +1,168 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <chrono>
+#endif
+
+//
+// Lock-free histogram of latencies in milliseconds, recorded from any thread.
+// Latencies are counted in buckets of BucketWidthMs up to MaxTrackedMs, higher ones all fall in a last overflow bucket.
+//
+class LatencyHistogram
+{
+public:
+    static constexpr double BucketWidthMs = 0.25;
+    static constexpr uint32_t BucketCount = 2048; // up to 512ms
+    static constexpr double MaxTrackedMs = BucketWidthMs * BucketCount;
+
+    void Record(double latencyMs)
+    {
+        latencyMs = std::max<double>(latencyMs, 0.0);
+        uint32_t bucket = (uint32_t)std::min<double>(latencyMs / BucketWidthMs, BucketCount);
+        m_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t latencyUs = (uint64_t)(latencyMs * 1000.0);
+        uint64_t maxUs = m_maxUs.load(std::memory_order_relaxed);
+        while (latencyUs > maxUs && !m_maxUs.compare_exchange_weak(maxUs, latencyUs, std::memory_order_relaxed));
+    }
+
+    //
+    // Latency under which the specified fraction of the recorded latencies fall, i.e. 0.99 for the 99th percentile.
+    // Returns the upper bound of the bucket holding that percentile, or the maximum recorded latency if lower.
+    //
+    double Percentile(double fraction) const
+    {
+        uint64_t count = Count();
+        if (count == 0)
+        {
+            return 0.0;
+        }
+        uint64_t rank = std::max<uint64_t>(1, (uint64_t)(std::min<double>(std::max<double>(fraction, 0.0), 1.0) * count + 0.5));
+        uint64_t cumulatedCount = 0;
+        for (uint32_t bucket = 0; bucket < BucketCount; bucket++)
+        {
+            cumulatedCount += m_buckets[bucket].load(std::memory_order_relaxed);
+            if (cumulatedCount >= rank)
+            {
+                return std::min<double>((bucket + 1) * BucketWidthMs, MaxMs());
+            }
+        }
+        return MaxMs();
+    }
+
+    uint64_t Count() const { return m_count.load(std::memory_order_relaxed); }
+    double MaxMs() const { return m_maxUs.load(std::memory_order_relaxed) / 1000.0; }
+
+private:
+    std::atomic<uint64_t> m_buckets[BucketCount + 1] = {};
+    std::atomic<uint64_t> m_count = 0;
+    std::atomic<uint64_t> m_maxUs = 0;
+};
+
+//
+// Helper class enforcing "latest frame wins" with a bounded frame age.
+// Frames are identified by their capture time, the MediaFrameReference::SystemRelativeTime of the camera frame
+// in 100ns ticks of the system-relative (QueryPerformanceCounter) clock. A frame older than the deadline when it is
+// about to be evaluated is discarded instead, and the age of each result is recorded once it is produced,
+// so that percentiles tell how old results are when they reach the app.
+//
+// The clock is injectable so that deadlines can be checked against a synthetic time.
+//
+class FrameDeadlinePolicy
+{
+public:
+    using Clock = std::function<int64_t()>; // current time in 100ns ticks, on the same time base as capture times
+
+    static constexpr int64_t TicksPerMs = 10000;
+
+    //
+    // Current system-relative time, the time base of MediaFrameReference::SystemRelativeTime
+    //
+    static int64_t SystemRelativeNow()
+    {
+#ifdef _WIN32
+        static const int64_t frequency = []()
+        {
+            LARGE_INTEGER value;
+            QueryPerformanceFrequency(&value);
+            return (int64_t)value.QuadPart;
+        }();
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+
+        // Split the conversion so that the multiplication does not overflow
+        return (counter.QuadPart / frequency) * 10000000 + (counter.QuadPart % frequency) * 10000000 / frequency;
+#else
+        return std::chrono::duration_cast<std::chrono::duration<int64_t, std::ratio<1, 10000000>>>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    // A deadline of 0 admits all frames and only records ages
+    explicit FrameDeadlinePolicy(double deadlineMs, Clock clock = SystemRelativeNow)
+        : m_deadlineTicks((int64_t)(deadlineMs * TicksPerMs)),
+        m_clock(std::move(clock))
+    {
+    }
+
+    double AgeMs(int64_t captureTime) const
+    {
+        return (double)(m_clock() - captureTime) / TicksPerMs;
+    }
+
+    //
+    // Decide whether a frame is still recent enough to be evaluated, records the age of admitted frames
+    //
+    bool Admit(int64_t captureTime)
+    {
+        int64_t age = m_clock() - captureTime;
+        if (m_deadlineTicks > 0 && age > m_deadlineTicks)
+        {
+            m_discardedFrameCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_admittedFrameCount.fetch_add(1, std::memory_order_relaxed);
+        m_admissionAges.Record((double)age / TicksPerMs);
+        return true;
+    }
+
+    //
+    // Record the age of a result produced from the frame captured at captureTime, returns that age in milliseconds
+    //
+    double RecordResult(int64_t captureTime)
+    {
+        double ageMs = AgeMs(captureTime);
+        m_resultAges.Record(ageMs);
+        if (m_deadlineTicks > 0 && ageMs * TicksPerMs > m_deadlineTicks)
+        {
+            m_lateResultCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        return ageMs;
+    }
+
+    double DeadlineMs() const { return (double)m_deadlineTicks / TicksPerMs; }
+    uint64_t AdmittedFrameCount() const { return m_admittedFrameCount.load(std::memory_order_relaxed); }
+    uint64_t DiscardedFrameCount() const { return m_discardedFrameCount.load(std::memory_order_relaxed); }
+    uint64_t LateResultCount() const { return m_lateResultCount.load(std::memory_order_relaxed); } // admitted in time but finished late
+
+    const LatencyHistogram& AdmissionAges() const { return m_admissionAges; } // time frames waited before evaluation
+    const LatencyHistogram& ResultAges() const { return m_resultAges; } // capture to result
+
+private:
+    int64_t m_deadlineTicks = 0;
+    Clock m_clock;
+    std::atomic<uint64_t> m_admittedFrameCount = 0;
+    std::atomic<uint64_t> m_discardedFrameCount = 0;
+    std::atomic<uint64_t> m_lateResultCount = 0;
+    LatencyHistogram m_admissionAges;
+    LatencyHistogram m_resultAges;
+};
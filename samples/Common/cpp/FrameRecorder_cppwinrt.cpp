@@ -0,0 +1,483 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "FrameRecorder_cppwinrt.h"
+#include <MemoryBuffer.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/windows.system.threading.h>
+
+#include "SoftwareBitmapHelper_cppwinrt.h"
+#include "Tracing.h"
+
+using namespace winrt;
+using namespace winrt::Windows::Foundation;
+using namespace winrt::Windows::Graphics::Imaging;
+using namespace winrt::Windows::Media;
+using namespace winrt::Windows::Media::Capture::Frames;
+using namespace winrt::Windows::System::Threading;
+using namespace FrameRecording;
+
+//
+// Helper method to append a fixed-size struct to a chunk payload
+//
+template <typename T>
+static void AppendValue(std::vector<uint8_t>& payload, const T& value)
+{
+    auto bytes = reinterpret_cast<const uint8_t*>(&value);
+    payload.insert(payload.end(), bytes, bytes + sizeof(T));
+}
+
+//
+// Helper method to read a fixed-size struct from a chunk payload, throws if the payload is too short
+//
+template <typename T>
+static T ReadValue(std::vector<uint8_t> const& payload, size_t& offset)
+{
+    if (offset + sizeof(T) > payload.size())
+    {
+        throw std::runtime_error("Corrupted recording: chunk is shorter than its content");
+    }
+    T value;
+    memcpy(&value, payload.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return value;
+}
+
+//
+// Create the recording file and start the background thread writing it
+//
+FrameRecorder::FrameRecorder(std::filesystem::path const& filePath, Options const& options)
+    : m_queue(options.queueCapacity)
+{
+    m_file.open(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!m_file)
+    {
+        throw std::runtime_error("Could not create recording file " + filePath.string());
+    }
+    FileHeader header = { { 'S', 'K', 'F', 'R' }, Version };
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_bytesWritten += sizeof(header);
+
+    m_worker = std::thread([this]() { WorkerLoop(); });
+}
+
+FrameRecorder::FrameRecorder(std::filesystem::path const& filePath)
+    : FrameRecorder(filePath, Options())
+{
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    Close();
+}
+
+void FrameRecorder::RecordFormat(MediaFrameFormat const& format)
+{
+    std::string subtype = winrt::to_string(format.Subtype());
+    Chunk chunk = { { 'F', 'M', 'T', ' ' } };
+    AppendValue(chunk.payload, FormatChunk{
+        format.VideoFormat().Width(),
+        format.VideoFormat().Height(),
+        format.FrameRate().Numerator(),
+        format.FrameRate().Denominator(),
+        (uint32_t)subtype.size() });
+    chunk.payload.insert(chunk.payload.end(), subtype.begin(), subtype.end());
+
+    // Formats are rare and needed to make sense of the frames, wait for room rather than losing them
+    m_queue.Push(std::move(chunk));
+}
+
+//
+// Copy the buffer of the frame as is, planes included, and enqueue it to be written
+//
+bool FrameRecorder::Record(VideoFrame const& frame, int64_t captureTime, int64_t arrivalTime)
+{
+    SAMPLES_TRACE_SCOPE("FrameRecorder::Record");
+
+    // Without room in the queue, only the arrival is recorded: skip converting, locking and copying the pixels.
+    // Room may still run out while copying, which TryPush handles below.
+    if (m_queue.IsFull())
+    {
+        std::lock_guard<std::mutex> guard(m_skipLock);
+        SkipLocked(captureTime, arrivalTime);
+        return false;
+    }
+
+    SoftwareBitmap bitmap = frame.SoftwareBitmap();
+    if (bitmap == nullptr)
+    {
+        bitmap = SoftwareBitmapHelper::GetSoftwareBitmap(frame);
+    }
+
+    Chunk chunk = { { 'F', 'R', 'A', 'M' } };
+    {
+        auto buffer = bitmap.LockBuffer(BitmapBufferAccessMode::Read);
+        auto reference = buffer.CreateReference();
+        uint8_t* data = nullptr;
+        uint32_t capacity = 0;
+        check_hresult(reference.as<::Windows::Foundation::IMemoryBufferByteAccess>()->GetBuffer(&data, &capacity));
+
+        uint32_t planeCount = (uint32_t)buffer.GetPlaneCount();
+        chunk.payload.reserve(sizeof(FrameChunk) + planeCount * sizeof(PlaneDescription) + capacity);
+        AppendValue(chunk.payload, FrameChunk{
+            captureTime,
+            arrivalTime,
+            (int32_t)bitmap.BitmapPixelFormat(),
+            (int32_t)bitmap.BitmapAlphaMode(),
+            (uint32_t)bitmap.PixelWidth(),
+            (uint32_t)bitmap.PixelHeight(),
+            planeCount });
+        for (uint32_t plane = 0; plane < planeCount; plane++)
+        {
+            auto description = buffer.GetPlaneDescription(plane);
+            AppendValue(chunk.payload, PlaneDescription{ description.StartIndex, description.Width, description.Height, description.Stride });
+        }
+        chunk.payload.insert(chunk.payload.end(), data, data + capacity);
+
+        reference.Close();
+        buffer.Close();
+    }
+
+    // Arrivals skipped so far are written just before this frame, or stay pending if it has to be skipped as well
+    std::lock_guard<std::mutex> guard(m_skipLock);
+    chunk.precedingSkips = m_pendingSkips;
+    if (!m_queue.TryPush(std::move(chunk)))
+    {
+        SkipLocked(captureTime, arrivalTime);
+        return false;
+    }
+    m_pendingSkips.clear();
+    m_recordedFrameCount++;
+    return true;
+}
+
+void FrameRecorder::SkipLocked(int64_t captureTime, int64_t arrivalTime)
+{
+    m_pendingSkips.push_back({ captureTime, arrivalTime });
+    m_skippedFrameCount++;
+}
+
+void FrameRecorder::Close()
+{
+    m_queue.Close();
+    if (m_worker.joinable())
+    {
+        m_worker.join();
+    }
+    if (m_file.is_open())
+    {
+        // Arrivals skipped after the last queued frame
+        for (auto&& skip : m_pendingSkips)
+        {
+            WriteChunk("SKIP", &skip, sizeof(skip));
+        }
+        m_pendingSkips.clear();
+        m_file.close();
+    }
+}
+
+//
+// Dequeue and write chunks until the recorder is closed
+//
+void FrameRecorder::WorkerLoop()
+{
+    while (auto chunk = m_queue.Pop())
+    {
+        SAMPLES_TRACE_SCOPE("FrameRecorder::Write");
+        for (auto&& skip : chunk->precedingSkips)
+        {
+            WriteChunk("SKIP", &skip, sizeof(skip));
+        }
+        WriteChunk(chunk->id, chunk->payload.data(), chunk->payload.size());
+    }
+}
+
+void FrameRecorder::WriteChunk(const char id[4], const void* payload, size_t size)
+{
+    ChunkHeader header = { { id[0], id[1], id[2], id[3] }, (uint32_t)size };
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.write(reinterpret_cast<const char*>(payload), size);
+    m_bytesWritten += sizeof(header) + size;
+}
+
+//
+// Open the recording, read its format and start emitting frames
+//
+FrameReplaySource::FrameReplaySource(
+    std::filesystem::path const& filePath,
+    Timing timing,
+    winrt::delegate<std::string> failureHandler,
+    winrt::delegate<VideoFrame> newFrameArrivedHandler,
+    std::shared_ptr<FrameDeadlinePolicy> deadlinePolicy)
+    : m_timing(timing),
+    m_failureHandler(failureHandler),
+    m_frameHandler(newFrameArrivedHandler),
+    m_deadlinePolicy(deadlinePolicy)
+{
+    if (failureHandler == nullptr || newFrameArrivedHandler == nullptr)
+    {
+        throw hresult_invalid_argument(L"Error: attempting to replay frames with a null handler");
+    }
+
+    m_file.open(filePath, std::ios::in | std::ios::binary);
+    if (!m_file)
+    {
+        throw std::runtime_error("Could not open recording file " + filePath.string());
+    }
+    FileHeader header = {};
+    if (!m_file.read(reinterpret_cast<char*>(&header), sizeof(header)) || memcmp(header.magic, "SKFR", 4) != 0)
+    {
+        throw std::runtime_error(filePath.string() + " is not a frame recording");
+    }
+    if (header.version != Version)
+    {
+        throw std::runtime_error("Unsupported frame recording version " + std::to_string(header.version));
+    }
+
+    // The format is recorded when the camera starts, before any frame
+    ChunkHeader chunkHeader;
+    std::vector<uint8_t> payload;
+    if (!ReadChunk(chunkHeader, payload) || memcmp(chunkHeader.id, "FMT ", 4) != 0)
+    {
+        throw std::runtime_error("Corrupted recording: missing frame format");
+    }
+    ReadFormat(payload);
+    std::cout << "Replayed frame source format: " << m_subtype << " : " << m_format.width << "x" << m_format.height
+        << "@" << FrameRate() << "fps" << std::endl;
+
+    m_worker = std::thread([this]() { ReplayLoop(); });
+}
+
+FrameReplaySource::~FrameReplaySource()
+{
+    Stop();
+}
+
+void FrameReplaySource::Wait()
+{
+    if (m_worker.joinable())
+    {
+        m_worker.join();
+    }
+    std::unique_lock<std::mutex> guard(m_lock);
+    m_stateChanged.wait(guard, [this]() { return m_pendingFrameCount == 0; });
+}
+
+void FrameReplaySource::Stop()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_isStopping = true;
+    }
+    m_stateChanged.notify_all();
+    Wait();
+}
+
+//
+// Read the next chunk, returns false at the end of the recording or on a truncated chunk
+//
+bool FrameReplaySource::ReadChunk(ChunkHeader& header, std::vector<uint8_t>& payload)
+{
+    if (!m_file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+    {
+        return false;
+    }
+    payload.resize(header.size);
+    return (bool)m_file.read(reinterpret_cast<char*>(payload.data()), header.size);
+}
+
+void FrameReplaySource::ReadFormat(std::vector<uint8_t> const& payload)
+{
+    size_t offset = 0;
+    m_format = ReadValue<FormatChunk>(payload, offset);
+    if (offset + m_format.subtypeLength > payload.size())
+    {
+        throw std::runtime_error("Corrupted recording: format chunk is shorter than its content");
+    }
+    m_subtype.assign(payload.begin() + offset, payload.begin() + offset + m_format.subtypeLength);
+}
+
+//
+// Rebuild the bitmap of a frame chunk, plane by plane since the strides of the new bitmap may differ from the recorded ones
+//
+SoftwareBitmap FrameReplaySource::ReadFrame(std::vector<uint8_t> const& payload, FrameChunk& frame)
+{
+    size_t offset = 0;
+    frame = ReadValue<FrameChunk>(payload, offset);
+    std::vector<PlaneDescription> planes;
+    for (uint32_t plane = 0; plane < frame.planeCount; plane++)
+    {
+        planes.push_back(ReadValue<PlaneDescription>(payload, offset));
+    }
+    const uint8_t* pixels = payload.data() + offset;
+    size_t pixelByteCount = payload.size() - offset;
+
+    SoftwareBitmap bitmap((BitmapPixelFormat)frame.pixelFormat, frame.width, frame.height, (BitmapAlphaMode)frame.alphaMode);
+    {
+        auto buffer = bitmap.LockBuffer(BitmapBufferAccessMode::Write);
+        auto reference = buffer.CreateReference();
+        uint8_t* data = nullptr;
+        uint32_t capacity = 0;
+        check_hresult(reference.as<::Windows::Foundation::IMemoryBufferByteAccess>()->GetBuffer(&data, &capacity));
+
+        uint32_t planeCount = std::min<uint32_t>(frame.planeCount, (uint32_t)buffer.GetPlaneCount());
+        for (uint32_t plane = 0; plane < planeCount; plane++)
+        {
+            auto& source = planes[plane];
+            auto destination = buffer.GetPlaneDescription(plane);
+            int32_t rowCount = std::min<int32_t>(source.height, destination.Height);
+            size_t rowSize = (size_t)std::min<int32_t>(source.stride, destination.Stride);
+            if (rowCount <= 0)
+            {
+                continue;
+            }
+            if (source.startIndex < 0 || (size_t)source.startIndex + (size_t)(rowCount - 1) * source.stride + rowSize > pixelByteCount
+                || (size_t)destination.StartIndex + (size_t)(rowCount - 1) * destination.Stride + rowSize > capacity)
+            {
+                throw std::runtime_error("Corrupted recording: frame is shorter than its planes");
+            }
+            for (int32_t row = 0; row < rowCount; row++)
+            {
+                memcpy(
+                    data + destination.StartIndex + (size_t)row * destination.Stride,
+                    pixels + source.startIndex + (size_t)row * source.stride,
+                    rowSize);
+            }
+        }
+
+        reference.Close();
+        buffer.Close();
+    }
+    return bitmap;
+}
+
+//
+// Read chunks one after the other and emit their frames, on time or as fast as possible
+//
+void FrameReplaySource::ReplayLoop()
+{
+    try
+    {
+        ChunkHeader header;
+        std::vector<uint8_t> payload;
+        SoftwareBitmap lastBitmap = nullptr;
+        while (ReadChunk(header, payload))
+        {
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                if (m_isStopping)
+                {
+                    break;
+                }
+            }
+
+            if (memcmp(header.id, "FMT ", 4) == 0)
+            {
+                // The camera was reinitialized
+                ReadFormat(payload);
+            }
+            else if (memcmp(header.id, "FRAM", 4) == 0)
+            {
+                FrameChunk frame;
+                lastBitmap = ReadFrame(payload, frame);
+                Emit(lastBitmap, frame.captureTime, frame.arrivalTime);
+            }
+            else if (memcmp(header.id, "SKIP", 4) == 0 && lastBitmap != nullptr)
+            {
+                size_t offset = 0;
+                auto skip = ReadValue<SkipChunk>(payload, offset);
+                Emit(lastBitmap, skip.captureTime, skip.arrivalTime);
+            }
+        }
+    }
+    catch (hresult_error const& ex)
+    {
+        m_failureHandler(std::string("Replay error:") + winrt::to_string(ex.message()));
+    }
+    catch (std::exception const& ex)
+    {
+        m_failureHandler(std::string("Replay error:") + ex.what());
+    }
+}
+
+//
+// Emit a copy of a bitmap as a new frame, once its recorded arrival time is reached on the replay clock
+//
+void FrameReplaySource::Emit(SoftwareBitmap const& bitmap, int64_t captureTime, int64_t arrivalTime)
+{
+    if (m_firstArrivalTime < 0)
+    {
+        m_firstArrivalTime = arrivalTime;
+        m_startTime = FrameDeadlinePolicy::SystemRelativeNow();
+    }
+    if (m_timing == Timing::Recorded)
+    {
+        int64_t delay = m_startTime + (arrivalTime - m_firstArrivalTime) - FrameDeadlinePolicy::SystemRelativeNow();
+        if (delay > 0)
+        {
+            std::unique_lock<std::mutex> guard(m_lock);
+            m_stateChanged.wait_for(guard, std::chrono::duration<int64_t, std::ratio<1, 10000000>>(delay), [this]() { return m_isStopping; });
+            if (m_isStopping)
+            {
+                return;
+            }
+        }
+    }
+
+    // Keep the age the frame had when it arrived
+    int64_t now = FrameDeadlinePolicy::SystemRelativeNow();
+    int64_t replayedCaptureTime = captureTime >= 0 ? now - (arrivalTime - captureTime) : now;
+    if (m_deadlinePolicy != nullptr && !m_deadlinePolicy->Admit(replayedCaptureTime))
+    {
+        m_discardedFrameCount++;
+        return;
+    }
+
+    // Handlers close the frames they get, each one gets its own bitmap
+    VideoFrame videoFrame = VideoFrame::CreateWithSoftwareBitmap(SoftwareBitmap::Copy(bitmap));
+    videoFrame.SystemRelativeTime(IReference<TimeSpan>(TimeSpan(replayedCaptureTime)));
+    m_emittedFrameCount++;
+
+    if (m_timing == Timing::AsFastAsPossible)
+    {
+        m_frameHandler(videoFrame);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_pendingFrameCount++;
+    }
+    ThreadPool::RunAsync([this, videoFrame](IAsyncAction const&)
+    {
+        // The frame is handled however the handlers return, or Wait() would never return
+        struct PendingFrameGuard
+        {
+            FrameReplaySource* source;
+            ~PendingFrameGuard()
+            {
+                std::lock_guard<std::mutex> guard(source->m_lock);
+                if (--source->m_pendingFrameCount == 0)
+                {
+                    source->m_stateChanged.notify_all();
+                }
+            }
+        } pendingFrameGuard{ this };
+
+        try
+        {
+            m_frameHandler(videoFrame);
+        }
+        catch (hresult_error const& ex)
+        {
+            m_failureHandler(std::string("Replay error:") + winrt::to_string(ex.message()));
+        }
+        catch (std::exception const& ex)
+        {
+            m_failureHandler(std::string("Replay error:") + ex.what());
+        }
+    });
+}
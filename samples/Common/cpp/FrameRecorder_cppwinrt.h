@@ -0,0 +1,209 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <winrt/Windows.Graphics.Imaging.h>
+#include <winrt/Windows.Media.h>
+#include <winrt/windows.media.capture.frames.h>
+
+#include "BoundedQueue.h"
+#include "FrameDeadlinePolicy.h"
+
+//
+// Layout of camera session recordings, shared by FrameRecorder and FrameReplaySource.
+// A recording starts with a FileHeader followed by chunks, each made of a ChunkHeader and its payload.
+// Readers skip chunks they do not know, and a truncated last chunk (i.e. of an interrupted recording) ends the session.
+// All values are little-endian, times are in 100ns ticks of the system-relative clock.
+//
+namespace FrameRecording
+{
+    struct FileHeader
+    {
+        char magic[4]; // "SKFR"
+        uint32_t version;
+    };
+
+    struct ChunkHeader
+    {
+        char id[4];
+        uint32_t size; // of the payload that follows
+    };
+
+    // "FMT " chunk: the negotiated MediaFrameFormat, followed by subtypeLength bytes of its UTF-8 subtype
+    struct FormatChunk
+    {
+        uint32_t width;
+        uint32_t height;
+        uint32_t frameRateNumerator;
+        uint32_t frameRateDenominator;
+        uint32_t subtypeLength;
+    };
+
+    // "FRAM" chunk: a frame, followed by planeCount PlaneDescription then the raw bytes of its buffer
+    struct FrameChunk
+    {
+        int64_t captureTime; // -1 if unknown
+        int64_t arrivalTime;
+        int32_t pixelFormat; // BitmapPixelFormat
+        int32_t alphaMode; // BitmapAlphaMode
+        uint32_t width;
+        uint32_t height;
+        uint32_t planeCount;
+    };
+
+    struct PlaneDescription
+    {
+        int32_t startIndex;
+        int32_t width;
+        int32_t height;
+        int32_t stride;
+    };
+
+    // "SKIP" chunk: a frame that arrived while the recorder was busy, replayed with the pixels of the previous frame
+    struct SkipChunk
+    {
+        int64_t captureTime;
+        int64_t arrivalTime;
+    };
+
+    static const uint32_t Version = 1;
+};
+
+//
+// Helper class that records the frames of a camera session with their capture and arrival times and the negotiated
+// format, so that the session can be replayed with FrameReplaySource. Frames are stored in their native pixel format.
+// Pixels are copied when a frame is recorded and written by a background thread; when the queue is full, only the
+// arrival of the frame is recorded so that the replay still reproduces the load of the session.
+//
+class FrameRecorder
+{
+public:
+    struct Options
+    {
+        size_t queueCapacity = 16; // in frames
+    };
+
+    // Throws std::runtime_error if the recording file cannot be created
+    FrameRecorder(std::filesystem::path const& filePath, Options const& options);
+    explicit FrameRecorder(std::filesystem::path const& filePath);
+    ~FrameRecorder();
+
+    FrameRecorder(const FrameRecorder&) = delete;
+    FrameRecorder& operator=(const FrameRecorder&) = delete;
+
+    // Record the format the camera negotiated, frames recorded afterwards are expected in that format
+    void RecordFormat(winrt::Windows::Media::Capture::Frames::MediaFrameFormat const& format);
+
+    // Record a frame, returns false if only its arrival could be recorded
+    bool Record(winrt::Windows::Media::VideoFrame const& frame, int64_t captureTime, int64_t arrivalTime);
+
+    // Write all queued frames and close the file
+    void Close();
+
+    uint64_t RecordedFrameCount() const { return m_recordedFrameCount; }
+    uint64_t SkippedFrameCount() const { return m_skippedFrameCount; } // recorded without pixels
+    uint64_t BytesWritten() const { return m_bytesWritten; }
+
+private:
+    struct Chunk
+    {
+        char id[4];
+        std::vector<uint8_t> payload;
+        std::vector<FrameRecording::SkipChunk> precedingSkips; // arrivals skipped since the previous queued frame
+    };
+
+    // Record only the arrival of a frame, m_skipLock held
+    void SkipLocked(int64_t captureTime, int64_t arrivalTime);
+
+    void WriteChunk(const char id[4], const void* payload, size_t size);
+
+    void WorkerLoop();
+
+    std::ofstream m_file;
+    BoundedQueue<Chunk> m_queue;
+    std::thread m_worker;
+    std::mutex m_skipLock;
+    std::vector<FrameRecording::SkipChunk> m_pendingSkips; // not queued yet
+    std::atomic<uint64_t> m_recordedFrameCount = 0;
+    std::atomic<uint64_t> m_skippedFrameCount = 0;
+    std::atomic<uint64_t> m_bytesWritten = 0;
+};
+
+//
+// Helper class that replays a session recorded by FrameRecorder in place of CameraHelper, with the same callbacks.
+// With Timing::Recorded, frames are emitted with their original inter-arrival times on the thread pool, so they
+// overlap like FrameReader events do when evaluation falls behind. With Timing::AsFastAsPossible, each frame is
+// emitted once the handler returned from the previous one, which makes runs deterministic.
+// Frames are tagged with a capture time rebased on the replay clock that keeps their recorded age on arrival,
+// and frames older than the deadline of deadlinePolicy, when specified, are discarded as CameraHelper does.
+//
+class FrameReplaySource
+{
+public:
+    enum class Timing
+    {
+        Recorded,
+        AsFastAsPossible
+    };
+
+    // Throws std::runtime_error if the file cannot be opened or is not a recording, starts emitting frames right away
+    FrameReplaySource(
+        std::filesystem::path const& filePath,
+        Timing timing,
+        winrt::delegate<std::string> failureHandler,
+        winrt::delegate<winrt::Windows::Media::VideoFrame> newFrameArrivedHandler,
+        std::shared_ptr<FrameDeadlinePolicy> deadlinePolicy = nullptr);
+    ~FrameReplaySource();
+
+    FrameReplaySource(const FrameReplaySource&) = delete;
+    FrameReplaySource& operator=(const FrameReplaySource&) = delete;
+
+    // Wait until all frames were emitted and handled
+    void Wait();
+
+    // Stop emitting frames and wait for the ones being handled
+    void Stop();
+
+    uint32_t Width() const { return m_format.width; }
+    uint32_t Height() const { return m_format.height; }
+    double FrameRate() const { return m_format.frameRateDenominator != 0 ? (double)m_format.frameRateNumerator / m_format.frameRateDenominator : 0.0; }
+    const std::string& Subtype() const { return m_subtype; }
+
+    uint64_t EmittedFrameCount() const { return m_emittedFrameCount; }
+    uint64_t DiscardedFrameCount() const { return m_discardedFrameCount; } // past the deadline
+
+private:
+    bool ReadChunk(FrameRecording::ChunkHeader& header, std::vector<uint8_t>& payload);
+    void ReadFormat(std::vector<uint8_t> const& payload);
+    winrt::Windows::Graphics::Imaging::SoftwareBitmap ReadFrame(std::vector<uint8_t> const& payload, FrameRecording::FrameChunk& frame);
+    void ReplayLoop();
+    void Emit(winrt::Windows::Graphics::Imaging::SoftwareBitmap const& bitmap, int64_t captureTime, int64_t arrivalTime);
+
+    std::ifstream m_file;
+    Timing m_timing;
+    winrt::delegate<std::string> m_failureHandler;
+    winrt::delegate<winrt::Windows::Media::VideoFrame> m_frameHandler;
+    std::shared_ptr<FrameDeadlinePolicy> m_deadlinePolicy;
+    FrameRecording::FormatChunk m_format = {};
+    std::string m_subtype;
+
+    // Replay clock
+    int64_t m_firstArrivalTime = -1;
+    int64_t m_startTime = 0;
+
+    std::thread m_worker;
+    std::mutex m_lock;
+    std::condition_variable m_stateChanged;
+    bool m_isStopping = false;
+    uint32_t m_pendingFrameCount = 0; // emitted on the thread pool and not handled yet
+    std::atomic<uint64_t> m_emittedFrameCount = 0;
+    std::atomic<uint64_t> m_discardedFrameCount = 0;
+};
@@ -0,0 +1,222 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "MemoryTracker.h"
+#include <algorithm>
+#include <iomanip>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include "ProcessMemoryHelper.h"
+#else
+#include <fstream>
+#include <unistd.h>
+#endif
+
+void MemoryTracker::Component::Add(uint64_t bytes)
+{
+    uint64_t current = m_currentBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    uint64_t peak = m_peakBytes.load(std::memory_order_relaxed);
+    while (current > peak && !m_peakBytes.compare_exchange_weak(peak, current, std::memory_order_relaxed));
+    m_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    m_tracker.OnTotalChanged((int64_t)bytes);
+}
+
+void MemoryTracker::Component::Release(uint64_t bytes)
+{
+    m_currentBytes.fetch_sub(bytes, std::memory_order_relaxed);
+    m_tracker.OnTotalChanged(-(int64_t)bytes);
+}
+
+uint64_t MemoryTracker::Component::SteadyStateBytes() const
+{
+    std::lock_guard<std::mutex> guard(m_tracker.m_componentLock);
+    return m_sampleCount > 0 ? (uint64_t)(m_sampleSum / m_sampleCount) : 0;
+}
+
+MemoryTracker::MemoryTracker()
+    : MemoryTracker(Options())
+{
+}
+
+MemoryTracker::MemoryTracker(Options const& options)
+    : m_options(options)
+{
+    m_samplingThread = std::thread([this]() { SamplingLoop(); });
+}
+
+MemoryTracker::~MemoryTracker()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_samplingLock);
+        m_isStopping = true;
+    }
+    m_stopSampling.notify_all();
+    m_samplingThread.join();
+}
+
+MemoryTracker::Component& MemoryTracker::GetComponent(std::string const& name)
+{
+    std::lock_guard<std::mutex> guard(m_componentLock);
+    for (auto&& component : m_components)
+    {
+        if (component->Name() == name)
+        {
+            return *component;
+        }
+    }
+    m_components.push_back(std::make_unique<Component>(*this, name));
+    return *m_components.back();
+}
+
+uint64_t MemoryTracker::MeasureFootprint(Component& component, std::function<void()> const& create)
+{
+    uint64_t before = ProcessPrivateBytes();
+    create();
+    uint64_t after = ProcessPrivateBytes();
+    uint64_t growth = after > before ? after - before : 0;
+    component.Add(growth);
+    return growth;
+}
+
+uint32_t MemoryTracker::AddPressureHandler(PressureHandler handler)
+{
+    std::lock_guard<std::recursive_mutex> guard(m_handlerLock);
+    uint32_t handlerId = m_nextHandlerId++;
+    m_handlers.push_back({ handlerId, std::move(handler) });
+    return handlerId;
+}
+
+void MemoryTracker::RemovePressureHandler(uint32_t handlerId)
+{
+    std::lock_guard<std::recursive_mutex> guard(m_handlerLock);
+    m_handlers.erase(
+        std::remove_if(m_handlers.begin(), m_handlers.end(), [handlerId](auto const& handler) { return handler.first == handlerId; }),
+        m_handlers.end());
+}
+
+//
+// Update the total and switch pressure when crossing a watermark, with hysteresis so that pools do not oscillate
+//
+void MemoryTracker::OnTotalChanged(int64_t delta)
+{
+    uint64_t total = m_totalBytes.fetch_add((uint64_t)delta, std::memory_order_relaxed) + (uint64_t)delta;
+    uint64_t peak = m_peakTotalBytes.load(std::memory_order_relaxed);
+    while (delta > 0 && total > peak && !m_peakTotalBytes.compare_exchange_weak(peak, total, std::memory_order_relaxed));
+    if (m_options.budgetBytes == 0)
+    {
+        return;
+    }
+
+    Pressure expected = m_pressure.load(std::memory_order_relaxed);
+    Pressure desired = expected;
+    if (expected == Pressure::Normal && total > m_options.budgetBytes * m_options.highWatermark)
+    {
+        desired = Pressure::High;
+    }
+    else if (expected == Pressure::High && total < m_options.budgetBytes * m_options.lowWatermark)
+    {
+        desired = Pressure::Normal;
+    }
+    if (desired == expected || !m_pressure.compare_exchange_strong(expected, desired))
+    {
+        return;
+    }
+    if (desired == Pressure::High)
+    {
+        m_highPressureCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Handlers get the pressure as of when they run so that the last call always reflects the latest transition
+    std::lock_guard<std::recursive_mutex> guard(m_handlerLock);
+    auto handlers = m_handlers;
+    for (auto&& handler : handlers)
+    {
+        handler.second(CurrentPressure());
+    }
+}
+
+void MemoryTracker::SamplingLoop()
+{
+    std::unique_lock<std::mutex> guard(m_samplingLock);
+    while (!m_stopSampling.wait_for(guard, m_options.samplingPeriod, [this]() { return m_isStopping; }))
+    {
+        {
+            std::lock_guard<std::mutex> componentGuard(m_componentLock);
+            for (auto&& component : m_components)
+            {
+                component->m_sampleSum += (double)component->CurrentBytes();
+                component->m_sampleCount++;
+            }
+        }
+        uint64_t workingSet = ProcessWorkingSetBytes();
+        uint64_t peak = m_peakWorkingSetBytes.load(std::memory_order_relaxed);
+        while (workingSet > peak && !m_peakWorkingSetBytes.compare_exchange_weak(peak, workingSet, std::memory_order_relaxed));
+    }
+}
+
+void MemoryTracker::Report(std::ostream& output) const
+{
+    auto toMB = [](uint64_t bytes) { return bytes / (1024.0 * 1024.0); };
+    auto flags = output.flags();
+    auto precision = output.precision();
+    output << std::fixed << std::setprecision(1);
+
+    output << std::left << std::setw(32) << "Memory (MB)" << std::right
+        << std::setw(10) << "current" << std::setw(10) << "peak" << std::setw(10) << "steady" << std::setw(12) << "allocations" << std::endl;
+    {
+        std::lock_guard<std::mutex> guard(m_componentLock);
+        for (auto&& component : m_components)
+        {
+            uint64_t steadyState = component->m_sampleCount > 0 ? (uint64_t)(component->m_sampleSum / component->m_sampleCount) : 0;
+            output << std::left << std::setw(32) << component->Name() << std::right
+                << std::setw(10) << toMB(component->CurrentBytes())
+                << std::setw(10) << toMB(component->PeakBytes())
+                << std::setw(10) << toMB(steadyState)
+                << std::setw(12) << component->AllocationCount() << std::endl;
+        }
+    }
+    output << std::left << std::setw(32) << "Total tracked" << std::right
+        << std::setw(10) << toMB(TotalBytes()) << std::setw(10) << toMB(PeakTotalBytes()) << std::endl;
+    output << "Process private bytes: " << toMB(ProcessPrivateBytes()) << "MB | working set: " << toMB(ProcessWorkingSetBytes())
+        << "MB (peak sampled " << toMB(m_peakWorkingSetBytes.load(std::memory_order_relaxed)) << "MB)";
+    if (m_options.budgetBytes > 0)
+    {
+        output << " | budget: " << toMB(m_options.budgetBytes) << "MB, went over " << HighPressureCount() << " times";
+    }
+    output << std::endl;
+
+    output.flags(flags);
+    output.precision(precision);
+}
+
+uint64_t MemoryTracker::ProcessPrivateBytes()
+{
+#ifdef _WIN32
+    return ProcessMemoryHelper::GetPrivateBytes();
+#else
+    // Resident pages not backed by a file, the closest to private bytes in /proc/self/statm
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0, resident = 0, shared = 0;
+    if (!(statm >> size >> resident >> shared))
+    {
+        return 0;
+    }
+    return (resident > shared ? resident - shared : 0) * (uint64_t)sysconf(_SC_PAGESIZE);
+#endif
+}
+
+uint64_t MemoryTracker::ProcessWorkingSetBytes()
+{
+#ifdef _WIN32
+    return ProcessMemoryHelper::GetWorkingSetBytes();
+#else
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0, resident = 0;
+    if (!(statm >> size >> resident))
+    {
+        return 0;
+    }
+    return resident * (uint64_t)sysconf(_SC_PAGESIZE);
+#endif
+}
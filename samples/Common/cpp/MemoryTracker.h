@@ -0,0 +1,221 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//
+// Helper class accounting the memory held by the components of a pipeline (skills, bindings, frame buffers, queues...)
+// against an optional budget.
+// Components report what they hold either explicitly, with Allocation objects or through the Allocator of their
+// containers, or for opaque objects such as skills and bindings, with the growth of the process private bytes
+// measured around their creation. A background thread samples all components to report their steady-state usage.
+//
+// When the tracked total exceeds highWatermark of the budget, pressure turns High and the registered handlers are
+// called so that pools and queues shrink; it turns back to Normal once the total falls under lowWatermark.
+//
+class MemoryTracker
+{
+public:
+    enum class Pressure
+    {
+        Normal,
+        High
+    };
+
+    struct Options
+    {
+        uint64_t budgetBytes = 0; // 0 to only account memory
+        double highWatermark = 0.9; // fraction of the budget above which pressure turns High
+        double lowWatermark = 0.75; // fraction of the budget below which pressure turns back to Normal
+        std::chrono::milliseconds samplingPeriod = std::chrono::milliseconds(100);
+    };
+
+    //
+    // Memory held by one component, updated from any thread
+    //
+    class Component
+    {
+    public:
+        Component(MemoryTracker& tracker, std::string const& name) : m_tracker(tracker), m_name(name) {}
+
+        Component(const Component&) = delete;
+        Component& operator=(const Component&) = delete;
+
+        void Add(uint64_t bytes);
+        void Release(uint64_t bytes);
+
+        const std::string& Name() const { return m_name; }
+        uint64_t CurrentBytes() const { return m_currentBytes.load(std::memory_order_relaxed); }
+        uint64_t PeakBytes() const { return m_peakBytes.load(std::memory_order_relaxed); }
+        uint64_t AllocationCount() const { return m_allocationCount.load(std::memory_order_relaxed); }
+
+        // Average of the samples taken since the component was created, 0 before the first sample
+        uint64_t SteadyStateBytes() const;
+
+    private:
+        friend class MemoryTracker;
+
+        MemoryTracker& m_tracker;
+        std::string m_name;
+        std::atomic<uint64_t> m_currentBytes = 0;
+        std::atomic<uint64_t> m_peakBytes = 0;
+        std::atomic<uint64_t> m_allocationCount = 0;
+        double m_sampleSum = 0.0; // guarded by the sampling lock of the tracker
+        uint64_t m_sampleCount = 0;
+    };
+
+    //
+    // Bytes held by a component for the lifetime of this object, a null component accounts nothing
+    //
+    class Allocation
+    {
+    public:
+        Allocation() = default;
+        Allocation(Component* component, uint64_t bytes) : m_component(component), m_bytes(bytes)
+        {
+            if (m_component != nullptr)
+            {
+                m_component->Add(m_bytes);
+            }
+        }
+        ~Allocation() { Release(); }
+
+        Allocation(Allocation&& other) noexcept : m_component(std::exchange(other.m_component, nullptr)), m_bytes(other.m_bytes) {}
+        Allocation& operator=(Allocation&& other) noexcept
+        {
+            if (this != &other)
+            {
+                Release();
+                m_component = std::exchange(other.m_component, nullptr);
+                m_bytes = other.m_bytes;
+            }
+            return *this;
+        }
+
+        void Release()
+        {
+            if (m_component != nullptr)
+            {
+                m_component->Release(m_bytes);
+                m_component = nullptr;
+            }
+        }
+
+    private:
+        Component* m_component = nullptr;
+        uint64_t m_bytes = 0;
+    };
+
+    //
+    // Standard allocator accounting the storage of a container to a component, i.e. std::vector<uint8_t, MemoryTracker::Allocator<uint8_t>>
+    //
+    template <typename T>
+    class Allocator
+    {
+    public:
+        using value_type = T;
+
+        Allocator() noexcept = default;
+        explicit Allocator(Component* component) noexcept : m_component(component) {}
+        template <typename U>
+        Allocator(Allocator<U> const& other) noexcept : m_component(other.GetComponent()) {}
+
+        T* allocate(size_t count)
+        {
+            T* items = std::allocator<T>().allocate(count);
+            if (m_component != nullptr)
+            {
+                m_component->Add(count * sizeof(T));
+            }
+            return items;
+        }
+
+        void deallocate(T* items, size_t count) noexcept
+        {
+            if (m_component != nullptr)
+            {
+                m_component->Release(count * sizeof(T));
+            }
+            std::allocator<T>().deallocate(items, count);
+        }
+
+        Component* GetComponent() const noexcept { return m_component; }
+
+        template <typename U>
+        bool operator==(Allocator<U> const& other) const noexcept { return m_component == other.GetComponent(); }
+        template <typename U>
+        bool operator!=(Allocator<U> const& other) const noexcept { return m_component != other.GetComponent(); }
+
+    private:
+        Component* m_component = nullptr;
+    };
+
+    using PressureHandler = std::function<void(Pressure)>;
+
+    MemoryTracker();
+    explicit MemoryTracker(Options const& options);
+    ~MemoryTracker();
+
+    MemoryTracker(const MemoryTracker&) = delete;
+    MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+    // Component of the specified name, created on first use. The reference stays valid for the lifetime of the tracker.
+    Component& GetComponent(std::string const& name);
+
+    //
+    // Run create and account the growth of the process private bytes it caused to the component, returns that growth.
+    // Allocations made meanwhile by other threads are accounted as well, so components are best created up front.
+    //
+    uint64_t MeasureFootprint(Component& component, std::function<void()> const& create);
+
+    // Register a handler called on the thread that changed the pressure, returns the id to unregister it with
+    uint32_t AddPressureHandler(PressureHandler handler);
+    void RemovePressureHandler(uint32_t handlerId);
+
+    Pressure CurrentPressure() const { return m_pressure.load(std::memory_order_relaxed); }
+    uint64_t TotalBytes() const { return m_totalBytes.load(std::memory_order_relaxed); }
+    uint64_t PeakTotalBytes() const { return m_peakTotalBytes.load(std::memory_order_relaxed); }
+    uint64_t BudgetBytes() const { return m_options.budgetBytes; }
+    uint32_t HighPressureCount() const { return m_highPressureCount.load(std::memory_order_relaxed); }
+
+    // Display the current, peak and steady-state usage of each component along with the process totals
+    void Report(std::ostream& output) const;
+
+    // Private bytes and working set of the current process, 0 if unknown
+    static uint64_t ProcessPrivateBytes();
+    static uint64_t ProcessWorkingSetBytes();
+
+private:
+    void OnTotalChanged(int64_t delta);
+    void SamplingLoop();
+
+    Options m_options;
+    mutable std::mutex m_componentLock; // guards the list of components and their samples
+    std::deque<std::unique_ptr<Component>> m_components;
+    std::atomic<uint64_t> m_totalBytes = 0;
+    std::atomic<uint64_t> m_peakTotalBytes = 0;
+    std::atomic<uint64_t> m_peakWorkingSetBytes = 0;
+
+    std::atomic<Pressure> m_pressure = Pressure::Normal;
+    std::atomic<uint32_t> m_highPressureCount = 0;
+    std::recursive_mutex m_handlerLock; // handlers may shrink containers accounted to this tracker
+    std::vector<std::pair<uint32_t, PressureHandler>> m_handlers;
+    uint32_t m_nextHandlerId = 1;
+
+    std::mutex m_samplingLock;
+    std::condition_variable m_stopSampling;
+    bool m_isStopping = false;
+    std::thread m_samplingThread;
+};
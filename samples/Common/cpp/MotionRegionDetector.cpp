@@ -0,0 +1,335 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "MotionRegionDetector.h"
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <utility>
+
+#ifdef MOTION_REGION_DETECTOR_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+MotionRegionDetector::MotionRegionDetector()
+    : MotionRegionDetector(Options())
+{
+}
+
+MotionRegionDetector::MotionRegionDetector(Options const& options)
+    : m_options(options)
+{
+    if (m_options.downsampleFactor == 0 || m_options.blockSize == 0 || m_options.blockSize % 8 != 0)
+    {
+        throw std::invalid_argument("Error: downsample factor must be at least 1 and block size a multiple of 8");
+    }
+    m_options.maxRegions = std::max<uint32_t>(m_options.maxRegions, 1);
+}
+
+void MotionRegionDetector::Reset()
+{
+    m_hasPrevious = false;
+}
+
+//
+// Allocate the luma and block maps for a frame size, forgetting the previous frame if the size changed
+//
+void MotionRegionDetector::Resize(uint32_t width, uint32_t height)
+{
+    if (width == m_frameWidth && height == m_frameHeight && !m_luma.empty())
+    {
+        return;
+    }
+    m_frameWidth = width;
+    m_frameHeight = height;
+    m_lumaWidth = std::max<uint32_t>(width / m_options.downsampleFactor, 1);
+    m_lumaHeight = std::max<uint32_t>(height / m_options.downsampleFactor, 1);
+    m_blockColumns = (m_lumaWidth + m_options.blockSize - 1) / m_options.blockSize;
+    m_blockRows = (m_lumaHeight + m_options.blockSize - 1) / m_options.blockSize;
+    m_lumaStride = m_blockColumns * m_options.blockSize;
+
+    size_t lumaSize = (size_t)m_lumaStride * m_blockRows * m_options.blockSize;
+    m_luma.assign(lumaSize, 0);
+    m_previousLuma.assign(lumaSize, 0);
+    m_changedBlocks.assign((size_t)m_blockColumns * m_blockRows, 0);
+    m_dilatedBlocks.assign(m_changedBlocks.size(), 0);
+    m_hasPrevious = false;
+}
+
+//
+// Each luma sample averages the 2x2 pixels at the top-left of its downsampleFactor x downsampleFactor cell,
+// which is enough to dampen sensor noise without reading every pixel
+//
+MotionRegionDetector::MotionMap MotionRegionDetector::DetectBgra8(const uint8_t* pixels, int32_t stride, uint32_t width, uint32_t height)
+{
+    Resize(width, height);
+    uint32_t factor = m_options.downsampleFactor;
+    uint32_t nextPixel = (factor > 1 && width > 1) ? 4 : 0;
+    int32_t nextRow = (factor > 1 && height > 1) ? stride : 0;
+    for (uint32_t y = 0; y < m_lumaHeight; y++)
+    {
+        const uint8_t* row = pixels + (size_t)y * factor * stride;
+        uint8_t* luma = &m_luma[(size_t)y * m_lumaStride];
+        for (uint32_t x = 0; x < m_lumaWidth; x++)
+        {
+            const uint8_t* top = row + (size_t)x * factor * 4;
+            const uint8_t* bottom = top + nextRow;
+            uint32_t blue = top[0] + top[nextPixel] + bottom[0] + bottom[nextPixel];
+            uint32_t green = top[1] + top[nextPixel + 1] + bottom[1] + bottom[nextPixel + 1];
+            uint32_t red = top[2] + top[nextPixel + 2] + bottom[2] + bottom[nextPixel + 2];
+
+            // BT.601 luma in 8 bits fixed point, averaged over the 4 pixels
+            luma[x] = (uint8_t)((29 * blue + 150 * green + 77 * red + 512) >> 10);
+        }
+    }
+    return Compare();
+}
+
+MotionRegionDetector::MotionMap MotionRegionDetector::DetectLuma(const uint8_t* lumaPlane, int32_t stride, uint32_t width, uint32_t height)
+{
+    Resize(width, height);
+    uint32_t factor = m_options.downsampleFactor;
+    uint32_t nextPixel = (factor > 1 && width > 1) ? 1 : 0;
+    int32_t nextRow = (factor > 1 && height > 1) ? stride : 0;
+    for (uint32_t y = 0; y < m_lumaHeight; y++)
+    {
+        const uint8_t* row = lumaPlane + (size_t)y * factor * stride;
+        uint8_t* luma = &m_luma[(size_t)y * m_lumaStride];
+        for (uint32_t x = 0; x < m_lumaWidth; x++)
+        {
+            const uint8_t* top = row + (size_t)x * factor;
+            const uint8_t* bottom = top + nextRow;
+            luma[x] = (uint8_t)((top[0] + top[nextPixel] + bottom[0] + bottom[nextPixel] + 2) >> 2);
+        }
+    }
+    return Compare();
+}
+
+uint32_t MotionRegionDetector::BlockSad(const uint8_t* a, const uint8_t* b, uint32_t stride, uint32_t size, bool useSimd)
+{
+#ifdef MOTION_REGION_DETECTOR_USE_SSE2
+    if (useSimd)
+    {
+        // _mm_sad_epu8 sums the absolute differences of each half of 16 samples into its low 16 bits
+        __m128i sum = _mm_setzero_si128();
+        for (uint32_t y = 0; y < size; y++, a += stride, b += stride)
+        {
+            uint32_t x = 0;
+            for (; x + 16 <= size; x += 16)
+            {
+                __m128i rowA = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + x));
+                __m128i rowB = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + x));
+                sum = _mm_add_epi64(sum, _mm_sad_epu8(rowA, rowB));
+            }
+            if (x < size)
+            {
+                __m128i rowA = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(a + x));
+                __m128i rowB = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(b + x));
+                sum = _mm_add_epi64(sum, _mm_sad_epu8(rowA, rowB));
+            }
+        }
+        return (uint32_t)_mm_cvtsi128_si32(sum) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+    }
+#else
+    (void)useSimd;
+#endif
+    uint32_t sum = 0;
+    for (uint32_t y = 0; y < size; y++, a += stride, b += stride)
+    {
+        for (uint32_t x = 0; x < size; x++)
+        {
+            sum += (uint32_t)std::abs((int32_t)a[x] - (int32_t)b[x]);
+        }
+    }
+    return sum;
+}
+
+//
+// Flag the blocks that changed since the previous frame and turn them into regions
+//
+MotionRegionDetector::MotionMap MotionRegionDetector::Compare()
+{
+    MotionMap map;
+    map.blockCount = m_blockColumns * m_blockRows;
+
+    uint32_t blockSize = m_options.blockSize;
+    for (uint32_t blockY = 0; blockY < m_blockRows; blockY++)
+    {
+        for (uint32_t blockX = 0; blockX < m_blockColumns; blockX++)
+        {
+            bool isChanged = true;
+            if (m_hasPrevious)
+            {
+                size_t offset = (size_t)blockY * blockSize * m_lumaStride + (size_t)blockX * blockSize;
+                uint32_t sad = BlockSad(&m_luma[offset], &m_previousLuma[offset], m_lumaStride, blockSize, m_options.useSimd);
+
+                // Blocks at the right and bottom edges are partly padding, which never differs
+                uint32_t sampleCount = std::min(blockSize, m_lumaWidth - blockX * blockSize) * std::min(blockSize, m_lumaHeight - blockY * blockSize);
+                isChanged = sad > m_options.changeThreshold * sampleCount;
+            }
+            m_changedBlocks[(size_t)blockY * m_blockColumns + blockX] = isChanged ? 1 : 0;
+            map.changedBlockCount += isChanged ? 1 : 0;
+        }
+    }
+
+    bool hadPrevious = m_hasPrevious;
+    std::swap(m_luma, m_previousLuma);
+    m_hasPrevious = true;
+
+    if (!hadPrevious)
+    {
+        map.isFullFrame = true;
+    }
+    else if (map.changedBlockCount > 0)
+    {
+        // Convert the regions to frame pixels, the last blocks also cover the pixels left over by downsampling
+        uint32_t pixelsPerBlock = blockSize * m_options.downsampleFactor;
+        uint64_t regionArea = 0;
+        for (auto&& box : ClusterChangedBlocks())
+        {
+            Region region;
+            region.x = std::min(box.left * pixelsPerBlock, m_frameWidth);
+            region.y = std::min(box.top * pixelsPerBlock, m_frameHeight);
+            uint32_t right = (box.right == m_blockColumns) ? m_frameWidth : std::min(box.right * pixelsPerBlock, m_frameWidth);
+            uint32_t bottom = (box.bottom == m_blockRows) ? m_frameHeight : std::min(box.bottom * pixelsPerBlock, m_frameHeight);
+            region.width = right - region.x;
+            region.height = bottom - region.y;
+            if (region.width > 0 && region.height > 0)
+            {
+                regionArea += (uint64_t)region.width * region.height;
+                map.regions.push_back(region);
+            }
+        }
+        map.regionFraction = (float)((double)regionArea / ((uint64_t)m_frameWidth * m_frameHeight));
+        map.isFullFrame = map.regionFraction > m_options.fullFrameFraction;
+    }
+
+    if (map.isFullFrame)
+    {
+        map.regions.assign(1, { 0, 0, m_frameWidth, m_frameHeight });
+        map.regionFraction = 1.0f;
+    }
+    return map;
+}
+
+//
+// Bounding boxes of the 8-connected groups of changed blocks once grown by the dilation
+//
+std::vector<MotionRegionDetector::BlockBox> MotionRegionDetector::ClusterChangedBlocks()
+{
+    int32_t dilation = (int32_t)m_options.dilation;
+    int32_t columns = (int32_t)m_blockColumns;
+    int32_t rows = (int32_t)m_blockRows;
+    std::fill(m_dilatedBlocks.begin(), m_dilatedBlocks.end(), (uint8_t)0);
+    for (int32_t y = 0; y < rows; y++)
+    {
+        for (int32_t x = 0; x < columns; x++)
+        {
+            if (m_changedBlocks[(size_t)y * columns + x])
+            {
+                for (int32_t dilatedY = std::max(y - dilation, 0); dilatedY <= std::min(y + dilation, rows - 1); dilatedY++)
+                {
+                    std::fill_n(&m_dilatedBlocks[(size_t)dilatedY * columns + std::max(x - dilation, 0)], std::min(x + dilation, columns - 1) - std::max(x - dilation, 0) + 1, (uint8_t)1);
+                }
+            }
+        }
+    }
+
+    // Flood fill each group, clearing its blocks as they get visited
+    std::vector<BlockBox> boxes;
+    for (int32_t y = 0; y < rows; y++)
+    {
+        for (int32_t x = 0; x < columns; x++)
+        {
+            if (!m_dilatedBlocks[(size_t)y * columns + x])
+            {
+                continue;
+            }
+            BlockBox box = { (uint32_t)x, (uint32_t)y, (uint32_t)x + 1, (uint32_t)y + 1 };
+            m_dilatedBlocks[(size_t)y * columns + x] = 0;
+            m_pendingBlocks.assign(1, (uint32_t)(y * columns + x));
+            while (!m_pendingBlocks.empty())
+            {
+                int32_t block = (int32_t)m_pendingBlocks.back();
+                m_pendingBlocks.pop_back();
+                int32_t blockX = block % columns;
+                int32_t blockY = block / columns;
+                box.left = std::min(box.left, (uint32_t)blockX);
+                box.top = std::min(box.top, (uint32_t)blockY);
+                box.right = std::max(box.right, (uint32_t)blockX + 1);
+                box.bottom = std::max(box.bottom, (uint32_t)blockY + 1);
+                for (int32_t neighborY = std::max(blockY - 1, 0); neighborY <= std::min(blockY + 1, rows - 1); neighborY++)
+                {
+                    for (int32_t neighborX = std::max(blockX - 1, 0); neighborX <= std::min(blockX + 1, columns - 1); neighborX++)
+                    {
+                        size_t neighbor = (size_t)neighborY * columns + neighborX;
+                        if (m_dilatedBlocks[neighbor])
+                        {
+                            m_dilatedBlocks[neighbor] = 0;
+                            m_pendingBlocks.push_back((uint32_t)neighbor);
+                        }
+                    }
+                }
+            }
+            boxes.push_back(box);
+        }
+    }
+
+    MergeBoxes(boxes);
+    return boxes;
+}
+
+//
+// Merge overlapping boxes, then the pairs adding the least area when merged until at most maxRegions are left
+//
+void MotionRegionDetector::MergeBoxes(std::vector<BlockBox>& boxes) const
+{
+    auto merge = [](BlockBox const& a, BlockBox const& b)
+    {
+        return BlockBox{ std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right), std::max(a.bottom, b.bottom) };
+    };
+    auto overlaps = [](BlockBox const& a, BlockBox const& b)
+    {
+        return a.left < b.right && b.left < a.right && a.top < b.bottom && b.top < a.bottom;
+    };
+
+    bool hasMerged = true;
+    while (hasMerged)
+    {
+        hasMerged = false;
+        for (size_t i = 0; i < boxes.size() && !hasMerged; i++)
+        {
+            for (size_t j = i + 1; j < boxes.size(); j++)
+            {
+                if (overlaps(boxes[i], boxes[j]))
+                {
+                    boxes[i] = merge(boxes[i], boxes[j]);
+                    boxes.erase(boxes.begin() + j);
+                    hasMerged = true;
+                    break;
+                }
+            }
+        }
+
+        if (!hasMerged && boxes.size() > m_options.maxRegions)
+        {
+            size_t bestI = 0;
+            size_t bestJ = 1;
+            int64_t bestGrowth = INT64_MAX;
+            for (size_t i = 0; i < boxes.size(); i++)
+            {
+                for (size_t j = i + 1; j < boxes.size(); j++)
+                {
+                    int64_t growth = (int64_t)merge(boxes[i], boxes[j]).Area() - boxes[i].Area() - boxes[j].Area();
+                    if (growth < bestGrowth)
+                    {
+                        bestGrowth = growth;
+                        bestI = i;
+                        bestJ = j;
+                    }
+                }
+            }
+            boxes[bestI] = merge(boxes[bestI], boxes[bestJ]);
+            boxes.erase(boxes.begin() + bestJ);
+            hasMerged = true;
+        }
+    }
+}
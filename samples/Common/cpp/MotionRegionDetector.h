@@ -0,0 +1,109 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// SSE2 is used when targeting x86 or x64, other architectures use the equivalent scalar code
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MOTION_REGION_DETECTOR_USE_SSE2
+#endif
+
+//
+// Helper class that finds the regions of a frame that changed since the previous one, so that skills only
+// evaluate those regions instead of the whole frame:
+// - frames are reduced to luma downsampled by downsampleFactor, read straight from the Y plane of NV12 and Gray8 frames
+// - the luma is split in blocks of blockSize samples compared to the previous frame by their sum of absolute
+//   differences (SAD), computed 16 samples at a time with SSE2 on x86/x64
+// - changed blocks are grown by dilation blocks of context, clustered into connected regions and merged down
+//   to at most maxRegions bounding boxes
+// The whole frame is reported instead when there is no previous frame to compare to, when the frame size
+// changed or when the regions cover more than fullFrameFraction of it, since cropping would then cost more than it saves.
+//
+class MotionRegionDetector
+{
+public:
+    struct Options
+    {
+        uint32_t downsampleFactor = 4; // frame pixels per luma sample in each dimension
+        uint32_t blockSize = 8; // luma samples per block side, a multiple of 8
+        uint32_t changeThreshold = 8; // mean absolute luma difference above which a block changed
+        uint32_t dilation = 1; // blocks of context added around changed blocks
+        uint32_t maxRegions = 4;
+        float fullFrameFraction = 0.5f; // frame area covered by regions above which the whole frame is reported
+        bool useSimd = true; // only effective when MOTION_REGION_DETECTOR_USE_SSE2 is defined
+    };
+
+    // Rectangle in frame pixels
+    struct Region
+    {
+        uint32_t x = 0;
+        uint32_t y = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+    };
+
+    struct MotionMap
+    {
+        std::vector<Region> regions; // empty if nothing changed, a single region covering the frame if isFullFrame
+        bool isFullFrame = false;
+        uint32_t changedBlockCount = 0;
+        uint32_t blockCount = 0;
+        float regionFraction = 0.0f; // frame area covered by regions
+    };
+
+    MotionRegionDetector();
+    explicit MotionRegionDetector(Options const& options);
+
+    // Compare a frame of 32bpp BGRA pixels to the previous one
+    MotionMap DetectBgra8(const uint8_t* pixels, int32_t stride, uint32_t width, uint32_t height);
+
+    // Compare a frame given by its 8bpp luma plane (i.e. the Y plane of an NV12 frame) to the previous one
+    MotionMap DetectLuma(const uint8_t* luma, int32_t stride, uint32_t width, uint32_t height);
+
+    // Forget the previous frame, the next one is reported as a whole
+    void Reset();
+
+    // Per block change flags of the last frame, row by row
+    const std::vector<uint8_t>& ChangedBlocks() const { return m_changedBlocks; }
+    uint32_t BlockColumns() const { return m_blockColumns; }
+    uint32_t BlockRows() const { return m_blockRows; }
+
+    // Sum of absolute differences of a block of size x size samples, size being a multiple of 8
+    static uint32_t BlockSad(const uint8_t* a, const uint8_t* b, uint32_t stride, uint32_t size, bool useSimd);
+
+private:
+    // Rectangle in blocks, right and bottom excluded
+    struct BlockBox
+    {
+        uint32_t left;
+        uint32_t top;
+        uint32_t right;
+        uint32_t bottom;
+
+        uint32_t Area() const { return (right - left) * (bottom - top); }
+    };
+
+    void Resize(uint32_t width, uint32_t height);
+    MotionMap Compare();
+    std::vector<BlockBox> ClusterChangedBlocks();
+    void MergeBoxes(std::vector<BlockBox>& boxes) const;
+
+    Options m_options;
+    uint32_t m_frameWidth = 0;
+    uint32_t m_frameHeight = 0;
+    bool m_hasPrevious = false;
+
+    // Downsampled luma of the current and previous frames, padded with zeros to whole blocks
+    uint32_t m_lumaWidth = 0;
+    uint32_t m_lumaHeight = 0;
+    uint32_t m_lumaStride = 0;
+    std::vector<uint8_t> m_luma;
+    std::vector<uint8_t> m_previousLuma;
+
+    uint32_t m_blockColumns = 0;
+    uint32_t m_blockRows = 0;
+    std::vector<uint8_t> m_changedBlocks;
+    std::vector<uint8_t> m_dilatedBlocks;
+    std::vector<uint32_t> m_pendingBlocks; // flood fill stack
+};
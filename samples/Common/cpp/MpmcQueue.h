@@ -0,0 +1,131 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+//
+// Lock-free bounded queue that any amount of threads can push to and pop from concurrently
+// (Dmitry Vyukov's bounded MPMC queue). Each cell carries a sequence number telling whether it is ready
+// to be written or read at a given position, so producers and consumers only contend on their own index.
+// Pushing to a full queue fails instead of waiting, which suits hot threads that would rather drop an item than stall.
+//
+template <typename T>
+class MpmcQueue
+{
+    static_assert(std::is_trivially_copyable<T>::value, "MpmcQueue items must be trivially copyable");
+
+public:
+    // capacity is rounded up to the next power of 2
+    explicit MpmcQueue(size_t capacity)
+    {
+        size_t cellCount = 2;
+        while (cellCount < capacity)
+        {
+            cellCount *= 2;
+        }
+        m_mask = cellCount - 1;
+        m_cells.reset(new Cell[cellCount]);
+        for (size_t i = 0; i < cellCount; i++)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    //
+    // Enqueue an item, returns false without waiting if the queue is full
+    //
+    bool TryPush(const T& item)
+    {
+        Cell* cell = nullptr;
+        size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &m_cells[position & m_mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+            if (difference == 0)
+            {
+                // The cell is free at this position, claim it
+                if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                // The cell still holds the item pushed one lap earlier
+                return false;
+            }
+            else
+            {
+                // Another producer claimed the cell, catch up
+                position = m_enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = item;
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    //
+    // Dequeue the oldest item, returns false without waiting if the queue is empty
+    //
+    bool TryPop(T& item)
+    {
+        Cell* cell = nullptr;
+        size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+        while (true)
+        {
+            cell = &m_cells[position & m_mask];
+            size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            intptr_t difference = (intptr_t)sequence - (intptr_t)(position + 1);
+            if (difference == 0)
+            {
+                // The cell holds an item at this position, claim it
+                if (m_dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (difference < 0)
+            {
+                // Nothing was pushed at this position yet
+                return false;
+            }
+            else
+            {
+                // Another consumer claimed the cell, catch up
+                position = m_dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+
+        item = cell->data;
+
+        // Free the cell for the producer one lap later
+        cell->sequence.store(position + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t Capacity() const { return m_mask + 1; }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T data;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask = 0;
+
+    // Keep producer and consumer positions on separate cache lines
+    alignas(64) std::atomic<size_t> m_enqueuePosition = 0;
+    alignas(64) std::atomic<size_t> m_dequeuePosition = 0;
+};
@@ -0,0 +1,458 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "PerspectiveWarp.h"
+#include "WorkStealingThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef PERSPECTIVE_WARP_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+PerspectiveWarp::Homography PerspectiveWarp::Homography::Translate(double offsetX, double offsetY)
+{
+    Homography translation;
+    translation.m[2] = offsetX;
+    translation.m[5] = offsetY;
+    return translation;
+}
+
+//
+// Closed form of the homography mapping the unit square onto the quad (Heckbert, Fundamentals of Texture Mapping
+// and Image Warping), applied after scaling the rectangle down to the unit square
+//
+PerspectiveWarp::Homography PerspectiveWarp::Homography::RectangleToQuad(double width, double height, Quad const& quad)
+{
+    if (!(width > 0.0) || !(height > 0.0))
+    {
+        throw std::invalid_argument("Error: the rectangle must not be empty");
+    }
+    double x0 = quad[0].x, y0 = quad[0].y;
+    double x1 = quad[1].x, y1 = quad[1].y;
+    double x2 = quad[2].x, y2 = quad[2].y;
+    double x3 = quad[3].x, y3 = quad[3].y;
+
+    double sumX = x0 - x1 + x2 - x3;
+    double sumY = y0 - y1 + y2 - y3;
+    double g = 0.0;
+    double h = 0.0;
+    if (sumX != 0.0 || sumY != 0.0)
+    {
+        // Not a parallelogram, the perspective terms are not null
+        double dx1 = x1 - x2, dx2 = x3 - x2;
+        double dy1 = y1 - y2, dy2 = y3 - y2;
+        double determinant = dx1 * dy2 - dx2 * dy1;
+        if (determinant == 0.0)
+        {
+            throw std::invalid_argument("Error: the quad is degenerate");
+        }
+        g = (sumX * dy2 - dx2 * sumY) / determinant;
+        h = (dx1 * sumY - sumX * dy1) / determinant;
+    }
+
+    Homography homography;
+    homography.m[0] = (x1 - x0 + g * x1) / width;
+    homography.m[1] = (x3 - x0 + h * x3) / height;
+    homography.m[2] = x0;
+    homography.m[3] = (y1 - y0 + g * y1) / width;
+    homography.m[4] = (y3 - y0 + h * y3) / height;
+    homography.m[5] = y0;
+    homography.m[6] = g / width;
+    homography.m[7] = h / height;
+    homography.m[8] = 1.0;
+    return homography;
+}
+
+PerspectiveWarp::Homography PerspectiveWarp::Homography::Then(Homography const& next) const
+{
+    Homography result;
+    for (int row = 0; row < 3; row++)
+    {
+        for (int column = 0; column < 3; column++)
+        {
+            result.m[row * 3 + column] =
+                next.m[row * 3] * m[column]
+                + next.m[row * 3 + 1] * m[3 + column]
+                + next.m[row * 3 + 2] * m[6 + column];
+        }
+    }
+    return result;
+}
+
+PerspectiveWarp::Homography PerspectiveWarp::Homography::Inverse() const
+{
+    // Adjugate over determinant
+    Homography inverse;
+    inverse.m[0] = m[4] * m[8] - m[5] * m[7];
+    inverse.m[1] = m[2] * m[7] - m[1] * m[8];
+    inverse.m[2] = m[1] * m[5] - m[2] * m[4];
+    inverse.m[3] = m[5] * m[6] - m[3] * m[8];
+    inverse.m[4] = m[0] * m[8] - m[2] * m[6];
+    inverse.m[5] = m[2] * m[3] - m[0] * m[5];
+    inverse.m[6] = m[3] * m[7] - m[4] * m[6];
+    inverse.m[7] = m[1] * m[6] - m[0] * m[7];
+    inverse.m[8] = m[0] * m[4] - m[1] * m[3];
+    double determinant = m[0] * inverse.m[0] + m[1] * inverse.m[3] + m[2] * inverse.m[6];
+    if (determinant == 0.0 || !std::isfinite(determinant))
+    {
+        throw std::invalid_argument("Error: the homography is not invertible");
+    }
+    for (auto&& value : inverse.m)
+    {
+        value /= determinant;
+    }
+    return inverse;
+}
+
+PerspectiveWarp::Point PerspectiveWarp::Homography::Apply(Point const& point) const
+{
+    double w = m[6] * point.x + m[7] * point.y + m[8];
+    return {
+        (float)((m[0] * point.x + m[1] * point.y + m[2]) / w),
+        (float)((m[3] * point.x + m[4] * point.y + m[5]) / w) };
+}
+
+void PerspectiveWarp::RectifiedSize(Quad const& quad, float& width, float& height)
+{
+    width = (std::hypot(quad[1].x - quad[0].x, quad[1].y - quad[0].y) + std::hypot(quad[2].x - quad[3].x, quad[2].y - quad[3].y)) / 2;
+    height = (std::hypot(quad[3].x - quad[0].x, quad[3].y - quad[0].y) + std::hypot(quad[2].x - quad[1].x, quad[2].y - quad[1].y)) / 2;
+}
+
+PerspectiveWarp::QuadCheck PerspectiveWarp::CheckQuad(Quad const& quad, uint32_t imageWidth, uint32_t imageHeight, QuadCheckOptions const& options)
+{
+    if (imageWidth == 0 || imageHeight == 0)
+    {
+        throw std::invalid_argument("Error: the image must not be empty");
+    }
+    QuadCheck check;
+
+    // The quad is convex when it turns the same way at each corner, which also rules out crossed corners
+    int positiveTurnCount = 0;
+    int negativeTurnCount = 0;
+    double area = 0.0;
+    for (size_t i = 0; i < quad.size(); i++)
+    {
+        auto& corner = quad[i];
+        auto& next = quad[(i + 1) % quad.size()];
+        auto& afterNext = quad[(i + 2) % quad.size()];
+        double turn = (double)(next.x - corner.x) * (afterNext.y - next.y) - (double)(next.y - corner.y) * (afterNext.x - next.x);
+        positiveTurnCount += turn > 0.0 ? 1 : 0;
+        negativeTurnCount += turn < 0.0 ? 1 : 0;
+        area += (double)corner.x * next.y - (double)next.x * corner.y;
+    }
+    check.areaFraction = (float)(std::abs(area) / 2 / ((double)imageWidth * imageHeight));
+
+    RectifiedSize(quad, check.rectifiedWidth, check.rectifiedHeight);
+    float shorterSide = std::min<float>(check.rectifiedWidth, check.rectifiedHeight);
+    float longerSide = std::max<float>(check.rectifiedWidth, check.rectifiedHeight);
+    check.aspectRatio = shorterSide > 0.0f ? longerSide / shorterSide : INFINITY;
+
+    if (positiveTurnCount != 4 && negativeTurnCount != 4)
+    {
+        check.issue = QuadIssue::NotConvex;
+    }
+    else if (check.areaFraction < options.minAreaFraction)
+    {
+        check.issue = QuadIssue::TooSmall;
+    }
+    else if (!(check.aspectRatio <= options.maxAspectRatio))
+    {
+        check.issue = QuadIssue::TooElongated;
+    }
+    return check;
+}
+
+const char* PerspectiveWarp::ToString(QuadIssue issue)
+{
+    switch (issue)
+    {
+    case QuadIssue::None: return "valid";
+    case QuadIssue::NotConvex: return "not convex";
+    case QuadIssue::TooSmall: return "too small";
+    case QuadIssue::TooElongated: return "too elongated";
+    }
+    return "unknown";
+}
+
+//
+// Source pixel at (x, y), clamped to the edges of the image
+//
+static inline uint32_t LoadClamped(PerspectiveWarp::Image const& image, int32_t x, int32_t y)
+{
+    x = std::min<int32_t>(std::max<int32_t>(x, 0), (int32_t)image.width - 1);
+    y = std::min<int32_t>(std::max<int32_t>(y, 0), (int32_t)image.height - 1);
+    uint32_t pixel;
+    memcpy(&pixel, image.Row((uint32_t)y) + (size_t)x * 4, sizeof(pixel));
+    return pixel;
+}
+
+//
+// Catmull-Rom weights of the 4 source pixels around a position t past the second one, computed the same way
+// by the scalar and the SIMD code
+//
+static inline void CubicWeights(float t, float* weights)
+{
+    weights[0] = ((-0.5f * t + 1.0f) * t - 0.5f) * t;
+    weights[1] = (1.5f * t - 2.5f) * t * t + 1.0f;
+    weights[2] = ((-1.5f * t + 2.0f) * t + 0.5f) * t;
+    weights[3] = (0.5f * t - 0.5f) * t * t;
+}
+
+//
+// Interpolate the source pixels around (x + tx, y + ty), x and y being the integer parts. The SIMD versions
+// interpolate the 4 channels at once with the same operations in the same order as the scalar versions.
+//
+static inline uint32_t SampleBilinear(PerspectiveWarp::Image const& source, int32_t x, int32_t y, float tx, float ty, bool useSimd)
+{
+    uint32_t topLeft = LoadClamped(source, x, y);
+    uint32_t topRight = LoadClamped(source, x + 1, y);
+    uint32_t bottomLeft = LoadClamped(source, x, y + 1);
+    uint32_t bottomRight = LoadClamped(source, x + 1, y + 1);
+    uint32_t weightX = (uint32_t)(tx * 256.0f);
+    uint32_t weightY = (uint32_t)(ty * 256.0f);
+#ifdef PERSPECTIVE_WARP_USE_SSE2
+    if (useSimd)
+    {
+        // 8 x 16 bit lanes, the channels of the left pixel then of the right pixel
+        __m128i zero = _mm_setzero_si128();
+        __m128i top = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128((int)topLeft), _mm_cvtsi32_si128((int)topRight)), zero);
+        __m128i bottom = _mm_unpacklo_epi8(_mm_unpacklo_epi32(_mm_cvtsi32_si128((int)bottomLeft), _mm_cvtsi32_si128((int)bottomRight)), zero);
+        __m128i half = _mm_set1_epi16(128);
+
+        // Products stay below 2^16, so that the low half of the signed products is the unsigned result
+        __m128i columns = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+            _mm_mullo_epi16(top, _mm_set1_epi16((short)(256 - weightY))),
+            _mm_mullo_epi16(bottom, _mm_set1_epi16((short)weightY))), half), 8);
+        __m128i blended = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(
+            _mm_mullo_epi16(columns, _mm_set1_epi16((short)(256 - weightX))),
+            _mm_mullo_epi16(_mm_srli_si128(columns, 8), _mm_set1_epi16((short)weightX))), half), 8);
+        return (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(blended, blended));
+    }
+#else
+    (void)useSimd;
+#endif
+    uint32_t result = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 8)
+    {
+        uint32_t left = (((topLeft >> shift) & 0xFF) * (256 - weightY) + ((bottomLeft >> shift) & 0xFF) * weightY + 128) >> 8;
+        uint32_t right = (((topRight >> shift) & 0xFF) * (256 - weightY) + ((bottomRight >> shift) & 0xFF) * weightY + 128) >> 8;
+        result |= ((left * (256 - weightX) + right * weightX + 128) >> 8) << shift;
+    }
+    return result;
+}
+
+static inline uint32_t SampleBicubic(PerspectiveWarp::Image const& source, int32_t x, int32_t y, float tx, float ty, bool useSimd)
+{
+    float weightsX[4];
+    float weightsY[4];
+    CubicWeights(tx, weightsX);
+    CubicWeights(ty, weightsY);
+    uint32_t pixels[4][4];
+    for (int32_t row = 0; row < 4; row++)
+    {
+        for (int32_t column = 0; column < 4; column++)
+        {
+            pixels[row][column] = LoadClamped(source, x + column - 1, y + row - 1);
+        }
+    }
+#ifdef PERSPECTIVE_WARP_USE_SSE2
+    if (useSimd)
+    {
+        // 4 x 32 bit float lanes, one per channel
+        __m128i zero = _mm_setzero_si128();
+        __m128 blended = _mm_setzero_ps();
+        for (int32_t row = 0; row < 4; row++)
+        {
+            __m128 rowSum = _mm_setzero_ps();
+            for (int32_t column = 0; column < 4; column++)
+            {
+                __m128 channels = _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128((int)pixels[row][column]), zero), zero));
+                rowSum = _mm_add_ps(rowSum, _mm_mul_ps(channels, _mm_set1_ps(weightsX[column])));
+            }
+            blended = _mm_add_ps(blended, _mm_mul_ps(rowSum, _mm_set1_ps(weightsY[row])));
+        }
+
+        // Catmull-Rom overshoots around sharp edges, clamp before rounding
+        blended = _mm_min_ps(_mm_max_ps(_mm_add_ps(blended, _mm_set1_ps(0.5f)), _mm_setzero_ps()), _mm_set1_ps(255.0f));
+        __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(blended), zero);
+        return (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(packed, packed));
+    }
+#else
+    (void)useSimd;
+#endif
+    uint32_t result = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 8)
+    {
+        float blended = 0.0f;
+        for (int32_t row = 0; row < 4; row++)
+        {
+            float rowSum = 0.0f;
+            for (int32_t column = 0; column < 4; column++)
+            {
+                rowSum = rowSum + (float)((pixels[row][column] >> shift) & 0xFF) * weightsX[column];
+            }
+            blended = blended + rowSum * weightsY[row];
+        }
+        blended = blended + 0.5f;
+        blended = blended > 0.0f ? blended : 0.0f;
+        blended = blended < 255.0f ? blended : 255.0f;
+        result |= (uint32_t)blended << shift;
+    }
+    return result;
+}
+
+//
+// Warp the output pixels of columns [left, right) and rows [top, bottom). transform maps output pixel indexes to
+// source pixel indexes, mapped positions are clamped to 1 pixel past the edges of the source image before being
+// split into integer and fractional parts, so that even positions at infinity give valid pixel indexes.
+//
+void PerspectiveWarp::WarpTile(Image const& source, float const* transform, Image const& output, uint32_t left, uint32_t top, uint32_t right, uint32_t bottom, WarpOptions const& options)
+{
+    bool isBicubic = options.interpolation == Interpolation::Bicubic;
+    float maxX = (float)source.width;
+    float maxY = (float)source.height;
+    for (uint32_t y = top; y < bottom; y++)
+    {
+        float rowX = transform[1] * (float)y + transform[2];
+        float rowY = transform[4] * (float)y + transform[5];
+        float rowW = transform[7] * (float)y + transform[8];
+        uint8_t* outputRow = output.Row(y);
+        uint32_t x = left;
+#ifdef PERSPECTIVE_WARP_USE_SSE2
+        if (options.useSimd)
+        {
+            // Map 4 output pixels at a time
+            __m128i one = _mm_set1_epi32(1);
+            __m128 minimum = _mm_set1_ps(-1.0f);
+            __m128 maxX4 = _mm_set1_ps(maxX);
+            __m128 maxY4 = _mm_set1_ps(maxY);
+            alignas(16) int32_t sourceX[4];
+            alignas(16) int32_t sourceY[4];
+            alignas(16) float fractionX[4];
+            alignas(16) float fractionY[4];
+            for (; x + 4 <= right; x += 4)
+            {
+                __m128 x4 = _mm_cvtepi32_ps(_mm_add_epi32(_mm_set1_epi32((int)x), _mm_setr_epi32(0, 1, 2, 3)));
+                __m128 w = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(transform[6]), x4), _mm_set1_ps(rowW));
+                __m128 mappedX = _mm_div_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(transform[0]), x4), _mm_set1_ps(rowX)), w);
+                __m128 mappedY = _mm_div_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(transform[3]), x4), _mm_set1_ps(rowY)), w);
+                mappedX = _mm_min_ps(_mm_max_ps(mappedX, minimum), maxX4);
+                mappedY = _mm_min_ps(_mm_max_ps(mappedY, minimum), maxY4);
+
+                // Floor of the positions: truncate, then step down where truncation rounded negative values up
+                __m128i integerX = _mm_cvttps_epi32(mappedX);
+                __m128i integerY = _mm_cvttps_epi32(mappedY);
+                integerX = _mm_sub_epi32(integerX, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(integerX), mappedX)), one));
+                integerY = _mm_sub_epi32(integerY, _mm_and_si128(_mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(integerY), mappedY)), one));
+                _mm_store_si128((__m128i*)sourceX, integerX);
+                _mm_store_si128((__m128i*)sourceY, integerY);
+                _mm_store_ps(fractionX, _mm_sub_ps(mappedX, _mm_cvtepi32_ps(integerX)));
+                _mm_store_ps(fractionY, _mm_sub_ps(mappedY, _mm_cvtepi32_ps(integerY)));
+
+                for (uint32_t lane = 0; lane < 4; lane++)
+                {
+                    uint32_t pixel = isBicubic
+                        ? SampleBicubic(source, sourceX[lane], sourceY[lane], fractionX[lane], fractionY[lane], true)
+                        : SampleBilinear(source, sourceX[lane], sourceY[lane], fractionX[lane], fractionY[lane], true);
+                    memcpy(outputRow + (size_t)(x + lane) * 4, &pixel, sizeof(pixel));
+                }
+            }
+        }
+#endif
+        for (; x < right; x++)
+        {
+            float outputX = (float)x;
+            float w = transform[6] * outputX + rowW;
+            float mappedX = (transform[0] * outputX + rowX) / w;
+            float mappedY = (transform[3] * outputX + rowY) / w;
+
+            // Same clamping as _mm_max_ps and _mm_min_ps, which turns NaN into the lower bound
+            mappedX = mappedX > -1.0f ? mappedX : -1.0f;
+            mappedX = mappedX < maxX ? mappedX : maxX;
+            mappedY = mappedY > -1.0f ? mappedY : -1.0f;
+            mappedY = mappedY < maxY ? mappedY : maxY;
+
+            float floorX = std::floor(mappedX);
+            float floorY = std::floor(mappedY);
+            uint32_t pixel = isBicubic
+                ? SampleBicubic(source, (int32_t)floorX, (int32_t)floorY, mappedX - floorX, mappedY - floorY, options.useSimd)
+                : SampleBilinear(source, (int32_t)floorX, (int32_t)floorY, mappedX - floorX, mappedY - floorY, options.useSimd);
+            memcpy(outputRow + (size_t)x * 4, &pixel, sizeof(pixel));
+        }
+    }
+}
+
+void PerspectiveWarp::Warp(Image const& source, Homography const& outputToSource, Image const& output, WarpOptions const& options)
+{
+    if (source.data == nullptr || source.width == 0 || source.height == 0)
+    {
+        throw std::invalid_argument("Error: the source image must not be empty");
+    }
+    if (output.data == nullptr && output.width > 0 && output.height > 0)
+    {
+        throw std::invalid_argument("Error: the output image has no pixels");
+    }
+    if (options.tileSize == 0)
+    {
+        throw std::invalid_argument("Error: the tile size must not be 0");
+    }
+
+    // Sample at pixel centers: shift output pixel indexes to their centers, then mapped centers back to source pixel indexes
+    auto centered = Homography::Translate(0.5, 0.5).Then(outputToSource).Then(Homography::Translate(-0.5, -0.5));
+    float transform[9];
+    for (int i = 0; i < 9; i++)
+    {
+        transform[i] = (float)centered.m[i];
+    }
+
+    uint32_t tileCountX = (output.width + options.tileSize - 1) / options.tileSize;
+    uint32_t tileCountY = (output.height + options.tileSize - 1) / options.tileSize;
+    uint32_t tileCount = tileCountX * tileCountY;
+    auto warpTile = [&](uint32_t tileIndex)
+    {
+        uint32_t left = (tileIndex % tileCountX) * options.tileSize;
+        uint32_t top = (tileIndex / tileCountX) * options.tileSize;
+        WarpTile(source, transform, output, left, top,
+            std::min<uint32_t>(left + options.tileSize, output.width),
+            std::min<uint32_t>(top + options.tileSize, output.height),
+            options);
+    };
+
+    uint32_t workerCount = options.threadPool != nullptr ? std::min<uint32_t>(options.threadPool->WorkerCount(), tileCount) : 1;
+    if (workerCount <= 1)
+    {
+        for (uint32_t tileIndex = 0; tileIndex < tileCount; tileIndex++)
+        {
+            warpTile(tileIndex);
+        }
+        return;
+    }
+
+    // Each task picks tiles until none is left, tiles write to disjoint output pixels
+    std::atomic<uint32_t> nextTile = 0;
+
+    // Declared last so that the tasks completing in its destructor never outlive what they reference
+    WorkStealingThreadPool::TaskGroup workers(*options.threadPool);
+    for (uint32_t workerIndex = 0; workerIndex < workerCount; workerIndex++)
+    {
+        workers.Run([&]()
+        {
+            for (uint32_t tileIndex = nextTile++; tileIndex < tileCount; tileIndex = nextTile++)
+            {
+                warpTile(tileIndex);
+            }
+        });
+    }
+    workers.Wait();
+}
+
+void PerspectiveWarp::Rectify(Image const& source, Quad const& quad, Image const& output, WarpOptions const& options)
+{
+    if (output.width == 0 || output.height == 0)
+    {
+        return;
+    }
+    Warp(source, Homography::RectangleToQuad(output.width, output.height, quad), output, options);
+}
@@ -0,0 +1,126 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// SSE2 is used when targeting x86 or x64, other architectures use the equivalent scalar code
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PERSPECTIVE_WARP_USE_SSE2
+#endif
+
+class WorkStealingThreadPool;
+
+//
+// Helper class with the CPU kernels needed to preview what ImageRectifier will produce before evaluating it:
+// - homography mapping a rectangle onto the four corners of a quad, and its inverse
+// - sanity check of a detected quad: its area, convexity and the aspect ratio of the rectangle it rectifies to
+// - perspective warp of BGRA8 pixels with bilinear or bicubic interpolation, i.e. to rectify a quad into a thumbnail
+// The warp computes its output in square tiles spread over the workers of a thread pool. Its SSE2 code maps 4 pixels
+// at a time and interpolates the 4 channels of a pixel at once, and gives the same results as the scalar code.
+//
+class PerspectiveWarp
+{
+public:
+    struct Point
+    {
+        float x;
+        float y;
+    };
+
+    // Corners in pixels, clockwise from the top-left one like the quads of QuadDetectorBinding::DetectedQuads()
+    using Quad = std::array<Point, 4>;
+
+    //
+    // Projective transform mapping (x, y) to ((m[0] * x + m[1] * y + m[2]) / w, (m[3] * x + m[4] * y + m[5]) / w)
+    // with w = m[6] * x + m[7] * y + m[8]
+    //
+    struct Homography
+    {
+        double m[9] = { 1.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0, 0.0, 1.0 };
+
+        static Homography Translate(double offsetX, double offsetY);
+
+        // Map the rectangle (0, 0, width, height) onto the quad, its top-left corner to the first corner and so on clockwise
+        static Homography RectangleToQuad(double width, double height, Quad const& quad);
+
+        // Transform applying this one, then next
+        Homography Then(Homography const& next) const;
+
+        // Throws if the transform is not invertible
+        Homography Inverse() const;
+
+        Point Apply(Point const& point) const;
+    };
+
+    //
+    // View over BGRA8 pixels, with the same layout as SoftwareBitmapHelper::PixelView
+    //
+    struct Image
+    {
+        uint8_t* data = nullptr;
+        int32_t stride = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        uint8_t* Row(uint32_t y) const { return data + (size_t)y * stride; }
+    };
+
+    enum class QuadIssue
+    {
+        None,
+        NotConvex, // the corners cross or bend inwards, the quad does not enclose a plane seen in perspective
+        TooSmall, // covers less than minAreaFraction of the image
+        TooElongated // rectifies to a rectangle more elongated than maxAspectRatio
+    };
+
+    struct QuadCheckOptions
+    {
+        float minAreaFraction = 0.02f; // smallest fraction of the image a quad worth rectifying covers
+        float maxAspectRatio = 12.0f; // longer over shorter side of the rectified rectangle, receipts are long but not that long
+    };
+
+    struct QuadCheck
+    {
+        QuadIssue issue = QuadIssue::None;
+        float areaFraction = 0.0f; // area of the quad over the area of the image
+        float aspectRatio = 0.0f; // longer over shorter side of the rectified rectangle
+        float rectifiedWidth = 0.0f; // see RectifiedSize()
+        float rectifiedHeight = 0.0f;
+
+        bool IsValid() const { return issue == QuadIssue::None; }
+    };
+
+    enum class Interpolation
+    {
+        Bilinear, // 2 x 2 source pixels per output pixel, 8 bit fixed point weights
+        Bicubic // 4 x 4 source pixels per output pixel, Catmull-Rom weights
+    };
+
+    struct WarpOptions
+    {
+        Interpolation interpolation = Interpolation::Bilinear;
+        uint32_t tileSize = 64; // side of the square tiles of output pixels, small enough for the source pixels they read to stay in cache
+        WorkStealingThreadPool* threadPool = nullptr; // pool the tiles are spread over, nullptr computes them all on the calling thread
+        bool useSimd = true; // only effective when PERSPECTIVE_WARP_USE_SSE2 is defined
+    };
+
+    // Size of the rectangle a quad rectifies to, the average length of its opposite sides
+    static void RectifiedSize(Quad const& quad, float& width, float& height);
+
+    static QuadCheck CheckQuad(Quad const& quad, uint32_t imageWidth, uint32_t imageHeight, QuadCheckOptions const& options);
+    static const char* ToString(QuadIssue issue);
+
+    //
+    // Fill each output pixel with the source pixel its center maps to through outputToSource, both in pixels.
+    // Source pixels past the edges of the source image repeat its edge pixels.
+    //
+    static void Warp(Image const& source, Homography const& outputToSource, Image const& output, WarpOptions const& options);
+
+    // Warp the quad of the source image onto the whole output image
+    static void Rectify(Image const& source, Quad const& quad, Image const& output, WarpOptions const& options);
+
+private:
+    static void WarpTile(Image const& source, float const* transform, Image const& output, uint32_t left, uint32_t top, uint32_t right, uint32_t bottom, WarpOptions const& options);
+};
@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <Windows.h>
+#include <Psapi.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace ProcessMemoryHelper
+{
+    //
+    // Helper method to retrieve the amount of private memory committed by the current process, in bytes
+    //
+    static uint64_t GetPrivateBytes()
+    {
+        PROCESS_MEMORY_COUNTERS_EX counters = {};
+        if (!K32GetProcessMemoryInfo(GetCurrentProcess(), (PROCESS_MEMORY_COUNTERS*)&counters, sizeof(counters)))
+        {
+            return 0;
+        }
+        return counters.PrivateUsage;
+    }
+
+    //
+    // Helper method to retrieve the working set of the current process, in bytes
+    //
+    static uint64_t GetWorkingSetBytes()
+    {
+        PROCESS_MEMORY_COUNTERS counters = {};
+        if (!K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        {
+            return 0;
+        }
+        return counters.WorkingSetSize;
+    }
+
+    //
+    // Helper class that samples the private bytes of the current process on a background thread
+    // to report the peak reached between its construction and a call to Stop()
+    //
+    class PeakMemorySampler
+    {
+    public:
+        PeakMemorySampler(std::chrono::milliseconds samplingPeriod = std::chrono::milliseconds(5))
+        {
+            m_baseline = GetPrivateBytes();
+            m_peak = m_baseline;
+            m_thread = std::thread([this, samplingPeriod]()
+            {
+                while (!m_stop)
+                {
+                    Sample();
+                    std::this_thread::sleep_for(samplingPeriod);
+                }
+            });
+        }
+
+        ~PeakMemorySampler()
+        {
+            Stop();
+        }
+
+        // Stop sampling and return the peak private bytes committed above the baseline
+        uint64_t Stop()
+        {
+            if (m_thread.joinable())
+            {
+                m_stop = true;
+                m_thread.join();
+                Sample();
+            }
+            return m_peak - std::min<uint64_t>(m_baseline, m_peak);
+        }
+
+    private:
+        void Sample()
+        {
+            uint64_t current = GetPrivateBytes();
+            uint64_t peak = m_peak;
+            while (current > peak && !m_peak.compare_exchange_weak(peak, current));
+        }
+
+        uint64_t m_baseline = 0;
+        std::atomic<uint64_t> m_peak = 0;
+        std::atomic<bool> m_stop = false;
+        std::thread m_thread;
+    };
+};
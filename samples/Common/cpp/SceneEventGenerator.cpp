@@ -0,0 +1,304 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "SceneEventGenerator.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+//
+// Largest displacement of a corner between two quads
+//
+static float MaxCornerDistance(SceneEventGenerator::Quad const& quad1, SceneEventGenerator::Quad const& quad2)
+{
+    float maxDistance = 0.0f;
+    for (size_t i = 0; i < quad1.size(); i++)
+    {
+        maxDistance = std::max<float>(maxDistance, std::hypot(quad1[i].x - quad2[i].x, quad1[i].y - quad2[i].y));
+    }
+    return maxDistance;
+}
+
+static BoxGeometry::Box BoundingBox(SceneEventGenerator::Quad const& quad)
+{
+    float left = quad[0].x;
+    float top = quad[0].y;
+    float right = quad[0].x;
+    float bottom = quad[0].y;
+    for (auto&& corner : quad)
+    {
+        left = std::min<float>(left, corner.x);
+        top = std::min<float>(top, corner.y);
+        right = std::max<float>(right, corner.x);
+        bottom = std::max<float>(bottom, corner.y);
+    }
+    return { left, top, right - left, bottom - top };
+}
+
+SceneEventGenerator::SceneEventGenerator(Options const& options)
+    : m_options(options)
+{
+    if (options.enterFrameCount == 0 || options.exitFrameCount == 0 || options.changeFrameCount == 0)
+    {
+        throw std::invalid_argument("Error: the enter, exit and change frame counts must be at least 1");
+    }
+}
+
+SceneEventGenerator::CameraState& SceneEventGenerator::GetCamera(uint32_t cameraId)
+{
+    for (auto&& camera : m_cameras)
+    {
+        if (camera.cameraId == cameraId)
+        {
+            return camera;
+        }
+    }
+    m_cameras.emplace_back();
+    m_cameras.back().cameraId = cameraId;
+    return m_cameras.back();
+}
+
+void SceneEventGenerator::AppendEvent(Event const& event, std::vector<Event>& events)
+{
+    m_statistics.eventCount++;
+    events.push_back(event);
+}
+
+void SceneEventGenerator::UpdateObjects(uint32_t cameraId, uint64_t frameId, std::vector<Detection> const& detections, std::vector<Event>& events)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_statistics.frameCount++;
+    CameraState& camera = GetCamera(cameraId);
+    auto& objects = camera.objects;
+
+    // Pair each tracked object with the detection of the same kind it overlaps most, best overlaps first
+    struct Match
+    {
+        float iou;
+        uint32_t objectIndex;
+        uint32_t detectionIndex;
+    };
+    std::vector<Match> matches;
+    for (uint32_t objectIndex = 0; objectIndex < objects.size(); objectIndex++)
+    {
+        for (uint32_t detectionIndex = 0; detectionIndex < detections.size(); detectionIndex++)
+        {
+            if (detections[detectionIndex].label != objects[objectIndex].label)
+            {
+                continue;
+            }
+            float iou = BoxGeometry::IoU(objects[objectIndex].box, detections[detectionIndex].box);
+            if (iou >= m_options.matchIoU)
+            {
+                matches.push_back({ iou, objectIndex, detectionIndex });
+            }
+        }
+    }
+    std::sort(matches.begin(), matches.end(), [](Match const& a, Match const& b)
+    {
+        if (a.iou != b.iou)
+        {
+            return a.iou > b.iou;
+        }
+        return a.objectIndex != b.objectIndex ? a.objectIndex < b.objectIndex : a.detectionIndex < b.detectionIndex;
+    });
+    std::vector<int32_t> objectDetections(objects.size(), -1);
+    std::vector<bool> isDetectionMatched(detections.size(), false);
+    for (auto&& match : matches)
+    {
+        if (objectDetections[match.objectIndex] < 0 && !isDetectionMatched[match.detectionIndex])
+        {
+            objectDetections[match.objectIndex] = (int32_t)match.detectionIndex;
+            isDetectionMatched[match.detectionIndex] = true;
+        }
+    }
+
+    auto objectEvent = [&](EventType type, TrackedObject const& object)
+    {
+        Event event;
+        event.type = type;
+        event.subject = Subject::Object;
+        event.cameraId = cameraId;
+        event.frameId = frameId;
+        event.objectId = object.id;
+        event.label = object.label;
+        event.box = object.box;
+        AppendEvent(event, events);
+    };
+    auto confirmIfSeenEnough = [&](TrackedObject& object)
+    {
+        if (object.seenFrameCount >= m_options.enterFrameCount)
+        {
+            object.isReported = true;
+            object.reportedBox = object.box;
+            object.changedFrameCount = 0;
+            objectEvent(EventType::Enter, object);
+        }
+    };
+
+    // Update the tracked objects, dropping the ones that exited or that flickered before being reported
+    size_t keptCount = 0;
+    for (size_t objectIndex = 0; objectIndex < objects.size(); objectIndex++)
+    {
+        TrackedObject object = objects[objectIndex];
+        if (objectDetections[objectIndex] >= 0)
+        {
+            object.box = detections[objectDetections[objectIndex]].box;
+            object.seenFrameCount = Increment(object.seenFrameCount);
+            object.missedFrameCount = 0;
+            if (!object.isReported)
+            {
+                confirmIfSeenEnough(object);
+            }
+            else if (BoxGeometry::IoU(object.box, object.reportedBox) < m_options.changeIoU)
+            {
+                object.changedFrameCount = Increment(object.changedFrameCount);
+                if (object.changedFrameCount >= m_options.changeFrameCount)
+                {
+                    object.reportedBox = object.box;
+                    object.changedFrameCount = 0;
+                    objectEvent(EventType::Change, object);
+                }
+            }
+            else
+            {
+                object.changedFrameCount = 0;
+            }
+        }
+        else
+        {
+            object.seenFrameCount = 0;
+            object.changedFrameCount = 0;
+            object.missedFrameCount = Increment(object.missedFrameCount);
+            if (!object.isReported)
+            {
+                continue;
+            }
+            if (object.missedFrameCount >= m_options.exitFrameCount)
+            {
+                objectEvent(EventType::Exit, object);
+                continue;
+            }
+        }
+        objects[keptCount++] = object;
+    }
+    objects.resize(keptCount);
+
+    // Track the detections matching no object as candidates
+    for (uint32_t detectionIndex = 0; detectionIndex < detections.size(); detectionIndex++)
+    {
+        if (isDetectionMatched[detectionIndex])
+        {
+            continue;
+        }
+        auto& detection = detections[detectionIndex];
+        TrackedObject object = { detection.box, detection.box, camera.nextObjectId++, detection.label, 1, 0, 0, false };
+        confirmIfSeenEnough(object);
+        objects.push_back(object);
+    }
+}
+
+void SceneEventGenerator::UpdateBodyCount(uint32_t cameraId, uint64_t frameId, uint32_t bodyCount, std::vector<Event>& events)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_statistics.frameCount++;
+    BodyCountState& bodies = GetCamera(cameraId).bodies;
+    if (bodyCount == bodies.reportedCount)
+    {
+        bodies.candidateFrameCount = 0;
+        return;
+    }
+
+    // The new count must hold for changeFrameCount frames in a row
+    if (bodyCount != bodies.candidateCount || bodies.candidateFrameCount == 0)
+    {
+        bodies.candidateCount = bodyCount;
+        bodies.candidateFrameCount = 0;
+    }
+    bodies.candidateFrameCount = Increment(bodies.candidateFrameCount);
+    if (bodies.candidateFrameCount >= m_options.changeFrameCount)
+    {
+        Event event;
+        event.type = EventType::Change;
+        event.subject = Subject::BodyCount;
+        event.cameraId = cameraId;
+        event.frameId = frameId;
+        event.count = bodyCount;
+        event.previousCount = bodies.reportedCount;
+        AppendEvent(event, events);
+        bodies.reportedCount = bodyCount;
+        bodies.candidateFrameCount = 0;
+    }
+}
+
+void SceneEventGenerator::UpdateQuad(uint32_t cameraId, uint64_t frameId, Quad const* quad, std::vector<Event>& events)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_statistics.frameCount++;
+    QuadState& state = GetCamera(cameraId).quad;
+
+    auto quadEvent = [&](EventType type)
+    {
+        Event event;
+        event.type = type;
+        event.subject = Subject::Quad;
+        event.cameraId = cameraId;
+        event.frameId = frameId;
+        event.box = BoundingBox(state.quad);
+        event.quad = state.quad;
+        AppendEvent(event, events);
+    };
+
+    if (quad == nullptr)
+    {
+        state.seenFrameCount = 0;
+        state.changedFrameCount = 0;
+        state.missedFrameCount = Increment(state.missedFrameCount);
+        if (state.isReported && state.missedFrameCount >= m_options.exitFrameCount)
+        {
+            state.isReported = false;
+            quadEvent(EventType::Exit);
+        }
+        return;
+    }
+
+    state.quad = *quad;
+    state.seenFrameCount = Increment(state.seenFrameCount);
+    state.missedFrameCount = 0;
+    if (!state.isReported)
+    {
+        if (state.seenFrameCount >= m_options.enterFrameCount)
+        {
+            state.isReported = true;
+            state.reportedQuad = state.quad;
+            state.changedFrameCount = 0;
+            quadEvent(EventType::Enter);
+        }
+    }
+    else if (MaxCornerDistance(state.quad, state.reportedQuad) > m_options.quadChangeDistance)
+    {
+        state.changedFrameCount = Increment(state.changedFrameCount);
+        if (state.changedFrameCount >= m_options.changeFrameCount)
+        {
+            state.reportedQuad = state.quad;
+            state.changedFrameCount = 0;
+            quadEvent(EventType::Change);
+        }
+    }
+    else
+    {
+        state.changedFrameCount = 0;
+    }
+}
+
+void SceneEventGenerator::RemoveCamera(uint32_t cameraId)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_cameras.erase(
+        std::remove_if(m_cameras.begin(), m_cameras.end(), [&](CameraState const& camera) { return camera.cameraId == cameraId; }),
+        m_cameras.end());
+}
+
+SceneEventGenerator::Statistics SceneEventGenerator::GetStatistics() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_statistics;
+}
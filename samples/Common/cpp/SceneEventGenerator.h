@@ -0,0 +1,170 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "BoxGeometry.h"
+
+//
+// Helper class turning the per-frame results of skills into events, so that what consumes them scales with the activity
+// of the scene rather than with the frame rate. Consecutive results of each camera are compared to what was last reported:
+// - objects are matched to the tracked objects of the same kind by overlap, and reported when they enter the scene,
+//   when their box moved away from the last reported one, and when they exit the scene
+// - the amount of bodies is reported when it changes
+// - a quad is reported when it appears, when its corners moved, and when it disappears
+// Every event is debounced: what appears must be seen for enterFrameCount consecutive frames, what disappears must be
+// missing for exitFrameCount consecutive frames and a change must last changeFrameCount consecutive frames, so that
+// detections flickering for a frame or two generate no events.
+//
+// The state of each camera is kept in a small store of records, looked up by camera id. Calls are thread-safe,
+// but the results of a camera must be passed in the order of its frames.
+//
+class SceneEventGenerator
+{
+public:
+    enum class EventType : uint8_t
+    {
+        Enter,
+        Exit,
+        Change
+    };
+
+    enum class Subject : uint8_t
+    {
+        Object,
+        BodyCount,
+        Quad
+    };
+
+    // Corners in normalized coordinates, clockwise from the top-left one like QuadDetectorBinding::DetectedQuads()
+    using Quad = std::array<BoxGeometry::Point, 4>;
+
+    struct Event
+    {
+        EventType type = EventType::Enter;
+        Subject subject = Subject::Object;
+        uint32_t cameraId = 0;
+        uint64_t frameId = 0; // frame the event was confirmed on
+        uint32_t objectId = 0; // Object: stable from the Enter to the Exit event of the object
+        int32_t label = 0; // Object: kind of the object
+        BoxGeometry::Box box = {}; // Object: box, Quad: bounding box of the corners, both as last seen
+        uint32_t count = 0; // BodyCount: amount of bodies
+        uint32_t previousCount = 0; // BodyCount: amount of bodies last reported
+        Quad quad = {}; // Quad: corners as last seen
+    };
+
+    struct Detection
+    {
+        int32_t label;
+        BoxGeometry::Box box;
+    };
+
+    struct Options
+    {
+        uint32_t enterFrameCount = 3; // consecutive frames something must be seen before its Enter event
+        uint32_t exitFrameCount = 5; // consecutive frames something must be missing before its Exit event
+        uint32_t changeFrameCount = 3; // consecutive frames a change must last before its Change event
+        float matchIoU = 0.3f; // overlap above which a detection is the tracked object of the same kind it overlaps most
+        float changeIoU = 0.5f; // overlap with the last reported box below which the box of an object changed
+        float quadChangeDistance = 0.02f; // corner displacement from the last reported quad above which the quad changed, normalized
+    };
+
+    struct Statistics
+    {
+        uint64_t frameCount = 0; // results passed, over all cameras and subjects
+        uint64_t eventCount = 0;
+    };
+
+    explicit SceneEventGenerator(Options const& options);
+
+    // Append the events the detected objects of a frame generate to events
+    void UpdateObjects(uint32_t cameraId, uint64_t frameId, std::vector<Detection> const& detections, std::vector<Event>& events);
+
+    // Append the event the amount of bodies detected in a frame generates to events
+    void UpdateBodyCount(uint32_t cameraId, uint64_t frameId, uint32_t bodyCount, std::vector<Event>& events);
+
+    // Append the event the quad detected in a frame generates to events, quad is nullptr when none was detected
+    void UpdateQuad(uint32_t cameraId, uint64_t frameId, Quad const* quad, std::vector<Event>& events);
+
+    // Forget the state of a camera, i.e. once it was removed, without generating Exit events
+    void RemoveCamera(uint32_t cameraId);
+
+    Statistics GetStatistics() const;
+
+    static const char* ToString(EventType type)
+    {
+        switch (type)
+        {
+        case EventType::Enter: return "enter";
+        case EventType::Exit: return "exit";
+        case EventType::Change: return "change";
+        }
+        return "unknown";
+    }
+
+    static const char* ToString(Subject subject)
+    {
+        switch (subject)
+        {
+        case Subject::Object: return "object";
+        case Subject::BodyCount: return "bodies";
+        case Subject::Quad: return "quad";
+        }
+        return "unknown";
+    }
+
+private:
+    // Debounce counters saturate, only their comparison with the frame counts of the options matters
+    static const uint16_t MaxFrameCount = UINT16_MAX;
+
+    struct TrackedObject
+    {
+        BoxGeometry::Box box; // as last seen
+        BoxGeometry::Box reportedBox; // of the last Enter or Change event
+        uint32_t id;
+        int32_t label;
+        uint16_t seenFrameCount; // consecutive frames matched
+        uint16_t missedFrameCount; // consecutive frames not matched
+        uint16_t changedFrameCount; // consecutive frames away from the reported box
+        bool isReported; // its Enter event was generated
+    };
+
+    struct BodyCountState
+    {
+        uint32_t reportedCount = 0;
+        uint32_t candidateCount = 0; // differs from the reported count since candidateFrameCount frames
+        uint16_t candidateFrameCount = 0;
+    };
+
+    struct QuadState
+    {
+        Quad quad = {}; // as last seen
+        Quad reportedQuad = {};
+        uint16_t seenFrameCount = 0;
+        uint16_t missedFrameCount = 0;
+        uint16_t changedFrameCount = 0;
+        bool isReported = false;
+    };
+
+    struct CameraState
+    {
+        uint32_t cameraId = 0;
+        uint32_t nextObjectId = 1;
+        std::vector<TrackedObject> objects;
+        BodyCountState bodies;
+        QuadState quad;
+    };
+
+    CameraState& GetCamera(uint32_t cameraId);
+    void AppendEvent(Event const& event, std::vector<Event>& events);
+
+    static uint16_t Increment(uint16_t frameCount) { return frameCount < MaxFrameCount ? (uint16_t)(frameCount + 1) : frameCount; }
+
+    Options m_options;
+    mutable std::mutex m_lock;
+    std::vector<CameraState> m_cameras; // a handful at most, looked up linearly
+    Statistics m_statistics;
+};
@@ -0,0 +1,597 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "SharedFrameChannel.h"
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Atomics in the shared region are used by several processes, which only works if they do not rely on a lock
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free, "SharedFrameChannel requires lock-free atomics");
+
+static const char RegionMagic[4] = { 'S', 'K', 'H', 'S' };
+static const uint32_t RegionVersion = 1;
+static const size_t CacheLineSize = 64;
+
+static size_t AlignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+struct SharedFrameChannel::RegionHeader
+{
+    char magic[4]; // set last by the host once the region and the semaphores are ready
+    uint32_t version;
+    uint32_t slotCount;
+    uint32_t maxResultCount;
+    uint64_t slotPixelCapacity;
+    uint64_t slotSize;
+    std::atomic<uint32_t> isHostRunning;
+    std::atomic<uint64_t> nextSequence; // submission order
+};
+
+struct SharedFrameChannel::SlotHeader
+{
+    std::atomic<uint32_t> state; // SlotState
+    int32_t status; // Status
+    uint32_t resultCount;
+    uint64_t sequence;
+    FrameDescription frame;
+};
+
+//
+// Layout of a slot: its header, its results then its pixels, each part starting on a cache line
+//
+static const size_t RegionHeaderSize = CacheLineSize;
+
+static size_t ResultsOffset()
+{
+    return CacheLineSize;
+}
+
+static size_t PixelsOffset(uint32_t maxResultCount)
+{
+    return AlignUp(ResultsOffset() + maxResultCount * sizeof(SharedFrameChannel::Result), CacheLineSize);
+}
+
+//
+// Named objects of a channel, in the session namespace on Windows
+//
+static std::string ObjectName(std::string const& name, const char* suffix)
+{
+#ifdef _WIN32
+    return "Local\\SkillHost." + name + suffix;
+#else
+    return "/SkillHost." + name + suffix;
+#endif
+}
+
+SharedFrameChannel::NamedSemaphore::~NamedSemaphore()
+{
+#ifdef _WIN32
+    if (m_handle != nullptr)
+    {
+        CloseHandle(m_handle);
+    }
+#else
+    if (m_semaphore != nullptr)
+    {
+        sem_close(m_semaphore);
+        if (m_isOwner)
+        {
+            sem_unlink(m_name.c_str());
+        }
+    }
+#endif
+}
+
+void SharedFrameChannel::NamedSemaphore::Create(std::string const& name, uint32_t initialCount, uint32_t maxCount)
+{
+#ifdef _WIN32
+    m_handle = CreateSemaphoreA(nullptr, (LONG)initialCount, (LONG)maxCount, name.c_str());
+    if (m_handle == nullptr || GetLastError() == ERROR_ALREADY_EXISTS)
+    {
+        throw std::runtime_error("Error: could not create the semaphore " + name);
+    }
+#else
+    (void)maxCount;
+    m_semaphore = sem_open(name.c_str(), O_CREAT | O_EXCL, 0600, initialCount);
+    if (m_semaphore == SEM_FAILED)
+    {
+        m_semaphore = nullptr;
+        throw std::runtime_error("Error: could not create the semaphore " + name);
+    }
+    m_name = name;
+    m_isOwner = true;
+#endif
+}
+
+void SharedFrameChannel::NamedSemaphore::Open(std::string const& name)
+{
+#ifdef _WIN32
+    m_handle = OpenSemaphoreA(SEMAPHORE_ALL_ACCESS, FALSE, name.c_str());
+    if (m_handle == nullptr)
+    {
+        throw std::runtime_error("Error: could not open the semaphore " + name);
+    }
+#else
+    m_semaphore = sem_open(name.c_str(), 0);
+    if (m_semaphore == SEM_FAILED)
+    {
+        m_semaphore = nullptr;
+        throw std::runtime_error("Error: could not open the semaphore " + name);
+    }
+    m_name = name;
+#endif
+}
+
+void SharedFrameChannel::NamedSemaphore::Post(uint32_t count)
+{
+#ifdef _WIN32
+    ReleaseSemaphore(m_handle, (LONG)count, nullptr);
+#else
+    for (uint32_t i = 0; i < count; i++)
+    {
+        sem_post(m_semaphore);
+    }
+#endif
+}
+
+bool SharedFrameChannel::NamedSemaphore::Wait(std::chrono::microseconds timeout)
+{
+#ifdef _WIN32
+    DWORD timeoutMs = (DWORD)std::max<int64_t>((timeout.count() + 999) / 1000, 0);
+    return WaitForSingleObject(m_handle, timeoutMs) == WAIT_OBJECT_0;
+#else
+    if (timeout.count() <= 0)
+    {
+        return sem_trywait(m_semaphore) == 0;
+    }
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    int64_t nanoseconds = deadline.tv_nsec + timeout.count() * 1000;
+    deadline.tv_sec += (time_t)(nanoseconds / 1000000000);
+    deadline.tv_nsec = (long)(nanoseconds % 1000000000);
+    while (sem_timedwait(m_semaphore, &deadline) != 0)
+    {
+        if (errno != EINTR)
+        {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+SharedFrameChannel::SharedFrameChannel(std::string const& name, Options const& options)
+    : m_name(name),
+    m_isHost(true),
+    m_slotCount(options.slotCount),
+    m_maxResultCount(options.maxResultCount),
+    m_slotPixelCapacity((size_t)options.maxWidth * options.maxHeight * options.bytesPerPixel)
+{
+    static_assert(sizeof(RegionHeader) <= RegionHeaderSize, "RegionHeader must fit in its cache line");
+    static_assert(sizeof(SlotHeader) <= CacheLineSize, "SlotHeader must fit in its cache line");
+    if (m_slotCount == 0 || m_slotPixelCapacity == 0)
+    {
+        throw std::invalid_argument("Error: a shared frame channel needs at least one slot and a non-empty frame size");
+    }
+    m_slotSize = AlignUp(PixelsOffset(m_maxResultCount) + m_slotPixelCapacity, CacheLineSize);
+    m_regionSize = RegionHeaderSize + m_slotSize * m_slotCount;
+    MapRegion(m_regionSize, true);
+
+    auto header = new (m_region) RegionHeader();
+    header->version = RegionVersion;
+    header->slotCount = m_slotCount;
+    header->maxResultCount = m_maxResultCount;
+    header->slotPixelCapacity = m_slotPixelCapacity;
+    header->slotSize = m_slotSize;
+    header->isHostRunning.store(1, std::memory_order_relaxed);
+    header->nextSequence.store(0, std::memory_order_relaxed);
+    for (uint32_t slot = 0; slot < m_slotCount; slot++)
+    {
+        auto slotHeader = new (m_region + RegionHeaderSize + m_slotSize * slot) SlotHeader();
+        slotHeader->state.store((uint32_t)SlotState::Free, std::memory_order_relaxed);
+    }
+
+    // The destructor does not run when the constructor throws, i.e. on semaphores left by a host that crashed.
+    // Release the region so that the next start does not find it and report a host already running.
+    try
+    {
+        CreateSemaphores(true);
+    }
+    catch (...)
+    {
+        UnmapRegion();
+        throw;
+    }
+
+    // Clients may map the region as soon as it exists, they only use it once the magic tells it is ready
+    std::atomic_thread_fence(std::memory_order_release);
+    memcpy(header->magic, RegionMagic, sizeof(RegionMagic));
+}
+
+SharedFrameChannel::SharedFrameChannel(std::string const& name)
+    : m_name(name),
+    m_isHost(false)
+{
+    MapRegion(0, false);
+    try
+    {
+        auto header = reinterpret_cast<RegionHeader*>(m_region);
+        if (m_regionSize < RegionHeaderSize || memcmp(header->magic, RegionMagic, sizeof(RegionMagic)) != 0)
+        {
+            throw std::runtime_error("Error: the skill host " + name + " is not ready");
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (header->version != RegionVersion)
+        {
+            throw std::runtime_error("Error: the skill host " + name + " uses another version of the shared frame channel");
+        }
+        m_slotCount = header->slotCount;
+        m_maxResultCount = header->maxResultCount;
+        m_slotPixelCapacity = (size_t)header->slotPixelCapacity;
+        m_slotSize = (size_t)header->slotSize;
+        if (RegionHeaderSize + m_slotSize * m_slotCount > m_regionSize)
+        {
+            throw std::runtime_error("Error: the shared region of the skill host " + name + " is truncated");
+        }
+        CreateSemaphores(false);
+        if (!IsHostRunning())
+        {
+            throw std::runtime_error("Error: the skill host " + name + " stopped");
+        }
+    }
+    catch (...)
+    {
+        UnmapRegion();
+        throw;
+    }
+}
+
+SharedFrameChannel::~SharedFrameChannel()
+{
+    if (m_isHost && m_region != nullptr && IsHostRunning())
+    {
+        Stop();
+    }
+    UnmapRegion();
+}
+
+//
+// Create or open the named shared memory region, clients map all of it
+//
+void SharedFrameChannel::MapRegion(size_t size, bool create)
+{
+    std::string regionName = ObjectName(m_name, "");
+#ifdef _WIN32
+    if (create)
+    {
+        m_mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)size, regionName.c_str());
+        if (m_mapping != nullptr && GetLastError() == ERROR_ALREADY_EXISTS)
+        {
+            CloseHandle(m_mapping);
+            m_mapping = nullptr;
+            throw std::runtime_error("Error: a skill host named " + m_name + " is already running");
+        }
+    }
+    else
+    {
+        m_mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, regionName.c_str());
+    }
+    if (m_mapping == nullptr)
+    {
+        throw std::runtime_error(create ? "Error: could not create the shared region " + regionName : "Error: no skill host named " + m_name + " is running");
+    }
+    m_region = (uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (m_region == nullptr)
+    {
+        throw std::runtime_error("Error: could not map the shared region " + regionName);
+    }
+    MEMORY_BASIC_INFORMATION information = {};
+    VirtualQuery(m_region, &information, sizeof(information));
+    m_regionSize = create ? size : (size_t)information.RegionSize;
+#else
+    int file = create ? shm_open(regionName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600) : shm_open(regionName.c_str(), O_RDWR, 0);
+    if (file < 0)
+    {
+        if (create && errno == EEXIST)
+        {
+            throw std::runtime_error("Error: a skill host named " + m_name + " is already running, or did not exit cleanly and left " + regionName);
+        }
+        throw std::runtime_error(create ? "Error: could not create the shared region " + regionName : "Error: no skill host named " + m_name + " is running");
+    }
+    if (create && ftruncate(file, (off_t)size) != 0)
+    {
+        close(file);
+        shm_unlink(regionName.c_str());
+        throw std::runtime_error("Error: could not size the shared region " + regionName);
+    }
+    if (!create)
+    {
+        struct stat status = {};
+        fstat(file, &status);
+        size = (size_t)status.st_size;
+    }
+    void* region = size > 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0) : MAP_FAILED;
+    close(file);
+    if (region == MAP_FAILED)
+    {
+        if (create)
+        {
+            shm_unlink(regionName.c_str());
+        }
+        throw std::runtime_error("Error: could not map the shared region " + regionName);
+    }
+    m_region = (uint8_t*)region;
+    m_regionSize = size;
+#endif
+}
+
+//
+// Unmap the region, the host also removes its name so that a new host can start
+//
+void SharedFrameChannel::UnmapRegion()
+{
+#ifdef _WIN32
+    if (m_region != nullptr)
+    {
+        UnmapViewOfFile(m_region);
+    }
+    if (m_mapping != nullptr)
+    {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+#else
+    if (m_region != nullptr)
+    {
+        munmap(m_region, m_regionSize);
+    }
+    if (m_isHost)
+    {
+        shm_unlink(ObjectName(m_name, "").c_str());
+    }
+#endif
+    m_region = nullptr;
+}
+
+void SharedFrameChannel::CreateSemaphores(bool create)
+{
+    if (create)
+    {
+        m_freeSlots.Create(ObjectName(m_name, ".free"), m_slotCount, m_slotCount * 2);
+        m_submittedSlots.Create(ObjectName(m_name, ".submitted"), 0, m_slotCount * 2);
+    }
+    else
+    {
+        m_freeSlots.Open(ObjectName(m_name, ".free"));
+        m_submittedSlots.Open(ObjectName(m_name, ".submitted"));
+    }
+    for (uint32_t slot = 0; slot < m_slotCount; slot++)
+    {
+        m_completedSlots.push_back(std::make_unique<NamedSemaphore>());
+        std::string name = ObjectName(m_name, (".completed." + std::to_string(slot)).c_str());
+        if (create)
+        {
+            m_completedSlots.back()->Create(name, 0, 2);
+        }
+        else
+        {
+            m_completedSlots.back()->Open(name);
+        }
+    }
+}
+
+SharedFrameChannel::SlotHeader& SharedFrameChannel::Slot(uint32_t slot) const
+{
+    return *reinterpret_cast<SlotHeader*>(m_region + RegionHeaderSize + m_slotSize * slot);
+}
+
+void SharedFrameChannel::CheckSlot(uint32_t slot) const
+{
+    if (slot >= m_slotCount)
+    {
+        throw std::out_of_range("Error: invalid shared frame slot " + std::to_string(slot));
+    }
+}
+
+bool SharedFrameChannel::IsHostRunning() const
+{
+    return reinterpret_cast<RegionHeader*>(m_region)->isHostRunning.load(std::memory_order_acquire) != 0;
+}
+
+int32_t SharedFrameChannel::AcquireSlot(std::chrono::milliseconds timeout)
+{
+    if (!IsHostRunning() || !m_freeSlots.Wait(timeout))
+    {
+        return -1;
+    }
+
+    // A stopped host wakes up all waiting clients, pass the wake up on to the next one
+    if (!IsHostRunning())
+    {
+        m_freeSlots.Post();
+        return -1;
+    }
+    for (uint32_t slot = 0; slot < m_slotCount; slot++)
+    {
+        uint32_t expected = (uint32_t)SlotState::Free;
+        if (Slot(slot).state.compare_exchange_strong(expected, (uint32_t)SlotState::Acquired, std::memory_order_acquire))
+        {
+            return (int32_t)slot;
+        }
+    }
+
+    // The semaphore counts free slots, so one of them is about to be marked free
+    m_freeSlots.Post();
+    return -1;
+}
+
+uint8_t* SharedFrameChannel::SlotPixels(uint32_t slot)
+{
+    CheckSlot(slot);
+    return m_region + RegionHeaderSize + m_slotSize * slot + PixelsOffset(m_maxResultCount);
+}
+
+void SharedFrameChannel::Submit(uint32_t slot, FrameDescription const& frame)
+{
+    CheckSlot(slot);
+    auto& slotHeader = Slot(slot);
+    if (slotHeader.state.load(std::memory_order_relaxed) != (uint32_t)SlotState::Acquired)
+    {
+        throw std::logic_error("Error: submitting shared frame slot " + std::to_string(slot) + " which was not acquired");
+    }
+    slotHeader.frame = frame;
+    slotHeader.status = (int32_t)Status::Success;
+    slotHeader.resultCount = 0;
+    slotHeader.sequence = reinterpret_cast<RegionHeader*>(m_region)->nextSequence.fetch_add(1, std::memory_order_relaxed);
+    slotHeader.state.store((uint32_t)SlotState::Submitted, std::memory_order_release);
+    m_submittedSlots.Post();
+}
+
+bool SharedFrameChannel::WaitCompleted(uint32_t slot, std::chrono::milliseconds timeout)
+{
+    CheckSlot(slot);
+    auto& slotHeader = Slot(slot);
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (slotHeader.state.load(std::memory_order_acquire) != (uint32_t)SlotState::Completed)
+    {
+        // Wake up regularly to notice a host that stopped without completing the slot
+        auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0 || !IsHostRunning())
+        {
+            return false;
+        }
+        m_completedSlots[slot]->Wait(std::min<std::chrono::microseconds>(remaining, std::chrono::milliseconds(100)));
+    }
+    return true;
+}
+
+SharedFrameChannel::Status SharedFrameChannel::SlotStatus(uint32_t slot) const
+{
+    CheckSlot(slot);
+    return (Status)Slot(slot).status;
+}
+
+uint32_t SharedFrameChannel::ResultCount(uint32_t slot) const
+{
+    CheckSlot(slot);
+    return std::min<uint32_t>(Slot(slot).resultCount, m_maxResultCount);
+}
+
+const SharedFrameChannel::Result* SharedFrameChannel::Results(uint32_t slot) const
+{
+    CheckSlot(slot);
+    return reinterpret_cast<const Result*>(m_region + RegionHeaderSize + m_slotSize * slot + ResultsOffset());
+}
+
+void SharedFrameChannel::ReleaseSlot(uint32_t slot)
+{
+    CheckSlot(slot);
+    auto& slotHeader = Slot(slot);
+    uint32_t expected = (uint32_t)SlotState::Completed;
+    if (!slotHeader.state.compare_exchange_strong(expected, (uint32_t)SlotState::Free, std::memory_order_release))
+    {
+        expected = (uint32_t)SlotState::Acquired;
+        if (!slotHeader.state.compare_exchange_strong(expected, (uint32_t)SlotState::Free, std::memory_order_release))
+        {
+            throw std::logic_error("Error: releasing shared frame slot " + std::to_string(slot) + " while the host is evaluating it");
+        }
+    }
+    m_freeSlots.Post();
+}
+
+std::vector<uint32_t> SharedFrameChannel::WaitSubmitted(uint32_t maxBatchSize, std::chrono::microseconds batchWindow, std::chrono::milliseconds timeout)
+{
+    std::vector<uint32_t> slots;
+    if (!m_submittedSlots.Wait(timeout))
+    {
+        return slots;
+    }
+
+    // Gather the slots submitted within the batch window, then the ones already waiting
+    uint32_t submittedCount = 1;
+    maxBatchSize = std::max<uint32_t>(maxBatchSize, 1);
+    auto windowEnd = std::chrono::steady_clock::now() + batchWindow;
+    while (submittedCount < maxBatchSize)
+    {
+        auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(windowEnd - std::chrono::steady_clock::now());
+        if (!m_submittedSlots.Wait(std::max<std::chrono::microseconds>(remaining, std::chrono::microseconds(0))))
+        {
+            break;
+        }
+        submittedCount++;
+    }
+
+    // Each token matches a slot marked submitted before the token was posted, take the oldest ones
+    std::vector<std::pair<uint64_t, uint32_t>> submitted;
+    for (uint32_t slot = 0; slot < m_slotCount; slot++)
+    {
+        auto& slotHeader = Slot(slot);
+        if (slotHeader.state.load(std::memory_order_acquire) == (uint32_t)SlotState::Submitted)
+        {
+            submitted.emplace_back(slotHeader.sequence, slot);
+        }
+    }
+    std::sort(submitted.begin(), submitted.end());
+    for (size_t i = 0; i < submitted.size() && slots.size() < submittedCount; i++)
+    {
+        uint32_t expected = (uint32_t)SlotState::Submitted;
+        if (Slot(submitted[i].second).state.compare_exchange_strong(expected, (uint32_t)SlotState::Processing, std::memory_order_acquire))
+        {
+            slots.push_back(submitted[i].second);
+        }
+    }
+    return slots;
+}
+
+const SharedFrameChannel::FrameDescription& SharedFrameChannel::SlotFrame(uint32_t slot) const
+{
+    CheckSlot(slot);
+    return Slot(slot).frame;
+}
+
+void SharedFrameChannel::Complete(uint32_t slot, Status status, const Result* results, uint32_t resultCount)
+{
+    CheckSlot(slot);
+    auto& slotHeader = Slot(slot);
+    resultCount = std::min<uint32_t>(resultCount, m_maxResultCount);
+    if (resultCount > 0)
+    {
+        memcpy(m_region + RegionHeaderSize + m_slotSize * slot + ResultsOffset(), results, resultCount * sizeof(Result));
+    }
+    slotHeader.resultCount = resultCount;
+    slotHeader.status = (int32_t)status;
+    slotHeader.state.store((uint32_t)SlotState::Completed, std::memory_order_release);
+    m_completedSlots[slot]->Post();
+}
+
+void SharedFrameChannel::Stop()
+{
+    if (!m_isHost)
+    {
+        return;
+    }
+    reinterpret_cast<RegionHeader*>(m_region)->isHostRunning.store(0, std::memory_order_release);
+
+    // Slots no one is going to evaluate complete right away
+    for (uint32_t slot = 0; slot < m_slotCount; slot++)
+    {
+        auto& slotHeader = Slot(slot);
+        uint32_t expected = (uint32_t)SlotState::Submitted;
+        if (slotHeader.state.compare_exchange_strong(expected, (uint32_t)SlotState::Processing, std::memory_order_acquire))
+        {
+            Complete(slot, Status::HostStopped, nullptr, 0);
+        }
+    }
+    m_freeSlots.Post(m_slotCount);
+}
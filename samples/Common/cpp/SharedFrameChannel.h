@@ -0,0 +1,186 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <semaphore.h>
+#endif
+
+//
+// Helper class implementing the shared-memory transport between a skill host process and its local clients.
+// The host creates a named region split in slotCount frame slots, each holding the pixels of a frame and the results
+// evaluated from it. A client acquires a free slot, writes the frame pixels straight into it, submits it and waits
+// for its results, so frames never go through a pipe or socket. Named semaphores carry the control messages:
+// one counts free slots, one counts submitted slots for the host, and one per slot signals its results to the client.
+//
+// A slot goes through Free -> Acquired (client) -> Submitted (client) -> Processing (host) -> Completed (host) -> Free (client).
+// Each transition is a compare-exchange on the slot state in shared memory, so slots are never handed to two parties.
+//
+class SharedFrameChannel
+{
+public:
+    struct Options
+    {
+        uint32_t slotCount = 8; // frames in flight across all clients
+        uint32_t maxWidth = 1920;
+        uint32_t maxHeight = 1080;
+        uint32_t bytesPerPixel = 4; // BGRA8
+        uint32_t maxResultCount = 64; // per frame
+    };
+
+    // Frame written in a slot by a client
+    struct FrameDescription
+    {
+        uint32_t width;
+        uint32_t height;
+        int32_t stride; // in bytes
+        int32_t pixelFormat; // BitmapPixelFormat
+        int64_t captureTime; // in 100ns ticks of the system-relative clock, -1 if unknown
+    };
+
+    // Box found in a frame, normalized in the frame
+    struct Result
+    {
+        int32_t label;
+        float x;
+        float y;
+        float width;
+        float height;
+    };
+
+    enum class SlotState : uint32_t
+    {
+        Free = 0,
+        Acquired,
+        Submitted,
+        Processing,
+        Completed
+    };
+
+    // Outcome of the evaluation of a slot
+    enum class Status : int32_t
+    {
+        Success = 0,
+        Failed,
+        InvalidFrame, // the frame description does not fit in the slot
+        HostStopped
+    };
+
+    // Host: create the region, throws std::runtime_error if a region with that name already exists or cannot be created
+    SharedFrameChannel(std::string const& name, Options const& options);
+
+    // Client: open the region of a running host, throws std::runtime_error if there is none
+    explicit SharedFrameChannel(std::string const& name);
+
+    // The host stops the channel and removes the region, which clients keep mapped until they close it
+    ~SharedFrameChannel();
+
+    SharedFrameChannel(const SharedFrameChannel&) = delete;
+    SharedFrameChannel& operator=(const SharedFrameChannel&) = delete;
+
+    //
+    // Client side
+    //
+
+    // Wait for a free slot and take it, returns -1 on timeout or if the host stopped
+    int32_t AcquireSlot(std::chrono::milliseconds timeout);
+
+    // Pixels of an acquired slot, SlotPixelCapacity() bytes
+    uint8_t* SlotPixels(uint32_t slot);
+
+    // Hand the frame written in an acquired slot to the host
+    void Submit(uint32_t slot, FrameDescription const& frame);
+
+    // Wait for the results of a submitted slot, returns false on timeout
+    bool WaitCompleted(uint32_t slot, std::chrono::milliseconds timeout);
+
+    Status SlotStatus(uint32_t slot) const;
+    uint32_t ResultCount(uint32_t slot) const;
+    const Result* Results(uint32_t slot) const;
+
+    // Give back a slot once its results were read, or an acquired slot that will not be submitted
+    void ReleaseSlot(uint32_t slot);
+
+    //
+    // Host side
+    //
+
+    //
+    // Wait up to timeout for a submitted slot, then up to batchWindow for more until maxBatchSize slots are submitted.
+    // Returns the submitted slots in submission order and marks them as being processed, empty on timeout.
+    //
+    std::vector<uint32_t> WaitSubmitted(uint32_t maxBatchSize, std::chrono::microseconds batchWindow, std::chrono::milliseconds timeout);
+
+    const FrameDescription& SlotFrame(uint32_t slot) const;
+
+    // Publish the results of a processed slot and wake up its client, extra results beyond MaxResultCount() are dropped
+    void Complete(uint32_t slot, Status status, const Result* results, uint32_t resultCount);
+
+    // Mark the host as stopped and wake up all waiting clients
+    void Stop();
+
+    bool IsHostRunning() const;
+    bool IsHost() const { return m_isHost; }
+    uint32_t SlotCount() const { return m_slotCount; }
+    size_t SlotPixelCapacity() const { return m_slotPixelCapacity; }
+    uint32_t MaxResultCount() const { return m_maxResultCount; }
+
+private:
+    struct RegionHeader;
+    struct SlotHeader;
+
+    // Named semaphore shared by the host and its clients
+    class NamedSemaphore
+    {
+    public:
+        NamedSemaphore() = default;
+        ~NamedSemaphore();
+        NamedSemaphore(const NamedSemaphore&) = delete;
+        NamedSemaphore& operator=(const NamedSemaphore&) = delete;
+
+        void Create(std::string const& name, uint32_t initialCount, uint32_t maxCount);
+        void Open(std::string const& name);
+        void Post(uint32_t count = 1);
+        bool Wait(std::chrono::microseconds timeout);
+
+    private:
+#ifdef _WIN32
+        HANDLE m_handle = nullptr;
+#else
+        sem_t* m_semaphore = nullptr;
+        std::string m_name;
+        bool m_isOwner = false;
+#endif
+    };
+
+    void MapRegion(size_t size, bool create);
+    void UnmapRegion();
+    void CreateSemaphores(bool create);
+    SlotHeader& Slot(uint32_t slot) const;
+    void CheckSlot(uint32_t slot) const;
+
+    std::string m_name;
+    bool m_isHost = false;
+    uint32_t m_slotCount = 0;
+    uint32_t m_maxResultCount = 0;
+    size_t m_slotPixelCapacity = 0;
+    size_t m_slotSize = 0;
+    size_t m_regionSize = 0;
+    uint8_t* m_region = nullptr;
+#ifdef _WIN32
+    HANDLE m_mapping = nullptr;
+#endif
+
+    NamedSemaphore m_freeSlots;
+    NamedSemaphore m_submittedSlots;
+    std::vector<std::unique_ptr<NamedSemaphore>> m_completedSlots;
+};
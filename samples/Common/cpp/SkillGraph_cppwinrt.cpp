@@ -0,0 +1,363 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "SkillGraph_cppwinrt.h"
+#include <algorithm>
+#include <chrono>
+#include <winrt/Windows.System.Threading.h>
+
+#include "Tracing.h"
+
+using namespace winrt;
+using namespace winrt::Windows::Foundation;
+using namespace winrt::Windows::Foundation::Collections;
+using namespace winrt::Windows::System::Threading;
+using namespace winrt::Microsoft::AI::Skills::SkillInterface;
+
+SkillGraph::Scheduler SkillGraph::ThreadPoolScheduler()
+{
+    return [](Task task)
+    {
+        ThreadPool::RunAsync([task](IAsyncAction const&) { task(); });
+    };
+}
+
+SkillGraph::Scheduler SkillGraph::WorkStealingScheduler(WorkStealingThreadPool& pool)
+{
+    return [&pool](Task task)
+    {
+        pool.Submit(std::move(task), WorkStealingThreadPool::Priority::Evaluate);
+    };
+}
+
+hstring SkillGraph::FindFeatureName(IVectorView<ISkillFeatureDescriptor> const& featureDescriptors, SkillFeatureKind featureKind)
+{
+    for (auto&& featureDescriptor : featureDescriptors)
+    {
+        if (featureDescriptor.FeatureKind() == featureKind)
+        {
+            return featureDescriptor.Name();
+        }
+    }
+    throw hresult_invalid_argument(L"Error: no feature of the requested kind");
+}
+
+SkillGraph::SkillGraph(Scheduler scheduler)
+    : m_scheduler(std::move(scheduler))
+{
+}
+
+SkillGraph::Node& SkillGraph::GetNode(NodeId node)
+{
+    if (node >= m_nodes.size())
+    {
+        throw hresult_invalid_argument(L"Error: unknown skill graph node");
+    }
+    return m_nodes[node];
+}
+
+//
+// Add a skill to the graph along with a binding of its own
+//
+SkillGraph::NodeId SkillGraph::AddNode(std::string const& name, ISkill const& skill)
+{
+    if (m_isBuilt)
+    {
+        throw hresult_illegal_method_call(L"Error: the skill graph is already built");
+    }
+    Node node;
+    node.name = name;
+    node.skill = skill;
+    node.binding = skill.CreateSkillBindingAsync().get();
+    m_nodes.push_back(std::move(node));
+    return (NodeId)(m_nodes.size() - 1);
+}
+
+//
+// Feed an input feature of a node from a graph input, several nodes can share the same graph input
+//
+void SkillGraph::AddInput(std::string const& inputName, NodeId node, hstring const& inputFeatureName)
+{
+    if (m_isBuilt)
+    {
+        throw hresult_illegal_method_call(L"Error: the skill graph is already built");
+    }
+    GetNode(node);
+    m_inputs[inputName].targets.push_back({ node, inputFeatureName });
+}
+
+void SkillGraph::AddDependency(NodeId source, NodeId target)
+{
+    if (m_isBuilt)
+    {
+        throw hresult_illegal_method_call(L"Error: the skill graph is already built");
+    }
+    auto& sourceNode = GetNode(source);
+    auto& targetNode = GetNode(target);
+    sourceNode.successors.push_back(target);
+    targetNode.predecessorCount++;
+}
+
+//
+// Source an input feature of the target node from an output feature of the source node
+//
+void SkillGraph::AddEdge(NodeId source, hstring const& outputFeatureName, NodeId target, hstring const& inputFeatureName)
+{
+    AddDependency(source, target);
+    m_featureEdges.push_back({ source, outputFeatureName, target, inputFeatureName });
+}
+
+//
+// Make the target node depend on the source node and run a transfer function between their bindings before evaluating the target
+//
+void SkillGraph::AddEdge(NodeId source, NodeId target, FeatureTransfer transfer)
+{
+    AddDependency(source, target);
+    m_nodes[target].transfers.push_back({ source, std::move(transfer) });
+}
+
+//
+// Check the graph is acyclic and fully bound, then wire features
+//
+void SkillGraph::Build()
+{
+    if (m_isBuilt)
+    {
+        return;
+    }
+
+    // Kahn's algorithm: a graph is acyclic if all its nodes can be removed in dependency order
+    std::vector<uint32_t> remainingPredecessors(m_nodes.size());
+    std::vector<NodeId> readyNodes;
+    for (NodeId node = 0; node < m_nodes.size(); node++)
+    {
+        remainingPredecessors[node] = m_nodes[node].predecessorCount;
+        if (remainingPredecessors[node] == 0)
+        {
+            readyNodes.push_back(node);
+        }
+    }
+    size_t visitedNodeCount = 0;
+    while (!readyNodes.empty())
+    {
+        NodeId node = readyNodes.back();
+        readyNodes.pop_back();
+        visitedNodeCount++;
+        for (auto successor : m_nodes[node].successors)
+        {
+            if (--remainingPredecessors[successor] == 0)
+            {
+                readyNodes.push_back(successor);
+            }
+        }
+    }
+    if (visitedNodeCount != m_nodes.size())
+    {
+        throw hresult_invalid_argument(L"Error: the skill graph contains a cycle");
+    }
+
+    // Every required input feature must be fed by a graph input or an edge, unless a transfer function takes care of the node inputs
+    std::vector<std::vector<hstring>> boundFeatures(m_nodes.size());
+    for (auto&& input : m_inputs)
+    {
+        for (auto&& target : input.second.targets)
+        {
+            boundFeatures[target.first].push_back(target.second);
+        }
+    }
+    for (auto&& edge : m_featureEdges)
+    {
+        boundFeatures[edge.target].push_back(edge.inputFeatureName);
+    }
+    for (NodeId node = 0; node < m_nodes.size(); node++)
+    {
+        if (!m_nodes[node].transfers.empty())
+        {
+            continue;
+        }
+        for (auto&& featureDescriptor : m_nodes[node].skill.SkillDescriptor().InputFeatureDescriptors())
+        {
+            if (featureDescriptor.IsRequired()
+                && std::find(boundFeatures[node].begin(), boundFeatures[node].end(), featureDescriptor.Name()) == boundFeatures[node].end())
+            {
+                throw hresult_invalid_argument(L"Error: required input feature " + featureDescriptor.Name() + L" of skill graph node " + to_hstring(m_nodes[node].name) + L" is not bound");
+            }
+        }
+    }
+
+    // Wire edges so that targets read their source output in place
+    for (auto&& edge : m_featureEdges)
+    {
+        auto& sourceBinding = m_nodes[edge.source].binding;
+        auto& targetBinding = m_nodes[edge.target].binding;
+        if (!sourceBinding.HasKey(edge.outputFeatureName) || !targetBinding.HasKey(edge.inputFeatureName))
+        {
+            throw hresult_invalid_argument(L"Error: unknown feature " + edge.outputFeatureName + L" or " + edge.inputFeatureName + L" on skill graph edge");
+        }
+        targetBinding.Lookup(edge.inputFeatureName).SourceFromOtherFeature(sourceBinding.Lookup(edge.outputFeatureName));
+    }
+
+    // Graph inputs are set on the feature of their first node and sourced by the others,
+    // unless the features are not compatible in which case they are set on each of them
+    for (auto&& input : m_inputs)
+    {
+        for (auto&& target : input.second.targets)
+        {
+            auto& node = m_nodes[target.first];
+            if (!node.binding.HasKey(target.second))
+            {
+                throw hresult_invalid_argument(L"Error: unknown input feature " + target.second + L" of skill graph node " + to_hstring(node.name));
+            }
+            auto feature = node.binding.Lookup(target.second);
+            if (input.second.feature == nullptr)
+            {
+                input.second.feature = feature;
+                continue;
+            }
+            try
+            {
+                feature.SourceFromOtherFeature(input.second.feature);
+            }
+            catch (hresult_error const&)
+            {
+                node.directInputs.push_back({ input.first, feature });
+            }
+        }
+    }
+
+    m_remainingPredecessors.reset(new std::atomic<uint32_t>[m_nodes.size()]);
+    m_isBuilt = true;
+}
+
+//
+// Set the value of a graph input, i.e. a VideoFrame, for the next evaluation
+//
+void SkillGraph::SetInput(std::string const& inputName, IInspectable const& value)
+{
+    auto input = m_inputs.find(inputName);
+    if (!m_isBuilt || input == m_inputs.end())
+    {
+        throw hresult_invalid_argument(L"Error: unknown skill graph input " + to_hstring(inputName));
+    }
+
+    // Set before any node runs since the features sourcing from it may be read as soon as their node starts
+    SAMPLES_TRACE_SCOPE("SkillGraph.SetInput");
+    input->second.feature.SetFeatureValueAsync(value).get();
+    input->second.value = value;
+}
+
+//
+// Evaluate all nodes in dependency order, running independent ones concurrently
+//
+void SkillGraph::Evaluate()
+{
+    if (!m_isBuilt)
+    {
+        throw hresult_illegal_method_call(L"Error: the skill graph must be built before being evaluated");
+    }
+
+    m_hasFailed = false;
+    m_exception = nullptr;
+    m_completedNodeCount = 0;
+    std::vector<NodeId> rootNodes;
+    for (NodeId node = 0; node < m_nodes.size(); node++)
+    {
+        m_remainingPredecessors[node] = m_nodes[node].predecessorCount;
+        if (m_nodes[node].predecessorCount == 0)
+        {
+            rootNodes.push_back(node);
+        }
+    }
+
+    // Nodes are traced as part of the frame being evaluated
+    uint64_t frameId = SAMPLES_TRACE_FRAME_ID();
+    for (auto node : rootNodes)
+    {
+        m_scheduler([this, node, frameId]() { RunNode(node, frameId); });
+    }
+
+    std::unique_lock<std::mutex> guard(m_lock);
+    m_completed.wait(guard, [this]() { return m_completedNodeCount == m_nodes.size(); });
+    if (m_exception != nullptr)
+    {
+        std::rethrow_exception(m_exception);
+    }
+}
+
+//
+// Evaluate a node then start the successors it was the last dependency of, the first of them on the current thread.
+// Once the last node is reported complete, Evaluate() may return and the graph be destroyed, so nothing after that
+// report touches a member.
+//
+void SkillGraph::RunNode(NodeId nodeId, uint64_t frameId)
+{
+    SAMPLES_TRACE_SET_FRAME_ID(frameId);
+    const NodeId nodeCount = (NodeId)m_nodes.size();
+    while (true)
+    {
+        auto& node = m_nodes[nodeId];
+
+        // Once a node failed, the remaining ones are only walked through so that the evaluation completes
+        if (!m_hasFailed)
+        {
+            try
+            {
+                auto begin = std::chrono::high_resolution_clock::now();
+                {
+                    SAMPLES_TRACE_SCOPE("SkillGraph.Bind");
+                    for (auto&& directInput : node.directInputs)
+                    {
+                        directInput.second.SetFeatureValueAsync(m_inputs.at(directInput.first).value).get();
+                    }
+                    for (auto&& transferEdge : node.transfers)
+                    {
+                        transferEdge.transfer(m_nodes[transferEdge.source].binding, node.binding);
+                    }
+                }
+                {
+                    SAMPLES_TRACE_SCOPE("SkillGraph.Evaluate");
+                    node.skill.EvaluateAsync(node.binding).get();
+                }
+                auto end = std::chrono::high_resolution_clock::now();
+                node.lastEvaluateMs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                if (m_exception == nullptr)
+                {
+                    m_exception = std::current_exception();
+                }
+                m_hasFailed = true;
+            }
+        }
+
+        NodeId nextNodeId = nodeCount;
+        for (auto successor : node.successors)
+        {
+            if (--m_remainingPredecessors[successor] == 0)
+            {
+                if (nextNodeId == nodeCount)
+                {
+                    nextNodeId = successor;
+                }
+                else
+                {
+                    m_scheduler([this, successor, frameId]() { RunNode(successor, frameId); });
+                }
+            }
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (++m_completedNodeCount == nodeCount)
+            {
+                m_completed.notify_all();
+            }
+        }
+
+        if (nextNodeId == nodeCount)
+        {
+            return;
+        }
+        nodeId = nextNodeId;
+    }
+}
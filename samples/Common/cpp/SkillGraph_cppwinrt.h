@@ -0,0 +1,134 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Foundation.Collections.h>
+
+#include "WorkStealingThreadPool.h"
+#include "winrt/Microsoft.AI.Skills.SkillInterface.h"
+
+//
+// Helper class that evaluates a set of skills composed as a directed acyclic graph.
+// Nodes are skills, each with its own binding. Edges connect the output feature of a node to the input feature of another one
+// with ISkillFeature::SourceFromOtherFeature(), so that the target reads the source value in place without copies.
+// Graph inputs such as a camera frame are set once on the feature of one node and sourced by all the others sharing it.
+// When features cannot be wired directly (i.e. a list of quads feeding a single quad input), an edge can instead carry
+// a FeatureTransfer function run before the target node is evaluated.
+//
+// Evaluate() starts the nodes without predecessors on the scheduler and each node completing starts the successors
+// it was the last dependency of, so independent branches run concurrently. The default scheduler is the shared WorkStealingThreadPool.
+//
+class SkillGraph
+{
+public:
+    using NodeId = uint32_t;
+    using Task = std::function<void()>;
+    using Scheduler = std::function<void(Task task)>;
+    using FeatureTransfer = std::function<void(
+        winrt::Microsoft::AI::Skills::SkillInterface::ISkillBinding const& source,
+        winrt::Microsoft::AI::Skills::SkillInterface::ISkillBinding const& target)>;
+
+    // Scheduler running tasks on the Windows thread pool
+    static Scheduler ThreadPoolScheduler();
+
+    // Scheduler running tasks on a WorkStealingThreadPool
+    static Scheduler WorkStealingScheduler(WorkStealingThreadPool& pool = WorkStealingThreadPool::Default());
+
+    // Name of the first feature of the specified kind, i.e. the input image of a vision skill. Throws if there is none.
+    static winrt::hstring FindFeatureName(
+        winrt::Windows::Foundation::Collections::IVectorView<winrt::Microsoft::AI::Skills::SkillInterface::ISkillFeatureDescriptor> const& featureDescriptors,
+        winrt::Microsoft::AI::Skills::SkillInterface::SkillFeatureKind featureKind);
+
+    explicit SkillGraph(Scheduler scheduler = WorkStealingScheduler());
+
+    SkillGraph(const SkillGraph&) = delete;
+    SkillGraph& operator=(const SkillGraph&) = delete;
+
+    //
+    // Graph construction, to be completed by Build() before the first evaluation
+    //
+    NodeId AddNode(std::string const& name, winrt::Microsoft::AI::Skills::SkillInterface::ISkill const& skill);
+    void AddInput(std::string const& inputName, NodeId node, winrt::hstring const& inputFeatureName);
+    void AddEdge(NodeId source, winrt::hstring const& outputFeatureName, NodeId target, winrt::hstring const& inputFeatureName);
+    void AddEdge(NodeId source, NodeId target, FeatureTransfer transfer);
+
+    // Validate the graph and wire features, throws hresult_invalid_argument if the graph is cyclic or misses a required input
+    void Build();
+
+    //
+    // Evaluation, one at a time
+    //
+    void SetInput(std::string const& inputName, winrt::Windows::Foundation::IInspectable const& value);
+
+    // Evaluate all nodes and wait for completion, rethrows the first failure after all started nodes completed
+    void Evaluate();
+
+    size_t NodeCount() const { return m_nodes.size(); }
+    const std::string& NodeName(NodeId node) const { return m_nodes.at(node).name; }
+    winrt::Microsoft::AI::Skills::SkillInterface::ISkillBinding const& Binding(NodeId node) const { return m_nodes.at(node).binding; }
+    float LastEvaluateMs(NodeId node) const { return m_nodes.at(node).lastEvaluateMs; } // bind and evaluation of the node in the last Evaluate()
+
+private:
+    struct TransferEdge
+    {
+        NodeId source;
+        FeatureTransfer transfer;
+    };
+
+    struct Node
+    {
+        std::string name;
+        winrt::Microsoft::AI::Skills::SkillInterface::ISkill skill = nullptr;
+        winrt::Microsoft::AI::Skills::SkillInterface::ISkillBinding binding = nullptr;
+        std::vector<NodeId> successors;
+        std::vector<TransferEdge> transfers;
+        uint32_t predecessorCount = 0;
+
+        // Graph inputs that could not be sourced from the feature set by SetInput(), set right before evaluation
+        std::vector<std::pair<std::string, winrt::Microsoft::AI::Skills::SkillInterface::ISkillFeature>> directInputs;
+
+        float lastEvaluateMs = 0.0f;
+    };
+
+    struct FeatureEdge
+    {
+        NodeId source;
+        winrt::hstring outputFeatureName;
+        NodeId target;
+        winrt::hstring inputFeatureName;
+    };
+
+    struct GraphInput
+    {
+        std::vector<std::pair<NodeId, winrt::hstring>> targets;
+        winrt::Microsoft::AI::Skills::SkillInterface::ISkillFeature feature = nullptr; // the feature SetInput() sets
+        winrt::Windows::Foundation::IInspectable value = nullptr;
+    };
+
+    Node& GetNode(NodeId node);
+    void AddDependency(NodeId source, NodeId target);
+    void RunNode(NodeId node, uint64_t frameId);
+
+    Scheduler m_scheduler;
+    std::vector<Node> m_nodes;
+    std::vector<FeatureEdge> m_featureEdges;
+    std::map<std::string, GraphInput> m_inputs;
+    bool m_isBuilt = false;
+
+    // State of the ongoing evaluation
+    std::unique_ptr<std::atomic<uint32_t>[]> m_remainingPredecessors;
+    std::atomic<bool> m_hasFailed = false;
+    std::exception_ptr m_exception = nullptr;
+    uint32_t m_completedNodeCount = 0;
+    std::mutex m_lock;
+    std::condition_variable m_completed;
+};
@@ -0,0 +1,194 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "SkillHost.h"
+#include <algorithm>
+#include <stdexcept>
+
+SkillHost::SkillHost(std::string const& name, Backend backend, Options const& options)
+    : m_channel(name, options.channel),
+    m_backend(std::move(backend)),
+    m_options(options)
+{
+    if (!m_backend)
+    {
+        throw std::invalid_argument("Error: a skill host needs a backend");
+    }
+}
+
+SkillHost::~SkillHost()
+{
+    Stop();
+}
+
+void SkillHost::Start()
+{
+    if (m_thread.joinable())
+    {
+        return;
+    }
+    m_startTime = std::chrono::steady_clock::now();
+    m_thread = std::thread([this]() { HostLoop(); });
+}
+
+void SkillHost::Stop()
+{
+    m_isStopping = true;
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+    if (m_channel.IsHostRunning())
+    {
+        m_channel.Stop();
+    }
+}
+
+double SkillHost::AverageBatchSize() const
+{
+    uint64_t batchCount = BatchCount();
+    return batchCount > 0 ? (double)FrameCount() / batchCount : 0.0;
+}
+
+double SkillHost::Occupancy() const
+{
+    if (m_startTime == std::chrono::steady_clock::time_point())
+    {
+        return 0.0;
+    }
+    auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - m_startTime).count();
+    return elapsedUs > 0 ? (double)m_busyUs.load(std::memory_order_relaxed) / elapsedUs : 0.0;
+}
+
+void SkillHost::HostLoop()
+{
+    std::vector<Request> batch;
+    while (!m_isStopping)
+    {
+        // Wake up regularly to notice Stop()
+        auto slots = m_channel.WaitSubmitted(m_options.maxBatchSize, m_options.batchWindow, std::chrono::milliseconds(100));
+        if (slots.empty())
+        {
+            continue;
+        }
+
+        // Frames that do not fit in their slot are completed right away
+        batch.clear();
+        for (auto slot : slots)
+        {
+            auto& frame = m_channel.SlotFrame(slot);
+            uint64_t frameSize = (uint64_t)frame.height * (uint64_t)std::max<int32_t>(frame.stride, 0);
+            if (frame.width == 0 || frame.height == 0 || frame.stride <= 0 || frameSize > m_channel.SlotPixelCapacity())
+            {
+                m_channel.Complete(slot, SharedFrameChannel::Status::InvalidFrame, nullptr, 0);
+                continue;
+            }
+            Request request;
+            request.slot = slot;
+            request.frame = frame;
+            request.pixels = m_channel.SlotPixels(slot);
+            batch.push_back(std::move(request));
+        }
+        if (batch.empty())
+        {
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        try
+        {
+            m_backend(batch);
+        }
+        catch (...)
+        {
+            for (auto&& request : batch)
+            {
+                request.status = SharedFrameChannel::Status::Failed;
+                request.results.clear();
+            }
+        }
+        auto busy = std::chrono::steady_clock::now() - start;
+        m_busyUs.fetch_add(std::chrono::duration_cast<std::chrono::microseconds>(busy).count(), std::memory_order_relaxed);
+        m_batchLatencies.Record(std::chrono::duration<double, std::milli>(busy).count());
+        m_frameCount.fetch_add(batch.size(), std::memory_order_relaxed);
+        m_batchCount.fetch_add(1, std::memory_order_relaxed);
+
+        for (auto&& request : batch)
+        {
+            m_channel.Complete(request.slot, request.status, request.results.data(), (uint32_t)request.results.size());
+        }
+    }
+}
+
+SkillHost::Backend SkillHost::SimulatedBackend(double fixedMs, double perFrameMs)
+{
+    return [fixedMs, perFrameMs](std::vector<Request>& batch)
+    {
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(fixedMs + perFrameMs * batch.size()));
+        for (auto&& request : batch)
+        {
+            request.results.push_back({ request.pixels[0], 0.25f, 0.25f, 0.5f, 0.5f });
+        }
+    };
+}
+
+SkillHostClient::SkillHostClient(std::string const& name)
+    : m_channel(name)
+{
+}
+
+SharedFrameChannel::Status SkillHostClient::Evaluate(
+    SharedFrameChannel::FrameDescription const& frame,
+    std::function<void(uint8_t* pixels)> const& writePixels,
+    std::vector<SharedFrameChannel::Result>& results,
+    std::chrono::milliseconds timeout)
+{
+    results.clear();
+
+    // Slots given up on earlier are returned once the host completed them
+    for (size_t i = 0; i < m_abandonedSlots.size();)
+    {
+        if (m_channel.WaitCompleted(m_abandonedSlots[i], std::chrono::milliseconds(0)))
+        {
+            m_channel.ReleaseSlot(m_abandonedSlots[i]);
+            m_abandonedSlots.erase(m_abandonedSlots.begin() + i);
+        }
+        else
+        {
+            i++;
+        }
+    }
+    if ((uint64_t)frame.height * (uint64_t)std::max<int32_t>(frame.stride, 0) > m_channel.SlotPixelCapacity())
+    {
+        return SharedFrameChannel::Status::InvalidFrame;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int32_t slot = m_channel.AcquireSlot(timeout);
+    if (slot < 0)
+    {
+        return SharedFrameChannel::Status::HostStopped;
+    }
+    try
+    {
+        writePixels(m_channel.SlotPixels(slot));
+    }
+    catch (...)
+    {
+        m_channel.ReleaseSlot(slot);
+        throw;
+    }
+    m_channel.Submit(slot, frame);
+
+    auto remaining = timeout - std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    if (!m_channel.WaitCompleted(slot, std::max<std::chrono::milliseconds>(remaining, std::chrono::milliseconds(0))))
+    {
+        // The slot stays with the host until it completes it, which it does even when stopping
+        m_abandonedSlots.push_back((uint32_t)slot);
+        return SharedFrameChannel::Status::HostStopped;
+    }
+    auto status = m_channel.SlotStatus(slot);
+    auto slotResults = m_channel.Results(slot);
+    results.assign(slotResults, slotResults + m_channel.ResultCount(slot));
+    m_channel.ReleaseSlot(slot);
+    m_latencies.Record(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+    return status;
+}
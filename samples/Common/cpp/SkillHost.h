@@ -0,0 +1,119 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "FrameDeadlinePolicy.h"
+#include "SharedFrameChannel.h"
+
+//
+// Helper class serving skill evaluations to local client processes over a SharedFrameChannel.
+// A single host thread gathers the frames submitted by all clients into batches and hands each batch to a backend,
+// which reads the pixels straight from the shared slots and fills in the results. Batching lets the backend spread
+// a batch over its bindings and amortize its fixed per-call cost across clients.
+//
+// The host measures its occupancy, the fraction of time spent in the backend, and the size of the batches it served.
+//
+class SkillHost
+{
+public:
+    // Frame of a batch, valid until the backend returns
+    struct Request
+    {
+        uint32_t slot;
+        SharedFrameChannel::FrameDescription frame;
+        const uint8_t* pixels; // in the shared slot, frame.stride * frame.height bytes
+        std::vector<SharedFrameChannel::Result> results;
+        SharedFrameChannel::Status status = SharedFrameChannel::Status::Success;
+    };
+
+    // Evaluates a batch of frames, called from the host thread only
+    using Backend = std::function<void(std::vector<Request>& batch)>;
+
+    struct Options
+    {
+        SharedFrameChannel::Options channel;
+        uint32_t maxBatchSize = 4;
+        std::chrono::microseconds batchWindow = std::chrono::microseconds(1000); // how long a frame waits for others to join its batch
+    };
+
+    SkillHost(std::string const& name, Backend backend) : SkillHost(name, std::move(backend), Options()) {}
+    SkillHost(std::string const& name, Backend backend, Options const& options);
+    ~SkillHost();
+
+    SkillHost(const SkillHost&) = delete;
+    SkillHost& operator=(const SkillHost&) = delete;
+
+    void Start();
+
+    // Stop serving, clients waiting on a frame get SharedFrameChannel::Status::HostStopped
+    void Stop();
+
+    uint64_t FrameCount() const { return m_frameCount.load(std::memory_order_relaxed); }
+    uint64_t BatchCount() const { return m_batchCount.load(std::memory_order_relaxed); }
+    double AverageBatchSize() const;
+
+    // Fraction of the time since Start() spent evaluating batches
+    double Occupancy() const;
+
+    // Time the backend took per batch
+    const LatencyHistogram& BatchLatencies() const { return m_batchLatencies; }
+
+    //
+    // Stand-in backend for measurements without skills: sleeps fixedMs per batch plus perFrameMs per frame,
+    // and reports one result per frame whose label is the first byte of its pixels.
+    //
+    static Backend SimulatedBackend(double fixedMs, double perFrameMs);
+
+private:
+    void HostLoop();
+
+    SharedFrameChannel m_channel;
+    Backend m_backend;
+    Options m_options;
+    std::thread m_thread;
+    std::atomic<bool> m_isStopping = false;
+
+    std::chrono::steady_clock::time_point m_startTime;
+    std::atomic<int64_t> m_busyUs = 0;
+    std::atomic<uint64_t> m_frameCount = 0;
+    std::atomic<uint64_t> m_batchCount = 0;
+    LatencyHistogram m_batchLatencies;
+};
+
+//
+// Helper class submitting frames to a SkillHost from another process, and measuring the latency it observes.
+// A client evaluates one frame at a time, processes wanting several frames in flight use several clients.
+//
+class SkillHostClient
+{
+public:
+    // Throws std::runtime_error if no host with that name is running
+    explicit SkillHostClient(std::string const& name);
+
+    //
+    // Evaluate a frame: writePixels writes frame.stride * frame.height bytes in the slot it is given, then the call
+    // waits for the results. Returns Status::HostStopped on timeout or if the host stopped.
+    //
+    SharedFrameChannel::Status Evaluate(
+        SharedFrameChannel::FrameDescription const& frame,
+        std::function<void(uint8_t* pixels)> const& writePixels,
+        std::vector<SharedFrameChannel::Result>& results,
+        std::chrono::milliseconds timeout = std::chrono::milliseconds(5000));
+
+    size_t SlotPixelCapacity() const { return m_channel.SlotPixelCapacity(); }
+
+    // Time from acquiring a slot to reading its results
+    const LatencyHistogram& Latencies() const { return m_latencies; }
+
+private:
+    SharedFrameChannel m_channel;
+    std::vector<uint32_t> m_abandonedSlots; // timed out while the host was evaluating them
+    LatencyHistogram m_latencies;
+};
@@ -0,0 +1,109 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <MemoryBuffer.h>
+#include <cstdint>
+#include <cstring>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Graphics.DirectX.Direct3D11.h>
+#include <winrt/Windows.Graphics.Imaging.h>
+#include <winrt/Windows.Media.h>
+
+namespace SoftwareBitmapHelper
+{
+    //
+    // Raw view over the first plane of a locked bitmap buffer
+    //
+    struct PixelView
+    {
+        uint8_t* data = nullptr;
+        int32_t stride = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+
+        uint8_t* Row(uint32_t y) const { return data + (size_t)y * stride; }
+    };
+
+    //
+    // Scoped lock on the pixels of a SoftwareBitmap, released when going out of scope
+    //
+    class LockedPixels
+    {
+    public:
+        LockedPixels(winrt::Windows::Graphics::Imaging::SoftwareBitmap const& bitmap, winrt::Windows::Graphics::Imaging::BitmapBufferAccessMode mode)
+        {
+            m_buffer = bitmap.LockBuffer(mode);
+            m_reference = m_buffer.CreateReference();
+            uint8_t* data = nullptr;
+            uint32_t capacity = 0;
+            winrt::check_hresult(m_reference.as<::Windows::Foundation::IMemoryBufferByteAccess>()->GetBuffer(&data, &capacity));
+            auto plane = m_buffer.GetPlaneDescription(0);
+            m_view.data = data + plane.StartIndex;
+            m_view.stride = plane.Stride;
+            m_view.width = (uint32_t)plane.Width;
+            m_view.height = (uint32_t)plane.Height;
+        }
+
+        ~LockedPixels()
+        {
+            m_reference.Close();
+            m_buffer.Close();
+        }
+
+        LockedPixels(const LockedPixels&) = delete;
+        LockedPixels& operator=(const LockedPixels&) = delete;
+
+        const PixelView& View() const { return m_view; }
+
+    private:
+        winrt::Windows::Graphics::Imaging::BitmapBuffer m_buffer = nullptr;
+        winrt::Windows::Foundation::IMemoryBufferReference m_reference = nullptr;
+        PixelView m_view;
+    };
+
+    //
+    // Retrieve a CPU-accessible SoftwareBitmap of the specified format from a VideoFrame, copying it out of GPU memory if needed
+    //
+    inline winrt::Windows::Graphics::Imaging::SoftwareBitmap GetSoftwareBitmap(
+        winrt::Windows::Media::VideoFrame const& frame,
+        winrt::Windows::Graphics::Imaging::BitmapPixelFormat pixelFormat = winrt::Windows::Graphics::Imaging::BitmapPixelFormat::Bgra8)
+    {
+        using namespace winrt::Windows::Graphics::Imaging;
+
+        SoftwareBitmap softwareBitmap = frame.SoftwareBitmap();
+        if (softwareBitmap == nullptr)
+        {
+            auto surfaceDescription = frame.Direct3DSurface().Description();
+            winrt::Windows::Media::VideoFrame cpuFrame(pixelFormat, surfaceDescription.Width, surfaceDescription.Height, BitmapAlphaMode::Premultiplied);
+            frame.CopyToAsync(cpuFrame).get();
+            softwareBitmap = cpuFrame.SoftwareBitmap();
+        }
+        if (softwareBitmap.BitmapPixelFormat() != pixelFormat)
+        {
+            softwareBitmap = SoftwareBitmap::Convert(softwareBitmap, pixelFormat, BitmapAlphaMode::Premultiplied);
+        }
+        return softwareBitmap;
+    }
+
+    //
+    // Copy a rectangle of 32bpp pixels from one view to another
+    //
+    inline void CopyBgra8Region(
+        const PixelView& source,
+        uint32_t sourceX,
+        uint32_t sourceY,
+        const PixelView& destination,
+        uint32_t destinationX,
+        uint32_t destinationY,
+        uint32_t width,
+        uint32_t height)
+    {
+        for (uint32_t row = 0; row < height; row++)
+        {
+            memcpy(
+                destination.Row(destinationY + row) + destinationX * 4,
+                source.Row(sourceY + row) + sourceX * 4,
+                (size_t)width * 4);
+        }
+    }
+};
@@ -0,0 +1,257 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+//
+// Lock-free queue between one producer thread and one consumer thread, holding at most Capacity items in place.
+// The capacity is a template parameter so that the items live in the queue itself and indexes wrap with a mask.
+//
+template <typename T, size_t Capacity>
+class SpscRingQueue
+{
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscRingQueue capacity must be a power of 2 of at least 2");
+    static_assert(std::is_default_constructible<T>::value && std::is_move_assignable<T>::value, "SpscRingQueue items must be default constructible and move assignable");
+
+public:
+    SpscRingQueue() = default;
+    SpscRingQueue(const SpscRingQueue&) = delete;
+    SpscRingQueue& operator=(const SpscRingQueue&) = delete;
+
+    // Producer only, fails if the queue is full
+    bool TryPush(T& item)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_head.load(std::memory_order_acquire) >= Capacity)
+        {
+            return false;
+        }
+        m_items[tail & (Capacity - 1)] = std::move(item);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only, fails if the queue is empty
+    bool TryPop(T& item)
+    {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        item = std::move(m_items[head & (Capacity - 1)]);
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t Size() const { return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire); }
+    static constexpr size_t CapacityValue = Capacity;
+
+private:
+    // Each index on its own cache line so that the producer and the consumer do not invalidate each other's
+    alignas(64) std::atomic<size_t> m_head = 0;
+    alignas(64) std::atomic<size_t> m_tail = 0;
+    alignas(64) std::array<T, Capacity> m_items;
+};
+
+namespace StaticPipelineDetails
+{
+    // Type produced by running Input through Stages, void once a stage returns nothing
+    template <typename Input, typename... Stages>
+    struct ChainResult
+    {
+        using Type = Input;
+    };
+
+    template <typename Input, typename Stage, typename... Rest>
+    struct ChainResult<Input, Stage, Rest...>
+    {
+        using Type = typename ChainResult<std::invoke_result_t<Stage&, Input>, Rest...>::Type;
+    };
+
+    // Whether each stage accepts what the previous one returns, checked before the result types are computed
+    template <typename Input, typename Stage, typename... Rest>
+    constexpr bool IsChainValid()
+    {
+        if constexpr (!std::is_invocable_v<Stage&, Input>)
+        {
+            return false;
+        }
+        else if constexpr (sizeof...(Rest) == 0)
+        {
+            return true;
+        }
+        else
+        {
+            using Output = std::invoke_result_t<Stage&, Input>;
+            return !std::is_void_v<Output> && IsChainValid<Output, Rest...>();
+        }
+    }
+
+    // Run input through the stages, each call is resolved at compile time and can be inlined
+    template <typename Input, typename Stage, typename... Rest>
+    inline void Apply(Input&& input, Stage& stage, Rest&... rest)
+    {
+        if constexpr (sizeof...(Rest) == 0)
+        {
+            stage(std::forward<Input>(input));
+        }
+        else
+        {
+            Apply(stage(std::forward<Input>(input)), rest...);
+        }
+    }
+}
+
+//
+// Pipeline whose stages are composed at compile time: a source producing frames, then any amount of stages
+// (preprocessing, skill, postprocessing) each taking the output of the previous one, ending with a sink returning void.
+// Stages are plain callable objects called directly rather than through a type-erased interface, so a stage boundary
+// is a function call the compiler can inline, and the queue between the source and the stages is a SpscRingQueue
+// of QueueCapacity frames. Mismatched stage types and invalid queue sizes fail to compile.
+//
+// The source is a callable object with a Frame type, filling the frame it is given and returning false once it ran out:
+//     struct Source { using Frame = ...; bool operator()(Frame& frame); };
+//
+template <typename Source, size_t QueueCapacity, typename... Stages>
+class StaticPipeline
+{
+public:
+    using Frame = typename Source::Frame;
+
+    static_assert(sizeof...(Stages) >= 1, "StaticPipeline needs at least a sink stage");
+    static_assert(std::is_invocable_r_v<bool, Source&, Frame&>, "StaticPipeline source must be callable as bool(Frame&)");
+    static_assert(StaticPipelineDetails::IsChainValid<Frame&&, Stages...>(), "each StaticPipeline stage must accept the output of the previous one");
+    static_assert(std::is_void_v<typename StaticPipelineDetails::ChainResult<Frame&&, Stages...>::Type>, "the last StaticPipeline stage must be a sink returning void");
+
+    explicit StaticPipeline(Source source, Stages... stages)
+        : m_source(std::move(source)),
+        m_stages(std::move(stages)...)
+    {
+    }
+
+    StaticPipeline(const StaticPipeline&) = delete;
+    StaticPipeline& operator=(const StaticPipeline&) = delete;
+
+    //
+    // Run the source and the stages on the calling thread until the source runs out, returns the frames processed
+    //
+    uint64_t RunInline()
+    {
+        uint64_t frameCount = 0;
+        Frame frame;
+        while (m_source(frame))
+        {
+            Process(std::move(frame));
+            frameCount++;
+        }
+        return frameCount;
+    }
+
+    //
+    // Run the source on a thread of its own feeding the queue, and the stages on the calling thread,
+    // until the source runs out and the queue is drained. The source waits while the queue is full.
+    // If a stage throws, the source is stopped and the exception rethrown once its thread exited. If the source throws,
+    // the frames it queued are processed and its exception is rethrown.
+    //
+    uint64_t Run()
+    {
+        std::atomic<bool> isSourceDone = false;
+        std::atomic<bool> isStopping = false;
+        std::exception_ptr sourceException;
+        std::thread sourceThread([this, &isSourceDone, &isStopping, &sourceException]()
+        {
+            try
+            {
+                Frame frame;
+                while (!isStopping.load(std::memory_order_acquire) && m_source(frame))
+                {
+                    while (!m_queue.TryPush(frame))
+                    {
+                        if (isStopping.load(std::memory_order_acquire))
+                        {
+                            break;
+                        }
+                        std::this_thread::yield();
+                    }
+                }
+            }
+            catch (...)
+            {
+                sourceException = std::current_exception();
+            }
+            isSourceDone.store(true, std::memory_order_release);
+        });
+
+        uint64_t frameCount = 0;
+        try
+        {
+            Frame frame;
+            while (true)
+            {
+                if (m_queue.TryPop(frame))
+                {
+                    Process(std::move(frame));
+                    frameCount++;
+                }
+                else if (isSourceDone.load(std::memory_order_acquire))
+                {
+                    // The source may have pushed its last frames right before finishing
+                    if (!m_queue.TryPop(frame))
+                    {
+                        break;
+                    }
+                    Process(std::move(frame));
+                    frameCount++;
+                }
+                else
+                {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        catch (...)
+        {
+            // Stop the source and drop the frames left in the queue so that the pipeline can run again
+            isStopping.store(true, std::memory_order_release);
+            sourceThread.join();
+            Frame frame;
+            while (m_queue.TryPop(frame))
+            {
+            }
+            throw;
+        }
+        sourceThread.join();
+        if (sourceException != nullptr)
+        {
+            std::rethrow_exception(sourceException);
+        }
+        return frameCount;
+    }
+
+    // Run one frame through the stages
+    void Process(Frame&& frame)
+    {
+        std::apply([&frame](Stages&... stages) { StaticPipelineDetails::Apply(std::move(frame), stages...); }, m_stages);
+    }
+
+    Source& GetSource() { return m_source; }
+
+    template <size_t Index>
+    auto& GetStage() { return std::get<Index>(m_stages); }
+
+    static constexpr size_t StageCount = sizeof...(Stages);
+
+private:
+    Source m_source;
+    std::tuple<Stages...> m_stages;
+    SpscRingQueue<Frame, QueueCapacity> m_queue;
+};
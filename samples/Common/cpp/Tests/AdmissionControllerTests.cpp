@@ -0,0 +1,299 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "AdmissionController.h"
+#include "TestCheck.h"
+
+using Decision = AdmissionController::Decision;
+
+static const int64_t TicksPerMs = FrameDeadlinePolicy::TicksPerMs;
+
+//
+// Simulated host driving the clock and the CPU sampler of the controller, so that runs are deterministic
+//
+struct SimulatedHost
+{
+    int64_t now = 1000 * TicksPerMs;
+    double cpuUtilization = 0.5;
+    uint32_t cpuSampleCount = 0;
+
+    AdmissionController::Clock Clock()
+    {
+        return [this]() { return now; };
+    }
+
+    AdmissionController::CpuSampler CpuSampler()
+    {
+        return [this]()
+        {
+            cpuSampleCount++;
+            return cpuUtilization;
+        };
+    }
+
+    double NowMs() const { return (double)now / TicksPerMs; }
+};
+
+//
+// Batch lane asking for its next item as soon as the previous one completed, again after the deferral delay when
+// deferred, and for the next item right away when shed
+//
+struct BatchLane
+{
+    struct Step
+    {
+        double timeMs;
+        Decision decision;
+    };
+
+    double itemMs = 10.0; // time an admitted item takes
+    int64_t readyTime = 0;
+    int64_t nextAskTime = 0;
+    std::vector<Step> steps;
+
+    uint32_t Count(Decision decision, double fromMs = 0.0) const
+    {
+        uint32_t count = 0;
+        for (auto&& step : steps)
+        {
+            count += (step.decision == decision && step.timeMs >= fromMs) ? 1 : 0;
+        }
+        return count;
+    }
+
+    std::vector<double> Times(Decision decision, double fromMs = 0.0) const
+    {
+        std::vector<double> times;
+        for (auto&& step : steps)
+        {
+            if (step.decision == decision && step.timeMs >= fromMs)
+            {
+                times.push_back(step.timeMs);
+            }
+        }
+        return times;
+    }
+};
+
+//
+// Run both lanes for durationMs in 1ms steps: a live frame of liveLatencyMs every 33ms when not negative,
+// and the batch lane asking for items
+//
+static void Simulate(AdmissionController& controller, SimulatedHost& host, BatchLane& lane, double durationMs, double liveLatencyMs)
+{
+    int64_t end = host.now + (int64_t)(durationMs * TicksPerMs);
+    int64_t nextLiveTime = host.now;
+    if (lane.steps.empty())
+    {
+        lane.readyTime = host.now;
+        lane.nextAskTime = host.now;
+    }
+    for (; host.now < end; host.now += TicksPerMs)
+    {
+        if (liveLatencyMs >= 0.0 && host.now >= nextLiveTime)
+        {
+            controller.RecordLiveLatency(liveLatencyMs);
+            nextLiveTime += 33 * TicksPerMs;
+        }
+        if (host.now >= lane.nextAskTime)
+        {
+            Decision decision = controller.AdmitBatch(lane.readyTime);
+            lane.steps.push_back({ host.NowMs(), decision });
+            switch (decision)
+            {
+            case Decision::Admit:
+                lane.readyTime = host.now + (int64_t)(lane.itemMs * TicksPerMs);
+                lane.nextAskTime = lane.readyTime;
+                break;
+            case Decision::Defer:
+                lane.nextAskTime = host.now + (int64_t)(controller.DeferDelayMs() * TicksPerMs);
+                break;
+            case Decision::Shed:
+                lane.nextAskTime = host.now + TicksPerMs;
+                break;
+            }
+        }
+    }
+}
+
+//
+// A batch running alone keeps the whole host, however long its items waited
+//
+static void BatchAloneIsAlwaysAdmitted()
+{
+    SimulatedHost host;
+    host.cpuUtilization = 1.0;
+    AdmissionController controller(AdmissionController::Options(), host.Clock(), host.CpuSampler());
+    TEST_CHECK(controller.AdmitBatch(host.now - 60000 * TicksPerMs) == Decision::Admit);
+
+    BatchLane lane;
+    Simulate(controller, host, lane, 2000.0, -1.0);
+    TEST_CHECK(lane.Count(Decision::Admit) == lane.steps.size());
+    TEST_CHECK(lane.steps.size() == 200);
+    TEST_CHECK(controller.DeferredCount() == 0 && controller.ShedCount() == 0);
+    TEST_CHECK(controller.LiveP99Ms() == 0.0);
+}
+
+//
+// Batch items are held back exactly when the p99 of live latencies crosses its target
+//
+static void LiveP99CrossingTargetDefersBatch()
+{
+    SimulatedHost host;
+    AdmissionController controller(AdmissionController::Options(), host.Clock(), host.CpuSampler());
+
+    // 1 latency out of 100 above target is within the p99
+    for (uint32_t i = 0; i < 99; i++)
+    {
+        controller.RecordLiveLatency(50.0);
+    }
+    controller.RecordLiveLatency(80.0);
+    TEST_CHECK(controller.LiveP99Ms() == 50.0);
+    TEST_CHECK(controller.AdmitBatch(host.now) == Decision::Admit);
+
+    // A second one moves the p99 above target
+    controller.RecordLiveLatency(80.0);
+    TEST_CHECK(controller.LiveP99Ms() == 80.0);
+    TEST_CHECK(controller.AdmitBatch(host.now) == Decision::Defer);
+
+    // Latencies older than the window no longer count, fresh ones under target let batch items through
+    host.now += 2001 * TicksPerMs;
+    controller.RecordLiveLatency(40.0);
+    TEST_CHECK(controller.LiveP99Ms() == 40.0);
+    TEST_CHECK(controller.AdmitBatch(host.now) == Decision::Admit);
+
+    // Only the most recent latencies of the ring are kept
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        controller.RecordLiveLatency(i < 500 ? 90.0 : 30.0);
+    }
+    TEST_CHECK(controller.LiveP99Ms() == 30.0);
+    TEST_CHECK(controller.AdmittedCount() == 2 && controller.DeferredCount() == 1);
+}
+
+//
+// A loaded host holds batch items back while live work runs, sampled at most once per sample interval
+//
+static void HostLoadDefersBatch()
+{
+    SimulatedHost host;
+    host.cpuUtilization = 0.95;
+    AdmissionController controller(AdmissionController::Options(), host.Clock(), host.CpuSampler());
+    BatchLane lane;
+    Simulate(controller, host, lane, 1000.0, 20.0);
+    TEST_CHECK(lane.Count(Decision::Admit) == 0);
+    TEST_CHECK(lane.Count(Decision::Defer) == lane.steps.size());
+    TEST_CHECK(controller.CpuUtilization() == 0.95);
+    TEST_CHECK(host.cpuSampleCount <= 4);
+
+    // Admitted again from the first sample once the load dropped
+    host.cpuUtilization = 0.5;
+    double dropMs = host.NowMs();
+    Simulate(controller, host, lane, 1000.0, 20.0);
+    auto admitTimes = lane.Times(Decision::Admit, dropMs);
+    TEST_CHECK(!admitTimes.empty());
+    TEST_CHECK(admitTimes[0] - dropMs <= 250.0 + controller.DeferDelayMs());
+    TEST_CHECK(lane.Count(Decision::Defer, admitTimes[0]) == 0);
+    TEST_CHECK(host.cpuSampleCount <= 8);
+}
+
+//
+// Under a standing overload, batch items are deferred until their sojourn stayed above target for a whole interval,
+// then shed at intervals shrinking with the square root of the amount shed
+//
+static void StandingOverloadShedsAfterInterval()
+{
+    SimulatedHost host;
+    AdmissionController::Options options;
+    AdmissionController controller(options, host.Clock(), host.CpuSampler());
+    BatchLane lane;
+    double startMs = host.NowMs();
+    Simulate(controller, host, lane, 5000.0, 100.0);
+
+    TEST_CHECK(lane.Count(Decision::Admit) == 0);
+    auto shedTimes = lane.Times(Decision::Shed);
+    TEST_CHECK(shedTimes.size() >= 5);
+
+    // The first item is shed once sojourn went above target, then stayed there for the interval
+    double firstShedMs = shedTimes[0] - startMs;
+    TEST_CHECK(firstShedMs >= options.sojournTargetMs + options.sojournIntervalMs);
+    TEST_CHECK(firstShedMs <= options.sojournTargetMs + options.sojournIntervalMs + 2 * controller.DeferDelayMs());
+    TEST_CHECK(lane.Count(Decision::Defer) >= (uint32_t)(firstShedMs / controller.DeferDelayMs()) - 1);
+
+    // Shedding intervals shrink as interval / sqrt(n), give or take a deferral
+    for (size_t i = 1; i < 4; i++)
+    {
+        double expectedMs = options.sojournIntervalMs / std::sqrt((double)i);
+        double intervalMs = shedTimes[i] - shedTimes[i - 1];
+        TEST_CHECK(intervalMs >= expectedMs - 1.0);
+        TEST_CHECK(intervalMs <= expectedMs + controller.DeferDelayMs() + 1.0);
+    }
+    TEST_CHECK(controller.ShedCount() == shedTimes.size());
+}
+
+//
+// Once live latencies recover, batch items get admitted again and shedding stops, and a new overload shortly after
+// resumes close to the previous shedding rate
+//
+static void RecoveryStopsShedding()
+{
+    SimulatedHost host;
+    AdmissionController::Options options;
+    AdmissionController controller(options, host.Clock(), host.CpuSampler());
+    BatchLane lane;
+    Simulate(controller, host, lane, 5000.0, 100.0);
+    auto firstShedTimes = lane.Times(Decision::Shed);
+    TEST_CHECK(firstShedTimes.size() >= 5);
+
+    // Live latencies back under target, admitted once the slow ones left the window
+    double recoveryMs = host.NowMs();
+    Simulate(controller, host, lane, 3000.0, 30.0);
+    auto admitTimes = lane.Times(Decision::Admit, recoveryMs);
+    TEST_CHECK(!admitTimes.empty());
+    TEST_CHECK(admitTimes[0] - recoveryMs <= options.liveWindowMs + controller.DeferDelayMs());
+    TEST_CHECK(lane.Count(Decision::Shed, admitTimes[0]) == 0);
+    TEST_CHECK(lane.Count(Decision::Defer, admitTimes[0]) == 0);
+    TEST_CHECK(controller.BatchSojourns().Count() == controller.AdmittedCount());
+    TEST_CHECK(controller.BatchSojourns().MaxMs() >= options.sojournTargetMs);
+
+    // Overloaded again: after the interval, shedding resumes faster than it started the first time
+    double overloadMs = host.NowMs();
+    Simulate(controller, host, lane, 5000.0, 100.0);
+    auto secondShedTimes = lane.Times(Decision::Shed, overloadMs);
+    TEST_CHECK(secondShedTimes.size() >= 2);
+    TEST_CHECK(secondShedTimes[1] - secondShedTimes[0] < firstShedTimes[1] - firstShedTimes[0] - controller.DeferDelayMs());
+}
+
+//
+// A live lane that stopped reporting releases the batch lane after the idle delay, even with slow latencies in the window
+//
+static void IdleLiveLaneReleasesBatch()
+{
+    SimulatedHost host;
+    AdmissionController::Options options;
+    AdmissionController controller(options, host.Clock(), host.CpuSampler());
+    BatchLane lane;
+    Simulate(controller, host, lane, 500.0, 100.0);
+    TEST_CHECK(lane.Count(Decision::Admit) == 0);
+
+    double lastLiveMs = host.NowMs() - 1.0;
+    Simulate(controller, host, lane, 1500.0, -1.0);
+    auto admitTimes = lane.Times(Decision::Admit);
+    TEST_CHECK(!admitTimes.empty());
+    TEST_CHECK(admitTimes[0] - lastLiveMs >= options.liveIdleMs - 33.0);
+    TEST_CHECK(admitTimes[0] - lastLiveMs <= options.liveIdleMs + controller.DeferDelayMs());
+    TEST_CHECK(controller.LiveP99Ms() == 100.0);
+}
+
+int main()
+{
+    TEST_RUN(BatchAloneIsAlwaysAdmitted);
+    TEST_RUN(LiveP99CrossingTargetDefersBatch);
+    TEST_RUN(HostLoadDefersBatch);
+    TEST_RUN(StandingOverloadShedsAfterInterval);
+    TEST_RUN(RecoveryStopsShedding);
+    TEST_RUN(IdleLiveLaneReleasesBatch);
+    return 0;
+}
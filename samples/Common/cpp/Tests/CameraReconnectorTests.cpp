@@ -0,0 +1,363 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CameraReconnector.h"
+#include "TestCheck.h"
+
+// Frame interval of the fake camera, 30fps in 100ns ticks
+static const int64_t FrameInterval = 333333;
+
+//
+// Capture device standing in for a camera: it logs what happens to it in order, and opening it can be made
+// to deliver frames before returning like a frame reader started at the end of opening, then to fail
+//
+class FakeCamera
+{
+public:
+    explicit FakeCamera(CameraReconnector::Options const& options = FastOptions())
+        : m_reconnector(
+            [this]() { Open(); },
+            [this]() { Log("close"); },
+            [this](CameraReconnector::Gap const& gap) { OnGap(gap); },
+            [this](std::string const& message) { OnGiveUp(message); },
+            options,
+            [this]() { return m_now.load(); })
+    {
+    }
+
+    static CameraReconnector::Options FastOptions()
+    {
+        CameraReconnector::Options options;
+        options.initialBackoff = std::chrono::milliseconds(1);
+        options.maxBackoff = std::chrono::milliseconds(4);
+        options.maxAttempts = 3;
+        return options;
+    }
+
+    CameraReconnector& Reconnector() { return m_reconnector; }
+
+    // Deliver a frame arriving at arrivalTime the way CameraHelper does, accounting it before consumers see it
+    void DeliverFrame(int64_t arrivalTime)
+    {
+        m_now = arrivalTime;
+        m_reconnector.NotifyFrame(arrivalTime);
+        Log("frame");
+    }
+
+    // Deliver frameCount frames at the frame interval, following the last one
+    void DeliverFrames(int frameCount)
+    {
+        for (int i = 0; i < frameCount; i++)
+        {
+            DeliverFrame(m_now + FrameInterval);
+        }
+    }
+
+    // The next openings throw
+    void FailNextOpens(int count) { m_failingOpenCount = count; }
+
+    // Run action inside the next opening
+    void OnNextOpen(std::function<void()> action)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_onOpen = std::move(action);
+    }
+
+    int64_t Now() const { return m_now; }
+
+    std::vector<std::string> Events()
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_events;
+    }
+
+    std::vector<CameraReconnector::Gap> Gaps()
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_gaps;
+    }
+
+    std::string GiveUpMessage()
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        return m_giveUpMessage;
+    }
+
+    void ClearEvents()
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_events.clear();
+    }
+
+    int OpenCount() const { return m_openCount; }
+
+private:
+    void Log(std::string const& event)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_events.push_back(event);
+    }
+
+    void Open()
+    {
+        m_openCount++;
+        Log("open");
+        std::function<void()> onOpen;
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            std::swap(onOpen, m_onOpen);
+        }
+        if (onOpen)
+        {
+            onOpen();
+        }
+        if (m_failingOpenCount > 0)
+        {
+            m_failingOpenCount--;
+            Log("open failed");
+            throw std::runtime_error("Error: fake camera failed to open");
+        }
+    }
+
+    void OnGap(CameraReconnector::Gap const& gap)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_events.push_back("gap");
+        m_gaps.push_back(gap);
+    }
+
+    void OnGiveUp(std::string const& message)
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_events.push_back("give up");
+        m_giveUpMessage = message;
+    }
+
+    std::mutex m_lock;
+    std::vector<std::string> m_events;
+    std::vector<CameraReconnector::Gap> m_gaps;
+    std::string m_giveUpMessage;
+    std::function<void()> m_onOpen;
+    std::atomic<int64_t> m_now = 0;
+    std::atomic<int> m_failingOpenCount = 0;
+    std::atomic<int> m_openCount = 0;
+    CameraReconnector m_reconnector; // declared last so that it stops before the fake camera state is destroyed
+};
+
+// Wait for a condition set by the reconnect thread, fails the test after a few seconds
+static void WaitFor(std::function<bool()> const& condition)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!condition())
+    {
+        TEST_CHECK(std::chrono::steady_clock::now() < deadline);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+static bool EndsWith(std::vector<std::string> const& events, std::vector<std::string> const& expected)
+{
+    return events.size() >= expected.size() && std::equal(expected.begin(), expected.end(), events.end() - expected.size());
+}
+
+//
+// Frames the reopened device delivers while opening it has not returned yet are preceded by the gap,
+// and the outage does not leak into the frame interval the lost frames of later gaps are estimated from
+//
+static void GapPrecedesFramesDeliveredWhileOpening()
+{
+    FakeCamera camera;
+    camera.Reconnector().Start();
+    camera.DeliverFrames(10);
+    int64_t lastFrameTime = camera.Now();
+
+    camera.OnNextOpen([&]() { camera.DeliverFrame(lastFrameTime + 10 * FrameInterval); });
+    camera.ClearEvents();
+    camera.Reconnector().ReportFailure("Error: unplugged");
+    WaitFor([&]() { return camera.Reconnector().CurrentState() == CameraReconnector::State::Running; });
+
+    TEST_CHECK((camera.Events() == std::vector<std::string>{ "close", "open", "gap", "frame" }));
+    auto gaps = camera.Gaps();
+    TEST_CHECK(gaps.size() == 1);
+    TEST_CHECK(gaps[0].startTime == lastFrameTime);
+    TEST_CHECK(gaps[0].endTime == lastFrameTime + 10 * FrameInterval);
+    TEST_CHECK(gaps[0].lostFrameCount == 9);
+    TEST_CHECK(gaps[0].attemptCount == 1);
+
+    // Frames keep flowing without gaps, then a second outage is estimated from the unchanged frame interval
+    camera.DeliverFrames(5);
+    TEST_CHECK(camera.Gaps().size() == 1);
+    lastFrameTime = camera.Now();
+    camera.OnNextOpen([&]() { camera.DeliverFrame(lastFrameTime + 5 * FrameInterval); });
+    camera.Reconnector().ReportFailure("Error: unplugged again");
+    WaitFor([&]() { return camera.Gaps().size() == 2; });
+    TEST_CHECK(camera.Gaps()[1].lostFrameCount == 4);
+
+    auto statistics = camera.Reconnector().GetStatistics();
+    TEST_CHECK(statistics.failureCount == 2);
+    TEST_CHECK(statistics.recoveryCount == 2);
+    TEST_CHECK(statistics.lostFrameCount == 13);
+    camera.Reconnector().Stop();
+}
+
+//
+// Frames the failed device still delivers before it is closed belong before the gap and do not close it
+//
+static void FramesOfFailedDeviceDoNotCloseGap()
+{
+    // The backoff leaves time for the stray frame to arrive before the reopen attempt
+    auto options = FakeCamera::FastOptions();
+    options.initialBackoff = std::chrono::milliseconds(200);
+    FakeCamera camera(options);
+    camera.Reconnector().Start();
+    camera.DeliverFrames(10);
+
+    camera.Reconnector().ReportFailure("Error: stream failed");
+    camera.DeliverFrames(1);
+    int64_t strayFrameTime = camera.Now();
+    TEST_CHECK(camera.Gaps().empty());
+
+    camera.OnNextOpen([&]() { camera.DeliverFrame(strayFrameTime + 4 * FrameInterval); });
+    WaitFor([&]() { return camera.Reconnector().CurrentState() == CameraReconnector::State::Running; });
+    TEST_CHECK(camera.Gaps().size() == 1);
+    auto gap = camera.Gaps()[0];
+    TEST_CHECK(gap.startTime == strayFrameTime);
+    TEST_CHECK(gap.lostFrameCount == 3);
+    TEST_CHECK(gap.attemptCount == 1);
+    TEST_CHECK(EndsWith(camera.Events(), { "open", "gap", "frame" }));
+    camera.Reconnector().Stop();
+}
+
+//
+// Frames delivered by a reopen attempt that failed afterwards end a gap, and the next gap starts after them
+//
+static void FailedAttemptFramesStartNextGap()
+{
+    FakeCamera camera;
+    camera.Reconnector().Start();
+    camera.DeliverFrames(10);
+    int64_t lastFrameTime = camera.Now();
+
+    camera.OnNextOpen([&]() { camera.DeliverFrame(lastFrameTime + 3 * FrameInterval); });
+    camera.FailNextOpens(1);
+    camera.Reconnector().ReportFailure("Error: unplugged");
+    WaitFor([&]() { return camera.Gaps().size() == 1; });
+    int64_t attemptFrameTime = camera.Now();
+    WaitFor([&]() { return camera.OpenCount() == 3; });
+
+    camera.DeliverFrame(attemptFrameTime + 6 * FrameInterval);
+    auto gaps = camera.Gaps();
+    TEST_CHECK(gaps.size() == 2);
+    TEST_CHECK(gaps[0].lostFrameCount == 2);
+    TEST_CHECK(gaps[0].attemptCount == 1);
+    TEST_CHECK(gaps[1].startTime == attemptFrameTime);
+    TEST_CHECK(gaps[1].lostFrameCount == 5);
+    TEST_CHECK(gaps[1].attemptCount == 2);
+    camera.Reconnector().Stop();
+}
+
+//
+// A device failing again before delivering a frame extends the same gap
+//
+static void RepeatedFailureExtendsGap()
+{
+    FakeCamera camera;
+    camera.Reconnector().Start();
+    camera.DeliverFrames(10);
+    int64_t lastFrameTime = camera.Now();
+
+    camera.Reconnector().ReportFailure("Error: first failure");
+    WaitFor([&]() { return camera.Reconnector().CurrentState() == CameraReconnector::State::Running; });
+    camera.Reconnector().ReportFailure("Error: second failure");
+    WaitFor([&]() { return camera.OpenCount() == 3 && camera.Reconnector().CurrentState() == CameraReconnector::State::Running; });
+
+    camera.DeliverFrame(lastFrameTime + 20 * FrameInterval);
+    auto gaps = camera.Gaps();
+    TEST_CHECK(gaps.size() == 1);
+    TEST_CHECK(gaps[0].startTime == lastFrameTime);
+    TEST_CHECK(gaps[0].lostFrameCount == 19);
+    TEST_CHECK(gaps[0].attemptCount == 2);
+    TEST_CHECK(camera.Reconnector().GetStatistics().failureCount == 2);
+    camera.Reconnector().Stop();
+}
+
+//
+// Reopening gives up after the maximum amount of attempts and reports why
+//
+static void GivesUpAfterMaxAttempts()
+{
+    FakeCamera camera;
+    camera.Reconnector().Start();
+    camera.DeliverFrames(3);
+
+    camera.FailNextOpens(100);
+    camera.Reconnector().ReportFailure("Error: unplugged");
+    WaitFor([&]() { return camera.Reconnector().CurrentState() == CameraReconnector::State::Failed; });
+    WaitFor([&]() { return !camera.GiveUpMessage().empty(); });
+
+    TEST_CHECK(camera.GiveUpMessage().find("after 3 attempts") != std::string::npos);
+    TEST_CHECK(camera.Reconnector().GetStatistics().attemptCount == 3);
+    TEST_CHECK(camera.Reconnector().GetStatistics().recoveryCount == 0);
+    TEST_CHECK(camera.Gaps().empty());
+
+    // Failures reported once it gave up are ignored
+    camera.Reconnector().ReportFailure("Error: ignored");
+    TEST_CHECK(camera.Reconnector().GetStatistics().failureCount == 1);
+    camera.Reconnector().Stop();
+}
+
+//
+// Stopping while reconnecting waits for the reconnect thread and leaves the device closed
+//
+static void StopWhileReconnecting()
+{
+    FakeCamera camera;
+    camera.Reconnector().Start();
+    camera.FailNextOpens(2);
+    camera.Reconnector().ReportFailure("Error: unplugged");
+    WaitFor([&]() { return camera.OpenCount() >= 2; });
+    camera.Reconnector().Stop();
+
+    TEST_CHECK(camera.Reconnector().CurrentState() == CameraReconnector::State::Stopped);
+    auto events = camera.Events();
+    TEST_CHECK(!events.empty() && events.back() == "close");
+    int openCount = camera.OpenCount();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    TEST_CHECK(camera.OpenCount() == openCount);
+}
+
+//
+// A device failing to open on start is closed and the failure thrown to the caller
+//
+static void StartThrowsWhenOpeningFails()
+{
+    FakeCamera camera;
+    camera.FailNextOpens(1);
+    TEST_CHECK_THROWS(camera.Reconnector().Start(), std::runtime_error);
+    TEST_CHECK((camera.Events() == std::vector<std::string>{ "open", "open failed", "close" }));
+    TEST_CHECK(camera.Reconnector().CurrentState() == CameraReconnector::State::Stopped);
+
+    camera.Reconnector().Start();
+    TEST_CHECK(camera.Reconnector().CurrentState() == CameraReconnector::State::Running);
+    camera.Reconnector().Stop();
+}
+
+int main()
+{
+    TEST_RUN(GapPrecedesFramesDeliveredWhileOpening);
+    TEST_RUN(FramesOfFailedDeviceDoNotCloseGap);
+    TEST_RUN(FailedAttemptFramesStartNextGap);
+    TEST_RUN(RepeatedFailureExtendsGap);
+    TEST_RUN(GivesUpAfterMaxAttempts);
+    TEST_RUN(StopWhileReconnecting);
+    TEST_RUN(StartThrowsWhenOpeningFails);
+    return 0;
+}
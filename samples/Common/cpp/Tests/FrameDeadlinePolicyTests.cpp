@@ -0,0 +1,167 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include <cstdint>
+
+#include "FrameDeadlinePolicy.h"
+#include "TestCheck.h"
+
+static const int64_t TicksPerMs = FrameDeadlinePolicy::TicksPerMs;
+
+//
+// Synthetic clock in 100ns ticks, moved by the tests only
+//
+struct SyntheticClock
+{
+    int64_t now = 1000 * TicksPerMs;
+
+    FrameDeadlinePolicy::Clock Clock()
+    {
+        return [this]() { return now; };
+    }
+};
+
+//
+// Frames are admitted up to the deadline included and discarded from the next tick on
+//
+static void AdmitsFramesUpToDeadline()
+{
+    SyntheticClock clock;
+    FrameDeadlinePolicy policy(50.0, clock.Clock());
+    TEST_CHECK(policy.DeadlineMs() == 50.0);
+
+    TEST_CHECK(policy.Admit(clock.now - 50 * TicksPerMs + 1));
+    TEST_CHECK(policy.Admit(clock.now - 50 * TicksPerMs));
+    TEST_CHECK(!policy.Admit(clock.now - 50 * TicksPerMs - 1));
+    TEST_CHECK(!policy.Admit(clock.now - 200 * TicksPerMs));
+    TEST_CHECK(policy.AdmittedFrameCount() == 2);
+    TEST_CHECK(policy.DiscardedFrameCount() == 2);
+
+    // Only admitted frames are recorded in the admission ages
+    TEST_CHECK(policy.AdmissionAges().Count() == 2);
+    TEST_CHECK(policy.AdmissionAges().MaxMs() == 50.0);
+    TEST_CHECK(policy.AgeMs(clock.now - 20 * TicksPerMs) == 20.0);
+
+    // Ages follow the clock
+    int64_t captureTime = clock.now;
+    clock.now += 30 * TicksPerMs;
+    TEST_CHECK(policy.Admit(captureTime));
+    clock.now += 21 * TicksPerMs;
+    TEST_CHECK(!policy.Admit(captureTime));
+
+    // A deadline of 0 admits all frames
+    FrameDeadlinePolicy unboundedPolicy(0.0, clock.Clock());
+    TEST_CHECK(unboundedPolicy.Admit(clock.now - 60000 * TicksPerMs));
+    TEST_CHECK(unboundedPolicy.DiscardedFrameCount() == 0);
+}
+
+//
+// Results produced after the deadline are counted late, whether or not their frame was admitted in time
+//
+static void CountsLateResults()
+{
+    SyntheticClock clock;
+    FrameDeadlinePolicy policy(50.0, clock.Clock());
+    int64_t captureTime = clock.now;
+
+    clock.now += 10 * TicksPerMs;
+    TEST_CHECK(policy.Admit(captureTime));
+    clock.now += 30 * TicksPerMs;
+    TEST_CHECK(policy.RecordResult(captureTime) == 40.0);
+    TEST_CHECK(policy.LateResultCount() == 0);
+
+    clock.now = captureTime + 50 * TicksPerMs;
+    TEST_CHECK(policy.RecordResult(captureTime) == 50.0);
+    TEST_CHECK(policy.LateResultCount() == 0);
+
+    clock.now += 10;
+    policy.RecordResult(captureTime);
+    TEST_CHECK(policy.LateResultCount() == 1);
+
+    TEST_CHECK(policy.ResultAges().Count() == 3);
+    TEST_CHECK(policy.AdmissionAges().Count() == 1);
+    TEST_CHECK(policy.AdmissionAges().MaxMs() == 10.0);
+
+    // Without deadline no result is late
+    FrameDeadlinePolicy unboundedPolicy(0.0, clock.Clock());
+    TEST_CHECK(unboundedPolicy.RecordResult(clock.now - 1000 * TicksPerMs) == 1000.0);
+    TEST_CHECK(unboundedPolicy.LateResultCount() == 0);
+}
+
+//
+// Percentiles are the upper bound of the bucket holding them, capped by the maximum recorded latency
+//
+static void HistogramPercentiles()
+{
+    LatencyHistogram empty;
+    TEST_CHECK(empty.Count() == 0);
+    TEST_CHECK(empty.Percentile(0.99) == 0.0);
+    TEST_CHECK(empty.MaxMs() == 0.0);
+
+    LatencyHistogram histogram;
+    for (uint32_t i = 0; i < 99; i++)
+    {
+        histogram.Record(10.125);
+    }
+    histogram.Record(100.125);
+    TEST_CHECK(histogram.Count() == 100);
+    TEST_CHECK(histogram.Percentile(0.0) == 10.25);
+    TEST_CHECK(histogram.Percentile(0.5) == 10.25);
+    TEST_CHECK(histogram.Percentile(0.99) == 10.25);
+    TEST_CHECK(histogram.Percentile(1.0) == 100.125);
+    TEST_CHECK(histogram.Percentile(2.0) == 100.125);
+    TEST_CHECK(histogram.MaxMs() == 100.125);
+
+    // A second slow latency moves the p99 to its bucket
+    histogram.Record(100.125);
+    TEST_CHECK(histogram.Percentile(0.99) == 100.125);
+
+    // Negative latencies count as 0
+    LatencyHistogram negative;
+    negative.Record(-5.0);
+    TEST_CHECK(negative.Count() == 1);
+    TEST_CHECK(negative.Percentile(0.5) == 0.0);
+    TEST_CHECK(negative.MaxMs() == 0.0);
+}
+
+//
+// Latencies from 512ms on all fall in the overflow bucket, whose percentiles are the maximum recorded latency
+//
+static void HistogramOverflowBucket()
+{
+    TEST_CHECK(LatencyHistogram::MaxTrackedMs == 512.0);
+
+    LatencyHistogram histogram;
+    histogram.Record(1.125);
+    histogram.Record(1.125);
+    histogram.Record(600.5);
+    histogram.Record(1000.5);
+    TEST_CHECK(histogram.Percentile(0.5) == 1.25);
+    TEST_CHECK(histogram.Percentile(0.75) == 1000.5);
+    TEST_CHECK(histogram.Percentile(1.0) == 1000.5);
+    TEST_CHECK(histogram.MaxMs() == 1000.5);
+
+    // The last tracked bucket ends at 512ms, 512ms itself overflows
+    LatencyHistogram boundary;
+    boundary.Record(511.875);
+    TEST_CHECK(boundary.Percentile(1.0) == 511.875);
+    boundary.Record(512.0);
+    boundary.Record(512.5);
+    TEST_CHECK(boundary.Percentile(0.3) == 512.0);
+    TEST_CHECK(boundary.Percentile(0.6) == 512.5);
+    TEST_CHECK(boundary.MaxMs() == 512.5);
+
+    // Through the policy, results older than the tracked range are still counted and reported late
+    SyntheticClock clock;
+    FrameDeadlinePolicy policy(50.0, clock.Clock());
+    TEST_CHECK(policy.RecordResult(clock.now - 2000 * TicksPerMs) == 2000.0);
+    TEST_CHECK(policy.ResultAges().Percentile(0.99) == 2000.0);
+    TEST_CHECK(policy.LateResultCount() == 1);
+}
+
+int main()
+{
+    TEST_RUN(AdmitsFramesUpToDeadline);
+    TEST_RUN(CountsLateResults);
+    TEST_RUN(HistogramPercentiles);
+    TEST_RUN(HistogramOverflowBucket);
+    return 0;
+}
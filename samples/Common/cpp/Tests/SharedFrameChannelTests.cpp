@@ -0,0 +1,121 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "SharedFrameChannel.h"
+#include "TestCheck.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace std::chrono_literals;
+
+// Channel name unique to this process, so that concurrent test runs do not share their objects
+static std::string ChannelName(const char* test)
+{
+#ifdef _WIN32
+    uint32_t processId = (uint32_t)GetCurrentProcessId();
+#else
+    uint32_t processId = (uint32_t)getpid();
+#endif
+    return std::string("Tests.") + test + "." + std::to_string(processId);
+}
+
+static SharedFrameChannel::Options SmallOptions()
+{
+    SharedFrameChannel::Options options;
+    options.slotCount = 2;
+    options.maxWidth = 16;
+    options.maxHeight = 16;
+    options.maxResultCount = 4;
+    return options;
+}
+
+//
+// A client frame goes through a slot to the host and its results come back
+//
+static void FrameRoundTrip()
+{
+    std::string name = ChannelName("RoundTrip");
+    SharedFrameChannel host(name, SmallOptions());
+    SharedFrameChannel client(name);
+    TEST_CHECK(client.SlotCount() == 2 && client.MaxResultCount() == 4);
+    TEST_CHECK(client.SlotPixelCapacity() == 16 * 16 * 4);
+
+    std::thread hostThread([&]()
+    {
+        auto slots = host.WaitSubmitted(1, 0us, 5000ms);
+        TEST_CHECK(slots.size() == 1);
+        auto const& frame = host.SlotFrame(slots[0]);
+        SharedFrameChannel::Result result = { (int32_t)frame.width, 0.25f, 0.5f, 0.125f, 0.0625f };
+        host.Complete(slots[0], SharedFrameChannel::Status::Success, &result, 1);
+    });
+
+    int32_t slot = client.AcquireSlot(1000ms);
+    TEST_CHECK(slot >= 0);
+    memset(client.SlotPixels(slot), 0x7f, 8 * 8 * 4);
+    client.Submit(slot, { 8, 8, 8 * 4, 87, -1 });
+    TEST_CHECK(client.WaitCompleted(slot, 5000ms));
+    hostThread.join();
+
+    TEST_CHECK(client.SlotStatus(slot) == SharedFrameChannel::Status::Success);
+    TEST_CHECK(client.ResultCount(slot) == 1);
+    TEST_CHECK(client.Results(slot)[0].label == 8 && client.Results(slot)[0].x == 0.25f);
+    client.ReleaseSlot(slot);
+}
+
+//
+// A host failing to start on semaphores left by a crashed host removes its region, so that it starts once they are gone
+//
+static void FailedStartReleasesRegion()
+{
+    std::string name = ChannelName("FailedStart");
+    std::string staleName = "SkillHost." + name + ".free";
+#ifdef _WIN32
+    HANDLE stale = CreateSemaphoreA(nullptr, 0, 1, ("Local\\" + staleName).c_str());
+    TEST_CHECK(stale != nullptr);
+#else
+    sem_t* stale = sem_open(("/" + staleName).c_str(), O_CREAT | O_EXCL, 0600, 0);
+    TEST_CHECK(stale != SEM_FAILED);
+#endif
+
+    TEST_CHECK_THROWS(SharedFrameChannel(name, SmallOptions()), std::runtime_error);
+    TEST_CHECK_THROWS(SharedFrameChannel(name, SmallOptions()), std::runtime_error);
+    TEST_CHECK_THROWS(SharedFrameChannel{ name }, std::runtime_error);
+
+#ifdef _WIN32
+    CloseHandle(stale);
+#else
+    sem_close(stale);
+    sem_unlink(("/" + staleName).c_str());
+#endif
+    SharedFrameChannel host(name, SmallOptions());
+    TEST_CHECK(host.IsHostRunning());
+}
+
+//
+// Clients cannot open a channel without host, nor one whose host stopped
+//
+static void ClientNeedsRunningHost()
+{
+    std::string name = ChannelName("NoHost");
+    TEST_CHECK_THROWS(SharedFrameChannel{ name }, std::runtime_error);
+
+    SharedFrameChannel host(name, SmallOptions());
+    host.Stop();
+    TEST_CHECK_THROWS(SharedFrameChannel{ name }, std::runtime_error);
+}
+
+int main()
+{
+    TEST_RUN(FrameRoundTrip);
+    TEST_RUN(FailedStartReleasesRegion);
+    TEST_RUN(ClientNeedsRunningHost);
+    return 0;
+}
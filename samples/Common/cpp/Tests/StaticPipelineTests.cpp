@@ -0,0 +1,101 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "StaticPipeline.h"
+#include "TestCheck.h"
+
+//
+// Source producing the integers from 1 to frameCount, throwing instead of producing throwAt if not 0
+//
+struct CountingSource
+{
+    using Frame = uint64_t;
+
+    uint64_t frameCount = 0;
+    uint64_t throwAt = 0;
+    uint64_t next = 1;
+
+    bool operator()(Frame& frame)
+    {
+        if (next > frameCount)
+        {
+            return false;
+        }
+        if (next == throwAt)
+        {
+            throw std::runtime_error("Error: source failed");
+        }
+        frame = next++;
+        return true;
+    }
+};
+
+struct Doubler
+{
+    uint64_t operator()(uint64_t frame) { return frame * 2; }
+};
+
+// Sink summing the frames, throwing on the throwAt-th frame if not 0
+struct SummingSink
+{
+    uint64_t* sum;
+    uint64_t throwAt = 0;
+    uint64_t count = 0;
+
+    void operator()(uint64_t frame)
+    {
+        if (++count == throwAt)
+        {
+            throw std::runtime_error("Error: sink failed");
+        }
+        *sum += frame;
+    }
+};
+
+static void RunProcessesEveryFrameInOrder()
+{
+    uint64_t sum = 0;
+    StaticPipeline<CountingSource, 4, Doubler, SummingSink> pipeline(CountingSource{ 10000 }, Doubler(), SummingSink{ &sum });
+    TEST_CHECK(pipeline.Run() == 10000);
+    TEST_CHECK(sum == 10000ull * 10001);
+
+    uint64_t inlineSum = 0;
+    StaticPipeline<CountingSource, 4, Doubler, SummingSink> inlinePipeline(CountingSource{ 100 }, Doubler(), SummingSink{ &inlineSum });
+    TEST_CHECK(inlinePipeline.RunInline() == 100);
+    TEST_CHECK(inlineSum == 100ull * 101);
+}
+
+static void RunRethrowsStageExceptionAfterStoppingSource()
+{
+    // The source would otherwise keep waiting on the full queue for a consumer that left
+    uint64_t sum = 0;
+    StaticPipeline<CountingSource, 2, Doubler, SummingSink> pipeline(CountingSource{ 1000000 }, Doubler(), SummingSink{ &sum, 5 });
+    TEST_CHECK_THROWS(pipeline.Run(), std::runtime_error);
+    TEST_CHECK(sum == 2 * (1 + 2 + 3 + 4));
+    TEST_CHECK(pipeline.GetSource().next < 1000000);
+
+    // The pipeline can run again once the failing stage recovered
+    pipeline.GetStage<1>().throwAt = 0;
+    pipeline.GetSource().frameCount = pipeline.GetSource().next + 9;
+    TEST_CHECK(pipeline.Run() == 10);
+}
+
+static void RunRethrowsSourceExceptionAfterQueuedFrames()
+{
+    uint64_t sum = 0;
+    StaticPipeline<CountingSource, 16, Doubler, SummingSink> pipeline(CountingSource{ 100, 51 }, Doubler(), SummingSink{ &sum });
+    TEST_CHECK_THROWS(pipeline.Run(), std::runtime_error);
+
+    // The 50 frames produced before the failure were all processed
+    TEST_CHECK(sum == 50ull * 51);
+}
+
+int main()
+{
+    TEST_RUN(RunProcessesEveryFrameInOrder);
+    TEST_RUN(RunRethrowsStageExceptionAfterStoppingSource);
+    TEST_RUN(RunRethrowsSourceExceptionAfterQueuedFrames);
+    return 0;
+}
@@ -0,0 +1,42 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+//
+// Minimal checks for the tests of the Common helpers: a failed check prints its location and exits with a failure code,
+// so that each test executable passes or fails as a whole under CTest
+//
+#define TEST_CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            std::fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1); \
+        } \
+    } while (false)
+
+#define TEST_CHECK_THROWS(expression, ExceptionType) \
+    do \
+    { \
+        bool isThrown = false; \
+        try \
+        { \
+            expression; \
+        } \
+        catch (ExceptionType const&) \
+        { \
+            isThrown = true; \
+        } \
+        TEST_CHECK(isThrown && "expected " #ExceptionType); \
+    } while (false)
+
+// Run a test function and report it
+#define TEST_RUN(testFunction) \
+    do \
+    { \
+        std::printf("%s\n", #testFunction); \
+        testFunction(); \
+    } while (false)
@@ -0,0 +1,144 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "WorkStealingThreadPool.h"
+
+//
+// Scaling benchmark of WorkStealingThreadPool on the per-frame work the samples give it: each frame is a 3x3 box blur
+// of a 1024x1024 image split in 64x64 tiles, one task per tile. Frames are either split from the submitting thread,
+// going through the shared queue, or split by a task on a worker, going through its deque and stealing.
+// Pass the amount of frames to time per run, 50 by default.
+//
+static const uint32_t ImageSize = 1024;
+static const uint32_t TileSize = 64;
+static const uint32_t TilesPerRow = ImageSize / TileSize;
+
+static void BlurTile(std::vector<float> const& source, std::vector<float>& destination, uint32_t tile)
+{
+    uint32_t left = (tile % TilesPerRow) * TileSize;
+    uint32_t top = (tile / TilesPerRow) * TileSize;
+    for (uint32_t y = top; y < top + TileSize; y++)
+    {
+        uint32_t above = y > 0 ? y - 1 : y;
+        uint32_t below = y + 1 < ImageSize ? y + 1 : y;
+        for (uint32_t x = left; x < left + TileSize; x++)
+        {
+            uint32_t before = x > 0 ? x - 1 : x;
+            uint32_t after = x + 1 < ImageSize ? x + 1 : x;
+            float sum = 0.0f;
+            for (uint32_t row : { above, y, below })
+            {
+                const float* line = source.data() + (size_t)row * ImageSize;
+                sum += line[before] + line[x] + line[after];
+            }
+            destination[(size_t)y * ImageSize + x] = sum / 9.0f;
+        }
+    }
+}
+
+struct RunResult
+{
+    double flatMs; // per frame, tiles submitted from outside the pool
+    double nestedMs; // per frame, tiles submitted from a worker
+};
+
+static RunResult Run(uint32_t workerCount, uint32_t frameCount, std::vector<float> const& source, std::vector<float> const& expected)
+{
+    WorkStealingThreadPool::Options options;
+    options.workerCount = workerCount;
+    WorkStealingThreadPool pool(options);
+    std::vector<float> destination(source.size());
+    RunResult result = {};
+
+    auto begin = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < frameCount; frame++)
+    {
+        WorkStealingThreadPool::TaskGroup tiles(pool);
+        for (uint32_t tile = 0; tile < TilesPerRow * TilesPerRow; tile++)
+        {
+            tiles.Run([&, tile]() { BlurTile(source, destination, tile); });
+        }
+        tiles.Wait();
+    }
+    auto end = std::chrono::steady_clock::now();
+    result.flatMs = std::chrono::duration<double, std::milli>(end - begin).count() / frameCount;
+    bool isCorrect = destination == expected;
+
+    std::fill(destination.begin(), destination.end(), 0.0f);
+    begin = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < frameCount; frame++)
+    {
+        WorkStealingThreadPool::TaskGroup frameGroup(pool);
+        frameGroup.Run([&]()
+        {
+            WorkStealingThreadPool::TaskGroup tiles(pool);
+            for (uint32_t tile = 0; tile < TilesPerRow * TilesPerRow; tile++)
+            {
+                tiles.Run([&, tile]() { BlurTile(source, destination, tile); });
+            }
+            tiles.Wait();
+        }, WorkStealingThreadPool::Priority::Capture);
+        frameGroup.Wait();
+    }
+    end = std::chrono::steady_clock::now();
+    result.nestedMs = std::chrono::duration<double, std::milli>(end - begin).count() / frameCount;
+    isCorrect = isCorrect && destination == expected;
+
+    if (!isCorrect)
+    {
+        std::fprintf(stderr, "Error: blurred image differs from the reference with %u workers\n", workerCount);
+        std::exit(1);
+    }
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t frameCount = argc > 1 ? (uint32_t)std::max(1, atoi(argv[1])) : 50;
+
+    std::vector<float> source((size_t)ImageSize * ImageSize);
+    for (size_t i = 0; i < source.size(); i++)
+    {
+        source[i] = (float)((i * 2654435761u) % 256);
+    }
+    std::vector<float> expected(source.size());
+    for (uint32_t tile = 0; tile < TilesPerRow * TilesPerRow; tile++)
+    {
+        BlurTile(source, expected, tile);
+    }
+
+    // Worker counts doubling up to the logical processors
+    uint32_t processorCount = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<uint32_t> workerCounts;
+    for (uint32_t workerCount = 1; workerCount < processorCount; workerCount *= 2)
+    {
+        workerCounts.push_back(workerCount);
+    }
+    workerCounts.push_back(processorCount);
+
+    std::printf("%u frames of %u tiles per run, %u logical processors\n", frameCount, TilesPerRow * TilesPerRow, processorCount);
+    std::printf("workers | flat ms/frame | speedup | efficiency | nested ms/frame | speedup | efficiency\n");
+    RunResult baseline = {};
+    for (auto workerCount : workerCounts)
+    {
+        Run(workerCount, std::max(1u, frameCount / 10), source, expected); // warm up
+        RunResult result = Run(workerCount, frameCount, source, expected);
+        if (workerCount == 1)
+        {
+            baseline = result;
+        }
+        double flatSpeedup = baseline.flatMs / result.flatMs;
+        double nestedSpeedup = baseline.nestedMs / result.nestedMs;
+        std::printf("%7u | %13.3f | %6.2fx | %9.0f%% | %15.3f | %6.2fx | %9.0f%%\n",
+            workerCount,
+            result.flatMs, flatSpeedup, 100.0 * flatSpeedup / workerCount,
+            result.nestedMs, nestedSpeedup, 100.0 * nestedSpeedup / workerCount);
+    }
+    return 0;
+}
@@ -0,0 +1,350 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "TestCheck.h"
+#include "WorkStealingThreadPool.h"
+
+using Priority = WorkStealingThreadPool::Priority;
+using TaskGroup = WorkStealingThreadPool::TaskGroup;
+
+// Worker counts from 1 to a few more than the logical processors, so that workers also get preempted
+static std::vector<uint32_t> WorkerCounts()
+{
+    uint32_t maxWorkerCount = std::max(4u, std::thread::hardware_concurrency() + 2);
+    std::vector<uint32_t> workerCounts;
+    for (uint32_t workerCount = 1; workerCount < maxWorkerCount; workerCount *= 2)
+    {
+        workerCounts.push_back(workerCount);
+    }
+    workerCounts.push_back(maxWorkerCount);
+    return workerCounts;
+}
+
+static WorkStealingThreadPool::Options PoolOptions(uint32_t workerCount)
+{
+    WorkStealingThreadPool::Options options;
+    options.workerCount = workerCount;
+    return options;
+}
+
+//
+// Gate holding tasks until it is opened, to fill the queues of a pool before its workers look them up
+//
+class Gate
+{
+public:
+    void Open()
+    {
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            m_isOpen = true;
+        }
+        m_opened.notify_all();
+    }
+
+    void Wait()
+    {
+        std::unique_lock<std::mutex> guard(m_lock);
+        m_opened.wait(guard, [this]() { return m_isOpen; });
+    }
+
+private:
+    std::mutex m_lock;
+    std::condition_variable m_opened;
+    bool m_isOpen = false;
+};
+
+//
+// The owner takes and thieves steal every item exactly once, while the ring grows under them
+//
+static void DequeHandsOutEveryItemOnce()
+{
+    const uint32_t itemCount = 200000;
+    const uint32_t thiefCount = 3;
+    ChaseLevDeque<uint32_t> deque(2);
+    std::unique_ptr<std::atomic<uint32_t>[]> seenCounts(new std::atomic<uint32_t>[itemCount]);
+    for (uint32_t i = 0; i < itemCount; i++)
+    {
+        seenCounts[i] = 0;
+    }
+
+    std::atomic<bool> isDone = false;
+    std::atomic<uint32_t> stolenCount = 0;
+    std::vector<std::thread> thieves;
+    for (uint32_t i = 0; i < thiefCount; i++)
+    {
+        thieves.emplace_back([&]()
+        {
+            uint32_t item = 0;
+            while (!isDone)
+            {
+                if (deque.Steal(item))
+                {
+                    seenCounts[item]++;
+                    stolenCount++;
+                }
+            }
+        });
+    }
+
+    // Push in bursts and take part of each one back, so that Take races thieves for the last items
+    uint32_t item = 0;
+    for (uint32_t next = 0; next < itemCount;)
+    {
+        for (uint32_t burstEnd = std::min<uint32_t>(next + 1000, itemCount); next < burstEnd; next++)
+        {
+            deque.Push(next);
+        }
+        for (uint32_t i = 0; i < 600 && deque.Take(item); i++)
+        {
+            seenCounts[item]++;
+        }
+    }
+    while (deque.Take(item))
+    {
+        seenCounts[item]++;
+    }
+    isDone = true;
+    for (auto&& thief : thieves)
+    {
+        thief.join();
+    }
+
+    for (uint32_t i = 0; i < itemCount; i++)
+    {
+        TEST_CHECK(seenCounts[i] == 1);
+    }
+    TEST_CHECK(deque.Size() == 0);
+}
+
+//
+// Tasks submitted from outside the pool and from its workers all run, whatever the amount of workers
+//
+static void RunsEveryTask()
+{
+    for (auto workerCount : WorkerCounts())
+    {
+        WorkStealingThreadPool pool(PoolOptions(workerCount));
+        TEST_CHECK(pool.WorkerCount() == workerCount);
+        TEST_CHECK(!pool.IsWorkerThread());
+
+        std::atomic<uint32_t> runCount = 0;
+        std::atomic<uint32_t> workerThreadCount = 0;
+        TaskGroup group(pool);
+        for (uint32_t i = 0; i < 2000; i++)
+        {
+            group.Run([&]()
+            {
+                runCount++;
+                workerThreadCount += pool.IsWorkerThread() ? 1 : 0;
+
+                // Submitted from a worker, lands on its own deque where others steal it
+                pool.Submit([&]() { runCount++; }, Priority::Logging);
+            }, (Priority)(i % (uint32_t)Priority::Count));
+        }
+        group.Wait();
+        TEST_CHECK(workerThreadCount == 2000);
+
+        // Tasks submitted without a group run before the pool is destroyed
+        for (uint32_t i = 0; i < 2000; i++)
+        {
+            pool.Submit([&]() { runCount++; });
+        }
+        while (runCount < 6000)
+        {
+            pool.RunPendingTask();
+            std::this_thread::yield();
+        }
+        TEST_CHECK(runCount == 6000);
+    }
+
+    std::atomic<uint32_t> runCount = 0;
+    {
+        WorkStealingThreadPool pool(PoolOptions(2));
+        for (uint32_t i = 0; i < 5000; i++)
+        {
+            pool.Submit([&]() { runCount++; });
+        }
+    }
+    TEST_CHECK(runCount == 5000);
+}
+
+//
+// Fork into a tree of nested task groups, each level waiting on its children from a worker
+//
+static uint64_t CountLeaves(WorkStealingThreadPool& pool, uint32_t depth)
+{
+    if (depth == 0)
+    {
+        return 1;
+    }
+    std::atomic<uint64_t> leafCount = 0;
+    TaskGroup children(pool);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        children.Run([&]() { leafCount += CountLeaves(pool, depth - 1); });
+    }
+    children.Wait();
+    return leafCount;
+}
+
+static void NestedTaskGroupsComplete()
+{
+    // With a single worker, waiting groups must run the tasks of their children rather than block the worker
+    for (auto workerCount : WorkerCounts())
+    {
+        WorkStealingThreadPool pool(PoolOptions(workerCount));
+        std::atomic<uint64_t> leafCount = 0;
+        TaskGroup root(pool);
+        root.Run([&]() { leafCount = CountLeaves(pool, 6); });
+        root.Wait();
+        TEST_CHECK(leafCount == 4096);
+    }
+}
+
+//
+// Higher priority tasks queued at the same time run first, from the shared queues and from the deque of a worker
+//
+static void HigherPrioritiesRunFirst()
+{
+    WorkStealingThreadPool pool(PoolOptions(1));
+    std::mutex orderLock;
+    std::vector<Priority> order;
+    auto record = [&](Priority priority)
+    {
+        std::lock_guard<std::mutex> guard(orderLock);
+        order.push_back(priority);
+    };
+
+    // The only worker is held while tasks of every priority are queued from outside the pool, lowest first
+    Gate gate;
+    TaskGroup group(pool);
+    group.Run([&]() { gate.Wait(); }, Priority::Capture);
+    for (auto priority : { Priority::Logging, Priority::Evaluate, Priority::Capture })
+    {
+        for (uint32_t i = 0; i < 10; i++)
+        {
+            group.Run([&record, priority]() { record(priority); }, priority);
+        }
+    }
+    gate.Open();
+    group.Wait();
+    TEST_CHECK(order.size() == 30);
+    TEST_CHECK(std::is_sorted(order.begin(), order.end()));
+
+    // Same from a worker, whose tasks go to its own deques
+    order.clear();
+    group.Run([&]()
+    {
+        for (auto priority : { Priority::Logging, Priority::Evaluate, Priority::Capture })
+        {
+            for (uint32_t i = 0; i < 10; i++)
+            {
+                pool.Submit([&record, priority]() { record(priority); }, priority);
+            }
+        }
+    });
+    group.Wait();
+    while (true)
+    {
+        std::lock_guard<std::mutex> guard(orderLock);
+        if (order.size() == 30)
+        {
+            TEST_CHECK(std::is_sorted(order.begin(), order.end()));
+            break;
+        }
+    }
+}
+
+//
+// The first exception of a group is rethrown by Wait() once all its tasks completed, through nested groups too
+//
+static void WaitRethrowsTaskException()
+{
+    for (auto workerCount : WorkerCounts())
+    {
+        WorkStealingThreadPool pool(PoolOptions(workerCount));
+        std::atomic<uint32_t> runCount = 0;
+        {
+            TaskGroup group(pool);
+            for (uint32_t i = 0; i < 100; i++)
+            {
+                group.Run([&runCount, i]()
+                {
+                    runCount++;
+                    if (i % 10 == 3)
+                    {
+                        throw std::runtime_error("Error: task failed");
+                    }
+                });
+            }
+            TEST_CHECK_THROWS(group.Wait(), std::runtime_error);
+            TEST_CHECK(runCount == 100);
+
+            // The failure is reported once, the group can be reused
+            group.Wait();
+            group.Run([&]() { runCount++; });
+            group.Wait();
+            TEST_CHECK(runCount == 101);
+            runCount = 100;
+        }
+
+        TaskGroup outer(pool);
+        outer.Run([&]()
+        {
+            TaskGroup inner(pool);
+            inner.Run([]() { throw std::invalid_argument("Error: inner task failed"); });
+            inner.Run([&]() { runCount++; });
+            inner.Wait();
+            runCount += 1000;
+        });
+        TEST_CHECK_THROWS(outer.Wait(), std::invalid_argument);
+        TEST_CHECK(runCount == 101);
+
+        // A group left without an explicit Wait() swallows the exception but still waits for its tasks
+        {
+            TaskGroup group(pool);
+            group.Run([]() { throw std::runtime_error("Error: unobserved"); });
+            group.Run([&]() { runCount++; });
+        }
+        TEST_CHECK(runCount == 102);
+    }
+}
+
+//
+// Pinned and NUMA aware pools place their workers and run tasks like the others
+//
+static void PinnedWorkersRunTasks()
+{
+    for (bool numaAware : { false, true })
+    {
+        WorkStealingThreadPool::Options options = PoolOptions(std::max(2u, std::thread::hardware_concurrency()));
+        options.pinWorkers = true;
+        options.numaAware = numaAware;
+        WorkStealingThreadPool pool(options);
+        std::atomic<uint64_t> leafCount = 0;
+        TaskGroup group(pool);
+        group.Run([&]() { leafCount = CountLeaves(pool, 5); });
+        group.Wait();
+        TEST_CHECK(leafCount == 1024);
+    }
+}
+
+int main()
+{
+    TEST_RUN(DequeHandsOutEveryItemOnce);
+    TEST_RUN(RunsEveryTask);
+    TEST_RUN(NestedTaskGroupsComplete);
+    TEST_RUN(HigherPrioritiesRunFirst);
+    TEST_RUN(WaitRethrowsTaskException);
+    TEST_RUN(PinnedWorkersRunTasks);
+    return 0;
+}
@@ -0,0 +1,244 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+//
+// Low-overhead tracing of the hot path of the samples: each thread records begin/end events tagged with the
+// identifier of the frame being processed into its own fixed-size ring buffer, without locking.
+// All recorded events can then be dumped in the Chrome trace event JSON format that can be loaded into
+// https://ui.perfetto.dev or chrome://tracing.
+//
+// Tracing is compiled out unless SKILLS_SAMPLES_ENABLE_TRACING is defined, otherwise the macros below expand to nothing:
+//   SAMPLES_TRACE_SCOPE("name")          records a begin event now and the matching end event when leaving the current scope
+//   SAMPLES_TRACE_SET_FRAME_ID(frameId)  tags the events subsequently recorded on the calling thread with frameId
+//   SAMPLES_TRACE_FRAME_ID()             frame identifier of the calling thread, to hand work over to another thread (0 when compiled out)
+//   SAMPLES_TRACE_THREAD_NAME("name")    names the calling thread in the trace
+//   SAMPLES_TRACE_DUMP("file.json")      writes all recorded events to a file and reports it on the console
+// Event names must be string literals or otherwise outlive the trace since only their address is recorded.
+//
+#ifdef SKILLS_SAMPLES_ENABLE_TRACING
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Amount of events each thread keeps before overwriting its oldest ones
+#ifndef SKILLS_SAMPLES_TRACE_BUFFER_SIZE
+#define SKILLS_SAMPLES_TRACE_BUFFER_SIZE 16384
+#endif
+
+namespace Tracing
+{
+    struct Event
+    {
+        const char* name;
+        int64_t timestamp; // nanoseconds since the trace origin
+        uint64_t frameId;
+        char phase; // 'B'egin or 'E'nd
+    };
+
+    //
+    // Ring buffer of events written by a single thread
+    //
+    struct ThreadBuffer
+    {
+        ThreadBuffer(uint32_t threadId)
+            : threadId(threadId),
+            events(SKILLS_SAMPLES_TRACE_BUFFER_SIZE)
+        {
+        }
+
+        const uint32_t threadId;
+        std::string threadName;
+        std::vector<Event> events;
+        std::atomic<uint64_t> writeCount = 0; // total amount of events ever written
+    };
+
+    //
+    // Buffers of all threads that recorded events, kept alive after their thread exits so that their events can still be dumped
+    //
+    struct Registry
+    {
+        std::mutex lock;
+        std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+        const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+    };
+
+    inline Registry& GetRegistry()
+    {
+        static Registry registry;
+        return registry;
+    }
+
+    inline ThreadBuffer& GetThreadBuffer()
+    {
+        thread_local std::shared_ptr<ThreadBuffer> buffer;
+        if (buffer == nullptr)
+        {
+            auto& registry = GetRegistry();
+            std::lock_guard<std::mutex> guard(registry.lock);
+            buffer = std::make_shared<ThreadBuffer>((uint32_t)registry.buffers.size() + 1);
+            registry.buffers.push_back(buffer);
+        }
+        return *buffer;
+    }
+
+    inline uint64_t& CurrentFrameId()
+    {
+        thread_local uint64_t frameId = 0;
+        return frameId;
+    }
+
+    inline void SetCurrentFrameId(uint64_t frameId)
+    {
+        CurrentFrameId() = frameId;
+    }
+
+    inline void SetThreadName(const char* name)
+    {
+        auto& buffer = GetThreadBuffer();
+        std::lock_guard<std::mutex> guard(GetRegistry().lock);
+        buffer.threadName = name;
+    }
+
+    inline void Record(const char* name, char phase)
+    {
+        auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - GetRegistry().origin).count();
+        auto& buffer = GetThreadBuffer();
+        uint64_t writeCount = buffer.writeCount.load(std::memory_order_relaxed);
+        buffer.events[writeCount % buffer.events.size()] = { name, timestamp, CurrentFrameId(), phase };
+
+        // Publish the event to a concurrent dump
+        buffer.writeCount.store(writeCount + 1, std::memory_order_release);
+    }
+
+    //
+    // Records a begin event when constructed and the matching end event when destroyed
+    //
+    class ScopedEvent
+    {
+    public:
+        ScopedEvent(const char* name)
+            : m_name(name)
+        {
+            Record(m_name, 'B');
+        }
+
+        ~ScopedEvent()
+        {
+            Record(m_name, 'E');
+        }
+
+        ScopedEvent(const ScopedEvent&) = delete;
+        ScopedEvent& operator=(const ScopedEvent&) = delete;
+
+    private:
+        const char* m_name;
+    };
+
+    inline void WriteJsonString(std::ostream& output, const std::string& value)
+    {
+        output << '"';
+        for (char c : value)
+        {
+            if (c == '"' || c == '\\')
+            {
+                output << '\\' << c;
+            }
+            else if ((unsigned char)c >= 0x20)
+            {
+                output << c;
+            }
+        }
+        output << '"';
+    }
+
+    //
+    // Write all events recorded so far to a file in the Chrome trace event JSON format. Returns false if the file could not be written.
+    // Dump once the traced threads are idle (i.e. after the camera is stopped): events recorded while dumping may be torn.
+    //
+    inline bool WriteChromeTrace(const std::string& filePath)
+    {
+        std::ofstream output(filePath, std::ios::out | std::ios::trunc);
+        if (!output)
+        {
+            return false;
+        }
+
+        auto& registry = GetRegistry();
+        std::lock_guard<std::mutex> guard(registry.lock);
+
+        output << std::fixed << std::setprecision(3); // timestamps in microseconds
+        output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool isFirstEvent = true;
+        for (auto&& buffer : registry.buffers)
+        {
+            if (!buffer->threadName.empty())
+            {
+                output << (isFirstEvent ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"name\":";
+                WriteJsonString(output, buffer->threadName);
+                output << "}}";
+                isFirstEvent = false;
+            }
+
+            // Walk the ring from its oldest surviving event, skipping end events whose begin event was overwritten
+            uint64_t writeCount = buffer->writeCount.load(std::memory_order_acquire);
+            uint64_t capacity = buffer->events.size();
+            uint64_t first = writeCount > capacity ? writeCount - capacity : 0;
+            int depth = 0;
+            for (uint64_t i = first; i < writeCount; i++)
+            {
+                auto& event = buffer->events[i % capacity];
+                if (event.phase == 'E' && depth == 0)
+                {
+                    continue;
+                }
+                depth += (event.phase == 'B') ? 1 : -1;
+
+                output << (isFirstEvent ? "" : ",") << "\n{\"name\":";
+                WriteJsonString(output, event.name);
+                output << ",\"ph\":\"" << event.phase << "\",\"ts\":" << event.timestamp / 1000.0
+                    << ",\"pid\":1,\"tid\":" << buffer->threadId << ",\"args\":{\"frame\":" << event.frameId << "}}";
+                isFirstEvent = false;
+            }
+        }
+        output << "\n]}\n";
+        return output.good();
+    }
+
+    inline void DumpChromeTrace(const std::string& filePath)
+    {
+        if (WriteChromeTrace(filePath))
+        {
+            std::cout << "Trace written to " << filePath << std::endl;
+        }
+        else
+        {
+            std::cerr << "Could not write trace to " << filePath << std::endl;
+        }
+    }
+};
+
+#define SAMPLES_TRACE_CONCAT_INNER(a, b) a##b
+#define SAMPLES_TRACE_CONCAT(a, b) SAMPLES_TRACE_CONCAT_INNER(a, b)
+#define SAMPLES_TRACE_SCOPE(name) Tracing::ScopedEvent SAMPLES_TRACE_CONCAT(traceScope, __COUNTER__)(name)
+#define SAMPLES_TRACE_SET_FRAME_ID(frameId) Tracing::SetCurrentFrameId(frameId)
+#define SAMPLES_TRACE_FRAME_ID() Tracing::CurrentFrameId()
+#define SAMPLES_TRACE_THREAD_NAME(name) Tracing::SetThreadName(name)
+#define SAMPLES_TRACE_DUMP(filePath) Tracing::DumpChromeTrace(filePath)
+
+#else
+
+#define SAMPLES_TRACE_SCOPE(name)
+#define SAMPLES_TRACE_SET_FRAME_ID(frameId)
+#define SAMPLES_TRACE_FRAME_ID() ((uint64_t)0)
+#define SAMPLES_TRACE_THREAD_NAME(name)
+#define SAMPLES_TRACE_DUMP(filePath)
+
+#endif
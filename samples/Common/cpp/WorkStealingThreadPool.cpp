@@ -0,0 +1,395 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "WorkStealingThreadPool.h"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+//
+// Logical processors of each NUMA node, a single node holding all processors when the topology is not available.
+// On Windows, only the processor group of the process is considered.
+//
+std::vector<std::vector<uint32_t>> WorkStealingThreadPool::GetNumaNodeProcessors()
+{
+    std::vector<std::vector<uint32_t>> nodes;
+#ifdef _WIN32
+    ULONG highestNode = 0;
+    if (GetNumaHighestNodeNumber(&highestNode))
+    {
+        for (ULONG node = 0; node <= highestNode; node++)
+        {
+            ULONGLONG processorMask = 0;
+            if (GetNumaNodeProcessorMask((UCHAR)node, &processorMask) && processorMask != 0)
+            {
+                std::vector<uint32_t> processors;
+                for (uint32_t processor = 0; processor < 64; processor++)
+                {
+                    if (processorMask & (1ull << processor))
+                    {
+                        processors.push_back(processor);
+                    }
+                }
+                nodes.push_back(processors);
+            }
+        }
+    }
+#else
+    // Each node lists its processors as ranges, i.e. "0-3,8-11"
+    for (uint32_t node = 0; node < 64; node++)
+    {
+        std::ifstream cpuList("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!cpuList.is_open())
+        {
+            continue;
+        }
+        std::vector<uint32_t> processors;
+        std::string range;
+        while (std::getline(cpuList, range, ','))
+        {
+            uint32_t first = 0;
+            uint32_t last = 0;
+            char separator = 0;
+            std::istringstream rangeStream(range);
+            if (!(rangeStream >> first))
+            {
+                continue;
+            }
+            last = (rangeStream >> separator >> last) ? last : first;
+            for (uint32_t processor = first; processor <= last; processor++)
+            {
+                processors.push_back(processor);
+            }
+        }
+        if (!processors.empty())
+        {
+            nodes.push_back(processors);
+        }
+    }
+#endif
+    if (nodes.empty())
+    {
+        nodes.emplace_back();
+        for (uint32_t processor = 0; processor < std::max(1u, std::thread::hardware_concurrency()); processor++)
+        {
+            nodes.back().push_back(processor);
+        }
+    }
+    return nodes;
+}
+
+void WorkStealingThreadPool::PinCurrentThread(int32_t processor)
+{
+    if (processor < 0)
+    {
+        return;
+    }
+#ifdef _WIN32
+    if (processor < 64)
+    {
+        SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << processor);
+    }
+#else
+    cpu_set_t processorSet;
+    CPU_ZERO(&processorSet);
+    CPU_SET(processor, &processorSet);
+    pthread_setaffinity_np(pthread_self(), sizeof(processorSet), &processorSet);
+#endif
+}
+
+WorkStealingThreadPool& WorkStealingThreadPool::Default()
+{
+    static WorkStealingThreadPool pool;
+    return pool;
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool()
+    : WorkStealingThreadPool(Options())
+{
+}
+
+WorkStealingThreadPool::WorkStealingThreadPool(Options options)
+    : m_spinCount(options.spinCount)
+{
+    uint32_t workerCount = options.workerCount != 0 ? options.workerCount : std::max(1u, std::thread::hardware_concurrency());
+    bool pinWorkers = options.pinWorkers || options.numaAware;
+
+    // Processors in placement order: node by node when NUMA aware so that neighbor workers share a node
+    std::vector<std::vector<uint32_t>> nodes;
+    if (options.numaAware)
+    {
+        nodes = GetNumaNodeProcessors();
+    }
+    else
+    {
+        nodes.emplace_back();
+        for (uint32_t processor = 0; processor < std::max(1u, std::thread::hardware_concurrency()); processor++)
+        {
+            nodes.back().push_back(processor);
+        }
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> placements; // processor and node
+    for (uint32_t node = 0; node < nodes.size(); node++)
+    {
+        for (auto processor : nodes[node])
+        {
+            placements.push_back({ processor, node });
+        }
+    }
+
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        auto worker = std::make_unique<Worker>();
+        auto& placement = placements[i % placements.size()];
+        worker->processor = pinWorkers ? (int32_t)placement.first : -1;
+        worker->numaNode = options.numaAware ? placement.second : 0;
+        m_workers.push_back(std::move(worker));
+    }
+
+    // Each worker steals from its neighbors first, starting with the ones on its own node
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        auto& victims = m_workers[i]->victims;
+        for (uint32_t offset = 1; offset < workerCount; victims.push_back((i + offset++) % workerCount));
+        std::stable_partition(victims.begin(), victims.end(), [&](uint32_t victim)
+        {
+            return m_workers[victim]->numaNode == m_workers[i]->numaNode;
+        });
+    }
+
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        m_workers[i]->thread = std::thread([this, i]() { WorkerLoop(i); });
+    }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> guard(m_sleepLock);
+        m_isStopping = true;
+    }
+    m_wakeUp.notify_all();
+    for (auto&& worker : m_workers)
+    {
+        worker->thread.join();
+    }
+}
+
+void WorkStealingThreadPool::Submit(Task task, Priority priority)
+{
+    auto queuedTask = new Task(std::move(task));
+    auto& context = CurrentWorker();
+    if (context.pool == this)
+    {
+        m_workers[context.workerIndex]->deques[(uint32_t)priority].Push(queuedTask);
+    }
+    else
+    {
+        std::lock_guard<std::mutex> guard(m_sharedLock);
+        m_sharedTasks[(uint32_t)priority].push_back(queuedTask);
+        m_sharedTaskCounts[(uint32_t)priority]++;
+    }
+
+    // Pairs with the sleeping count increment of WorkerLoop(): either the worker sees the task or the submitter sees the worker
+    m_queuedTaskCount.fetch_add(1, std::memory_order_seq_cst);
+    if (m_sleepingWorkerCount.load(std::memory_order_seq_cst) > 0)
+    {
+        {
+            std::lock_guard<std::mutex> guard(m_sleepLock);
+        }
+        m_wakeUp.notify_one();
+    }
+}
+
+bool WorkStealingThreadPool::RunPendingTask()
+{
+    auto& context = CurrentWorker();
+    Task* task = FindTask(context.pool == this ? context.workerIndex : NoWorker);
+    if (task == nullptr)
+    {
+        return false;
+    }
+    RunTask(task);
+    return true;
+}
+
+//
+// Look up the highest priority task: own deque first, then tasks submitted from outside the pool, then other workers
+//
+WorkStealingThreadPool::Task* WorkStealingThreadPool::FindTask(uint32_t workerIndex)
+{
+    Task* task = nullptr;
+    for (uint32_t priority = 0; priority < PriorityCount; priority++)
+    {
+        if (workerIndex != NoWorker && m_workers[workerIndex]->deques[priority].Take(task))
+        {
+            break;
+        }
+        task = nullptr; // a lost race still loads the item
+
+        if (m_sharedTaskCounts[priority].load(std::memory_order_relaxed) > 0)
+        {
+            std::lock_guard<std::mutex> guard(m_sharedLock);
+            if (!m_sharedTasks[priority].empty())
+            {
+                task = m_sharedTasks[priority].front();
+                m_sharedTasks[priority].pop_front();
+                m_sharedTaskCounts[priority]--;
+                break;
+            }
+        }
+
+        if (workerIndex != NoWorker)
+        {
+            for (auto victim : m_workers[workerIndex]->victims)
+            {
+                if (m_workers[victim]->deques[priority].Steal(task))
+                {
+                    break;
+                }
+                task = nullptr;
+            }
+        }
+        else
+        {
+            uint32_t firstVictim = m_nextVictim++;
+            for (uint32_t i = 0; i < m_workers.size() && task == nullptr; i++)
+            {
+                if (!m_workers[(firstVictim + i) % m_workers.size()]->deques[priority].Steal(task))
+                {
+                    task = nullptr;
+                }
+            }
+        }
+        if (task != nullptr)
+        {
+            break;
+        }
+    }
+
+    if (task != nullptr)
+    {
+        m_queuedTaskCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+void WorkStealingThreadPool::RunTask(Task* task)
+{
+    std::unique_ptr<Task> ownedTask(task);
+    (*ownedTask)();
+}
+
+void WorkStealingThreadPool::WorkerLoop(uint32_t workerIndex)
+{
+    PinCurrentThread(m_workers[workerIndex]->processor);
+    CurrentWorker() = { this, workerIndex };
+
+    uint32_t failedLookupCount = 0;
+    while (true)
+    {
+        Task* task = FindTask(workerIndex);
+        if (task != nullptr)
+        {
+            RunTask(task);
+            failedLookupCount = 0;
+            continue;
+        }
+        if (m_isStopping && m_queuedTaskCount.load() == 0)
+        {
+            break;
+        }
+
+        // Frame tasks tend to come in bursts, spin a little before paying for a sleep and a wake up
+        if (++failedLookupCount < m_spinCount)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        failedLookupCount = 0;
+
+        std::unique_lock<std::mutex> guard(m_sleepLock);
+        m_sleepingWorkerCount.fetch_add(1, std::memory_order_seq_cst);
+        m_wakeUp.wait(guard, [this]() { return m_queuedTaskCount.load(std::memory_order_seq_cst) > 0 || m_isStopping; });
+        m_sleepingWorkerCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    CurrentWorker() = {};
+}
+
+WorkStealingThreadPool::TaskGroup::~TaskGroup()
+{
+    try
+    {
+        Wait();
+    }
+    catch (...)
+    {
+        // Failures are only reported to explicit Wait() calls
+    }
+}
+
+void WorkStealingThreadPool::TaskGroup::Run(Task task, Priority priority)
+{
+    m_pendingTaskCount++;
+    m_pool.Submit([this, task = std::move(task)]()
+    {
+        try
+        {
+            task();
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> guard(m_lock);
+            if (m_exception == nullptr)
+            {
+                m_exception = std::current_exception();
+            }
+        }
+
+        // Completed under the lock so that the group cannot be destroyed by a waiter before the notification
+        std::lock_guard<std::mutex> guard(m_lock);
+        if (--m_pendingTaskCount == 0)
+        {
+            m_completed.notify_all();
+        }
+    }, priority);
+}
+
+void WorkStealingThreadPool::TaskGroup::Wait()
+{
+    // A worker waiting on its own pool keeps running tasks, otherwise tasks of the group could be queued behind it
+    if (m_pool.IsWorkerThread())
+    {
+        while (m_pendingTaskCount > 0)
+        {
+            if (!m_pool.RunPendingTask())
+            {
+                std::unique_lock<std::mutex> guard(m_lock);
+                m_completed.wait_for(guard, std::chrono::milliseconds(1), [this]() { return m_pendingTaskCount == 0; });
+            }
+        }
+    }
+
+    std::unique_lock<std::mutex> guard(m_lock);
+    m_completed.wait(guard, [this]() { return m_pendingTaskCount == 0; });
+    if (m_exception != nullptr)
+    {
+        // Reported once, so that the group can be reused
+        std::exception_ptr exception = nullptr;
+        std::swap(exception, m_exception);
+        std::rethrow_exception(exception);
+    }
+}
@@ -0,0 +1,273 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+//
+// Lock-free work-stealing deque (Chase and Lev, with the C11 memory orderings of Le et al.).
+// Only the owner thread pushes and takes items at the bottom, any other thread can steal items from the top,
+// so the owner works on the most recent, cache-hot items while thieves pick up the oldest ones.
+// The ring grows when full. Previous rings stay alive until the deque is destroyed since a thief may still read them.
+//
+template <typename T>
+class ChaseLevDeque
+{
+    static_assert(std::is_trivially_copyable<T>::value, "ChaseLevDeque items must be trivially copyable");
+
+public:
+    // capacity is rounded up to the next power of 2
+    explicit ChaseLevDeque(size_t capacity = 256)
+    {
+        size_t slotCount = 2;
+        while (slotCount < capacity)
+        {
+            slotCount *= 2;
+        }
+        m_rings.emplace_back(new Ring(slotCount));
+        m_ring.store(m_rings.back().get(), std::memory_order_relaxed);
+    }
+
+    ChaseLevDeque(const ChaseLevDeque&) = delete;
+    ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+    //
+    // Add an item at the bottom, owner thread only
+    //
+    void Push(T item)
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_acquire);
+        Ring* ring = m_ring.load(std::memory_order_relaxed);
+        if (bottom - top > (int64_t)ring->mask)
+        {
+            ring = Grow(ring, top, bottom);
+        }
+        ring->Store(bottom, item);
+        m_bottom.store(bottom + 1, std::memory_order_release);
+    }
+
+    //
+    // Remove the most recent item from the bottom, owner thread only. Returns false if the deque is empty.
+    //
+    bool Take(T& item)
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        Ring* ring = m_ring.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+        if (top > bottom)
+        {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return false;
+        }
+        item = ring->Load(bottom);
+        if (top == bottom)
+        {
+            // Last item, race thieves for it
+            bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    //
+    // Remove the oldest item from the top, any thread. Returns false if the deque is empty or another thread won the item.
+    //
+    bool Steal(T& item)
+    {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom)
+        {
+            return false;
+        }
+        Ring* ring = m_ring.load(std::memory_order_acquire);
+        item = ring->Load(top);
+        return m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    }
+
+    // Approximate amount of items, exact only from the owner thread when no thief is active
+    size_t Size() const
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+        return bottom > top ? (size_t)(bottom - top) : 0;
+    }
+
+private:
+    struct Ring
+    {
+        explicit Ring(size_t slotCount)
+            : mask(slotCount - 1),
+            slots(new std::atomic<T>[slotCount])
+        {
+        }
+
+        T Load(int64_t index) const { return slots[(size_t)index & mask].load(std::memory_order_relaxed); }
+        void Store(int64_t index, T item) { slots[(size_t)index & mask].store(item, std::memory_order_relaxed); }
+
+        size_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Ring* Grow(Ring* ring, int64_t top, int64_t bottom)
+    {
+        m_rings.emplace_back(new Ring((ring->mask + 1) * 2));
+        Ring* grownRing = m_rings.back().get();
+        for (int64_t i = top; i < bottom; i++)
+        {
+            grownRing->Store(i, ring->Load(i));
+        }
+        m_ring.store(grownRing, std::memory_order_release);
+        return grownRing;
+    }
+
+    alignas(64) std::atomic<int64_t> m_top = 0;
+    alignas(64) std::atomic<int64_t> m_bottom = 0;
+    std::atomic<Ring*> m_ring = nullptr;
+    std::vector<std::unique_ptr<Ring>> m_rings; // owner thread only
+};
+
+//
+// Thread pool tuned for short per-frame tasks such as evaluating a skill binding or processing a tile.
+// Each worker owns one ChaseLevDeque per priority: tasks submitted from a worker go to its own deque and are run
+// most recent first, idle workers steal the oldest tasks of the others, and tasks submitted from any other thread
+// (i.e. the camera frame callback) go through a shared queue. Higher priorities are always looked up first
+// across all these queues, so capture work is never stuck behind logging.
+//
+// Workers can optionally be pinned to a logical processor each. With NUMA awareness, workers are placed node by node
+// and steal from workers of their own node before reaching across nodes.
+//
+// Submitted tasks must not throw, an escaping exception terminates the process like it would from a std::thread.
+// TaskGroup captures exceptions and rethrows the first one from Wait().
+//
+class WorkStealingThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    enum class Priority : uint32_t
+    {
+        Capture = 0,
+        Evaluate,
+        Logging,
+        Count
+    };
+
+    struct Options
+    {
+        uint32_t workerCount = 0; // 0 for one worker per logical processor
+        bool pinWorkers = false; // pin each worker to its own logical processor
+        bool numaAware = false; // pin workers node by node and prefer stealing within a node, implies pinWorkers
+        uint32_t spinCount = 64; // amount of failed lookups before an idle worker goes to sleep
+    };
+
+    //
+    // Set of tasks that can be waited on together
+    //
+    class TaskGroup
+    {
+    public:
+        explicit TaskGroup(WorkStealingThreadPool& pool) : m_pool(pool) {}
+        ~TaskGroup();
+
+        TaskGroup(const TaskGroup&) = delete;
+        TaskGroup& operator=(const TaskGroup&) = delete;
+
+        void Run(Task task, Priority priority = Priority::Evaluate);
+
+        // Wait for all tasks of the group and rethrow the first exception they raised since the previous Wait().
+        // When called from a worker of the pool, runs pending tasks instead of blocking it.
+        void Wait();
+
+    private:
+        WorkStealingThreadPool& m_pool;
+        std::atomic<uint32_t> m_pendingTaskCount = 0;
+        std::exception_ptr m_exception = nullptr;
+        std::mutex m_lock;
+        std::condition_variable m_completed;
+    };
+
+    WorkStealingThreadPool();
+    explicit WorkStealingThreadPool(Options options);
+
+    // Runs the tasks still queued, then joins the workers
+    ~WorkStealingThreadPool();
+
+    WorkStealingThreadPool(const WorkStealingThreadPool&) = delete;
+    WorkStealingThreadPool& operator=(const WorkStealingThreadPool&) = delete;
+
+    void Submit(Task task, Priority priority = Priority::Evaluate);
+
+    // Run one queued task on the calling thread, returns false if none was found
+    bool RunPendingTask();
+
+    uint32_t WorkerCount() const { return (uint32_t)m_workers.size(); }
+
+    // True when called from one of the workers of this pool
+    bool IsWorkerThread() const { return CurrentWorker().pool == this; }
+
+    // Pool shared by the samples, one worker per logical processor
+    static WorkStealingThreadPool& Default();
+
+private:
+    static constexpr uint32_t PriorityCount = (uint32_t)Priority::Count;
+    static constexpr uint32_t NoWorker = UINT32_MAX;
+
+    struct alignas(64) Worker
+    {
+        ChaseLevDeque<Task*> deques[PriorityCount];
+        std::thread thread;
+        int32_t processor = -1; // logical processor the worker is pinned to, -1 if not pinned
+        uint32_t numaNode = 0;
+        std::vector<uint32_t> victims; // workers to steal from, same NUMA node first
+    };
+
+    struct WorkerContext
+    {
+        const WorkStealingThreadPool* pool = nullptr;
+        uint32_t workerIndex = NoWorker;
+    };
+
+    static WorkerContext& CurrentWorker()
+    {
+        static thread_local WorkerContext context;
+        return context;
+    }
+
+    static std::vector<std::vector<uint32_t>> GetNumaNodeProcessors();
+    static void PinCurrentThread(int32_t processor);
+
+    Task* FindTask(uint32_t workerIndex);
+    void RunTask(Task* task);
+    void WorkerLoop(uint32_t workerIndex);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    uint32_t m_spinCount = 0;
+
+    // Tasks submitted from outside the pool, one queue per priority
+    std::mutex m_sharedLock;
+    std::deque<Task*> m_sharedTasks[PriorityCount];
+    std::atomic<uint32_t> m_sharedTaskCounts[PriorityCount] = {}; // lets lookups skip the lock when a queue is empty
+    std::atomic<uint32_t> m_nextVictim = 0; // first worker stolen from by threads outside the pool
+
+    // Idle workers sleep until a task is submitted. Submitters only take the lock when a worker may be sleeping.
+    alignas(64) std::atomic<int64_t> m_queuedTaskCount = 0;
+    alignas(64) std::atomic<uint32_t> m_sleepingWorkerCount = 0;
+    std::atomic<bool> m_isStopping = false;
+    std::mutex m_sleepLock;
+    std::condition_variable m_wakeUp;
+};
@@ -11,6 +11,7 @@
 #include <winrt/Windows.Storage.Streams.h>
 #include <winrt/Windows.Graphics.Imaging.h>
 
+#include "Tracing.h"
 #include "WindowsVersionHelper.h"
 #include "winrt/Microsoft.AI.Skills.SkillInterface.h"
 #include "winrt/Microsoft.AI.Skills.Vision.ConceptTagger.h"
@@ -134,17 +135,30 @@ int main()
             auto binding = skill.CreateSkillBindingAsync().get().as<ConceptTaggerBinding>();
 
             // Set the input image retrieved from file earlier
-            binding.SetInputImageAsync(videoFrame).get();
+            {
+                SAMPLES_TRACE_SCOPE("Bind");
+                binding.SetInputImageAsync(videoFrame).get();
+            }
 
             // Evaluate the binding
-            skill.EvaluateAsync(binding).get();
+            {
+                SAMPLES_TRACE_SCOPE("Evaluate");
+                skill.EvaluateAsync(binding).get();
+            }
 
             // Retrieve results and display time
-            auto results = binding.GetTopXTagsAboveThreshold(topX, threshold);
+            IVectorView<ConceptTagScore> results = nullptr;
+            {
+                SAMPLES_TRACE_SCOPE("Extract");
+                results = binding.GetTopXTagsAboveThreshold(topX, threshold);
+            }
             for (auto result : results)
             {
                 std::wcout << L"\t- "  << result.Name().c_str() << L": " << winrt::to_hstring(result.Score()).c_str() << std::endl;
             }
+
+            // Write the traced events, when built with SKILLS_SAMPLES_ENABLE_TRACING
+            SAMPLES_TRACE_DUMP("ConceptTaggerSample_Desktop.trace.json");
         }
         catch (hresult_error const& ex)
         {
@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+//
+// Helper class that keeps track of the quadrangle detected over a stream of frames to seed the
+// search of the next frame with it and to tell when the quadrangle is stable enough to be scanned.
+// Corners are expressed in normalized coordinates [0,1] like QuadDetectorBinding::DetectedQuads().
+//
+class LiveQuadTracker
+{
+public:
+    struct Corner
+    {
+        float x;
+        float y;
+    };
+    using Quad = std::array<Corner, 4>;
+
+    // stabilityThreshold: maximum displacement of any corner between 2 frames, as a fraction of the image dimension, for the quad to be considered still
+    // stableFrameCount: amount of consecutive still frames required before the quad is considered stable
+    LiveQuadTracker(float stabilityThreshold, uint32_t stableFrameCount)
+        : m_stabilityThreshold(stabilityThreshold),
+        m_stableFrameCount(stableFrameCount)
+    {
+    }
+
+    //
+    // Update the tracker with the quad detected in the latest frame
+    //
+    void Update(const Quad& quad)
+    {
+        if (m_hasQuad && MaxCornerDisplacement(m_quad, quad) <= m_stabilityThreshold)
+        {
+            m_stillFrameCount++;
+        }
+        else
+        {
+            // The quad moved or was just found, any previous scan no longer applies
+            m_stillFrameCount = 0;
+            m_isCaptured = false;
+        }
+        m_quad = quad;
+        m_hasQuad = true;
+    }
+
+    //
+    // Update the tracker when no quad was detected in the latest frame
+    //
+    void Reset()
+    {
+        m_hasQuad = false;
+        m_stillFrameCount = 0;
+        m_isCaptured = false;
+    }
+
+    bool HasQuad() const { return m_hasQuad; }
+    const Quad& LastQuad() const { return m_quad; }
+
+    // The quad stayed still for long enough and was not yet scanned
+    bool ShouldCapture() const { return m_hasQuad && !m_isCaptured && m_stillFrameCount >= m_stableFrameCount; }
+    void MarkCaptured() { m_isCaptured = true; }
+
+    // Center of the last quad, used to center the lookup region of the next search
+    Corner Center() const
+    {
+        Corner center = { 0.0f, 0.0f };
+        for (auto&& corner : m_quad)
+        {
+            center.x += corner.x / 4.0f;
+            center.y += corner.y / 4.0f;
+        }
+        return center;
+    }
+
+private:
+    static float MaxCornerDisplacement(const Quad& quad1, const Quad& quad2)
+    {
+        float maxDisplacement = 0.0f;
+        for (size_t i = 0; i < quad1.size(); i++)
+        {
+            maxDisplacement = std::max(maxDisplacement, std::hypot(quad1[i].x - quad2[i].x, quad1[i].y - quad2[i].y));
+        }
+        return maxDisplacement;
+    }
+
+    float m_stabilityThreshold = 0.0f;
+    uint32_t m_stableFrameCount = 0;
+    uint32_t m_stillFrameCount = 0;
+    bool m_hasQuad = false;
+    bool m_isCaptured = false;
+    Quad m_quad = {};
+};
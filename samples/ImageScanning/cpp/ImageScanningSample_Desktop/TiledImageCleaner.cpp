@@ -0,0 +1,190 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "TiledImageCleaner.h"
+#include <algorithm>
+#include <atomic>
+
+#include "SoftwareBitmapHelper_cppwinrt.h"
+#include "Tracing.h"
+#include "WorkStealingThreadPool.h"
+
+using namespace winrt;
+using namespace winrt::Windows::Media;
+using namespace winrt::Windows::Graphics::Imaging;
+using namespace winrt::Microsoft::AI::Skills::Vision::ImageScanning;
+
+//
+// Create the set of bindings used to evaluate tiles concurrently, one per worker
+//
+TiledImageCleaner::TiledImageCleaner(
+    ImageCleanerSkill const& skill,
+    ImageCleaningKind imageCleaningKind,
+    uint32_t tileSize,
+    uint32_t tileOverlap,
+    uint32_t workerCount,
+    MemoryTracker* memoryTracker)
+    : m_skill(skill),
+    m_tileSize(tileSize),
+    m_tileOverlap(tileOverlap),
+    m_memoryTracker(memoryTracker),
+    m_activeWorkerLimit(std::max<uint32_t>(workerCount, 1))
+{
+    if (tileSize == 0)
+    {
+        throw hresult_invalid_argument(L"Error: tile size must be greater than 0");
+    }
+
+    workerCount = std::max<uint32_t>(workerCount, 1);
+    for (uint32_t i = 0; i < workerCount; i++)
+    {
+        auto binding = m_skill.CreateSkillBindingAsync().get().as<ImageCleanerBinding>();
+        binding.SetImageCleaningKindAsync(imageCleaningKind).get();
+        m_bindings.push_back(binding);
+    }
+
+    // Trade throughput for memory while over budget, each active worker holds its own tiles
+    if (m_memoryTracker != nullptr)
+    {
+        m_tileMemory = &m_memoryTracker->GetComponent("TiledImageCleaner tiles");
+        auto onPressureChanged = [this, workerCount](MemoryTracker::Pressure pressure)
+        {
+            m_activeWorkerLimit = (pressure == MemoryTracker::Pressure::High) ? 1 : workerCount;
+        };
+        m_pressureHandlerId = m_memoryTracker->AddPressureHandler(onPressureChanged);
+        onPressureChanged(m_memoryTracker->CurrentPressure());
+    }
+}
+
+TiledImageCleaner::~TiledImageCleaner()
+{
+    if (m_memoryTracker != nullptr)
+    {
+        m_memoryTracker->RemovePressureHandler(m_pressureHandlerId);
+    }
+}
+
+//
+// Split the image in a grid of tiles of m_tileSize pixels, each extended by m_tileOverlap pixels of context
+//
+std::vector<TiledImageCleaner::Tile> TiledImageCleaner::ComputeTiles(uint32_t width, uint32_t height) const
+{
+    std::vector<Tile> tiles;
+    for (uint32_t y = 0; y < height; y += m_tileSize)
+    {
+        for (uint32_t x = 0; x < width; x += m_tileSize)
+        {
+            Tile tile;
+            tile.coreBounds.X = x;
+            tile.coreBounds.Y = y;
+            tile.coreBounds.Width = std::min(m_tileSize, width - x);
+            tile.coreBounds.Height = std::min(m_tileSize, height - y);
+
+            uint32_t left = x - std::min(x, m_tileOverlap);
+            uint32_t top = y - std::min(y, m_tileOverlap);
+            uint32_t right = std::min(width, x + tile.coreBounds.Width + m_tileOverlap);
+            uint32_t bottom = std::min(height, y + tile.coreBounds.Height + m_tileOverlap);
+            tile.inputBounds = { left, top, right - left, bottom - top };
+
+            tiles.push_back(tile);
+        }
+    }
+    return tiles;
+}
+
+//
+// Clean the input image tile by tile across all workers and return the stitched result
+//
+VideoFrame TiledImageCleaner::Clean(VideoFrame const& inputImage)
+{
+    SoftwareBitmap sourceBitmap = SoftwareBitmapHelper::GetSoftwareBitmap(inputImage);
+    uint32_t width = (uint32_t)sourceBitmap.PixelWidth();
+    uint32_t height = (uint32_t)sourceBitmap.PixelHeight();
+    SoftwareBitmap stitchedBitmap(BitmapPixelFormat::Bgra8, width, height, BitmapAlphaMode::Premultiplied);
+    MemoryTracker::Allocation stitchedMemory(m_tileMemory, (uint64_t)width * height * 4);
+
+    auto tiles = ComputeTiles(width, height);
+    m_lastTileCount = (uint32_t)tiles.size();
+
+    {
+        // Lock both images once so that workers can access their pixels without further synchronization,
+        // each of them only ever writes to the disjoint core region of its tiles
+        SoftwareBitmapHelper::LockedPixels source(sourceBitmap, BitmapBufferAccessMode::Read);
+        SoftwareBitmapHelper::LockedPixels stitched(stitchedBitmap, BitmapBufferAccessMode::Write);
+
+        std::atomic<uint32_t> nextTile = 0;
+
+        // Tiles are traced as part of the frame being cleaned
+        uint64_t frameId = SAMPLES_TRACE_FRAME_ID();
+
+        // Declared last so that the tasks completing in its destructor never outlive what they reference
+        WorkStealingThreadPool::TaskGroup workers(WorkStealingThreadPool::Default());
+
+        uint32_t workerCount = std::min((uint32_t)m_bindings.size(), (uint32_t)tiles.size());
+        for (uint32_t workerIndex = 0; workerIndex < workerCount; workerIndex++)
+        {
+            // Each task owns a binding and picks tiles until none is left
+            workers.Run([&, workerIndex]()
+            {
+                SAMPLES_TRACE_SET_FRAME_ID(frameId);
+                auto binding = m_bindings[workerIndex];
+                try
+                {
+                    while (workerIndex < m_activeWorkerLimit)
+                    {
+                        uint32_t tileIndex = nextTile++;
+                        if (tileIndex >= tiles.size())
+                        {
+                            break;
+                        }
+                        const Tile& tile = tiles[tileIndex];
+
+                        // Account the input tile and the cleaned tile the binding holds
+                        MemoryTracker::Allocation tileMemory(m_tileMemory, 2ull * tile.inputBounds.Width * tile.inputBounds.Height * 4);
+
+                        // Copy the tile and its margin out of the source image and bind it
+                        {
+                            SAMPLES_TRACE_SCOPE("Tile.Bind");
+                            SoftwareBitmap tileBitmap(BitmapPixelFormat::Bgra8, tile.inputBounds.Width, tile.inputBounds.Height, BitmapAlphaMode::Premultiplied);
+                            {
+                                SoftwareBitmapHelper::LockedPixels tilePixels(tileBitmap, BitmapBufferAccessMode::Write);
+                                SoftwareBitmapHelper::CopyBgra8Region(
+                                    source.View(), tile.inputBounds.X, tile.inputBounds.Y,
+                                    tilePixels.View(), 0, 0,
+                                    tile.inputBounds.Width, tile.inputBounds.Height);
+                            }
+                            binding.SetInputImageAsync(VideoFrame::CreateWithSoftwareBitmap(tileBitmap)).get();
+                        }
+
+                        // Run ImageCleanerSkill on the tile
+                        {
+                            SAMPLES_TRACE_SCOPE("Tile.Evaluate");
+                            m_skill.EvaluateAsync(binding).get();
+                        }
+
+                        // Write back only the core region of the cleaned tile
+                        SAMPLES_TRACE_SCOPE("Tile.Extract");
+                        SoftwareBitmap cleanedBitmap = SoftwareBitmapHelper::GetSoftwareBitmap(binding.OutputImage());
+                        if ((uint32_t)cleanedBitmap.PixelWidth() != tile.inputBounds.Width
+                            || (uint32_t)cleanedBitmap.PixelHeight() != tile.inputBounds.Height)
+                        {
+                            throw hresult_error(E_UNEXPECTED, L"Error: ImageCleaner output tile size differs from its input tile size");
+                        }
+                        SoftwareBitmapHelper::LockedPixels cleanedPixels(cleanedBitmap, BitmapBufferAccessMode::Read);
+                        SoftwareBitmapHelper::CopyBgra8Region(
+                            cleanedPixels.View(), tile.coreBounds.X - tile.inputBounds.X, tile.coreBounds.Y - tile.inputBounds.Y,
+                            stitched.View(), tile.coreBounds.X, tile.coreBounds.Y,
+                            tile.coreBounds.Width, tile.coreBounds.Height);
+                    }
+                }
+                catch (...)
+                {
+                    // Stop handing out tiles, the first failure is rethrown to the caller by Wait()
+                    nextTile = (uint32_t)tiles.size();
+                    throw;
+                }
+            });
+        }
+        workers.Wait();
+    }
+
+    return VideoFrame::CreateWithSoftwareBitmap(stitchedBitmap);
+}
@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <winrt/Windows.Graphics.Imaging.h>
+#include <winrt/Windows.Media.h>
+
+#include "winrt/Microsoft.AI.Skills.Vision.ImageScanning.h"
+#include "MemoryTracker.h"
+
+//
+// Helper class that cleans a large image by splitting it into overlapping tiles evaluated in parallel
+// by a set of ImageCleanerBinding instances, then stitching the tiles back into a single image.
+// Each tile is evaluated with a margin of tileOverlap pixels of surrounding context and only its core
+// region is written back, so tiles never write to the same output pixels and seams are not visible as
+// long as the overlap covers the neighborhood the cleaning preset looks at.
+// Memory is bounded to one input and one output tile per worker on top of the source and stitched images.
+// When a MemoryTracker is specified, tiles and stitched images are accounted to it and only one worker
+// keeps evaluating tiles while its pressure is High.
+//
+class TiledImageCleaner
+{
+public:
+    TiledImageCleaner(
+        winrt::Microsoft::AI::Skills::Vision::ImageScanning::ImageCleanerSkill const& skill,
+        winrt::Microsoft::AI::Skills::Vision::ImageScanning::ImageCleaningKind imageCleaningKind,
+        uint32_t tileSize,
+        uint32_t tileOverlap,
+        uint32_t workerCount,
+        MemoryTracker* memoryTracker = nullptr);
+    ~TiledImageCleaner();
+
+    TiledImageCleaner(const TiledImageCleaner&) = delete;
+    TiledImageCleaner& operator=(const TiledImageCleaner&) = delete;
+
+    winrt::Windows::Media::VideoFrame Clean(winrt::Windows::Media::VideoFrame const& inputImage);
+
+    uint32_t WorkerCount() const { return (uint32_t)m_bindings.size(); }
+    uint32_t LastTileCount() const { return m_lastTileCount; }
+
+private:
+    struct Tile
+    {
+        // Region of the source image bound to the skill, including the overlap margin
+        winrt::Windows::Graphics::Imaging::BitmapBounds inputBounds;
+
+        // Region of the stitched image this tile is responsible for
+        winrt::Windows::Graphics::Imaging::BitmapBounds coreBounds;
+    };
+
+    std::vector<Tile> ComputeTiles(uint32_t width, uint32_t height) const;
+
+    winrt::Microsoft::AI::Skills::Vision::ImageScanning::ImageCleanerSkill m_skill = nullptr;
+    std::vector<winrt::Microsoft::AI::Skills::Vision::ImageScanning::ImageCleanerBinding> m_bindings;
+    uint32_t m_tileSize = 0;
+    uint32_t m_tileOverlap = 0;
+    uint32_t m_lastTileCount = 0;
+
+    MemoryTracker* m_memoryTracker = nullptr;
+    MemoryTracker::Component* m_tileMemory = nullptr;
+    uint32_t m_pressureHandlerId = 0;
+    std::atomic<uint32_t> m_activeWorkerLimit; // workers past this index stop picking tiles
+};
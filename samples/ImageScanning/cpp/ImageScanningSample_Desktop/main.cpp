@@ -1,8 +1,17 @@
 ﻿// Copyright (c) Microsoft Corporation. All rights reserved.
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <future>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <thread>
+#include <vector>
 #include <winrt/Windows.Foundation.h>
 #include <winrt/windows.foundation.collections.h>
 #include <winrt/windows.media.h>
@@ -11,7 +20,20 @@
 #include <winrt/Windows.Storage.Streams.h>
 #include <winrt/Windows.Graphics.Imaging.h>
 
+#include "AdmissionController.h"
+#include "AsyncFrameWriter_cppwinrt.h"
+#include "CameraHelper_cppwinrt.h"
+#include "DetectionLogger.h"
+#include "LiveQuadTracker.h"
+#include "MemoryTracker.h"
+#include "PerspectiveWarp.h"
+#include "ProcessMemoryHelper.h"
+#include "SceneEventGenerator.h"
+#include "SoftwareBitmapHelper_cppwinrt.h"
+#include "TiledImageCleaner.h"
+#include "Tracing.h"
 #include "WindowsVersionHelper.h"
+#include "WorkStealingThreadPool.h"
 #include "winrt/Microsoft.AI.Skills.SkillInterface.h"
 #include "winrt/Microsoft.AI.Skills.Vision.ImageScanning.h"
 
@@ -52,6 +74,21 @@ static const std::map<ImageCleaningKind, std::string> ImageCleaningKindLookup =
     { ImageCleaningKind::Picture, "Picture" },
 };
 
+// Amount of surrounding context in pixels bound with each tile when cleaning an image in tiles
+static const uint32_t TileOverlap = 64;
+
+// Default center crop percentage of the frame where the search for quads begins when no previous quad is known
+static const int DefaultLookupRegionCropPercentage = 5;
+
+// Maximum corner displacement between 2 frames, as a fraction of the frame dimension, for a quad to be considered still
+static const float LiveQuadStabilityThreshold = 0.01f;
+
+// Amount of consecutive frames a quad needs to stay still for before it gets rectified and cleaned
+static const uint32_t LiveQuadStableFrameCount = 10;
+
+// Amount of runs each CPU rectification time of -benchmark is averaged over
+static const uint32_t WarpBenchmarkRunCount = 3;
+
 //
 // Load a VideoFrame from a specified image file path
 //
@@ -93,35 +130,694 @@ VideoFrame LoadVideoFrameFromImageFile(hstring imageFilePath)
 }
 
 //
-// Save a modified VideoFrame using an existing image file path with an appended suffix
+// Helper method to retrieve the value following a named argument, i.e. "-quality 0.8"
 //
-hstring SaveModifiedVideoFrameToFile(hstring imageFilePath, VideoFrame frame)
+const char* FindOptionValue(const char* optionName)
 {
-    try
+    for (int i = 1; i < __argc - 1; i++)
     {
-        StorageFile file = StorageFile::GetFileFromPathAsync(imageFilePath).get();
-        StorageFolder folder = file.GetParentAsync().get();
-        std::wstring fileNameTemp = file.Name().c_str();
-        auto insertPosition = fileNameTemp.find(file.FileType());
-        fileNameTemp.insert(insertPosition, L"_mod");
+        if (strcmp(__argv[i], optionName) == 0)
+        {
+            return __argv[i + 1];
+        }
+    }
+    return nullptr;
+}
 
-        StorageFile modifiedFile = folder.CreateFileAsync(fileNameTemp, CreationCollisionOption::GenerateUniqueName).get();
-        imageFilePath = modifiedFile.Path();
+//
+// Helper method to check if a named flag argument was specified, i.e. "-benchmark"
+//
+bool HasOption(const char* optionName)
+{
+    for (int i = 1; i < __argc; i++)
+    {
+        if (strcmp(__argv[i], optionName) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
 
-        // Create the encoder from the stream
-        IRandomAccessStream stream = modifiedFile.OpenAsync(FileAccessMode::ReadWrite).get();
+//
+// Create the logger displaying quad events, as text or JSON lines with "-json" and also written to a file with "-log <file path>"
+//
+std::unique_ptr<DetectionLogger> CreateEventLogger()
+{
+    DetectionLogger::Options options;
+    options.format = HasOption("-json") ? DetectionLogger::Format::Json : DetectionLogger::Format::Text;
+    if (auto filePath = FindOptionValue("-log"))
+    {
+        options.filePath = filePath;
+        std::cout << "Logging events to " << filePath << std::endl;
+    }
+
+    // Quad events carry no label
+    return std::make_unique<DetectionLogger>(options, [](int32_t) { return "quad"; });
+}
+
+//
+// Options of the checks done on the CPU with each detected quad before the skills rectify and clean an image
+//
+struct QuadPreCheckOptions
+{
+    PerspectiveWarp::QuadCheckOptions quadCheck;
+    uint32_t thumbnailSize = 0; // longer side in pixels of the rectified thumbnail written next to each result, 0 for none
+};
 
-        BitmapEncoder encoder = BitmapEncoder::CreateAsync(BitmapEncoder::JpegEncoderId(), stream).get();
-        SoftwareBitmap softwareBitmap = frame.SoftwareBitmap();
-        encoder.SetSoftwareBitmap(softwareBitmap);
-        encoder.FlushAsync().get();
+//
+// Retrieve the size in pixels of a VideoFrame, whether it is backed by a SoftwareBitmap or a Direct3D surface
+//
+void GetFrameSize(VideoFrame const& videoFrame, uint32_t& width, uint32_t& height)
+{
+    SoftwareBitmap bitmap = videoFrame.SoftwareBitmap();
+    if (bitmap != nullptr)
+    {
+        width = (uint32_t)bitmap.PixelWidth();
+        height = (uint32_t)bitmap.PixelHeight();
     }
-    catch (hresult_error const& ex)
+    else
     {
-        std::wcerr << L"Could not save modified VideoFrame from file: " << imageFilePath.c_str();
-        throw ex;
+        auto surfaceDescription = videoFrame.Direct3DSurface().Description();
+        width = (uint32_t)surfaceDescription.Width;
+        height = (uint32_t)surfaceDescription.Height;
+    }
+}
+
+//
+// Convert the first quad of QuadDetectorBinding::DetectedQuads(), in normalized coordinates, to pixels of the frame.
+// Returns false if no quad was detected.
+//
+bool ToPixelQuad(IVectorView<Point> const& corners, uint32_t width, uint32_t height, PerspectiveWarp::Quad& quad)
+{
+    if (corners == nullptr || corners.Size() < 4)
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        auto corner = corners.GetAt(i);
+        quad[i] = { corner.X * width, corner.Y * height };
+    }
+    return true;
+}
+
+PerspectiveWarp::Image ToWarpImage(SoftwareBitmapHelper::PixelView const& view)
+{
+    return { view.data, view.stride, view.width, view.height };
+}
+
+//
+// Rectify the quad of a frame on the CPU into a thumbnail whose longer side is at most thumbnailSize pixels,
+// a bilinear preview of what ImageRectifier produces that takes a fraction of its time
+//
+VideoFrame CreateThumbnail(VideoFrame const& videoFrame, PerspectiveWarp::Quad const& quad, PerspectiveWarp::QuadCheck const& quadCheck, uint32_t thumbnailSize)
+{
+    // Keep the aspect ratio of the rectified quad and never upscale it
+    float scale = std::min<float>(1.0f, thumbnailSize / std::max<float>(quadCheck.rectifiedWidth, quadCheck.rectifiedHeight));
+    uint32_t width = std::max<uint32_t>(1, (uint32_t)std::lround(quadCheck.rectifiedWidth * scale));
+    uint32_t height = std::max<uint32_t>(1, (uint32_t)std::lround(quadCheck.rectifiedHeight * scale));
+
+    SoftwareBitmap sourceBitmap = SoftwareBitmapHelper::GetSoftwareBitmap(videoFrame);
+    SoftwareBitmap thumbnailBitmap(BitmapPixelFormat::Bgra8, width, height, BitmapAlphaMode::Premultiplied);
+    {
+        SoftwareBitmapHelper::LockedPixels source(sourceBitmap, BitmapBufferAccessMode::Read);
+        SoftwareBitmapHelper::LockedPixels thumbnail(thumbnailBitmap, BitmapBufferAccessMode::Write);
+        PerspectiveWarp::WarpOptions warpOptions;
+        warpOptions.threadPool = &WorkStealingThreadPool::Default();
+        PerspectiveWarp::Rectify(ToWarpImage(source.View()), quad, ToWarpImage(thumbnail.View()), warpOptions);
+    }
+    return VideoFrame::CreateWithSoftwareBitmap(thumbnailBitmap);
+}
+
+//
+// Time the CPU rectification of a quad at the size ImageRectifier would produce, with each interpolation,
+// with the scalar code, with SIMD, and with SIMD spread over the default thread pool, in milliseconds per megapixel
+//
+void BenchmarkPerspectiveWarp(VideoFrame const& videoFrame, PerspectiveWarp::Quad const& quad, PerspectiveWarp::QuadCheck const& quadCheck)
+{
+    uint32_t width = std::max<uint32_t>(1, (uint32_t)std::lround(quadCheck.rectifiedWidth));
+    uint32_t height = std::max<uint32_t>(1, (uint32_t)std::lround(quadCheck.rectifiedHeight));
+    double megapixels = (double)width * height / 1000000.0;
+    std::vector<uint8_t> outputPixels((size_t)width * height * 4);
+    PerspectiveWarp::Image output = { outputPixels.data(), (int32_t)width * 4, width, height };
+
+    SoftwareBitmap sourceBitmap = SoftwareBitmapHelper::GetSoftwareBitmap(videoFrame);
+    SoftwareBitmapHelper::LockedPixels source(sourceBitmap, BitmapBufferAccessMode::Read);
+
+    const char* variantNames[] = { "scalar", "SIMD", "SIMD on pool" };
+    std::cout << "CPU rectification to " << width << "x" << height << " (" << std::round(megapixels * 10) / 10 << "MP), in ms/MP:" << std::endl;
+    for (auto interpolation : { PerspectiveWarp::Interpolation::Bilinear, PerspectiveWarp::Interpolation::Bicubic })
+    {
+        std::cout << (interpolation == PerspectiveWarp::Interpolation::Bilinear ? "\tBilinear" : "\tBicubic ");
+        for (uint32_t variant = 0; variant < 3; variant++)
+        {
+            PerspectiveWarp::WarpOptions warpOptions;
+            warpOptions.interpolation = interpolation;
+            warpOptions.useSimd = variant > 0;
+            warpOptions.threadPool = variant > 1 ? &WorkStealingThreadPool::Default() : nullptr;
+
+            // Warm up once, then average
+            PerspectiveWarp::Rectify(ToWarpImage(source.View()), quad, output, warpOptions);
+            auto begin = std::chrono::high_resolution_clock::now();
+            for (uint32_t run = 0; run < WarpBenchmarkRunCount; run++)
+            {
+                PerspectiveWarp::Rectify(ToWarpImage(source.View()), quad, output, warpOptions);
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            double msPerMegapixel = std::chrono::duration<double, std::milli>(end - begin).count() / WarpBenchmarkRunCount / megapixels;
+
+            std::cout << " | " << variantNames[variant] << ": " << std::round(msPerMegapixel * 100) / 100;
+        }
+        std::cout << std::endl;
+    }
+}
+
+//
+// Skills and bindings executed in succession to scan an image, created once and reused for every image
+//
+struct ImageScanningSkills
+{
+    QuadDetectorSkill quadDetectorSkill = nullptr;
+    QuadDetectorBinding quadDetectorBinding = nullptr;
+    ImageRectifierSkill imageRectifierSkill = nullptr;
+    ImageRectifierBinding imageRectifierBinding = nullptr;
+    ImageCleanerSkill imageCleanerSkill = nullptr;
+    ImageCleanerBinding imageCleanerBinding = nullptr;
+    std::unique_ptr<TiledImageCleaner> tiledImageCleaner; // only set when cleaning in tiles
+};
+
+//
+// Create the skills and their bindings, the tiled cleaner accounts its tiles to memoryTracker when specified
+//
+ImageScanningSkills CreateImageScanningSkills(ImageInterpolationKind imageInterpolationKind, ImageCleaningKind imageCleaningPreset, uint32_t tileSize, MemoryTracker* memoryTracker = nullptr)
+{
+    ImageScanningSkills skills;
+
+    // Create instance of the skills
+    skills.quadDetectorSkill = QuadDetectorDescriptor().CreateSkillAsync().get().as<QuadDetectorSkill>();
+    skills.imageRectifierSkill = ImageRectifierDescriptor().CreateSkillAsync().get().as<ImageRectifierSkill>();
+    skills.imageCleanerSkill = ImageCleanerDescriptor().CreateSkillAsync().get().as<ImageCleanerSkill>();
+    auto skillDevice = skills.quadDetectorSkill.Device();
+    std::cout << "Running Skill on : " << SkillExecutionDeviceKindLookup.at(skillDevice.ExecutionDeviceKind());
+    std::wcout << L" : " << skillDevice.Name().c_str() << std::endl;
+    std::cout << "ImageInterpolationKind: " << ImageInterpolationKindLookup.at(imageInterpolationKind) << std::endl;
+    std::cout << "ImageCleaningPreset: " << ImageCleaningKindLookup.at(imageCleaningPreset) << std::endl;
+
+    // Create instances of the skill bindings and set the features that do not change from one image to the next
+    skills.quadDetectorBinding = skills.quadDetectorSkill.CreateSkillBindingAsync().get().as<QuadDetectorBinding>();
+    skills.imageRectifierBinding = skills.imageRectifierSkill.CreateSkillBindingAsync().get().as<ImageRectifierBinding>();
+    skills.imageRectifierBinding.SetInterpolationKind(imageInterpolationKind);
+    skills.imageCleanerBinding = skills.imageCleanerSkill.CreateSkillBindingAsync().get().as<ImageCleanerBinding>();
+    skills.imageCleanerBinding.SetImageCleaningKindAsync(imageCleaningPreset).get();
+
+    if (tileSize > 0)
+    {
+        // Create a tiled cleaner that evaluates tiles of the rectified image in parallel, one binding per core
+        std::cout << "Tile size: " << tileSize << " px with " << TileOverlap << " px overlap" << std::endl;
+        skills.tiledImageCleaner = std::make_unique<TiledImageCleaner>(skills.imageCleanerSkill, imageCleaningPreset, tileSize, TileOverlap, WorkStealingThreadPool::Default().WorkerCount(), memoryTracker);
+    }
+
+    return skills;
+}
+
+//
+// Rectify an image using the specified quad and clean the rectified image, either whole or in tiles
+//
+VideoFrame RectifyAndCleanImage(ImageScanningSkills& skills, VideoFrame const& videoFrame, IVectorView<Point> const& quad, bool isBenchmark)
+{
+    // ### 2. Image rectification ###
+    auto rectifyBegin = std::chrono::high_resolution_clock::now();
+    {
+        SAMPLES_TRACE_SCOPE("ImageRectifier.Bind");
+        skills.imageRectifierBinding.SetInputImageAsync(videoFrame).get();
+        skills.imageRectifierBinding.SetInputQuadAsync(quad).get();
+    }
+
+    // Run ImageRectifierSkill
+    {
+        SAMPLES_TRACE_SCOPE("ImageRectifier.Evaluate");
+        skills.imageRectifierSkill.EvaluateAsync(skills.imageRectifierBinding).get();
+    }
+    if (isBenchmark)
+    {
+        // Per megapixel of rectified image, comparable to the CPU rectification
+        auto rectifyEnd = std::chrono::high_resolution_clock::now();
+        uint32_t width = 0;
+        uint32_t height = 0;
+        GetFrameSize(skills.imageRectifierBinding.OutputImage(), width, height);
+        double rectifyMs = std::chrono::duration<double, std::milli>(rectifyEnd - rectifyBegin).count();
+        std::cout << "ImageRectifier to " << width << "x" << height << ": " << std::round(rectifyMs) << "ms | "
+            << std::round(rectifyMs * 1000000.0 / std::max<double>(1.0, (double)width * height) * 100) / 100 << "ms/MP" << std::endl;
+    }
+
+    // ### 3. Image cleaner ###
+    VideoFrame results = nullptr;
+    if (skills.tiledImageCleaner != nullptr)
+    {
+        // Run ImageCleanerSkill over all tiles and measure time and memory spent
+        ProcessMemoryHelper::PeakMemorySampler memorySampler;
+        auto begin = std::chrono::high_resolution_clock::now();
+
+        {
+            SAMPLES_TRACE_SCOPE("TiledImageCleaner.Clean");
+            results = skills.tiledImageCleaner->Clean(skills.imageRectifierBinding.OutputImage());
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        auto peakBytes = memorySampler.Stop();
+        std::cout << "Tiled clean (" << skills.tiledImageCleaner->LastTileCount() << " tiles on " << skills.tiledImageCleaner->WorkerCount() << " workers): "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "ms | "
+            << "peak memory: +" << peakBytes / (1024 * 1024) << "MB" << std::endl;
+    }
+    if (skills.tiledImageCleaner == nullptr || isBenchmark)
+    {
+        ProcessMemoryHelper::PeakMemorySampler memorySampler;
+        auto begin = std::chrono::high_resolution_clock::now();
+
+        {
+            SAMPLES_TRACE_SCOPE("ImageCleaner.Bind");
+            skills.imageCleanerBinding.SetInputImageAsync(skills.imageRectifierBinding.OutputImage()).get();
+        }
+
+        // Run ImageCleanerSkill
+        {
+            SAMPLES_TRACE_SCOPE("ImageCleaner.Evaluate");
+            skills.imageCleanerSkill.EvaluateAsync(skills.imageCleanerBinding).get();
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        auto peakBytes = memorySampler.Stop();
+        if (isBenchmark)
+        {
+            std::cout << "Whole-image clean: "
+                << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "ms | "
+                << "peak memory: +" << peakBytes / (1024 * 1024) << "MB" << std::endl;
+        }
+
+        // Retrieve result unless the tiled result is the one to keep
+        if (results == nullptr)
+        {
+            SAMPLES_TRACE_SCOPE("ImageCleaner.Extract");
+            results = skills.imageCleanerBinding.OutputImage();
+        }
+    }
+    return results;
+}
+
+//
+// Images produced by scanning an image, both nullptr when no quad worth rectifying was found
+//
+struct ScanResult
+{
+    VideoFrame image = nullptr; // rectified and cleaned by the skills
+    VideoFrame thumbnail = nullptr; // rectified on the CPU, only when a thumbnail size is specified
+};
+
+//
+// Find the predominant quad in an image, check it on the CPU, then rectify and clean the image with it
+//
+ScanResult ScanImage(ImageScanningSkills& skills, VideoFrame const& videoFrame, QuadPreCheckOptions const& preCheckOptions, bool isBenchmark)
+{
+    // ### 1. Quad detection ###
+    {
+        SAMPLES_TRACE_SCOPE("QuadDetector.Bind");
+        skills.quadDetectorBinding.SetInputImageAsync(videoFrame).get();
+    }
+
+    // Run QuadDetectorSkill
+    {
+        SAMPLES_TRACE_SCOPE("QuadDetector.Evaluate");
+        skills.quadDetectorSkill.EvaluateAsync(skills.quadDetectorBinding).get();
+    }
+
+    IVectorView<Point> detectedQuads = nullptr;
+    {
+        SAMPLES_TRACE_SCOPE("QuadDetector.Extract");
+        detectedQuads = skills.quadDetectorBinding.DetectedQuads();
+    }
+
+    // Reject quads not worth rectifying before the skills spend time on them
+    ScanResult result;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    GetFrameSize(videoFrame, width, height);
+    PerspectiveWarp::Quad quad = {};
+    if (!ToPixelQuad(detectedQuads, width, height, quad))
+    {
+        std::cout << "No quad detected" << std::endl;
+        return result;
+    }
+    PerspectiveWarp::QuadCheck quadCheck;
+    {
+        SAMPLES_TRACE_SCOPE("PerspectiveWarp.CheckQuad");
+        quadCheck = PerspectiveWarp::CheckQuad(quad, width, height, preCheckOptions.quadCheck);
+    }
+    if (!quadCheck.IsValid())
+    {
+        std::cout << "Quad rejected, " << PerspectiveWarp::ToString(quadCheck.issue) << ": "
+            << std::round(quadCheck.areaFraction * 1000) / 10 << "% of the image | "
+            << "aspect ratio: " << std::round(quadCheck.aspectRatio * 10) / 10 << std::endl;
+        return result;
     }
-    return imageFilePath;
+
+    if (preCheckOptions.thumbnailSize > 0)
+    {
+        SAMPLES_TRACE_SCOPE("PerspectiveWarp.Thumbnail");
+        result.thumbnail = CreateThumbnail(videoFrame, quad, quadCheck, preCheckOptions.thumbnailSize);
+    }
+    if (isBenchmark)
+    {
+        BenchmarkPerspectiveWarp(videoFrame, quad, quadCheck);
+    }
+
+    result.image = RectifyAndCleanImage(skills, videoFrame, detectedQuads, isBenchmark);
+    return result;
+}
+
+//
+// Wait for pending writes to complete and display their outcome
+//
+void WaitForPendingWrites(std::vector<std::future<hstring>>& pendingWrites)
+{
+    for (auto&& pendingWrite : pendingWrites)
+    {
+        try
+        {
+            std::wcout << L"Written output image to " << pendingWrite.get().c_str() << std::endl;
+        }
+        catch (hresult_error const& ex)
+        {
+            std::wcerr << L"Could not write output image: " << ex.message().c_str() << std::endl;
+        }
+    }
+    pendingWrites.clear();
+}
+
+//
+// Display write throughput and queue depth of the output stage
+//
+void PrintFrameWriterMetrics(AsyncFrameWriter const& frameWriter)
+{
+    auto metrics = frameWriter.GetMetrics();
+    std::cout << "Output: " << metrics.framesWritten << " files | "
+        << metrics.bytesWritten / 1024 << "KB in " << metrics.elapsedSeconds << "s | "
+        << metrics.framesPerSecond << " files/s | "
+        << metrics.megabytesPerSecond << "MB/s | "
+        << "queue depth max: " << metrics.maxQueueDepth << " avg: " << metrics.averageQueueDepth;
+    if (metrics.failures > 0)
+    {
+        std::cout << " | failures: " << metrics.failures;
+    }
+    std::cout << std::endl;
+}
+
+//
+// Scan all .jpg and .png images of a folder, results are encoded and written next to them while the next image gets scanned.
+// Images whose quad is rejected are skipped. When an admission controller is specified, each image is held back or skipped
+// while live work is at risk.
+//
+void RunBatchScan(ImageScanningSkills& skills, std::filesystem::path const& folderPath, AsyncFrameWriter& frameWriter, QuadPreCheckOptions const& preCheckOptions, bool isBenchmark, AdmissionController* admissionController = nullptr)
+{
+    StorageFolder folder = StorageFolder::GetFolderFromPathAsync(folderPath.wstring()).get();
+    auto files = folder.GetFilesAsync().get();
+    std::vector<std::future<hstring>> pendingWrites;
+
+    auto begin = std::chrono::high_resolution_clock::now();
+    uint64_t imageIndex = 0;
+    uint64_t skippedImageCount = 0;
+    uint64_t scannedImageCount = 0;
+    uint64_t rejectedImageCount = 0;
+    int64_t readyTime = admissionController != nullptr ? admissionController->Now() : 0;
+    for (auto&& file : files)
+    {
+        // Skip files that are not images as well as results and thumbnails of previous runs
+        std::wstring displayName = file.DisplayName().c_str();
+        if ((file.FileType() != L".jpg" && file.FileType() != L".png")
+            || (displayName.size() >= 4 && displayName.compare(displayName.size() - 4, 4, L"_mod") == 0)
+            || (displayName.size() >= 6 && displayName.compare(displayName.size() - 6, 6, L"_thumb") == 0))
+        {
+            continue;
+        }
+
+        // Wait for live work to be out of risk, or skip the image if that takes too long
+        if (admissionController != nullptr)
+        {
+            auto decision = admissionController->AdmitBatch(readyTime);
+            while (decision == AdmissionController::Decision::Defer)
+            {
+                std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(admissionController->DeferDelayMs()));
+                decision = admissionController->AdmitBatch(readyTime);
+            }
+            if (decision == AdmissionController::Decision::Shed)
+            {
+                std::wcout << L"Skipped " << file.Name().c_str() << L" to preserve live latency" << std::endl;
+                skippedImageCount++;
+                continue;
+            }
+        }
+
+        // Tag the events traced while scanning this image
+        SAMPLES_TRACE_SET_FRAME_ID(++imageIndex);
+
+        std::wcout << L"Scanning " << file.Name().c_str() << std::endl;
+        auto videoFrame = LoadVideoFrameFromImageFile(file.Path());
+        auto results = ScanImage(skills, videoFrame, preCheckOptions, isBenchmark);
+        if (results.image != nullptr)
+        {
+            pendingWrites.push_back(frameWriter.Write(folderPath.wstring(), displayName + L"_mod", results.image));
+            scannedImageCount++;
+        }
+        else
+        {
+            rejectedImageCount++;
+        }
+        if (results.thumbnail != nullptr)
+        {
+            pendingWrites.push_back(frameWriter.Write(folderPath.wstring(), displayName + L"_thumb", results.thumbnail));
+        }
+        if (admissionController != nullptr)
+        {
+            readyTime = admissionController->Now();
+        }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Scanned " << scannedImageCount << " images in "
+        << std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count() << "ms";
+    if (rejectedImageCount > 0)
+    {
+        std::cout << " | " << rejectedImageCount << " images without a valid quad";
+    }
+    std::cout << std::endl;
+    if (admissionController != nullptr)
+    {
+        std::cout << "Admission: " << skippedImageCount << " images skipped | "
+            << admissionController->DeferredCount() << " deferrals | "
+            << "batch wait p50: " << admissionController->BatchSojourns().Percentile(0.5) << "ms "
+            << "p99: " << admissionController->BatchSojourns().Percentile(0.99) << "ms" << std::endl;
+    }
+
+    WaitForPendingWrites(pendingWrites);
+}
+
+//
+// Scan documents from the camera stream: the quad search of each frame is seeded with the quad found in the previous one,
+// and the frame is only rectified and cleaned once its quad passed the CPU check and stayed still for LiveQuadStableFrameCount frames.
+// With isEventOutput, the status of every frame is replaced by a line per quad appearing, moving or disappearing,
+// logged off the evaluation thread like the events of the other samples.
+// When an admission controller is specified, the latency of each frame is reported to it.
+//
+void RunLiveCapture(ImageScanningSkills& skills, int lookupRegionCropPercentage, AsyncFrameWriter& frameWriter, QuadPreCheckOptions const& preCheckOptions, bool isEventOutput, AdmissionController* admissionController = nullptr)
+{
+    std::cout << "Lookup region center crop percentage: " << lookupRegionCropPercentage << "%" << std::endl;
+    std::cout << std::fixed;
+    std::cout.precision(3);
+
+    // Scanned images are written to the current directory
+    std::wstring outputFolderPath = std::filesystem::current_path().wstring();
+    std::vector<std::future<hstring>> pendingWrites;
+
+    LiveQuadTracker quadTracker(LiveQuadStabilityThreshold, LiveQuadStableFrameCount);
+    float fullSearchTotalTime = 0.0f;
+    float trackedSearchTotalTime = 0.0f;
+    int fullSearchCount = 0;
+    int trackedSearchCount = 0;
+
+    std::unique_ptr<SceneEventGenerator> eventGenerator;
+    std::unique_ptr<DetectionLogger> eventLogger;
+    std::vector<SceneEventGenerator::Event> events;
+    uint64_t frameId = 0;
+    if (isEventOutput)
+    {
+        eventGenerator = std::make_unique<SceneEventGenerator>(SceneEventGenerator::Options());
+        eventLogger = CreateEventLogger();
+    }
+
+    // Create a mutex to orchestrate skill evaluation one at a time
+    winrt::slim_mutex lock;
+
+    // Initialize Camera and register a frame callback handler
+    auto cameraHelper = std::shared_ptr<CameraHelper>(
+        CameraHelper::CreateCameraHelper(
+            [&](std::string failureMessage) // lambda function that acts as callback for failure event
+            {
+                std::cerr << failureMessage;
+                return 1;
+            },
+            [&](VideoFrame const& videoFrame) // lambda function that acts as callback for new frame event
+            {
+                // Lock context so multiple overlapping events from FrameReader do not race for the resources.
+                if (!lock.try_lock())
+                {
+                    return;
+                }
+
+                // Seed the search with the quad found in the previous frame and narrow it down around its center,
+                // otherwise search the whole frame
+                bool isTracking = quadTracker.HasQuad();
+                if (isTracking)
+                {
+                    std::vector<Point> previousQuad;
+                    for (auto&& corner : quadTracker.LastQuad())
+                    {
+                        previousQuad.push_back(Point(corner.x, corner.y));
+                    }
+                    auto center = quadTracker.Center();
+                    skills.quadDetectorBinding.SetPreviousQuad(winrt::single_threaded_vector<Point>(std::move(previousQuad)).GetView());
+                    skills.quadDetectorBinding.SetCenterPoint(Point(center.x, center.y));
+                    skills.quadDetectorBinding.SetLookupRegionCenterCropPercentage(lookupRegionCropPercentage);
+                }
+                else
+                {
+                    skills.quadDetectorBinding.SetPreviousQuad(nullptr);
+                    skills.quadDetectorBinding.SetCenterPoint(nullptr);
+                    skills.quadDetectorBinding.SetLookupRegionCenterCropPercentage(DefaultLookupRegionCropPercentage);
+                }
+
+                // measure time spent binding and evaluating
+                auto begin = std::chrono::high_resolution_clock::now();
+
+                {
+                    SAMPLES_TRACE_SCOPE("QuadDetector.Bind");
+                    skills.quadDetectorBinding.SetInputImageAsync(videoFrame).get();
+                }
+                {
+                    SAMPLES_TRACE_SCOPE("QuadDetector.Evaluate");
+                    skills.quadDetectorSkill.EvaluateAsync(skills.quadDetectorBinding).get();
+                }
+
+                auto end = std::chrono::high_resolution_clock::now();
+                auto detectTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+                if (isTracking)
+                {
+                    trackedSearchTotalTime += detectTime;
+                    trackedSearchCount++;
+                }
+                else
+                {
+                    fullSearchTotalTime += detectTime;
+                    fullSearchCount++;
+                }
+
+                IVectorView<Point> detectedQuads = nullptr;
+                {
+                    SAMPLES_TRACE_SCOPE("QuadDetector.Extract");
+                    detectedQuads = skills.quadDetectorBinding.DetectedQuads();
+                }
+
+                // Rejected quads are not tracked, so that they never get rectified and cleaned
+                uint32_t width = 0;
+                uint32_t height = 0;
+                GetFrameSize(videoFrame, width, height);
+                PerspectiveWarp::Quad pixelQuad = {};
+                PerspectiveWarp::QuadCheck quadCheck;
+                SceneEventGenerator::Quad eventQuad = {};
+                bool isQuadDetected = ToPixelQuad(detectedQuads, width, height, pixelQuad);
+                if (isQuadDetected)
+                {
+                    SAMPLES_TRACE_SCOPE("PerspectiveWarp.CheckQuad");
+                    quadCheck = PerspectiveWarp::CheckQuad(pixelQuad, width, height, preCheckOptions.quadCheck);
+                }
+                if (isQuadDetected && quadCheck.IsValid())
+                {
+                    LiveQuadTracker::Quad quad;
+                    for (uint32_t i = 0; i < 4; i++)
+                    {
+                        auto corner = detectedQuads.GetAt(i);
+                        quad[i] = { corner.X, corner.Y };
+                        eventQuad[i] = { corner.X, corner.Y };
+                    }
+                    quadTracker.Update(quad);
+                }
+                else
+                {
+                    quadTracker.Reset();
+                }
+
+                frameId++;
+                if (eventGenerator != nullptr)
+                {
+                    // Only display the quad appearing, moving or disappearing
+                    events.clear();
+                    eventGenerator->UpdateQuad(0, frameId, quadTracker.HasQuad() ? &eventQuad : nullptr, events);
+                    for (auto&& event : events)
+                    {
+                        eventLogger->LogEvent(event);
+                    }
+                }
+                else
+                {
+                    // Display average detection cost of full and seeded searches
+                    std::cout << "full search: " << (fullSearchCount > 0 ? fullSearchTotalTime / fullSearchCount : 0.0f) << "ms | ";
+                    std::cout << "tracked search: " << (trackedSearchCount > 0 ? trackedSearchTotalTime / trackedSearchCount : 0.0f) << "ms | ";
+                    std::cout << (quadTracker.HasQuad() ? "tracking quad             " : (isQuadDetected ? "---- Quad rejected -------" : "---- No quad detected ----")) << "\r";
+                }
+
+                // Rectify and clean the frame only once the quad is stable, the result is written asynchronously
+                if (quadTracker.ShouldCapture())
+                {
+                    auto results = RectifyAndCleanImage(skills, videoFrame, detectedQuads, false);
+                    pendingWrites.push_back(frameWriter.Write(outputFolderPath, L"LiveScan", results));
+                    if (preCheckOptions.thumbnailSize > 0)
+                    {
+                        SAMPLES_TRACE_SCOPE("PerspectiveWarp.Thumbnail");
+                        pendingWrites.push_back(frameWriter.Write(outputFolderPath, L"LiveScan_thumb", CreateThumbnail(videoFrame, pixelQuad, quadCheck, preCheckOptions.thumbnailSize)));
+                    }
+                    std::cout << std::endl << "Quad scanned" << std::endl;
+                    quadTracker.MarkCaptured();
+                }
+
+                // Report the time from capture to the end of the frame processing, or the processing time if the capture time is unknown
+                if (admissionController != nullptr)
+                {
+                    auto captureTime = CameraHelper::GetCaptureTime(videoFrame);
+                    admissionController->RecordLiveLatency(captureTime >= 0
+                        ? (double)(FrameDeadlinePolicy::SystemRelativeNow() - captureTime) / FrameDeadlinePolicy::TicksPerMs
+                        : std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - begin).count());
+                }
+
+                videoFrame.Close();
+
+                lock.unlock();
+            }));
+
+    std::cout << "\t\t\t\t\t\t\t\t...press enter to Stop" << std::endl;
+
+    // Wait for enter keypress
+    while (std::cin.get() != '\n');
+
+    std::cout << std::endl << "Key pressed.. exiting" << std::endl;
+
+    // De-initialize the MediaCapture and FrameReader
+    cameraHelper->Cleanup();
+    if (eventGenerator != nullptr)
+    {
+        // Write the remaining queued events
+        eventLogger->Close();
+        std::cout << "Events: " << eventGenerator->GetStatistics().eventCount << " for " << frameId << " frames" << std::endl;
+    }
+
+    WaitForPendingWrites(pendingWrites);
 }
 
 //
@@ -129,9 +825,10 @@ hstring SaveModifiedVideoFrameToFile(hstring imageFilePath, VideoFrame frame)
 //
 int main()
 {
-    hstring fileName;
     ImageInterpolationKind imageInterpolationKind = ImageInterpolationKind::Bilinear; // default value if none specified as argument
     ImageCleaningKind imageCleaningPreset = ImageCleaningKind::WhiteboardOrDocument; // default value if none specified as argument
+    uint32_t tileSize = 0; // default to cleaning the whole image at once if none specified as argument
+    AsyncFrameWriter::Options frameWriterOptions;
 
     std::cout << "Image Scanning C++/WinRT Non-packaged(win32) Console App - "
         << "This app executes a common productivity scenario that consists of scanning an "
@@ -153,7 +850,7 @@ int main()
         // Parse arguments
         if (__argc < 2)
         {
-            std::string errorMessage = "Allowed command arguments: <file path to .jpg or .png>";
+            std::string errorMessage = "Allowed command arguments: <file path to .jpg or .png, folder path to scan all its .jpg and .png files, or -live to scan from the camera>";
             errorMessage = errorMessage
                 + " <optional image rectifier interpolation to apply to the rectified image:\n"
                 + "\t1. " + ImageInterpolationKindLookup.at(ImageInterpolationKind::Bilinear) + "\n"
@@ -164,13 +861,38 @@ int main()
                 + "\t2. " + ImageCleaningKindLookup.at(ImageCleaningKind::Whiteboard) + "\n"
                 + "\t3. " + ImageCleaningKindLookup.at(ImageCleaningKind::Document) + "\n"
                 + "\t4. " + ImageCleaningKindLookup.at(ImageCleaningKind::Picture) + "\n"
-                + "i.e.: \n> ImageScanningSample_Desktop.exe test.jpg 1 1\n\n";
+                + "<optional tile size in pixels to clean the rectified image in parallel tiles, 0 cleans the whole image at once>\n"
+                + "In -live mode, the 4th argument is instead the optional center crop percentage of the frame to search quads in around the previous quad\n"
+                + "Optional named arguments:\n"
+                + "\t-benchmark: compare wall time and peak memory of the tiled and whole-image cleaning\n"
+                + "\t-format <jpg|png|raw>: output file format, raw dumps uncompressed BGRA8 pixels after a small header (default jpg)\n"
+                + "\t-quality <0 to 1>: JPEG encoding quality (default 0.9)\n"
+                + "\t-writers <count>: amount of threads encoding and writing output files (default 2)\n"
+                + "\t-batch <folder path>: in -live mode, also scan the images of a folder in the background, held back while live frames are late\n"
+                + "\t-livetarget <ms>: p99 capture to result latency of live frames above which background scanning is held back (default 66)\n"
+                + "\t-cputarget <percent>: host CPU utilization above which background scanning is held back while live frames come in (default 90)\n"
+                + "\t-memorybudget <MB>: memory budget of the pipeline (skills, frames and tiles in flight), above which the output queue and tile parallelism shrink\n"
+                + "\t-minquadarea <percent>: smallest area of the image a detected quad covers for the image to be rectified and cleaned (default 2)\n"
+                + "\t-maxquadaspect <ratio>: largest aspect ratio of the rectangle a detected quad rectifies to for the image to be rectified and cleaned (default 12)\n"
+                + "\t-thumbnail <pixels>: also write a thumbnail of the quad rectified on the CPU, of at most this size on its longer side\n"
+                + "\t-events: in -live mode, only display the quad appearing, moving and disappearing rather than the status of every frame\n"
+                + "\t-json: with -events, display events as JSON lines\n"
+                + "\t-log <file path>: with -events, also write events to a file\n"
+                + "i.e.: \n> ImageScanningSample_Desktop.exe test.jpg 1 1\n"
+                + "> ImageScanningSample_Desktop.exe scan_600dpi.png 1 3 1024 -benchmark\n"
+                + "> ImageScanningSample_Desktop.exe c:\\scans 1 3 0 -format png -writers 4\n"
+                + "> ImageScanningSample_Desktop.exe -live 1 3 20\n"
+                + "> ImageScanningSample_Desktop.exe -live 1 3 20 -batch c:\\scans -livetarget 50\n"
+                + "> ImageScanningSample_Desktop.exe c:\\scans 1 3 1024 -format raw -memorybudget 512\n"
+                + "> ImageScanningSample_Desktop.exe c:\\scans 1 3 0 -thumbnail 256 -minquadarea 10\n\n";
             throw hresult_invalid_argument(winrt::to_hstring(errorMessage));
         }
-
-        // Load image from specified file path
-        fileName = winrt::to_hstring(__argv[1]);
-        auto videoFrame = LoadVideoFrameFromImageFile(fileName);
+        bool isLiveMode = (std::string(__argv[1]) == "-live");
+        std::filesystem::path inputPath;
+        if (!isLiveMode)
+        {
+            inputPath = std::filesystem::absolute(__argv[1]);
+        }
 
         // Parse optional image interpolation preset argument
         int selection = 0;
@@ -220,58 +942,181 @@ int main()
         }
         imageCleaningPreset = (ImageCleaningKind)(selection - 1);
 
+        // Parse optional tile size or lookup region argument
+        int lookupRegionCropPercentage = 20;
+        if (__argc > 4 && __argv[4][0] != '-')
+        {
+            if (isLiveMode)
+            {
+                lookupRegionCropPercentage = std::stoi(__argv[4]);
+            }
+            else
+            {
+                tileSize = (uint32_t)std::stoul(__argv[4]);
+            }
+        }
+        bool isBenchmark = HasOption("-benchmark");
+        bool isEventOutput = HasOption("-events");
+
+        // Parse optional output stage arguments
+        if (auto format = FindOptionValue("-format"))
+        {
+            std::string formatName = format;
+            if (formatName == "png")
+            {
+                frameWriterOptions.format = AsyncFrameWriter::OutputFormat::Png;
+            }
+            else if (formatName == "raw")
+            {
+                frameWriterOptions.format = AsyncFrameWriter::OutputFormat::Raw;
+            }
+            else if (formatName != "jpg")
+            {
+                throw hresult_invalid_argument(L"Invalid output format specified, allowed values are jpg, png and raw");
+            }
+        }
+        if (auto quality = FindOptionValue("-quality"))
+        {
+            frameWriterOptions.jpegQuality = std::stof(quality);
+        }
+        if (auto writerCount = FindOptionValue("-writers"))
+        {
+            frameWriterOptions.workerCount = (uint32_t)std::stoul(writerCount);
+        }
+
+        // Parse optional background scanning arguments
+        std::filesystem::path batchFolderPath;
+        AdmissionController::Options admissionOptions;
+        if (auto batchFolder = FindOptionValue("-batch"))
+        {
+            if (!isLiveMode)
+            {
+                throw hresult_invalid_argument(L"-batch is only allowed in -live mode");
+            }
+            batchFolderPath = std::filesystem::absolute(batchFolder);
+            if (!std::filesystem::is_directory(batchFolderPath))
+            {
+                throw hresult_invalid_argument(L"-batch requires a folder path");
+            }
+        }
+        if (auto liveTarget = FindOptionValue("-livetarget"))
+        {
+            admissionOptions.liveLatencyTargetMs = std::stod(liveTarget);
+        }
+        if (auto cpuTarget = FindOptionValue("-cputarget"))
+        {
+            admissionOptions.cpuUtilizationTarget = std::stod(cpuTarget) / 100.0;
+        }
+
+        // Parse optional memory budget argument
+        MemoryTracker::Options memoryOptions;
+        if (auto memoryBudget = FindOptionValue("-memorybudget"))
+        {
+            memoryOptions.budgetBytes = (uint64_t)(std::stod(memoryBudget) * 1024 * 1024);
+        }
+
+        // Parse optional quad pre-check arguments
+        QuadPreCheckOptions preCheckOptions;
+        if (auto minQuadArea = FindOptionValue("-minquadarea"))
+        {
+            preCheckOptions.quadCheck.minAreaFraction = std::stof(minQuadArea) / 100.0f;
+        }
+        if (auto maxQuadAspect = FindOptionValue("-maxquadaspect"))
+        {
+            preCheckOptions.quadCheck.maxAspectRatio = std::stof(maxQuadAspect);
+        }
+        if (auto thumbnailSize = FindOptionValue("-thumbnail"))
+        {
+            preCheckOptions.thumbnailSize = (uint32_t)std::stoul(thumbnailSize);
+        }
+
         // Set and run skill
         try
         {
-            // Create the skill descriptors
-            QuadDetectorDescriptor quadDetectorSkillDescriptor;
-            ImageRectifierDescriptor imageRectifierSkillDescriptor;
-            ImageCleanerDescriptor imageCleanerSkillDescriptor;
+            // Account the memory of each stage of the pipeline, declared first so that it outlives them
+            MemoryTracker memoryTracker(memoryOptions);
+            frameWriterOptions.memoryTracker = &memoryTracker;
 
-            // Create instance of the skills
-            auto quadDetectorSkill = quadDetectorSkillDescriptor.CreateSkillAsync().get().as<QuadDetectorSkill>();
-            auto imageRectifierSkill = imageRectifierSkillDescriptor.CreateSkillAsync().get().as<ImageRectifierSkill>();
-            auto imageCleanerSkill = imageCleanerSkillDescriptor.CreateSkillAsync().get().as<ImageCleanerSkill>();
-            auto skillDevice = quadDetectorSkill.Device();
-            std::cout << "Running Skill on : " << SkillExecutionDeviceKindLookup.at(skillDevice.ExecutionDeviceKind());
-            std::wcout << L" : " << skillDevice.Name().c_str() << std::endl;
-            std::wcout << L"Image file: " << fileName.c_str() << std::endl;
-            std::cout << "ImageInterpolationKind: " << ImageInterpolationKindLookup.at(imageInterpolationKind) << std::endl;
-            std::cout << "ImageCleaningPreset: " << ImageCleaningKindLookup.at(imageCleaningPreset) << std::endl;
+            // Create the output stage, files are encoded and written on its own threads
+            AsyncFrameWriter frameWriter(frameWriterOptions);
 
-            // ### 1. Quad detection ###
-            // Create instance of QuadDetectorBinding and set features
-            auto quadDetectorBinding = quadDetectorSkill.CreateSkillBindingAsync().get().as<QuadDetectorBinding>();
-            quadDetectorBinding.SetInputImageAsync(videoFrame).get();
-
-            // Run QuadDetectorSkill
-            quadDetectorSkill.EvaluateAsync(quadDetectorBinding).get();
+            // Create the skills and bindings, their footprint is what the process grew by while creating them
+            ImageScanningSkills skills;
+            memoryTracker.MeasureFootprint(memoryTracker.GetComponent("Skills and bindings"), [&]()
+            {
+                skills = CreateImageScanningSkills(imageInterpolationKind, imageCleaningPreset, tileSize, &memoryTracker);
+            });
 
-            // ### 2. Image rectification ###
-            // Create instance of ImageRectifierBinding and set input features
-            auto imageRectifierBinding = imageRectifierSkill.CreateSkillBindingAsync().get().as<ImageRectifierBinding>();
-            imageRectifierBinding.SetInputImageAsync(videoFrame).get();
-            imageRectifierBinding.SetInputQuadAsync(quadDetectorBinding.DetectedQuads()).get();
-            imageRectifierBinding.SetInterpolationKind(imageInterpolationKind);
+            if (isLiveMode && !batchFolderPath.empty())
+            {
+                // Scan the folder on its own skills and thread, the admission controller gives live frames precedence
+                std::wcout << L"Background image folder: " << batchFolderPath.c_str() << std::endl;
+                std::cout << "Live p99 latency target: " << admissionOptions.liveLatencyTargetMs << "ms | "
+                    << "CPU utilization target: " << admissionOptions.cpuUtilizationTarget * 100 << "%" << std::endl;
+                AdmissionController admissionController(admissionOptions);
+                ImageScanningSkills batchSkills;
+                memoryTracker.MeasureFootprint(memoryTracker.GetComponent("Background skills and bindings"), [&]()
+                {
+                    batchSkills = CreateImageScanningSkills(imageInterpolationKind, imageCleaningPreset, tileSize, &memoryTracker);
+                });
+                std::thread batchThread([&]()
+                {
+                    try
+                    {
+                        RunBatchScan(batchSkills, batchFolderPath, frameWriter, preCheckOptions, false, &admissionController);
+                    }
+                    catch (hresult_error const& ex)
+                    {
+                        std::wcerr << L"Background scan failed: " << ex.message().c_str() << std::endl;
+                    }
+                    catch (std::exception const& ex)
+                    {
+                        std::cerr << "Background scan failed: " << ex.what() << std::endl;
+                    }
+                });
 
-            // Run ImageRectifierSkill
-            imageRectifierSkill.EvaluateAsync(imageRectifierBinding).get();
+                RunLiveCapture(skills, lookupRegionCropPercentage, frameWriter, preCheckOptions, isEventOutput, &admissionController);
 
-            // ### 3. Image cleaner ###
-            // Create instance of QuadDetectorBinding and set features
-            auto imageCleanerBinding = imageCleanerSkill.CreateSkillBindingAsync().get().as<ImageCleanerBinding>();
-            imageCleanerBinding.SetImageCleaningKindAsync(imageCleaningPreset).get();
-            imageCleanerBinding.SetInputImageAsync(imageRectifierBinding.OutputImage()).get();
+                // Once the camera stopped, the remaining images are admitted right away
+                std::cout << "Waiting for the background scan to complete" << std::endl;
+                batchThread.join();
+            }
+            else if (isLiveMode)
+            {
+                RunLiveCapture(skills, lookupRegionCropPercentage, frameWriter, preCheckOptions, isEventOutput);
+            }
+            else if (std::filesystem::is_directory(inputPath))
+            {
+                std::wcout << L"Image folder: " << inputPath.c_str() << std::endl;
+                RunBatchScan(skills, inputPath, frameWriter, preCheckOptions, isBenchmark);
+            }
+            else
+            {
+                // Load image from specified file path
+                std::wcout << L"Image file: " << inputPath.c_str() << std::endl;
+                auto videoFrame = LoadVideoFrameFromImageFile(inputPath.c_str());
 
-            // Run ImageCleanerSkill
-            imageCleanerSkill.EvaluateAsync(imageCleanerBinding).get();
+                auto results = ScanImage(skills, videoFrame, preCheckOptions, isBenchmark);
 
-            // Retrieve result and save it to file
-            auto results = imageCleanerBinding.OutputImage();
+                // Save results to files next to the input image, using its name with an appended suffix
+                std::vector<std::future<hstring>> pendingWrites;
+                if (results.image != nullptr)
+                {
+                    pendingWrites.push_back(frameWriter.Write(inputPath.parent_path().wstring(), inputPath.stem().wstring() + L"_mod", results.image));
+                }
+                if (results.thumbnail != nullptr)
+                {
+                    pendingWrites.push_back(frameWriter.Write(inputPath.parent_path().wstring(), inputPath.stem().wstring() + L"_thumb", results.thumbnail));
+                }
+                WaitForPendingWrites(pendingWrites);
+            }
 
-            auto outputFilePath = SaveModifiedVideoFrameToFile(fileName, results);
-            std::wcout << L"Written output image to " << outputFilePath.c_str();
+            frameWriter.Close();
+            PrintFrameWriterMetrics(frameWriter);
+            memoryTracker.Report(std::cout);
 
+            // Write the traced events, when built with SKILLS_SAMPLES_ENABLE_TRACING
+            SAMPLES_TRACE_DUMP("ImageScanningSample_Desktop.trace.json");
         }
         catch (hresult_error const& ex)
         {
@@ -285,4 +1130,4 @@ int main()
         return  ex.code().value;;
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,205 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "MotionGatedDetector.h"
+#include <algorithm>
+#include <chrono>
+
+#include "BoxGeometry.h"
+#include "SoftwareBitmapHelper_cppwinrt.h"
+#include "Tracing.h"
+
+using namespace winrt;
+using namespace winrt::Windows::Foundation;
+using namespace winrt::Windows::Graphics::Imaging;
+using namespace winrt::Windows::Media;
+using namespace winrt::Microsoft::AI::Skills::Vision::ObjectDetector;
+
+//
+// Round a pixel dimension up to a multiple of alignment, skills do not accept odd image dimensions
+//
+static uint32_t AlignDimension(uint32_t value, uint32_t alignment)
+{
+    return std::max(alignment, (value + alignment - 1) / alignment * alignment);
+}
+
+static float ElapsedMs(std::chrono::high_resolution_clock::time_point begin)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - begin).count() / 1000000.0f;
+}
+
+MotionGatedDetector::MotionGatedDetector(ObjectDetectorSkill const& skill, Options const& options)
+    : m_options(options),
+    m_skill(skill),
+    m_motionDetector(options.motion)
+{
+    m_binding = m_skill.CreateSkillBindingAsync().get().as<ObjectDetectorBinding>();
+}
+
+void MotionGatedDetector::Reset()
+{
+    m_motionDetector.Reset();
+    m_detections.clear();
+    m_framesSinceFullFrame = 0;
+}
+
+//
+// Compute the motion map of the frame, straight from the luma plane of NV12 and Gray8 frames to avoid a conversion
+//
+MotionRegionDetector::MotionMap MotionGatedDetector::DetectMotion(VideoFrame const& frame, uint32_t& frameWidth, uint32_t& frameHeight)
+{
+    SAMPLES_TRACE_SCOPE("Motion");
+    SoftwareBitmap bitmap = frame.SoftwareBitmap();
+    bool isLuma = bitmap != nullptr
+        && (bitmap.BitmapPixelFormat() == BitmapPixelFormat::Nv12 || bitmap.BitmapPixelFormat() == BitmapPixelFormat::Gray8);
+    if (!isLuma)
+    {
+        bitmap = SoftwareBitmapHelper::GetSoftwareBitmap(frame);
+    }
+    frameWidth = (uint32_t)bitmap.PixelWidth();
+    frameHeight = (uint32_t)bitmap.PixelHeight();
+
+    SoftwareBitmapHelper::LockedPixels pixels(bitmap, BitmapBufferAccessMode::Read);
+    auto& view = pixels.View();
+    return isLuma
+        ? m_motionDetector.DetectLuma(view.data, view.stride, view.width, view.height)
+        : m_motionDetector.DetectBgra8(view.data, view.stride, view.width, view.height);
+}
+
+//
+// Evaluate ObjectDetector on a region of the frame and map the boxes it found back to normalized frame coordinates
+//
+std::vector<MotionGatedDetector::Detection> MotionGatedDetector::EvaluateRegion(
+    VideoFrame const& frame,
+    uint32_t frameWidth,
+    uint32_t frameHeight,
+    BitmapBounds const& bounds)
+{
+    auto begin = std::chrono::high_resolution_clock::now();
+    {
+        SAMPLES_TRACE_SCOPE("Region.Bind");
+        if (bounds.Width == frameWidth && bounds.Height == frameHeight)
+        {
+            m_binding.SetInputImageAsync(frame).get();
+        }
+        else
+        {
+            VideoFrame cropFrame(BitmapPixelFormat::Bgra8, bounds.Width, bounds.Height, BitmapAlphaMode::Premultiplied);
+            frame.CopyToAsync(cropFrame, bounds, BitmapBounds{ 0, 0, bounds.Width, bounds.Height }).get();
+            m_binding.SetInputImageAsync(cropFrame).get();
+        }
+    }
+    m_lastTimings.bindMs += ElapsedMs(begin);
+
+    begin = std::chrono::high_resolution_clock::now();
+    {
+        SAMPLES_TRACE_SCOPE("Region.Evaluate");
+        m_skill.EvaluateAsync(m_binding).get();
+    }
+    m_lastTimings.evaluateMs += ElapsedMs(begin);
+
+    SAMPLES_TRACE_SCOPE("Region.Extract");
+    auto toFrame = BoxGeometry::Affine::RegionToFrame(
+        (float)bounds.X, (float)bounds.Y, (float)bounds.Width, (float)bounds.Height, (float)frameWidth, (float)frameHeight);
+    std::vector<Detection> detections;
+    for (auto&& detectedObject : m_binding.DetectedObjects())
+    {
+        auto rect = detectedObject.Rect();
+        auto box = BoxGeometry::TransformBox(toFrame, { rect.X, rect.Y, rect.Width, rect.Height });
+        detections.push_back({ (int32_t)detectedObject.Kind(), Rect{ box.x, box.y, box.width, box.height }, false });
+    }
+    return detections;
+}
+
+//
+// Objects straddling a region border can be found twice: fresh boxes replace cached ones, and among fresh boxes
+// the largest is kept since the other one is likely cut by its region
+//
+std::vector<MotionGatedDetector::Detection> MotionGatedDetector::SuppressDuplicates(std::vector<Detection> const& detections) const
+{
+    std::vector<BoxGeometry::Box> boxes;
+    std::vector<float> scores;
+    std::vector<int32_t> kinds;
+    for (auto&& detection : detections)
+    {
+        BoxGeometry::Box box = { detection.rect.X, detection.rect.Y, detection.rect.Width, detection.rect.Height };
+        boxes.push_back(box);
+        scores.push_back((detection.isCached ? 0.0f : 1.0f) + std::min<float>(BoxGeometry::Area(box), 1.0f));
+        kinds.push_back(detection.kind);
+    }
+
+    BoxGeometry::NmsOptions options;
+    options.iouThreshold = m_options.duplicateIoU;
+    std::vector<Detection> keptDetections;
+    for (uint32_t index : BoxGeometry::SuppressNonMaximum(boxes, scores, kinds, options))
+    {
+        keptDetections.push_back(detections[index]);
+    }
+    return keptDetections;
+}
+
+//
+// Evaluate the regions of the frame that changed and merge their detections with the ones of static regions
+//
+std::vector<MotionGatedDetector::Detection> MotionGatedDetector::Evaluate(VideoFrame const& frame)
+{
+    m_lastTimings = Timings();
+    auto begin = std::chrono::high_resolution_clock::now();
+    uint32_t frameWidth = 0;
+    uint32_t frameHeight = 0;
+    auto motion = DetectMotion(frame, frameWidth, frameHeight);
+    m_lastTimings.motionMs = ElapsedMs(begin);
+    m_frameCount++;
+
+    m_framesSinceFullFrame++;
+    bool isRefreshDue = m_options.refreshInterval > 0 && m_framesSinceFullFrame >= m_options.refreshInterval;
+    if (motion.isFullFrame || isRefreshDue)
+    {
+        m_detections = EvaluateRegion(frame, frameWidth, frameHeight, { 0, 0, frameWidth, frameHeight });
+        m_framesSinceFullFrame = 0;
+        m_fullFrameCount++;
+        m_lastTimings.regionCount = 1;
+        m_lastTimings.isFullFrame = true;
+        m_lastTimings.evaluatedFraction = 1.0f;
+        m_evaluatedFractionSum += 1.0;
+        return m_detections;
+    }
+
+    for (auto&& detection : m_detections)
+    {
+        detection.isCached = true;
+    }
+    if (motion.regions.empty())
+    {
+        m_staticFrameCount++;
+        return m_detections;
+    }
+
+    uint64_t evaluatedArea = 0;
+    std::vector<Detection> detections;
+    for (auto&& region : motion.regions)
+    {
+        // Grow the region to an even size, shifting it back inside the frame when at its edge
+        uint32_t width = std::min(AlignDimension(region.width, 2), frameWidth & ~1u);
+        uint32_t height = std::min(AlignDimension(region.height, 2), frameHeight & ~1u);
+        BitmapBounds bounds = { std::min(region.x, frameWidth - width), std::min(region.y, frameHeight - height), width, height };
+        evaluatedArea += (uint64_t)width * height;
+        auto regionDetections = EvaluateRegion(frame, frameWidth, frameHeight, bounds);
+        detections.insert(detections.end(), regionDetections.begin(), regionDetections.end());
+
+        // The region was evaluated again: drop what was cached in it
+        auto isInRegion = [&](Detection const& detection)
+        {
+            float centerX = (detection.rect.X + detection.rect.Width / 2) * frameWidth;
+            float centerY = (detection.rect.Y + detection.rect.Height / 2) * frameHeight;
+            return centerX >= bounds.X && centerX < bounds.X + bounds.Width
+                && centerY >= bounds.Y && centerY < bounds.Y + bounds.Height;
+        };
+        m_detections.erase(std::remove_if(m_detections.begin(), m_detections.end(), isInRegion), m_detections.end());
+    }
+    detections.insert(detections.end(), m_detections.begin(), m_detections.end());
+    m_detections = SuppressDuplicates(detections);
+
+    m_lastTimings.regionCount = (uint32_t)motion.regions.size();
+    m_lastTimings.evaluatedFraction = std::min(1.0f, (float)((double)evaluatedArea / ((uint64_t)frameWidth * frameHeight)));
+    m_evaluatedFractionSum += m_lastTimings.evaluatedFraction;
+    return m_detections;
+}
@@ -0,0 +1,87 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <winrt/Windows.Foundation.h>
+#include <winrt/Windows.Graphics.Imaging.h>
+#include <winrt/Windows.Media.h>
+
+#include "MotionRegionDetector.h"
+#include "winrt/Microsoft.AI.Skills.Vision.ObjectDetector.h"
+
+//
+// Helper class that only runs ObjectDetector on the regions of the frame that changed since the previous frame.
+// Each region found by MotionRegionDetector is cropped and evaluated on its own, its boxes are mapped back to
+// normalized frame coordinates and replace the cached detections centered in that region, while detections in
+// static regions are carried over from previous frames. Evaluation work therefore grows with the moving area
+// rather than with the frame area. The whole frame is evaluated when most of it changed and every refreshInterval
+// frames, so that cached detections do not drift from what the full frame evaluation would find.
+//
+class MotionGatedDetector
+{
+public:
+    struct Options
+    {
+        MotionRegionDetector::Options motion;
+        uint32_t refreshInterval = 60; // frames between whole frame evaluations, 0 to never force one
+        float duplicateIoU = 0.5f; // overlap above which two boxes of the same kind are the same object
+    };
+
+    //
+    // Object detected in the frame, with its box normalized in the frame
+    //
+    struct Detection
+    {
+        int32_t kind; // ObjectKind
+        winrt::Windows::Foundation::Rect rect;
+        bool isCached; // carried over from a previous frame
+    };
+
+    struct Timings
+    {
+        float motionMs = 0.0f; // motion map of the frame
+        float bindMs = 0.0f; // crops and ObjectDetector binds of all regions
+        float evaluateMs = 0.0f; // ObjectDetector evaluations of all regions
+        uint32_t regionCount = 0; // evaluated regions, 0 when the frame was static
+        bool isFullFrame = false;
+        float evaluatedFraction = 0.0f; // frame area evaluated
+    };
+
+    MotionGatedDetector(
+        winrt::Microsoft::AI::Skills::Vision::ObjectDetector::ObjectDetectorSkill const& skill,
+        Options const& options);
+
+    std::vector<Detection> Evaluate(winrt::Windows::Media::VideoFrame const& frame);
+
+    // Forget the cached detections and the previous frame, the next frame is evaluated as a whole
+    void Reset();
+
+    const Timings& LastTimings() const { return m_lastTimings; }
+    uint64_t FrameCount() const { return m_frameCount; }
+    uint64_t FullFrameCount() const { return m_fullFrameCount; }
+    uint64_t StaticFrameCount() const { return m_staticFrameCount; }
+    double AverageEvaluatedFraction() const { return m_frameCount > 0 ? m_evaluatedFractionSum / m_frameCount : 0.0; }
+
+private:
+    MotionRegionDetector::MotionMap DetectMotion(winrt::Windows::Media::VideoFrame const& frame, uint32_t& frameWidth, uint32_t& frameHeight);
+    std::vector<Detection> EvaluateRegion(
+        winrt::Windows::Media::VideoFrame const& frame,
+        uint32_t frameWidth,
+        uint32_t frameHeight,
+        winrt::Windows::Graphics::Imaging::BitmapBounds const& bounds);
+    std::vector<Detection> SuppressDuplicates(std::vector<Detection> const& detections) const;
+
+    Options m_options;
+    winrt::Microsoft::AI::Skills::Vision::ObjectDetector::ObjectDetectorSkill m_skill = nullptr;
+    winrt::Microsoft::AI::Skills::Vision::ObjectDetector::ObjectDetectorBinding m_binding = nullptr;
+    MotionRegionDetector m_motionDetector;
+    std::vector<Detection> m_detections; // of the last frame
+    uint32_t m_framesSinceFullFrame = 0;
+
+    Timings m_lastTimings;
+    uint64_t m_frameCount = 0;
+    uint64_t m_fullFrameCount = 0;
+    uint64_t m_staticFrameCount = 0;
+    double m_evaluatedFractionSum = 0.0;
+};
@@ -1,14 +1,27 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <future>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <string>
+#include <vector>
 #include <winrt/Windows.Foundation.h>
 #include <winrt/windows.foundation.collections.h>
 #include <winrt/windows.media.h>
 #include <winrt/windows.system.threading.h>
 
+#include "BoxGeometry.h"
 #include "CameraHelper_cppwinrt.h"
+#include "DetectionLogger.h"
+#include "FrameDeadlinePolicy.h"
+#include "FrameRecorder_cppwinrt.h"
+#include "MotionGatedDetector.h"
+#include "SceneEventGenerator.h"
+#include "Tracing.h"
 #include "WindowsVersionHelper.h"
 #include "winrt/Microsoft.AI.Skills.SkillInterface.h"
 #include "winrt/Microsoft.AI.Skills.Vision.ObjectDetector.h"
@@ -22,90 +35,99 @@ using namespace winrt::Windows::Media;
 using namespace Microsoft::AI::Skills::SkillInterface;
 using namespace Microsoft::AI::Skills::Vision::ObjectDetector;
 
-// enum to string lookup table for ObjectKind
-static const std::map<ObjectKind, std::string> ObjectKindLookup = {
-    { ObjectKind::Undefined, "Undefined" },
-    { ObjectKind::Person, "Person" },
-    { ObjectKind::Bicycle, "Bicycle" },
-    { ObjectKind::Car, "Car" },
-    { ObjectKind::Motorbike, "Motorbike" },
-    { ObjectKind::Aeroplane, "Aeroplane" },
-    { ObjectKind::Bus, "Bus" },
-    { ObjectKind::Train, "Train" },
-    { ObjectKind::Truck, "Truck" },
-    { ObjectKind::Boat, "Boat" },
-    { ObjectKind::TrafficLight, "TrafficLight" },
-    { ObjectKind::FireHydrant, "FireHydrant" },
-    { ObjectKind::StopSign, "StopSign" },
-    { ObjectKind::ParkingMeter, "ParkingMeter" },
-    { ObjectKind::Bench, "Bench" },
-    { ObjectKind::Bird, "Bird" },
-    { ObjectKind::Cat, "Cat" },
-    { ObjectKind::Dog, "Dog" },
-    { ObjectKind::Horse, "Horse" },
-    { ObjectKind::Sheep, "Sheep" },
-    { ObjectKind::Cow, "Cow" },
-    { ObjectKind::Elephant, "Elephant" },
-    { ObjectKind::Bear, "Bear" },
-    { ObjectKind::Zebra, "Zebra" },
-    { ObjectKind::Giraffe, "Giraffe" },
-    { ObjectKind::Backpack, "Backpack" },
-    { ObjectKind::Umbrella, "Umbrella" },
-    { ObjectKind::Handbag, "Handbag" },
-    { ObjectKind::Tie, "Tie" },
-    { ObjectKind::Suitcase, "Suitcase" },
-    { ObjectKind::Frisbee, "Frisbee" },
-    { ObjectKind::Skis, "Skis" },
-    { ObjectKind::Snowboard, "Snowboard" },
-    { ObjectKind::SportsBall, "SportsBall" },
-    { ObjectKind::Kite, "Kite" },
-    { ObjectKind::BaseballBat, "BaseballBat" },
-    { ObjectKind::BaseballGlove, "BaseballGlove" },
-    { ObjectKind::Skateboard, "Skateboard" },
-    { ObjectKind::Surfboard, "Surfboard" },
-    { ObjectKind::TennisRacket, "TennisRacket" },
-    { ObjectKind::Bottle, "Bottle" },
-    { ObjectKind::WineGlass, "WineGlass" },
-    { ObjectKind::Cup, "Cup" },
-    { ObjectKind::Fork, "Fork" },
-    { ObjectKind::Knife, "Knife" },
-    { ObjectKind::Spoon, "Spoon" },
-    { ObjectKind::Bowl, "Bowl" },
-    { ObjectKind::Banana, "Banana" },
-    { ObjectKind::Apple, "Apple" },
-    { ObjectKind::Sandwich, "Sandwich" },
-    { ObjectKind::Orange, "Orange" },
-    { ObjectKind::Broccoli, "Broccoli" },
-    { ObjectKind::Carrot, "Carrot" },
-    { ObjectKind::HotDog, "HotDog" },
-    { ObjectKind::Pizza, "Pizza" },
-    { ObjectKind::Donut, "Donut" },
-    { ObjectKind::Cake, "Cake" },
-    { ObjectKind::Chair, "Chair" },
-    { ObjectKind::Sofa, "Sofa" },
-    { ObjectKind::PottedPlant, "PottedPlant" },
-    { ObjectKind::Bed, "Bed" },
-    { ObjectKind::DiningTable, "DiningTable" },
-    { ObjectKind::Toilet, "Toilet" },
-    { ObjectKind::Tvmonitor, "Tvmonitor" },
-    { ObjectKind::Laptop, "Laptop" },
-    { ObjectKind::Mouse, "Mouse" },
-    { ObjectKind::Remote, "Remote" },
-    { ObjectKind::Keyboard, "Keyboard" },
-    { ObjectKind::CellPhone, "CellPhone" },
-    { ObjectKind::Microwave, "Microwave" },
-    { ObjectKind::Oven, "Oven" },
-    { ObjectKind::Toaster, "Toaster" },
-    { ObjectKind::Sink, "Sink" },
-    { ObjectKind::Refrigerator, "Refrigerator" },
-    { ObjectKind::Book, "Book" },
-    { ObjectKind::Clock, "Clock" },
-    { ObjectKind::Vase, "Vase" },
-    { ObjectKind::Scissors, "Scissors" },
-    { ObjectKind::TeddyBear, "TeddyBear" },
-    { ObjectKind::HairDryer, "HairDryer" },
-    { ObjectKind::Toothbrush, "Toothbrush" },
+// enum to string lookup table for ObjectKind, indexed by enum value + 1 since ObjectKind::Undefined is -1
+static constexpr const char* ObjectKindLookup[] = {
+    "Undefined",
+    "Person",
+    "Bicycle",
+    "Car",
+    "Motorbike",
+    "Aeroplane",
+    "Bus",
+    "Train",
+    "Truck",
+    "Boat",
+    "TrafficLight",
+    "FireHydrant",
+    "StopSign",
+    "ParkingMeter",
+    "Bench",
+    "Bird",
+    "Cat",
+    "Dog",
+    "Horse",
+    "Sheep",
+    "Cow",
+    "Elephant",
+    "Bear",
+    "Zebra",
+    "Giraffe",
+    "Backpack",
+    "Umbrella",
+    "Handbag",
+    "Tie",
+    "Suitcase",
+    "Frisbee",
+    "Skis",
+    "Snowboard",
+    "SportsBall",
+    "Kite",
+    "BaseballBat",
+    "BaseballGlove",
+    "Skateboard",
+    "Surfboard",
+    "TennisRacket",
+    "Bottle",
+    "WineGlass",
+    "Cup",
+    "Fork",
+    "Knife",
+    "Spoon",
+    "Bowl",
+    "Banana",
+    "Apple",
+    "Sandwich",
+    "Orange",
+    "Broccoli",
+    "Carrot",
+    "HotDog",
+    "Pizza",
+    "Donut",
+    "Cake",
+    "Chair",
+    "Sofa",
+    "PottedPlant",
+    "Bed",
+    "DiningTable",
+    "Toilet",
+    "Tvmonitor",
+    "Laptop",
+    "Mouse",
+    "Remote",
+    "Keyboard",
+    "CellPhone",
+    "Microwave",
+    "Oven",
+    "Toaster",
+    "Sink",
+    "Refrigerator",
+    "Book",
+    "Clock",
+    "Vase",
+    "Scissors",
+    "TeddyBear",
+    "HairDryer",
+    "Toothbrush",
 };
+static_assert(sizeof(ObjectKindLookup) / sizeof(ObjectKindLookup[0]) == (size_t)ObjectKind::Toothbrush + 2, "ObjectKindLookup must name every ObjectKind");
+
+//
+// Helper method to retrieve the name of an ObjectKind value, nullptr if unknown
+//
+constexpr const char* ObjectKindName(int32_t kind)
+{
+    return (kind >= (int32_t)ObjectKind::Undefined && kind <= (int32_t)ObjectKind::Toothbrush) ? ObjectKindLookup[kind + 1] : nullptr;
+}
 
 // enum to string lookup table for SkillExecutionDeviceKind
 static const std::map<SkillExecutionDeviceKind, std::string> SkillExecutionDeviceKindLookup = {
@@ -117,6 +139,116 @@ static const std::map<SkillExecutionDeviceKind, std::string> SkillExecutionDevic
     { SkillExecutionDeviceKind::Cloud, "Cloud" }
 };
 
+//
+// Helper method to retrieve the value following a named argument, i.e. "-log detections.txt"
+//
+const char* FindOptionValue(const char* optionName)
+{
+    for (int i = 1; i < __argc - 1; i++)
+    {
+        if (strcmp(__argv[i], optionName) == 0)
+        {
+            return __argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+//
+// Helper method to check if a named flag argument was specified, i.e. "-json"
+//
+bool HasOption(const char* optionName)
+{
+    for (int i = 1; i < __argc; i++)
+    {
+        if (strcmp(__argv[i], optionName) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//
+// Create the logger displaying detection results, as text or JSON lines with "-json" and also written to a file with "-log <file path>"
+//
+std::unique_ptr<DetectionLogger> CreateDetectionLogger(DetectionLogger::LabelNameFunction labelName, const char* noResultText)
+{
+    DetectionLogger::Options options;
+    options.format = HasOption("-json") ? DetectionLogger::Format::Json : DetectionLogger::Format::Text;
+    options.noResultText = noResultText;
+    if (auto filePath = FindOptionValue("-log"))
+    {
+        options.filePath = filePath;
+        std::cout << "Logging detections to " << filePath << std::endl;
+    }
+    return std::make_unique<DetectionLogger>(options, labelName);
+}
+
+//
+// Box with the coordinates of a Rect, for BoxGeometry
+//
+static BoxGeometry::Box ToBox(Rect const& rect)
+{
+    return { rect.X, rect.Y, rect.Width, rect.Height };
+}
+
+//
+// Accuracy and cost of motion-gated evaluation compared to whole frame evaluation of the same frames
+//
+struct MotionBenchmark
+{
+    uint64_t frameCount = 0;
+    double motionGatedMsSum = 0.0;
+    double fullFrameMsSum = 0.0;
+    uint64_t motionGatedDetectionCount = 0;
+    uint64_t fullFrameDetectionCount = 0;
+    uint64_t matchedDetectionCount = 0;
+
+    //
+    // Match each whole frame detection to a motion-gated detection of the same kind overlapping it enough
+    //
+    void Record(
+        float motionGatedMs,
+        float fullFrameMs,
+        std::vector<MotionGatedDetector::Detection> const& motionGatedDetections,
+        std::vector<MotionGatedDetector::Detection> const& fullFrameDetections)
+    {
+        frameCount++;
+        motionGatedMsSum += motionGatedMs;
+        fullFrameMsSum += fullFrameMs;
+        motionGatedDetectionCount += motionGatedDetections.size();
+        fullFrameDetectionCount += fullFrameDetections.size();
+        std::vector<bool> isMatched(motionGatedDetections.size(), false);
+        for (auto&& reference : fullFrameDetections)
+        {
+            for (size_t i = 0; i < motionGatedDetections.size(); i++)
+            {
+                if (!isMatched[i]
+                    && motionGatedDetections[i].kind == reference.kind
+                    && BoxGeometry::IoU(ToBox(motionGatedDetections[i].rect), ToBox(reference.rect)) >= 0.5f)
+                {
+                    isMatched[i] = true;
+                    matchedDetectionCount++;
+                    break;
+                }
+            }
+        }
+    }
+
+    void Print() const
+    {
+        if (frameCount == 0)
+        {
+            return;
+        }
+        std::cout << "Benchmark over " << frameCount << " frames: motion-gated " << motionGatedMsSum / frameCount
+            << "ms/frame vs whole frame " << fullFrameMsSum / frameCount << "ms/frame | recall "
+            << (fullFrameDetectionCount > 0 ? 100.0 * matchedDetectionCount / fullFrameDetectionCount : 100.0) << "% | precision "
+            << (motionGatedDetectionCount > 0 ? 100.0 * matchedDetectionCount / motionGatedDetectionCount : 100.0) << "%" << std::endl;
+    }
+};
+
 //
 // App main loop
 //
@@ -131,98 +263,320 @@ int main()
             throw_hresult(hr);
         }
         std::cout << "Object Detector C++/WinRT Non-packaged(win32) console App: Place something to detect in front of the camera" << std::endl;
+        std::cout << "Optional arguments: -json to display results as JSON lines, -log <file path> to also write them to a file, "
+            << "-deadline <milliseconds> to discard frames older than that before evaluation, "
+            << "-record <file path> to record the camera session, -replay <file path> to replay a recorded session instead of using the camera "
+            << "with its original timing, or as fast as possible with -fast, "
+            << "-motion to only evaluate the regions that changed since the previous frame, along with -benchmark to compare it with whole frame evaluation, "
+            << "-events to only display the objects entering, moving in and exiting the scene rather than the results of every frame" << std::endl;
 
         // Set and run skill
         try
         {
             // Create the ObjectDetector skill descriptor
             auto skillDescriptor = ObjectDetectorDescriptor().as<ISkillDescriptor>();
-
-            // Create instance of the skill
-            auto skill = skillDescriptor.CreateSkillAsync().get().as<ObjectDetectorSkill>();
-            std::cout << "Running Skill on : " << SkillExecutionDeviceKindLookup.at(skill.Device().ExecutionDeviceKind());
-            std::wcout << L" : " << skill.Device().Name().c_str() << std::endl;
             std::cout << std::fixed;
             std::cout.precision(3);
 
-            // Create instance of the skill binding
-            auto binding = skill.CreateSkillBindingAsync().get().as<ObjectDetectorBinding>();
+            // Create instances of the skill and its binding on another thread while the camera is brought up,
+            // frames arriving before they are ready are skipped
+            auto startupBegin = std::chrono::high_resolution_clock::now();
+            ObjectDetectorSkill skill = nullptr;
+            ObjectDetectorBinding binding = nullptr;
+            float skillCreationTime = 0.0f;
+            float bindingCreationTime = 0.0f;
+            auto skillCreation = std::async(std::launch::async, [&]()
+            {
+                auto begin = std::chrono::high_resolution_clock::now();
+                skill = skillDescriptor.CreateSkillAsync().get().as<ObjectDetectorSkill>();
+                auto end = std::chrono::high_resolution_clock::now();
+                skillCreationTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+                begin = end;
+                binding = skill.CreateSkillBindingAsync().get().as<ObjectDetectorBinding>();
+                end = std::chrono::high_resolution_clock::now();
+                bindingCreationTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+            });
+            std::atomic<bool> isSkillReady = false;
+            std::atomic<uint64_t> startupFrameCount = 0;
+
+            // Create the logger that formats and displays results off the evaluation thread
+            auto logger = CreateDetectionLogger(ObjectKindName, "---------------- No object detected ----------------");
+            uint64_t frameId = 0;
+
+            // Track the age of frames from capture to result, discarding the ones older than the deadline if specified
+            auto deadlineValue = FindOptionValue("-deadline");
+            auto deadlinePolicy = std::make_shared<FrameDeadlinePolicy>(deadlineValue != nullptr ? atof(deadlineValue) : 0.0);
+            if (deadlinePolicy->DeadlineMs() > 0)
+            {
+                std::cout << "Discarding frames older than " << deadlinePolicy->DeadlineMs() << "ms" << std::endl;
+            }
+
+            // Only evaluate the regions of the frames that changed if specified, on a binding of its own
+            std::unique_ptr<MotionGatedDetector> motionGatedDetector;
+            bool isBenchmark = HasOption("-benchmark");
+            MotionBenchmark motionBenchmark;
+
+            // Turn the results of frames into events of objects entering, moving in and exiting the scene if specified
+            std::unique_ptr<SceneEventGenerator> eventGenerator;
+            std::vector<SceneEventGenerator::Detection> eventDetections;
+            std::vector<SceneEventGenerator::Event> events;
+            if (HasOption("-events"))
+            {
+                eventGenerator = std::make_unique<SceneEventGenerator>(SceneEventGenerator::Options());
+                std::cout << "Displaying the objects entering, moving in and exiting the scene" << std::endl;
+            }
 
             // Create a mutex to orchestrate skill evaluation one at a time
             winrt::slim_mutex lock;
+            std::atomic<uint64_t> busyFrameCount = 0;
 
-            // Initialize Camera and register a frame callback handler
-            auto cameraHelper = std::shared_ptr<CameraHelper>(
-                CameraHelper::CreateCameraHelper(
-                    [&](std::string failureMessage) // lambda function that acts as callback for failure event
-                    {
-                        std::cerr << failureMessage;
-                        return 1;
-                    },
-                    [&](VideoFrame const& videoFrame) // lambda function that acts as callback for new frame event
-                    {
-                        // Lock context so multiple overlapping events from FrameReader do not race for the resources.
-                        if (!lock.try_lock())
-                        {
-                            return;
-                        }
+            // lambda function that acts as callback for failure event
+            auto failureHandler = [&](std::string failureMessage)
+            {
+                std::cerr << failureMessage;
+                return 1;
+            };
+
+            // lambda function that acts as callback for new frame event
+            auto frameHandler = [&](VideoFrame const& videoFrame)
+            {
+                // Skip the frames arriving while the skill is being created
+                if (!isSkillReady)
+                {
+                    startupFrameCount++;
+                    return;
+                }
+
+                // Lock context so multiple overlapping events from FrameReader do not race for the resources.
+                if (!lock.try_lock())
+                {
+                    busyFrameCount++;
+                    return;
+                }
 
-                        // measure time spent binding and evaluating
-                        auto begin = std::chrono::high_resolution_clock::now();
+                // Evaluate the whole frame
+                float bindTime = 0.0f;
+                float evalTime = 0.0f;
+                auto evaluateFullFrame = [&]()
+                {
+                    // measure time spent binding and evaluating
+                    auto begin = std::chrono::high_resolution_clock::now();
 
-                        // Set the video frame on the skill binding.
+                    // Set the video frame on the skill binding.
+                    {
+                        SAMPLES_TRACE_SCOPE("Bind");
                         binding.SetInputImageAsync(videoFrame).get();
+                    }
 
-                        auto end = std::chrono::high_resolution_clock::now();
-                        auto bindTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
-                        begin = std::chrono::high_resolution_clock::now();
+                    auto end = std::chrono::high_resolution_clock::now();
+                    bindTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+                    begin = std::chrono::high_resolution_clock::now();
 
-                        // Detect objects in video frame using the skill
+                    // Detect objects in video frame using the skill
+                    {
+                        SAMPLES_TRACE_SCOPE("Evaluate");
                         skill.EvaluateAsync(binding).get();
+                    }
+
+                    end = std::chrono::high_resolution_clock::now();
+                    evalTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+
+                    SAMPLES_TRACE_SCOPE("Extract");
+                    std::vector<MotionGatedDetector::Detection> detections;
+                    for (auto&& obj : binding.DetectedObjects())
+                    {
+                        detections.push_back({ (int32_t)obj.Kind(), obj.Rect(), false });
+                    }
+                    return detections;
+                };
+
+                std::vector<MotionGatedDetector::Detection> detectedObjects;
+                if (motionGatedDetector != nullptr)
+                {
+                    // Only evaluate the regions that changed, the motion map is accounted as binding time
+                    detectedObjects = motionGatedDetector->Evaluate(videoFrame);
+                    auto& timings = motionGatedDetector->LastTimings();
+                    if (isBenchmark)
+                    {
+                        auto fullFrameDetections = evaluateFullFrame();
+                        motionBenchmark.Record(timings.motionMs + timings.bindMs + timings.evaluateMs, bindTime + evalTime, detectedObjects, fullFrameDetections);
+                    }
+                    bindTime = timings.motionMs + timings.bindMs;
+                    evalTime = timings.evaluateMs;
+                }
+                else
+                {
+                    detectedObjects = evaluateFullFrame();
+                }
+
+                auto captureTime = CameraHelper::GetCaptureTime(videoFrame);
+                if (captureTime >= 0)
+                {
+                    deadlinePolicy->RecordResult(captureTime);
+                }
+
+                // Log bind and eval time along with detection results, they get displayed by a background thread
+                if (eventGenerator != nullptr)
+                {
+                    // Only log what changed in the scene
+                    SAMPLES_TRACE_SCOPE("Log");
+                    frameId++;
+                    eventDetections.clear();
+                    for (auto&& obj : detectedObjects)
+                    {
+                        eventDetections.push_back({ obj.kind, ToBox(obj.rect) });
+                    }
+                    events.clear();
+                    eventGenerator->UpdateObjects(0, frameId, eventDetections, events);
+                    for (auto&& event : events)
+                    {
+                        logger->LogEvent(event);
+                    }
+                }
+                else
+                {
+                    SAMPLES_TRACE_SCOPE("Log");
+                    frameId++;
+                    logger->LogFrame(frameId, bindTime, evalTime, (uint32_t)detectedObjects.size());
+                    for (auto&& obj : detectedObjects)
+                    {
+                        logger->LogObject(frameId, obj.kind, obj.rect.X, obj.rect.Y, obj.rect.Width, obj.rect.Height);
+                    }
+                }
 
-                        end = std::chrono::high_resolution_clock::now();
-                        auto evalTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+                videoFrame.Close();
 
-                        auto detectedObjects = binding.DetectedObjects();
+                lock.unlock();
+            };
 
-                        // Display bind and eval time
-                        std::cout << "bind: " << bindTime << "ms | ";
-                        std::cout << "eval: " << evalTime << "ms | ";
+            // Wait for the skill and its binding, then create what depends on them and let frames through
+            auto waitForSkill = [&]()
+            {
+                skillCreation.get();
+                std::cout << "Running Skill on : " << SkillExecutionDeviceKindLookup.at(skill.Device().ExecutionDeviceKind());
+                std::wcout << L" : " << skill.Device().Name().c_str() << std::endl;
 
-                        // Refresh the displayed line with detection result
-                        if (detectedObjects.Size() > 0)
-                        {
-                            for (auto&& obj : detectedObjects)
-                            {
-                                std::cout << ObjectKindLookup.at(obj.Kind()) << " ";
-                            }
-                        }
-                        else
-                        {
-                            std::cout << "---------------- No object detected ----------------";
-                        }
-                        std::cout << "\r";
+                // Only evaluate the regions of the frames that changed if specified, on a binding of its own
+                if (HasOption("-motion"))
+                {
+                    auto detector = std::make_unique<MotionGatedDetector>(skill, MotionGatedDetector::Options());
+                    lock.lock();
+                    motionGatedDetector = std::move(detector);
+                    lock.unlock();
+                    std::cout << "Evaluating the regions that changed since the previous frame"
+                        << (isBenchmark ? ", compared with whole frame evaluation" : "") << std::endl;
+                }
+                isSkillReady = true;
+            };
 
-                        videoFrame.Close();
+            if (auto replayPath = FindOptionValue("-replay"))
+            {
+                // Replay a recorded session in place of the camera until its last frame was handled, all of them evaluated
+                waitForSkill();
+                auto timing = HasOption("-fast") ? FrameReplaySource::Timing::AsFastAsPossible : FrameReplaySource::Timing::Recorded;
+                FrameReplaySource replaySource(replayPath, timing, failureHandler, frameHandler, deadlinePolicy);
+                replaySource.Wait();
+                std::cout << std::endl << "Replay completed: " << replaySource.EmittedFrameCount() << " frames emitted";
+            }
+            else
+            {
+                // Record the camera session if specified
+                std::shared_ptr<FrameRecorder> recorder;
+                if (auto recordPath = FindOptionValue("-record"))
+                {
+                    recorder = std::make_shared<FrameRecorder>(recordPath);
+                    std::cout << "Recording the camera session to " << recordPath << std::endl;
+                }
+
+                // Frames stopped while the camera was reopened, the previous frame of the motion map no longer matches the next one
+                auto gapHandler = [&](CameraReconnector::Gap const& gap)
+                {
+                    std::cout << std::endl << "Camera recovered after " << (gap.endTime - gap.startTime) / FrameDeadlinePolicy::TicksPerMs
+                        << "ms | ~" << gap.lostFrameCount << " frames lost" << std::endl;
+                    lock.lock();
+                    if (motionGatedDetector != nullptr)
+                    {
+                        motionGatedDetector->Reset();
+                    }
+                    lock.unlock();
+                };
 
-                        lock.unlock();
-                    }));
+                // Initialize Camera and register a frame callback handler
+                auto cameraHelper = std::shared_ptr<CameraHelper>(CameraHelper::CreateCameraHelper(failureHandler, frameHandler, deadlinePolicy, recorder, gapHandler));
+                waitForSkill();
 
-            std::cout << "\t\t\t\t\t\t\t\t...press enter to Stop" << std::endl;
+                // Display how long each phase of the startup took, the skill was created while the camera was brought up
+                auto startupTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - startupBegin).count() / 1000000.0f;
+                std::cout << "Startup | skill: " << skillCreationTime << "ms | binding: " << bindingCreationTime << "ms | "
+                    << cameraHelper->LastStartupProfile().ToString() << std::endl;
+                std::cout << "Ready after " << startupTime << "ms | frames skipped meanwhile: " << startupFrameCount << std::endl;
 
-            // Wait for enter keypress
-            while (std::cin.get() != '\n');
+                std::cout << "\t\t\t\t\t\t\t\t...press enter to Stop" << std::endl;
 
-            std::cout << std::endl << "Key pressed.. exiting";
+                // Wait for enter keypress
+                while (std::cin.get() != '\n');
 
-            // De-initialize the MediaCapture and FrameReader
-            cameraHelper->Cleanup();
+                std::cout << std::endl << "Key pressed.. exiting";
+
+                // De-initialize the MediaCapture and FrameReader
+                cameraHelper->Cleanup();
+                auto reconnectStatistics = cameraHelper->ReconnectStatistics();
+                if (reconnectStatistics.failureCount > 0)
+                {
+                    std::cout << std::endl << "Camera failures: " << reconnectStatistics.failureCount << " | recovered: " << reconnectStatistics.recoveryCount
+                        << " | longest recovery: " << reconnectStatistics.maxRecoveryMs << "ms | frames lost: " << reconnectStatistics.lostFrameCount;
+                }
+
+                // Write the remaining recorded frames
+                if (recorder != nullptr)
+                {
+                    recorder->Close();
+                    std::cout << std::endl << "Recorded " << recorder->RecordedFrameCount() << " frames | "
+                        << recorder->SkippedFrameCount() << " arrivals without pixels | "
+                        << recorder->BytesWritten() / (1024 * 1024) << "MB";
+                }
+            }
+
+            // Write the remaining queued results
+            logger->Close();
+
+            // Display how old results were when they were produced
+            auto& resultAges = deadlinePolicy->ResultAges();
+            std::cout << std::endl << "Result age from capture: p50 " << resultAges.Percentile(0.5) << "ms | p90 " << resultAges.Percentile(0.9)
+                << "ms | p99 " << resultAges.Percentile(0.99) << "ms | max " << resultAges.MaxMs() << "ms" << std::endl;
+            std::cout << "Frames admitted: " << deadlinePolicy->AdmittedFrameCount() << " | discarded stale: " << deadlinePolicy->DiscardedFrameCount()
+                << " | results past deadline: " << deadlinePolicy->LateResultCount()
+                << " | skipped while busy: " << busyFrameCount << std::endl;
+
+            // Display how much of the frames was evaluated in motion-gated mode
+            if (motionGatedDetector != nullptr)
+            {
+                std::cout << "Motion-gated frames: " << motionGatedDetector->FrameCount() << " | evaluated as a whole: " << motionGatedDetector->FullFrameCount()
+                    << " | static: " << motionGatedDetector->StaticFrameCount()
+                    << " | average evaluated area: " << 100.0 * motionGatedDetector->AverageEvaluatedFraction() << "%" << std::endl;
+                motionBenchmark.Print();
+            }
+
+            // Display how many events stood for the results of all frames
+            if (eventGenerator != nullptr)
+            {
+                auto eventStatistics = eventGenerator->GetStatistics();
+                std::cout << "Events: " << eventStatistics.eventCount << " for " << eventStatistics.frameCount << " frames" << std::endl;
+            }
+
+            // Write the events traced while processing frames, when built with SKILLS_SAMPLES_ENABLE_TRACING
+            SAMPLES_TRACE_DUMP("ObjectDetectorSample_Desktop.trace.json");
         }
         catch (hresult_error const& ex)
         {
             std::wcerr << "Error:" << ex.message().c_str() << ":" << std::hex << ex.code().value << std::endl;
             return ex.code().value;
         }
+        catch (std::exception const& ex)
+        {
+            std::cerr << "Error:" << ex.what() << std::endl;
+            return 1;
+        }
         return 0;
     }
     catch (hresult_error const& ex)
@@ -0,0 +1,469 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#include "PoseAnalyzer.h"
+#include <algorithm>
+#include <bitset>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#ifdef POSE_ANALYZER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Triplets of JointLabel values, the angle is measured at the middle joint
+const uint8_t PoseAnalyzer::AngleJoints[AngleCount][3] = {
+    { 2, 3, 4 }, // RightShoulder-RightElbow-RightWrist
+    { 5, 6, 7 }, // LeftShoulder-LeftElbow-LeftWrist
+    { 1, 2, 3 }, // Neck-RightShoulder-RightElbow
+    { 1, 5, 6 }, // Neck-LeftShoulder-LeftElbow
+    { 8, 9, 10 }, // RightHip-RightKnee-RightAnkle
+    { 11, 12, 13 }, // LeftHip-LeftKnee-LeftAnkle
+    { 1, 8, 9 }, // Neck-RightHip-RightKnee
+    { 1, 11, 12 } // Neck-LeftHip-LeftKnee
+};
+
+// Pairs of JointLabel values
+const uint8_t PoseAnalyzer::LimbJoints[LimbCount][2] = {
+    { 1, 2 }, { 1, 5 }, { 2, 3 }, { 3, 4 }, { 5, 6 }, { 6, 7 },
+    { 1, 8 }, { 8, 9 }, { 9, 10 }, { 1, 11 }, { 11, 12 }, { 12, 13 },
+    { 1, 0 }, { 0, 14 }, { 14, 16 }, { 0, 15 }, { 15, 17 }
+};
+
+static const float Pi = 3.14159265f;
+
+// Frame period assumed when the time elapsed since the previous frame is unknown
+static const double DefaultFramePeriod = 1.0 / 30.0;
+
+//
+// Minimax polynomial approximation of atan(x) for x in [0, 1], max error ~1e-5 radian
+//
+static float AtanUnit(float x)
+{
+    float x2 = x * x;
+    return x * (0.99997726f + x2 * (-0.33262347f + x2 * (0.19354346f + x2 * (-0.11643287f + x2 * (0.05265332f + x2 * -0.01172120f)))));
+}
+
+//
+// Approximation of atan2(y, x) following the same steps as its SIMD counterpart
+//
+static float Atan2(float y, float x)
+{
+    float ax = std::fabs(x);
+    float ay = std::fabs(y);
+    float result = AtanUnit(std::min(ax, ay) / std::max(std::max(ax, ay), FLT_MIN));
+    if (ay > ax)
+    {
+        result = Pi / 2 - result;
+    }
+    if (x < 0.0f)
+    {
+        result = Pi - result;
+    }
+    return std::copysign(result, y);
+}
+
+//
+// One-Euro filter over count values: the cutoff frequency of the low-pass filter applied to each value
+// rises with the speed of the value, which is itself low-pass filtered with a fixed cutoff
+//
+static void OneEuroFilterScalar(float* positions, float* derivatives, const float* measurements, size_t count, float rate, const PoseAnalyzer::Options& options)
+{
+    float derivativeAlpha = (2 * Pi * options.derivativeCutoff) / (2 * Pi * options.derivativeCutoff + rate);
+    for (size_t i = 0; i < count; i++)
+    {
+        float delta = (measurements[i] - positions[i]) * rate;
+        derivatives[i] += derivativeAlpha * (delta - derivatives[i]);
+        float cutoff = 2 * Pi * (options.minCutoff + options.beta * std::fabs(derivatives[i]));
+        float alpha = cutoff / (cutoff + rate);
+        positions[i] += alpha * (measurements[i] - positions[i]);
+    }
+}
+
+struct BoundingBox
+{
+    float left;
+    float top;
+    float right;
+    float bottom;
+};
+
+static BoundingBox GetBoundingBox(const float* joints, uint32_t validJoints)
+{
+    BoundingBox box = { FLT_MAX, FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (uint32_t joint = 0; joint < PoseAnalyzer::JointCount; joint++)
+    {
+        if (validJoints & (1u << joint))
+        {
+            box.left = std::min(box.left, joints[joint * 2]);
+            box.right = std::max(box.right, joints[joint * 2]);
+            box.top = std::min(box.top, joints[joint * 2 + 1]);
+            box.bottom = std::max(box.bottom, joints[joint * 2 + 1]);
+        }
+    }
+    return box;
+}
+
+#ifdef POSE_ANALYZER_USE_SSE2
+
+static __m128 Select(__m128 mask, __m128 ifTrue, __m128 ifFalse)
+{
+    return _mm_or_ps(_mm_and_ps(mask, ifTrue), _mm_andnot_ps(mask, ifFalse));
+}
+
+static __m128 AtanUnit(__m128 x)
+{
+    __m128 x2 = _mm_mul_ps(x, x);
+    __m128 result = _mm_set1_ps(-0.01172120f);
+    result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(0.05265332f));
+    result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(-0.11643287f));
+    result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(0.19354346f));
+    result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(-0.33262347f));
+    result = _mm_add_ps(_mm_mul_ps(result, x2), _mm_set1_ps(0.99997726f));
+    return _mm_mul_ps(result, x);
+}
+
+static __m128 Atan2(__m128 y, __m128 x)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 ax = _mm_andnot_ps(signMask, x);
+    __m128 ay = _mm_andnot_ps(signMask, y);
+    __m128 result = AtanUnit(_mm_div_ps(_mm_min_ps(ax, ay), _mm_max_ps(_mm_max_ps(ax, ay), _mm_set1_ps(FLT_MIN))));
+    result = Select(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(Pi / 2), result), result);
+    result = Select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(Pi), result), result);
+    return _mm_or_ps(result, _mm_and_ps(y, signMask));
+}
+
+static void OneEuroFilterSse2(float* positions, float* derivatives, const float* measurements, size_t count, float rate, const PoseAnalyzer::Options& options)
+{
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 rateVector = _mm_set1_ps(rate);
+    const __m128 derivativeAlpha = _mm_set1_ps((2 * Pi * options.derivativeCutoff) / (2 * Pi * options.derivativeCutoff + rate));
+    const __m128 minCutoff = _mm_set1_ps(options.minCutoff);
+    const __m128 beta = _mm_set1_ps(options.beta);
+    const __m128 twoPi = _mm_set1_ps(2 * Pi);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 position = _mm_loadu_ps(positions + i);
+        __m128 derivative = _mm_loadu_ps(derivatives + i);
+        __m128 measurement = _mm_loadu_ps(measurements + i);
+
+        __m128 delta = _mm_mul_ps(_mm_sub_ps(measurement, position), rateVector);
+        derivative = _mm_add_ps(derivative, _mm_mul_ps(derivativeAlpha, _mm_sub_ps(delta, derivative)));
+        __m128 cutoff = _mm_mul_ps(twoPi, _mm_add_ps(minCutoff, _mm_mul_ps(beta, _mm_andnot_ps(signMask, derivative))));
+        __m128 alpha = _mm_div_ps(cutoff, _mm_add_ps(cutoff, rateVector));
+        position = _mm_add_ps(position, _mm_mul_ps(alpha, _mm_sub_ps(measurement, position)));
+
+        _mm_storeu_ps(positions + i, position);
+        _mm_storeu_ps(derivatives + i, derivative);
+    }
+    OneEuroFilterScalar(positions + i, derivatives + i, measurements + i, count - i, rate, options);
+}
+
+// Gather a value at the same offset of 4 consecutive bodies
+static __m128 Gather(const float* values, size_t body, size_t stride, size_t offset)
+{
+    return _mm_setr_ps(
+        values[body * stride + offset],
+        values[(body + 1) * stride + offset],
+        values[(body + 2) * stride + offset],
+        values[(body + 3) * stride + offset]);
+}
+
+// Scatter 4 values to the same offset of 4 consecutive bodies
+static void Scatter(__m128 source, float* values, size_t body, size_t stride, size_t offset)
+{
+    float lanes[4];
+    _mm_storeu_ps(lanes, source);
+    for (size_t i = 0; i < 4; i++)
+    {
+        values[(body + i) * stride + offset] = lanes[i];
+    }
+}
+
+#endif
+
+PoseAnalyzer::PoseAnalyzer(Options const& options)
+    : m_options(options)
+{
+}
+
+void PoseAnalyzer::Reset()
+{
+    m_hasTimestamp = false;
+    m_tracks.clear();
+    m_trackPositions.clear();
+    m_trackDerivatives.clear();
+    m_bodyToTrack.clear();
+    m_validJoints.clear();
+}
+
+//
+// Ingest the bodies detected in a frame captured at the specified time in seconds
+//
+void PoseAnalyzer::Update(const std::vector<Body>& bodies, double timestamp)
+{
+    double period = (m_hasTimestamp && timestamp > m_lastTimestamp) ? timestamp - m_lastTimestamp : DefaultFramePeriod;
+    float rate = (float)(1.0 / period);
+    m_lastTimestamp = timestamp;
+    m_hasTimestamp = true;
+
+    RemoveStaleTracks();
+    MatchBodies(bodies);
+
+    // Smooth the joints of all tracked bodies in a single pass over the packed arrays
+    size_t valueCount = m_tracks.size() * FloatsPerBody;
+#ifdef POSE_ANALYZER_USE_SSE2
+    if (m_options.useSimd)
+    {
+        OneEuroFilterSse2(m_trackPositions.data(), m_trackDerivatives.data(), m_measurements.data(), valueCount, rate, m_options);
+    }
+    else
+#endif
+    {
+        OneEuroFilterScalar(m_trackPositions.data(), m_trackDerivatives.data(), m_measurements.data(), valueCount, rate, m_options);
+    }
+
+    // Pack the results in the order of the bodies, padded with zeros to a multiple of 4 bodies
+    size_t bodyCount = bodies.size();
+    size_t paddedBodyCount = (bodyCount + 3) & ~(size_t)3;
+    m_validJoints.resize(bodyCount);
+    m_joints.assign(paddedBodyCount * FloatsPerBody, 0.0f);
+    m_velocities.assign(paddedBodyCount * FloatsPerBody, 0.0f);
+    m_angles.assign(paddedBodyCount * AngleCount, 0.0f);
+    m_limbSpeeds.assign(paddedBodyCount * LimbCount, 0.0f);
+    for (size_t body = 0; body < bodyCount; body++)
+    {
+        size_t track = m_bodyToTrack[body];
+        m_validJoints[body] = bodies[body].validJoints;
+        memcpy(&m_joints[body * FloatsPerBody], &m_trackPositions[track * FloatsPerBody], FloatsPerBody * sizeof(float));
+        memcpy(&m_velocities[body * FloatsPerBody], &m_trackDerivatives[track * FloatsPerBody], FloatsPerBody * sizeof(float));
+    }
+
+    ComputeKinematics(bodyCount);
+}
+
+//
+// Forget the bodies that went undetected for too long, keeping the packed arrays contiguous
+//
+void PoseAnalyzer::RemoveStaleTracks()
+{
+    size_t kept = 0;
+    for (size_t track = 0; track < m_tracks.size(); track++)
+    {
+        if (m_tracks[track].missedFrames > m_options.maxMissedFrames)
+        {
+            continue;
+        }
+        if (kept != track)
+        {
+            m_tracks[kept] = m_tracks[track];
+            memcpy(&m_trackPositions[kept * FloatsPerBody], &m_trackPositions[track * FloatsPerBody], FloatsPerBody * sizeof(float));
+            memcpy(&m_trackDerivatives[kept * FloatsPerBody], &m_trackDerivatives[track * FloatsPerBody], FloatsPerBody * sizeof(float));
+        }
+        kept++;
+    }
+    m_tracks.resize(kept);
+    m_trackPositions.resize(kept * FloatsPerBody);
+    m_trackDerivatives.resize(kept * FloatsPerBody);
+}
+
+//
+// Greedily pair bodies with the tracked bodies whose skeleton is the nearest, starting with the closest pairs.
+// Unmatched bodies start new tracks and the new joint positions become the measurements to filter.
+//
+void PoseAnalyzer::MatchBodies(const std::vector<Body>& bodies)
+{
+    struct Candidate
+    {
+        float distance;
+        size_t body;
+        size_t track;
+    };
+    std::vector<Candidate> candidates;
+    candidates.reserve(bodies.size() * m_tracks.size());
+
+    // Every joint distance is at least the gap between the bounding boxes of both skeletons,
+    // which rules out most pairs without visiting their joints
+    std::vector<BoundingBox> bodyBoxes(bodies.size());
+    for (size_t body = 0; body < bodies.size(); body++)
+    {
+        bodyBoxes[body] = GetBoundingBox(&bodies[body].joints[0][0], bodies[body].validJoints);
+    }
+    std::vector<BoundingBox> trackBoxes(m_tracks.size());
+    for (size_t track = 0; track < m_tracks.size(); track++)
+    {
+        trackBoxes[track] = GetBoundingBox(&m_trackPositions[track * FloatsPerBody], m_tracks[track].validJoints);
+    }
+
+    for (size_t body = 0; body < bodies.size(); body++)
+    {
+        for (size_t track = 0; track < m_tracks.size(); track++)
+        {
+            const BoundingBox& a = bodyBoxes[body];
+            const BoundingBox& b = trackBoxes[track];
+            float gapX = std::max(a.left - b.right, b.left - a.right);
+            float gapY = std::max(a.top - b.bottom, b.top - a.bottom);
+            if (gapX > m_options.maxMatchDistance || gapY > m_options.maxMatchDistance)
+            {
+                continue;
+            }
+
+            // Mean distance between the joints both skeletons have, given up once it cannot be close enough anymore
+            uint32_t commonJoints = bodies[body].validJoints & m_tracks[track].validJoints;
+            if (commonJoints == 0)
+            {
+                continue;
+            }
+            size_t jointCount = std::bitset<JointCount>(commonJoints).count();
+            float maxDistanceSum = m_options.maxMatchDistance * jointCount;
+            const float* trackJoints = &m_trackPositions[track * FloatsPerBody];
+            float distanceSum = 0.0f;
+            for (uint32_t joint = 0; joint < JointCount && distanceSum <= maxDistanceSum; joint++)
+            {
+                if (commonJoints & (1u << joint))
+                {
+                    float dx = bodies[body].joints[joint][0] - trackJoints[joint * 2];
+                    float dy = bodies[body].joints[joint][1] - trackJoints[joint * 2 + 1];
+                    distanceSum += std::sqrt(dx * dx + dy * dy);
+                }
+            }
+            if (distanceSum <= maxDistanceSum)
+            {
+                candidates.push_back({ distanceSum / jointCount, body, track });
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [](const Candidate& a, const Candidate& b) { return a.distance < b.distance; });
+
+    const size_t unmatched = std::numeric_limits<size_t>::max();
+    m_bodyToTrack.assign(bodies.size(), unmatched);
+    std::vector<bool> isTrackMatched(m_tracks.size(), false);
+    for (auto&& candidate : candidates)
+    {
+        if (m_bodyToTrack[candidate.body] == unmatched && !isTrackMatched[candidate.track])
+        {
+            m_bodyToTrack[candidate.body] = candidate.track;
+            isTrackMatched[candidate.track] = true;
+        }
+    }
+    for (size_t track = 0; track < m_tracks.size(); track++)
+    {
+        m_tracks[track].missedFrames = isTrackMatched[track] ? 0 : m_tracks[track].missedFrames + 1;
+    }
+
+    // Start tracking new bodies from their current joints
+    for (size_t body = 0; body < bodies.size(); body++)
+    {
+        if (m_bodyToTrack[body] == unmatched)
+        {
+            m_bodyToTrack[body] = m_tracks.size();
+            m_tracks.push_back({ m_nextId++, 0, 0 });
+            m_trackPositions.insert(m_trackPositions.end(), &bodies[body].joints[0][0], &bodies[body].joints[0][0] + FloatsPerBody);
+            m_trackDerivatives.insert(m_trackDerivatives.end(), FloatsPerBody, 0.0f);
+        }
+    }
+
+    // Measurements default to the current positions so that undetected joints and bodies hold still
+    m_measurements = m_trackPositions;
+    for (size_t body = 0; body < bodies.size(); body++)
+    {
+        size_t track = m_bodyToTrack[body];
+        m_tracks[track].validJoints = bodies[body].validJoints;
+        for (uint32_t joint = 0; joint < JointCount; joint++)
+        {
+            if (bodies[body].validJoints & (1u << joint))
+            {
+                m_measurements[track * FloatsPerBody + joint * 2] = bodies[body].joints[joint][0];
+                m_measurements[track * FloatsPerBody + joint * 2 + 1] = bodies[body].joints[joint][1];
+            }
+        }
+    }
+}
+
+//
+// Compute joint angles and limb speeds of all bodies from their smoothed joints and velocities
+//
+void PoseAnalyzer::ComputeKinematics(size_t bodyCount)
+{
+    size_t body = 0;
+#ifdef POSE_ANALYZER_USE_SSE2
+    if (m_options.useSimd)
+    {
+        // 4 bodies at a time, the arrays are padded accordingly
+        const __m128 aspectRatio = _mm_set1_ps(m_options.aspectRatio);
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        for (; body < bodyCount; body += 4)
+        {
+            for (uint32_t angle = 0; angle < AngleCount; angle++)
+            {
+                const uint8_t* joints = AngleJoints[angle];
+                __m128 vertexX = Gather(m_joints.data(), body, FloatsPerBody, joints[1] * 2);
+                __m128 vertexY = Gather(m_joints.data(), body, FloatsPerBody, joints[1] * 2 + 1);
+                __m128 x1 = _mm_mul_ps(_mm_sub_ps(Gather(m_joints.data(), body, FloatsPerBody, joints[0] * 2), vertexX), aspectRatio);
+                __m128 y1 = _mm_sub_ps(Gather(m_joints.data(), body, FloatsPerBody, joints[0] * 2 + 1), vertexY);
+                __m128 x2 = _mm_mul_ps(_mm_sub_ps(Gather(m_joints.data(), body, FloatsPerBody, joints[2] * 2), vertexX), aspectRatio);
+                __m128 y2 = _mm_sub_ps(Gather(m_joints.data(), body, FloatsPerBody, joints[2] * 2 + 1), vertexY);
+                __m128 dot = _mm_add_ps(_mm_mul_ps(x1, x2), _mm_mul_ps(y1, y2));
+                __m128 cross = _mm_sub_ps(_mm_mul_ps(x1, y2), _mm_mul_ps(y1, x2));
+                Scatter(Atan2(_mm_andnot_ps(signMask, cross), dot), m_angles.data(), body, AngleCount, angle);
+            }
+            for (uint32_t limb = 0; limb < LimbCount; limb++)
+            {
+                const uint8_t* joints = LimbJoints[limb];
+                __m128 vx = _mm_mul_ps(_mm_add_ps(Gather(m_velocities.data(), body, FloatsPerBody, joints[0] * 2), Gather(m_velocities.data(), body, FloatsPerBody, joints[1] * 2)), half);
+                __m128 vy = _mm_mul_ps(_mm_add_ps(Gather(m_velocities.data(), body, FloatsPerBody, joints[0] * 2 + 1), Gather(m_velocities.data(), body, FloatsPerBody, joints[1] * 2 + 1)), half);
+                vx = _mm_mul_ps(vx, aspectRatio);
+                Scatter(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy))), m_limbSpeeds.data(), body, LimbCount, limb);
+            }
+        }
+    }
+#endif
+    for (; body < bodyCount; body++)
+    {
+        const float* joints = &m_joints[body * FloatsPerBody];
+        const float* velocities = &m_velocities[body * FloatsPerBody];
+        for (uint32_t angle = 0; angle < AngleCount; angle++)
+        {
+            const uint8_t* angleJoints = AngleJoints[angle];
+            float x1 = (joints[angleJoints[0] * 2] - joints[angleJoints[1] * 2]) * m_options.aspectRatio;
+            float y1 = joints[angleJoints[0] * 2 + 1] - joints[angleJoints[1] * 2 + 1];
+            float x2 = (joints[angleJoints[2] * 2] - joints[angleJoints[1] * 2]) * m_options.aspectRatio;
+            float y2 = joints[angleJoints[2] * 2 + 1] - joints[angleJoints[1] * 2 + 1];
+            m_angles[body * AngleCount + angle] = Atan2(std::fabs(x1 * y2 - y1 * x2), x1 * x2 + y1 * y2);
+        }
+        for (uint32_t limb = 0; limb < LimbCount; limb++)
+        {
+            const uint8_t* limbJoints = LimbJoints[limb];
+            float vx = (velocities[limbJoints[0] * 2] + velocities[limbJoints[1] * 2]) * 0.5f * m_options.aspectRatio;
+            float vy = (velocities[limbJoints[0] * 2 + 1] + velocities[limbJoints[1] * 2 + 1]) * 0.5f;
+            m_limbSpeeds[body * LimbCount + limb] = std::sqrt(vx * vx + vy * vy);
+        }
+    }
+
+    // Kinematics involving undetected joints are meaningless
+    const float notANumber = std::numeric_limits<float>::quiet_NaN();
+    for (body = 0; body < bodyCount; body++)
+    {
+        uint32_t validJoints = m_validJoints[body];
+        for (uint32_t angle = 0; angle < AngleCount; angle++)
+        {
+            uint32_t requiredJoints = (1u << AngleJoints[angle][0]) | (1u << AngleJoints[angle][1]) | (1u << AngleJoints[angle][2]);
+            if ((validJoints & requiredJoints) != requiredJoints)
+            {
+                m_angles[body * AngleCount + angle] = notANumber;
+            }
+        }
+        for (uint32_t limb = 0; limb < LimbCount; limb++)
+        {
+            uint32_t requiredJoints = (1u << LimbJoints[limb][0]) | (1u << LimbJoints[limb][1]);
+            if ((validJoints & requiredJoints) != requiredJoints)
+            {
+                m_limbSpeeds[body * LimbCount + limb] = notANumber;
+            }
+        }
+    }
+}
@@ -0,0 +1,127 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// SSE2 is used when targeting x86 or x64, other architectures use the equivalent scalar code
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define POSE_ANALYZER_USE_SSE2
+#endif
+
+//
+// Helper class that turns the bodies detected in successive frames into smoothed poses and kinematics.
+// Joints of all bodies are kept packed in flat arrays of [body][joint][x,y] floats so that smoothing and kinematics
+// run over all bodies at once with SIMD instructions:
+// - bodies are matched to the ones of the previous frame by nearest skeleton to keep a stable identifier across frames
+// - joint positions are smoothed with a One-Euro filter, which removes jitter when still while keeping up with fast motion
+// - joint angles and limb speeds are derived from the smoothed joints and their filtered velocities
+// Joint coordinates are expected normalized [0,1] like the ones of SkeletalDetectorResult.
+//
+class PoseAnalyzer
+{
+public:
+    // Amount of joints per body, matches JointLabel::NumJoints
+    static const uint32_t JointCount = 18;
+    static const uint32_t FloatsPerBody = JointCount * 2;
+
+    // Joint angles, each measured at the middle joint of a triplet of joints listed in AngleJoints
+    enum class Angle
+    {
+        RightElbow,
+        LeftElbow,
+        RightShoulder,
+        LeftShoulder,
+        RightKnee,
+        LeftKnee,
+        RightHip,
+        LeftHip
+    };
+    static const uint32_t AngleCount = 8;
+    static const uint8_t AngleJoints[AngleCount][3];
+
+    // Limbs as pairs of JointLabel values
+    static const uint32_t LimbCount = 17;
+    static const uint8_t LimbJoints[LimbCount][2];
+
+    //
+    // Joints of a detected body, only the joints flagged in validJoints are meaningful
+    //
+    struct Body
+    {
+        float joints[JointCount][2] = {};
+        uint32_t validJoints = 0; // bit per JointLabel value
+
+        void SetJoint(uint32_t label, float x, float y)
+        {
+            if (label < JointCount)
+            {
+                joints[label][0] = x;
+                joints[label][1] = y;
+                validJoints |= 1u << label;
+            }
+        }
+    };
+
+    struct Options
+    {
+        float minCutoff = 1.0f; // Hz, lower removes more jitter when still
+        float beta = 0.5f; // speed coefficient, higher reduces lag when moving fast
+        float derivativeCutoff = 1.0f; // Hz, cutoff used to smooth velocities
+        float maxMatchDistance = 0.15f; // mean joint distance above which a body is considered a new person
+        uint32_t maxMissedFrames = 10; // frames a body can go undetected before its identifier is dropped
+        float aspectRatio = 1.0f; // frame width / height, applied to x for angles and speeds
+        bool useSimd = true; // only effective when POSE_ANALYZER_USE_SSE2 is defined
+    };
+
+    explicit PoseAnalyzer(Options const& options);
+
+    //
+    // Ingest the bodies detected in a frame captured at the specified time in seconds
+    //
+    void Update(const std::vector<Body>& bodies, double timestamp);
+
+    // Forget all tracked bodies
+    void Reset();
+
+    // Results of the last Update(), in the order of its bodies
+    size_t BodyCount() const { return m_bodyToTrack.size(); }
+    uint32_t BodyId(size_t body) const { return m_tracks[m_bodyToTrack[body]].id; }
+    uint32_t ValidJoints(size_t body) const { return m_validJoints[body]; }
+    const float* Joints(size_t body) const { return &m_joints[body * FloatsPerBody]; } // smoothed x,y per joint
+    const float* JointVelocities(size_t body) const { return &m_velocities[body * FloatsPerBody]; } // vx,vy per joint, per second
+    const float* Angles(size_t body) const { return &m_angles[body * AngleCount]; } // radians in [0, pi], NaN if a joint is missing
+    const float* LimbSpeeds(size_t body) const { return &m_limbSpeeds[body * LimbCount]; } // speed of the limb middle, per second, NaN if a joint is missing
+
+private:
+    struct Track
+    {
+        uint32_t id;
+        uint32_t missedFrames;
+        uint32_t validJoints; // joints detected when last matched
+    };
+
+    void RemoveStaleTracks();
+    void MatchBodies(const std::vector<Body>& bodies);
+    void ComputeKinematics(size_t bodyCount);
+
+    Options m_options;
+    double m_lastTimestamp = 0.0;
+    bool m_hasTimestamp = false;
+    uint32_t m_nextId = 0;
+
+    // Tracked bodies and their filter state, packed by track
+    std::vector<Track> m_tracks;
+    std::vector<float> m_trackPositions;
+    std::vector<float> m_trackDerivatives;
+    std::vector<float> m_measurements;
+
+    // Results packed by body of the last Update(), padded to a multiple of 4 bodies
+    std::vector<size_t> m_bodyToTrack;
+    std::vector<uint32_t> m_validJoints;
+    std::vector<float> m_joints;
+    std::vector<float> m_velocities;
+    std::vector<float> m_angles;
+    std::vector<float> m_limbSpeeds;
+};
@@ -1,14 +1,30 @@
 ﻿// Copyright (c) Microsoft Corporation. All rights reserved.
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <future>
 #include <iomanip>
 #include <iostream>
+#include <memory>
+#include <random>
 #include <string>
+#include <vector>
 #include <winrt/Windows.Foundation.h>
 #include <winrt/windows.foundation.collections.h>
 #include <winrt/windows.media.h>
 #include <winrt/windows.system.threading.h>
 
 #include "CameraHelper_cppwinrt.h"
+#include "CameraReconnector.h"
+#include "DetectionLogger.h"
+#include "FrameDeadlinePolicy.h"
+#include "FrameRecorder_cppwinrt.h"
+#include "PoseAnalyzer.h"
+#include "SceneEventGenerator.h"
+#include "Tracing.h"
 #include "WindowsVersionHelper.h"
 #include "winrt/Microsoft.AI.Skills.SkillInterface.h"
 #include "winrt/Microsoft.AI.Skills.Vision.SkeletalDetector.h"
@@ -32,28 +48,165 @@ static const std::map<SkillExecutionDeviceKind, std::string> SkillExecutionDevic
     { SkillExecutionDeviceKind::Cloud, "Cloud" }
 };
 
-// enum to string lookup table for JointLabel
-static const std::map<JointLabel, std::string> JointLabelLookup = {
-    { JointLabel::Nose, "Nose" },
-    { JointLabel::Neck, "Neck" },
-    { JointLabel::RightShoulder, "RightShoulder" },
-    { JointLabel::RightElbow, "RightElbow" },
-    { JointLabel::RightWrist, "RightWrist" },
-    { JointLabel::LeftShoulder, "LeftShoulder" },
-    { JointLabel::LeftElbow, "LeftElbow" },
-    { JointLabel::LeftWrist, "LeftWrist" },
-    { JointLabel::RightHip, "RightHip" },
-    { JointLabel::RightKnee, "RightKnee" },
-    { JointLabel::RightAnkle, "RightAnkle" },
-    { JointLabel::LeftHip, "LeftHip" },
-    { JointLabel::LeftKnee, "LeftKnee" },
-    { JointLabel::LeftAnkle, "LeftAnkle" },
-    { JointLabel::RightEye, "RightEye" },
-    { JointLabel::LeftEye, "LeftEye" },
-    { JointLabel::RightEar, "RightEar" },
-    { JointLabel::LeftEar, "LeftEar" },
-    { JointLabel::NumJoints, "NumJoints" }
+// enum to string lookup table for JointLabel, indexed by enum value
+static constexpr const char* JointLabelLookup[] = {
+    "Nose",
+    "Neck",
+    "RightShoulder",
+    "RightElbow",
+    "RightWrist",
+    "LeftShoulder",
+    "LeftElbow",
+    "LeftWrist",
+    "RightHip",
+    "RightKnee",
+    "RightAnkle",
+    "LeftHip",
+    "LeftKnee",
+    "LeftAnkle",
+    "RightEye",
+    "LeftEye",
+    "RightEar",
+    "LeftEar",
+    "NumJoints",
 };
+static_assert(sizeof(JointLabelLookup) / sizeof(JointLabelLookup[0]) == (size_t)JointLabel::NumJoints + 1, "JointLabelLookup must name every JointLabel");
+static_assert(PoseAnalyzer::JointCount == (uint32_t)JointLabel::NumJoints, "PoseAnalyzer must track every JointLabel");
+
+//
+// Helper method to retrieve the name of a JointLabel value, nullptr if unknown
+//
+constexpr const char* JointLabelName(int32_t label)
+{
+    return (label >= 0 && label <= (int32_t)JointLabel::NumJoints) ? JointLabelLookup[label] : nullptr;
+}
+
+//
+// Helper method to retrieve the value following a named argument, i.e. "-log detections.txt"
+//
+const char* FindOptionValue(const char* optionName)
+{
+    for (int i = 1; i < __argc - 1; i++)
+    {
+        if (strcmp(__argv[i], optionName) == 0)
+        {
+            return __argv[i + 1];
+        }
+    }
+    return nullptr;
+}
+
+//
+// Helper method to check if a named flag argument was specified, i.e. "-json"
+//
+bool HasOption(const char* optionName)
+{
+    for (int i = 1; i < __argc; i++)
+    {
+        if (strcmp(__argv[i], optionName) == 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+//
+// Create the logger displaying detection results, as text or JSON lines with "-json" and also written to a file with "-log <file path>"
+//
+std::unique_ptr<DetectionLogger> CreateDetectionLogger(DetectionLogger::LabelNameFunction labelName, const char* noResultText)
+{
+    DetectionLogger::Options options;
+    options.format = HasOption("-json") ? DetectionLogger::Format::Json : DetectionLogger::Format::Text;
+    options.noResultText = noResultText;
+    options.resultName = "bodies";
+    if (auto filePath = FindOptionValue("-log"))
+    {
+        options.filePath = filePath;
+        std::cout << "Logging detections to " << filePath << std::endl;
+    }
+    return std::make_unique<DetectionLogger>(options, labelName);
+}
+
+//
+// Time the pose analytics over a synthetic workload of 50 moving bodies with jittery and missing joints, with and without SIMD
+//
+void RunPoseAnalyzerBenchmark()
+{
+    const size_t BodyCount = 50;
+    const size_t FrameCount = 1000;
+    const double FramePeriod = 1.0 / 30.0;
+
+    // Pre-generate the frames so that only the analysis gets timed. Bodies sit on a 10x5 grid and sway in their cell.
+    std::mt19937 random(31);
+    std::uniform_real_distribution<float> offset(-0.02f, 0.02f);
+    std::uniform_real_distribution<float> phase(0.0f, 6.28f);
+    std::normal_distribution<float> jitter(0.0f, 0.002f);
+    std::bernoulli_distribution isMissing(0.1);
+    std::vector<PoseAnalyzer::Body> skeletons(BodyCount);
+    std::vector<float> phases(BodyCount);
+    for (size_t body = 0; body < BodyCount; body++)
+    {
+        for (uint32_t joint = 0; joint < PoseAnalyzer::JointCount; joint++)
+        {
+            skeletons[body].SetJoint(joint, 0.05f + 0.1f * (body % 10) + offset(random), 0.1f + 0.2f * (body / 10) + 2 * offset(random));
+        }
+        phases[body] = phase(random);
+    }
+    std::vector<std::vector<PoseAnalyzer::Body>> frames(FrameCount, std::vector<PoseAnalyzer::Body>(BodyCount));
+    for (size_t frame = 0; frame < FrameCount; frame++)
+    {
+        for (size_t body = 0; body < BodyCount; body++)
+        {
+            float sway = 0.02f * sinf((float)(frame * FramePeriod) * 2.0f + phases[body]);
+            for (uint32_t joint = 0; joint < PoseAnalyzer::JointCount; joint++)
+            {
+                if (!isMissing(random))
+                {
+                    frames[frame][body].SetJoint(
+                        joint,
+                        skeletons[body].joints[joint][0] + sway + jitter(random),
+                        skeletons[body].joints[joint][1] + jitter(random));
+                }
+            }
+        }
+    }
+
+    std::vector<float> results[2];
+    for (int useSimd = 1; useSimd >= 0; useSimd--)
+    {
+        PoseAnalyzer::Options options;
+        options.useSimd = (useSimd != 0);
+        PoseAnalyzer analyzer(options);
+
+        auto begin = std::chrono::high_resolution_clock::now();
+        for (size_t frame = 0; frame < FrameCount; frame++)
+        {
+            analyzer.Update(frames[frame], frame * FramePeriod);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto frameTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000.0f / FrameCount;
+        std::cout << (options.useSimd ? "SIMD  " : "Scalar") << " : " << frameTime << "us per frame of " << analyzer.BodyCount() << " bodies" << std::endl;
+
+        // Keep the last frame results to compare both paths
+        for (size_t body = 0; body < analyzer.BodyCount(); body++)
+        {
+            results[useSimd].insert(results[useSimd].end(), analyzer.Joints(body), analyzer.Joints(body) + PoseAnalyzer::FloatsPerBody);
+            results[useSimd].insert(results[useSimd].end(), analyzer.Angles(body), analyzer.Angles(body) + PoseAnalyzer::AngleCount);
+            results[useSimd].insert(results[useSimd].end(), analyzer.LimbSpeeds(body), analyzer.LimbSpeeds(body) + PoseAnalyzer::LimbCount);
+        }
+    }
+
+    float maxDifference = 0.0f;
+    for (size_t i = 0; i < results[0].size(); i++)
+    {
+        if (!std::isnan(results[0][i]) || !std::isnan(results[1][i]))
+        {
+            maxDifference = std::max(maxDifference, fabsf(results[0][i] - results[1][i]));
+        }
+    }
+    std::cout << "Max difference between SIMD and scalar results: " << maxDifference << std::endl;
+}
 
 //
 // App main loop
@@ -69,6 +222,20 @@ int main()
             throw_hresult(hr);
         }
         std::cout << "Skeletal Detector C++/WinRT Non-packaged(win32) console App: Place something to detect in front of the camera" << std::endl;
+        std::cout << "Optional arguments: -json to display results as JSON lines, -log <file path> to also write them to a file" << std::endl;
+        std::cout << "                    -benchmark to time the pose analytics on synthetic bodies and exit" << std::endl;
+        std::cout << "                    -deadline <milliseconds> to discard frames older than that before evaluation" << std::endl;
+        std::cout << "                    -record <file path> to record the camera session, -replay <file path> to replay a recorded session" << std::endl;
+        std::cout << "                    instead of using the camera with its original timing, or as fast as possible with -fast" << std::endl;
+        std::cout << "                    -events to only display the changes of the amount of bodies rather than the results of every frame" << std::endl;
+        std::cout << std::fixed;
+        std::cout.precision(3);
+
+        if (HasOption("-benchmark"))
+        {
+            RunPoseAnalyzerBenchmark();
+            return 0;
+        }
 
         // Set and run skill
         try
@@ -76,101 +243,270 @@ int main()
             // Create the SkeletalDetector skill descriptor
             auto skillDescriptor = SkeletalDetectorDescriptor().as<ISkillDescriptor>();
 
-            // Create instance of the skill
-            auto skill = skillDescriptor.CreateSkillAsync().get().as<SkeletalDetectorSkill>();
-            std::cout << "Running Skill on : " << SkillExecutionDeviceKindLookup.at(skill.Device().ExecutionDeviceKind());
-            std::wcout << L" : " << skill.Device().Name().c_str() << std::endl;
-            std::cout << std::fixed;
-            std::cout.precision(3);
+            // Create instances of the skill and its binding on another thread while the camera is brought up,
+            // frames arriving before they are ready are skipped
+            auto startupBegin = std::chrono::high_resolution_clock::now();
+            SkeletalDetectorSkill skill = nullptr;
+            SkeletalDetectorBinding binding = nullptr;
+            float skillCreationTime = 0.0f;
+            float bindingCreationTime = 0.0f;
+            auto skillCreation = std::async(std::launch::async, [&]()
+            {
+                auto begin = std::chrono::high_resolution_clock::now();
+                skill = skillDescriptor.CreateSkillAsync().get().as<SkeletalDetectorSkill>();
+                auto end = std::chrono::high_resolution_clock::now();
+                skillCreationTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+                begin = end;
+                binding = skill.CreateSkillBindingAsync().get().as<SkeletalDetectorBinding>();
+                end = std::chrono::high_resolution_clock::now();
+                bindingCreationTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+            });
+            std::atomic<bool> isSkillReady = false;
+            std::atomic<uint64_t> startupFrameCount = 0;
 
-            // Create instance of the skill binding
-            auto binding = skill.CreateSkillBindingAsync().get().as<SkeletalDetectorBinding>();
+            // Create the logger that formats and displays results off the evaluation thread
+            auto logger = CreateDetectionLogger(JointLabelName, "---------------- No body detected ----------------");
+            uint64_t frameId = 0;
+
+            // Create the analyzer smoothing joints and identifying bodies across frames
+            PoseAnalyzer analyzer(PoseAnalyzer::Options{});
+            std::vector<PoseAnalyzer::Body> bodies;
+            auto startTime = std::chrono::steady_clock::now();
+
+            // Track the age of frames from capture to result, discarding the ones older than the deadline if specified
+            auto deadlineValue = FindOptionValue("-deadline");
+            auto deadlinePolicy = std::make_shared<FrameDeadlinePolicy>(deadlineValue != nullptr ? atof(deadlineValue) : 0.0);
+            if (deadlinePolicy->DeadlineMs() > 0)
+            {
+                std::cout << "Discarding frames older than " << deadlinePolicy->DeadlineMs() << "ms" << std::endl;
+            }
+
+            // Turn the results of frames into events of the amount of bodies changing if specified
+            std::unique_ptr<SceneEventGenerator> eventGenerator;
+            std::vector<SceneEventGenerator::Event> events;
+            if (HasOption("-events"))
+            {
+                eventGenerator = std::make_unique<SceneEventGenerator>(SceneEventGenerator::Options());
+                std::cout << "Displaying the changes of the amount of bodies" << std::endl;
+            }
 
             // Create a mutex to orchestrate skill evaluation one at a time
             winrt::slim_mutex lock;
+            std::atomic<uint64_t> busyFrameCount = 0;
 
-            // Initialize Camera and register a frame callback handler
-            auto cameraHelper = std::shared_ptr<CameraHelper>(
-                CameraHelper::CreateCameraHelper(
-                    [&](std::string failureMessage) // lambda function that acts as callback for failure event
-                    {
-                        std::cerr << failureMessage;
-                        return 1;
-                    },
-                    [&](VideoFrame const& videoFrame) // lambda function that acts as callback for new frame event
-                    {
-                        // Lock context so multiple overlapping events from FrameReader do not race for the resources.
-                        if (!lock.try_lock())
-                        {
-                            return;
-                        }
+            // lambda function that acts as callback for failure event
+            auto failureHandler = [&](std::string failureMessage)
+            {
+                std::cerr << failureMessage;
+                return 1;
+            };
+
+            // lambda function that acts as callback for new frame event
+            auto frameHandler = [&](VideoFrame const& videoFrame)
+            {
+                // Skip the frames arriving while the skill is being created
+                if (!isSkillReady)
+                {
+                    startupFrameCount++;
+                    return;
+                }
 
-                        // measure time spent binding and evaluating
-                        auto begin = std::chrono::high_resolution_clock::now();
+                // Lock context so multiple overlapping events from FrameReader do not race for the resources.
+                if (!lock.try_lock())
+                {
+                    busyFrameCount++;
+                    return;
+                }
 
-                        // Set the video frame on the skill binding.
-                        binding.SetInputImageAsync(videoFrame).get();
+                // measure time spent binding and evaluating
+                auto begin = std::chrono::high_resolution_clock::now();
 
-                        auto end = std::chrono::high_resolution_clock::now();
-                        auto bindTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
-                        begin = std::chrono::high_resolution_clock::now();
+                // Set the video frame on the skill binding.
+                {
+                    SAMPLES_TRACE_SCOPE("Bind");
+                    binding.SetInputImageAsync(videoFrame).get();
+                }
 
-                        // Detect bodies in video frame using the skill
-                        skill.EvaluateAsync(binding).get();
+                auto end = std::chrono::high_resolution_clock::now();
+                auto bindTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+                begin = std::chrono::high_resolution_clock::now();
 
-                        end = std::chrono::high_resolution_clock::now();
-                        auto evalTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
+                // Detect bodies in video frame using the skill
+                {
+                    SAMPLES_TRACE_SCOPE("Evaluate");
+                    skill.EvaluateAsync(binding).get();
+                }
 
-                        auto detectedBodies = binding.Bodies();
+                end = std::chrono::high_resolution_clock::now();
+                auto evalTime = std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count() / 1000000.0f;
 
-                        // Display bind and eval time
-                        std::cout << "bind: " << bindTime << "ms | ";
-                        std::cout << "eval: " << evalTime << "ms | ";
+                IVectorView<SkeletalDetectorResult> detectedBodies = nullptr;
+                {
+                    SAMPLES_TRACE_SCOPE("Extract");
+                    detectedBodies = binding.Bodies();
+                }
 
-                        int bodyCount = (int)binding.Bodies().Size();
-                        
-                        // Refresh the displayed line with detection result
-                        if (bodyCount > 0)
+                // Smooth the joints of the detected bodies and match them with the ones of the previous frames
+                {
+                    SAMPLES_TRACE_SCOPE("Analyze");
+                    bodies.assign(detectedBodies.Size(), PoseAnalyzer::Body());
+                    for (uint32_t i = 0; i < detectedBodies.Size(); i++)
+                    {
+                        for (auto&& limb : detectedBodies.GetAt(i).Limbs())
                         {
-                            std::cout << "Found "<< bodyCount << " bodies:";
-
-                            for (int i = 0; i < (int)detectedBodies.Size(); i++)
-                            {
-                                std::cout << "<-B" << i+1 << "->";
-                                auto body = detectedBodies.GetAt(i);
-                                auto limbs = body.Limbs();
-                                for (auto&& limb : limbs)
-                                {
-                                    std::cout << JointLabelLookup.at(limb.Joint1.Label) << "-" << JointLabelLookup.at(limb.Joint2.Label) << "|";
-                                }
-                            }
+                            bodies[i].SetJoint((uint32_t)limb.Joint1.Label, limb.Joint1.X, limb.Joint1.Y);
+                            bodies[i].SetJoint((uint32_t)limb.Joint2.Label, limb.Joint2.X, limb.Joint2.Y);
                         }
-                        else
+                    }
+                    analyzer.Update(bodies, std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+                }
+
+                auto captureTime = CameraHelper::GetCaptureTime(videoFrame);
+                if (captureTime >= 0)
+                {
+                    deadlinePolicy->RecordResult(captureTime);
+                }
+
+                // Log bind and eval time along with the smoothed limbs of each body, they get displayed by a background thread
+                if (eventGenerator != nullptr)
+                {
+                    // Only log what changed in the scene
+                    SAMPLES_TRACE_SCOPE("Log");
+                    frameId++;
+                    events.clear();
+                    eventGenerator->UpdateBodyCount(0, frameId, detectedBodies.Size(), events);
+                    for (auto&& event : events)
+                    {
+                        logger->LogEvent(event);
+                    }
+                }
+                else
+                {
+                    SAMPLES_TRACE_SCOPE("Log");
+                    frameId++;
+                    uint32_t limbCount = 0;
+                    for (auto&& body : detectedBodies)
+                    {
+                        limbCount += body.Limbs().Size();
+                    }
+                    logger->LogFrame(frameId, bindTime, evalTime, detectedBodies.Size(), limbCount);
+                    for (uint32_t i = 0; i < detectedBodies.Size(); i++)
+                    {
+                        const float* joints = analyzer.Joints(i);
+                        for (auto&& limb : detectedBodies.GetAt(i).Limbs())
                         {
-                            std::cout << "---------------- No body detected ----------------";
+                            uint32_t label1 = (uint32_t)limb.Joint1.Label;
+                            uint32_t label2 = (uint32_t)limb.Joint2.Label;
+                            logger->LogLimb(
+                                frameId, analyzer.BodyId(i),
+                                (int32_t)label1, joints[label1 * 2], joints[label1 * 2 + 1],
+                                (int32_t)label2, joints[label2 * 2], joints[label2 * 2 + 1]);
                         }
-                        std::cout << "\r";
+                    }
+                }
+
+                videoFrame.Close();
 
-                        videoFrame.Close();
+                lock.unlock();
+            };
 
-                        lock.unlock();
-                    }));
+            // Wait for the skill and its binding, then let frames through
+            auto waitForSkill = [&]()
+            {
+                skillCreation.get();
+                std::cout << "Running Skill on : " << SkillExecutionDeviceKindLookup.at(skill.Device().ExecutionDeviceKind());
+                std::wcout << L" : " << skill.Device().Name().c_str() << std::endl;
+                isSkillReady = true;
+            };
 
-            std::cout << "\t\t\t\t\t\t\t\t...press enter to Stop" << std::endl;
+            if (auto replayPath = FindOptionValue("-replay"))
+            {
+                // Replay a recorded session in place of the camera until its last frame was handled, all of them evaluated
+                waitForSkill();
+                auto timing = HasOption("-fast") ? FrameReplaySource::Timing::AsFastAsPossible : FrameReplaySource::Timing::Recorded;
+                FrameReplaySource replaySource(replayPath, timing, failureHandler, frameHandler, deadlinePolicy);
+                replaySource.Wait();
+                std::cout << std::endl << "Replay completed: " << replaySource.EmittedFrameCount() << " frames emitted";
+            }
+            else
+            {
+                // Record the camera session if specified
+                std::shared_ptr<FrameRecorder> recorder;
+                if (auto recordPath = FindOptionValue("-record"))
+                {
+                    recorder = std::make_shared<FrameRecorder>(recordPath);
+                    std::cout << "Recording the camera session to " << recordPath << std::endl;
+                }
 
-            // Wait for enter keypress
-            while (std::cin.get() != '\n');
+                // Frames stopped while the camera was reopened, smoothed joints and tracks would be extrapolated from stale positions
+                auto gapHandler = [&](CameraReconnector::Gap const& gap)
+                {
+                    std::cout << std::endl << "Camera recovered after " << (gap.endTime - gap.startTime) / FrameDeadlinePolicy::TicksPerMs
+                        << "ms | ~" << gap.lostFrameCount << " frames lost" << std::endl;
+                    lock.lock();
+                    analyzer.Reset();
+                    lock.unlock();
+                };
 
-            std::cout << std::endl << "Key pressed.. exiting";
+                // Initialize Camera and register a frame callback handler
+                auto cameraHelper = std::shared_ptr<CameraHelper>(CameraHelper::CreateCameraHelper(failureHandler, frameHandler, deadlinePolicy, recorder, gapHandler));
+                waitForSkill();
 
-            // De-initialize the MediaCapture and FrameReader
-            cameraHelper->Cleanup();
+                // Display how long each phase of the startup took, the skill was created while the camera was brought up
+                auto startupTime = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::high_resolution_clock::now() - startupBegin).count() / 1000000.0f;
+                std::cout << "Startup | skill: " << skillCreationTime << "ms | binding: " << bindingCreationTime << "ms | "
+                    << cameraHelper->LastStartupProfile().ToString() << std::endl;
+                std::cout << "Ready after " << startupTime << "ms | frames skipped meanwhile: " << startupFrameCount << std::endl;
+
+                std::cout << "\t\t\t\t\t\t\t\t...press enter to Stop" << std::endl;
+
+                // Wait for enter keypress
+                while (std::cin.get() != '\n');
+
+                std::cout << std::endl << "Key pressed.. exiting";
+
+                // De-initialize the MediaCapture and FrameReader
+                cameraHelper->Cleanup();
+
+                // Write the remaining recorded frames
+                if (recorder != nullptr)
+                {
+                    recorder->Close();
+                    std::cout << std::endl << "Recorded " << recorder->RecordedFrameCount() << " frames | "
+                        << recorder->SkippedFrameCount() << " arrivals without pixels | "
+                        << recorder->BytesWritten() / (1024 * 1024) << "MB";
+                }
+            }
+
+            // Write the remaining queued results
+            logger->Close();
+
+            // Display how old results were when they were produced
+            auto& resultAges = deadlinePolicy->ResultAges();
+            std::cout << std::endl << "Result age from capture: p50 " << resultAges.Percentile(0.5) << "ms | p90 " << resultAges.Percentile(0.9)
+                << "ms | p99 " << resultAges.Percentile(0.99) << "ms | max " << resultAges.MaxMs() << "ms" << std::endl;
+            std::cout << "Frames evaluated: " << frameId << " | admitted: " << deadlinePolicy->AdmittedFrameCount()
+                << " | discarded stale: " << deadlinePolicy->DiscardedFrameCount()
+                << " | results past deadline: " << deadlinePolicy->LateResultCount()
+                << " | skipped while busy: " << busyFrameCount << std::endl;
+            if (eventGenerator != nullptr)
+            {
+                std::cout << "Events: " << eventGenerator->GetStatistics().eventCount << std::endl;
+            }
+
+            // Write the events traced while processing frames, when built with SKILLS_SAMPLES_ENABLE_TRACING
+            SAMPLES_TRACE_DUMP("SkeletalDetectorSample_Desktop.trace.json");
         }
         catch (hresult_error const& ex)
         {
             std::wcerr << "Error:" << ex.message().c_str() << ":" << std::hex << ex.code().value << std::endl;
             return ex.code().value;
         }
+        catch (std::exception const& ex)
+        {
+            std::cerr << "Error:" << ex.what() << std::endl;
+            return 1;
+        }
         return 0;
     }
     catch (hresult_error const& ex)